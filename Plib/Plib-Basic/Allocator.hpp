@@ -171,6 +171,24 @@ namespace Plib
 			#endif
 			}
 			
+			// Get a raw buffer for _count objects.
+			// The objects are not constructed, the container
+			// should use placement new on each slot.
+			_TyObject * Allocate( unsigned int _count )
+			{
+				_TyObject * _P = NULL;
+				PMALLOC( _TyObject, _P, sizeof(_TyObject) * _count );
+				return _P;
+			}
+
+			// Release a buffer from Allocate, all objects
+			// inside must already be destroyed.
+			void Deallocate( _TyObject * _P )
+			{
+				if ( _P == NULL ) return;
+				PFREE( _P );
+			}
+			
 			// Rebind
 			template < typename _TyRebindObject >
 			struct Rebind {
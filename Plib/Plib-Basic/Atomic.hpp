@@ -0,0 +1,289 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Atomic.hpp
+* Propose  			: Atomic operations, cache line padding and futex wait/wake.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_BASIC_ATOMIC_HPP_
+#define _PLIB_BASIC_ATOMIC_HPP_
+
+#if _DEF_IOS
+#include "Plib.hpp"
+#else
+#include <Plib-Basic/Plib.hpp>
+#endif
+
+#if _DEF_WIN32
+#include <intrin.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// Linux has futex, other platforms wait by polling.
+#if _DEF_LINUX
+#include <linux/futex.h>
+#define PLIB_HAS_FUTEX			1
+#else
+#define PLIB_HAS_FUTEX			0
+#endif
+
+// Most x86 and arm cpu use 64 bytes cache line.
+// Objects written by different threads should not share one line.
+#define PLIB_CACHELINE_SIZE		64
+
+// Padding bytes after a field of type _type, so the next field
+// starts on another cache line.
+#define PLIB_CACHELINE_PAD( _name, _type )	\
+	char _name[PLIB_CACHELINE_SIZE - (sizeof(_type) % PLIB_CACHELINE_SIZE)]
+
+namespace Plib
+{
+	namespace Basic
+	{
+		// Memory order of the atomic operations.
+		// Same value as the GCC builtin so we can pass it directly.
+		enum AtomicOrder {
+	#if _DEF_WIN32
+			AO_RELAXED = 0,
+			AO_CONSUME,
+			AO_ACQUIRE,
+			AO_RELEASE,
+			AO_ACQ_REL,
+			AO_SEQ_CST
+	#else
+			AO_RELAXED = __ATOMIC_RELAXED,
+			AO_CONSUME = __ATOMIC_CONSUME,
+			AO_ACQUIRE = __ATOMIC_ACQUIRE,
+			AO_RELEASE = __ATOMIC_RELEASE,
+			AO_ACQ_REL = __ATOMIC_ACQ_REL,
+			AO_SEQ_CST = __ATOMIC_SEQ_CST
+	#endif
+		};
+
+	#if _DEF_WIN32
+		// Interlocked function wrapper, choose by the size of the object.
+		template < int _Size > struct __Interlocked;
+		template < > struct __Interlocked< 4 >
+		{
+			typedef long				TValue;
+			static INLINE TValue Exchange( volatile void * _p, TValue _v ) {
+				return ::_InterlockedExchange( (volatile long *)_p, _v );
+			}
+			static INLINE TValue CompareExchange( volatile void * _p, TValue _v, TValue _cmp ) {
+				return ::_InterlockedCompareExchange( (volatile long *)_p, _v, _cmp );
+			}
+			static INLINE TValue ExchangeAdd( volatile void * _p, TValue _v ) {
+				return ::_InterlockedExchangeAdd( (volatile long *)_p, _v );
+			}
+		};
+		template < > struct __Interlocked< 8 >
+		{
+			typedef __int64				TValue;
+			static INLINE TValue Exchange( volatile void * _p, TValue _v ) {
+				return ::_InterlockedExchange64( (volatile __int64 *)_p, _v );
+			}
+			static INLINE TValue CompareExchange( volatile void * _p, TValue _v, TValue _cmp ) {
+				return ::_InterlockedCompareExchange64( (volatile __int64 *)_p, _v, _cmp );
+			}
+			static INLINE TValue ExchangeAdd( volatile void * _p, TValue _v ) {
+				return ::_InterlockedExchangeAdd64( (volatile __int64 *)_p, _v );
+			}
+		};
+		#define _PLIB_INTERLOCKED( _Ty )	__Interlocked< sizeof(_Ty) >
+		#define _PLIB_IL_VALUE( _Ty, _v )	\
+			((typename _PLIB_INTERLOCKED(_Ty)::TValue)(_v))
+	#endif
+
+		// Load the value.
+		template < typename _Ty >
+		INLINE _Ty AtomicLoad( const volatile _Ty * _p, AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			// x86 loads are acquire, only stop the compiler.
+			_Ty _v = *_p; _ReadWriteBarrier(); return _v;
+	#else
+			return __atomic_load_n( _p, _order );
+	#endif
+		}
+
+		// Store the value.
+		template < typename _Ty >
+		INLINE void AtomicStore( volatile _Ty * _p, _Ty _v, AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			if ( _order == AO_SEQ_CST ) {
+				_PLIB_INTERLOCKED(_Ty)::Exchange( _p, _PLIB_IL_VALUE(_Ty, _v) );
+			} else {
+				_ReadWriteBarrier(); *_p = _v;
+			}
+	#else
+			__atomic_store_n( _p, _v, _order );
+	#endif
+		}
+
+		// Set the new value and return the old one.
+		template < typename _Ty >
+		INLINE _Ty AtomicExchange( volatile _Ty * _p, _Ty _v, AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			return (_Ty)_PLIB_INTERLOCKED(_Ty)::Exchange( _p, _PLIB_IL_VALUE(_Ty, _v) );
+	#else
+			return __atomic_exchange_n( _p, _v, _order );
+	#endif
+		}
+
+		// If *_p equals to _expected, set it to _desired and return true.
+		// Otherwise load the current value into _expected and return false.
+		template < typename _Ty >
+		INLINE bool AtomicCompareExchange( volatile _Ty * _p, _Ty & _expected, _Ty _desired,
+			AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			_Ty _old = (_Ty)_PLIB_INTERLOCKED(_Ty)::CompareExchange( _p,
+				_PLIB_IL_VALUE(_Ty, _desired), _PLIB_IL_VALUE(_Ty, _expected) );
+			if ( _old == _expected ) return true;
+			_expected = _old;
+			return false;
+	#else
+			// The failure order cannot be release.
+			return __atomic_compare_exchange_n( _p, &_expected, _desired, false, _order,
+				(_order == AO_RELEASE) ? AO_RELAXED :
+				((_order == AO_ACQ_REL) ? AO_ACQUIRE : _order) );
+	#endif
+		}
+
+		// Add the value and return the old one.
+		template < typename _Ty >
+		INLINE _Ty AtomicFetchAdd( volatile _Ty * _p, _Ty _v, AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			return (_Ty)_PLIB_INTERLOCKED(_Ty)::ExchangeAdd( _p, _PLIB_IL_VALUE(_Ty, _v) );
+	#else
+			return __atomic_fetch_add( _p, _v, _order );
+	#endif
+		}
+
+		// Sub the value and return the old one.
+		template < typename _Ty >
+		INLINE _Ty AtomicFetchSub( volatile _Ty * _p, _Ty _v, AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			return (_Ty)_PLIB_INTERLOCKED(_Ty)::ExchangeAdd( _p, _PLIB_IL_VALUE(_Ty, 0 - _v) );
+	#else
+			return __atomic_fetch_sub( _p, _v, _order );
+	#endif
+		}
+
+		// Memory fence.
+		INLINE void AtomicFence( AtomicOrder _order = AO_SEQ_CST )
+		{
+	#if _DEF_WIN32
+			if ( _order == AO_SEQ_CST ) ::MemoryBarrier();
+			else _ReadWriteBarrier();
+	#else
+			__atomic_thread_fence( _order );
+	#endif
+		}
+
+		// Tell the cpu we are in a spin loop.
+		INLINE void CpuRelax( )
+		{
+	#if _DEF_WIN32
+			::YieldProcessor();
+	#elif defined(__i386__) || defined(__x86_64__)
+			__asm__ __volatile__( "pause" ::: "memory" );
+	#elif defined(__aarch64__)
+			__asm__ __volatile__( "yield" ::: "memory" );
+	#else
+			__atomic_signal_fence( __ATOMIC_SEQ_CST );
+	#endif
+		}
+
+		// Give up the time slice.
+		INLINE void ThreadYield( )
+		{
+	#if _DEF_WIN32
+			::SwitchToThread();
+	#else
+			::sched_yield();
+	#endif
+		}
+
+		// Monotonic clock in micro seconds, used to calculate the
+		// remaining time of a futex wait. Not affected by settimeofday.
+		INLINE Uint64 MonotonicMicroSeconds( )
+		{
+	#if _DEF_WIN32
+			return (Uint64)::GetTickCount64() * 1000;
+	#else
+			struct timespec _ts;
+			::clock_gettime( CLOCK_MONOTONIC, &_ts );
+			return (Uint64)_ts.tv_sec * 1000000 + (Uint64)_ts.tv_nsec / 1000;
+	#endif
+		}
+
+		// Wait while *_addr is still _expected.
+		// _timeout is relative, in micro seconds, (Uint64)-1 means infinite.
+		// Return false only on time out. The wait can wake up without
+		// any reason, the caller must check the value again.
+		INLINE bool FutexWait( volatile Int32 * _addr, Int32 _expected, Uint64 _timeout = (Uint64)-1 )
+		{
+	#if PLIB_HAS_FUTEX
+			struct timespec _ts;
+			struct timespec * _pts = NULL;
+			if ( _timeout != (Uint64)-1 ) {
+				_ts.tv_sec = (time_t)(_timeout / 1000000);
+				_ts.tv_nsec = (long)((_timeout % 1000000) * 1000);
+				_pts = &_ts;
+			}
+			// FUTEX_WAIT use CLOCK_MONOTONIC for the relative timeout.
+			if ( ::syscall( SYS_futex, (int *)_addr, FUTEX_WAIT_PRIVATE,
+				_expected, _pts, NULL, 0 ) == -1 )
+			{
+				return errno != ETIMEDOUT;
+			}
+			return true;
+	#else
+			// No futex, sleep a little and let the caller check again.
+			if ( AtomicLoad( _addr, AO_ACQUIRE ) != _expected ) return true;
+			if ( _timeout == 0 ) return false;
+		#if _DEF_WIN32
+			::Sleep( 0 );
+		#else
+			::usleep( (_timeout < 50) ? (useconds_t)_timeout : 50 );
+		#endif
+			return true;
+	#endif
+		}
+
+		// Wake at most _count threads waiting on _addr.
+		INLINE void FutexWake( volatile Int32 * _addr, Int32 _count = 1 )
+		{
+	#if PLIB_HAS_FUTEX
+			::syscall( SYS_futex, (int *)_addr, FUTEX_WAKE_PRIVATE, _count, NULL, NULL, 0 );
+	#else
+			// The waiters are polling.
+			(void)_addr; (void)_count;
+	#endif
+		}
+	}
+}
+
+#endif // plib.basic.atomic.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
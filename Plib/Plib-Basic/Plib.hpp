@@ -75,6 +75,8 @@
 #include <locale>
 #include <iostream>
 #include <string>
+#include <new>
+#include <utility>
 
 // Socket Including file in Windows must in a specified order.
 #if _DEF_WIN32
@@ -113,6 +115,21 @@
 // just comment the following macro
 //#define PLIB_USE_MEMPOOL
 
+// Rvalue reference support, containers use it to move
+// objects instead of copying them when the compiler allows.
+#if ( __cplusplus >= 201103L ) || ( defined(_MSC_VER) && _MSC_VER >= 1600 )
+#define PLIB_RVALUE_REF		1
+#else
+#define PLIB_RVALUE_REF		0
+#endif
+
+// Thread local storage, only for POD objects.
+#if _DEF_WIN32
+#define PLIB_THREAD_LOCAL	__declspec(thread)
+#else
+#define PLIB_THREAD_LOCAL	__thread
+#endif
+
 namespace Plib
 {
     #define _DUMMY_CLASS class	// Unused Class definiton.
@@ -5,10 +5,14 @@
 * File Name			: ArrayOrganizer.hpp
 * Propose  			: An organizer of ArrayBlocks.
 * 
-* Current Version	: 1.0.0
+* Current Version	: 1.0.2
+* Change Log		: 1.0.2: The index is rebuilt by the changing calls, lookups only read it.
+* Change Log		: 1.0.1: Block index(Fenwick tree) of the storage item count,
+*					  locate an item in O(log blocks). Released storages are
+*					  removed from the cache.
 * Change Log		: Re-organize the ArrayList code. 
 * Author			: Push Chen
-* Change Date		: 2011-07-02
+* Change Date		: 2026-10-19
 */
 
 #ifndef _PLIB_GENERIC_ARRAYORGANIZER_HPP_
@@ -57,8 +61,18 @@ namespace Plib
 			PSTORAGE_T				m_HeadFree;				// The not full storage before the frist element.
 			Uint32					m_CacheSize;			// the size of m_StorageCache.
 			Uint32					m_CacheUsed;			// the storage used.
-			Uint32					m_FirstUnFull;			// The first Not full storage in the list.
 			Uint32					m_AllSize;				// Element Count.
+			
+			// Fenwick tree of the item count in each storage, 1-based,
+			// m_BlockIndex[i] holds the count of storages (i - lowbit(i), i].
+			// When a storage is added or removed before the tail, the index
+			// is marked dirty and rebuilt before the changing call returns,
+			// so the lookups never write it.
+			Uint32 *				m_BlockIndex;
+			bool					m_IndexDirty;
+			// All storages in [head storage, m_FirstUnFull) are full, 
+			// the item in them can be located without the index.
+			Uint32					m_FirstUnFull;
 		
 			PLIB_THREAD_SAFE_DEFINE;
 		private:
@@ -69,25 +83,78 @@ namespace Plib
 						sizeof(PSTORAGE_T) * m_CacheSize * 2 );
 				assert( _appendCache != NULL );
 				m_StorageCache = _appendCache;
+				PCREALLOC( Uint32, m_BlockIndex, _appendIndex,
+						sizeof(Uint32) * (m_CacheSize * 2 + 1) );
+				assert( _appendIndex != NULL );
+				m_BlockIndex = _appendIndex;
 				m_CacheSize *= 2;
 			}
+			
+			// Lowest set bit, the range size of a Fenwick node.
+			static INLINE Uint32 __LowBit( Uint32 _i ) { return _i & (~_i + 1); }
+			
+			// The storage list has been changed.
+			INLINE void __InvalidateIndex( ) {
+				m_IndexDirty = true;
+				m_FirstUnFull = 0;
+			}
+			
+			// Re-calculate all index node in O(blocks).
+			INLINE void __RebuildIndex( ) {
+				if ( !m_IndexDirty ) return;
+				m_FirstUnFull = __HeadStorageId( );
+				while ( m_FirstUnFull < m_CacheUsed && m_StorageCache[m_FirstUnFull]->IsFull() )
+					SELF_INCREASE( m_FirstUnFull );
+				for ( Uint32 i = 1; i <= m_CacheUsed; ++i )
+					m_BlockIndex[i] = m_StorageCache[i - 1]->Count();
+				for ( Uint32 i = 1; i <= m_CacheUsed; ++i ) {
+					Uint32 _parent = i + __LowBit( i );
+					if ( _parent <= m_CacheUsed ) m_BlockIndex[_parent] += m_BlockIndex[i];
+				}
+				m_IndexDirty = false;
+			}
+			
+			// One item has been added to/removed from the storage.
+			INLINE void __UpdateIndex( Uint32 _storageId, bool _add ) {
+				if ( m_IndexDirty ) return;
+				if ( _storageId < m_FirstUnFull ) m_FirstUnFull = _storageId;
+				if ( _add && _storageId == m_FirstUnFull && m_StorageCache[_storageId]->IsFull() )
+					SELF_INCREASE( m_FirstUnFull );
+				for ( Uint32 i = _storageId + 1; i <= m_CacheUsed; i += __LowBit( i ) ) {
+					if ( _add ) SELF_INCREASE( m_BlockIndex[i] );
+					else SELF_DECREASE( m_BlockIndex[i] );
+				}
+			}
+			
+			// A new empty storage has been appended to the end of the cache.
+			// Only the new node need to be calculated, the index is still valid.
+			INLINE void __IndexAppendStorage( ) {
+				if ( m_IndexDirty ) return;
+				m_BlockIndex[m_CacheUsed] = __PrefixCount( m_CacheUsed - 1 ) - 
+					__PrefixCount( m_CacheUsed - __LowBit( m_CacheUsed ) );
+			}
+			
+			// Item count in the first _storageCount storages.
+			INLINE Uint32 __PrefixCount( Uint32 _storageCount ) const {
+				Uint32 _count = 0;
+				for ( Uint32 i = _storageCount; i > 0; i -= __LowBit( i ) )
+					_count += m_BlockIndex[i];
+				return _count;
+			}
 		
 			/*
-			 * When the head free storage contains no elements
-			 * and the head storage is not full, invoke this method
-			 * to release the head free storage.
-			 * this method will return the storage space to the 
-			 * memory pool.
+			 * Release the storage at _storageId, the storage must be empty.
+			 * Removing the last storage keeps the index valid, the nodes
+			 * before it never cover it.
 			 */
-			INLINE void __ReleaseHeadFreeStorage( ) {
-				assert( m_HeadFree->Count() == 0 );
-				g_StorageAlloc.Destroy( m_HeadFree );
-				memmove( m_StorageCache, m_StorageCache + 1,
-					sizeof( PSTORAGE_T ) * (m_CacheUsed - 1) );
+			INLINE void __ReleaseStorage( Uint32 _storageId ) {
+				assert( m_StorageCache[_storageId]->Count() == 0 );
+				g_StorageAlloc.Destroy( m_StorageCache[_storageId] );
+				memmove( m_StorageCache + _storageId, m_StorageCache + _storageId + 1,
+					sizeof( PSTORAGE_T ) * (m_CacheUsed - _storageId - 1) );
 				SELF_DECREASE(m_CacheUsed);
 				m_StorageCache[m_CacheUsed] = NULL;
-				m_HeadStorage = m_HeadFree = m_StorageCache[0];	
-				SELF_DECREASE( m_FirstUnFull );			
+				if ( _storageId != m_CacheUsed ) __InvalidateIndex( );
 			}
 		
 			/*
@@ -99,141 +166,63 @@ namespace Plib
 			 */
 			INLINE void __AddHeadFreeStorage( ) {
 				assert( m_HeadFree->IsFull() );
+				__CheckStorageCacheSize( );
 				memmove( m_StorageCache + 1, m_StorageCache, 
 					sizeof( PSTORAGE_T ) * m_CacheUsed );
-				// Move the first unfull to the next one.
-				SELF_INCREASE(m_FirstUnFull);
-				m_HeadFree = g_StorageAlloc.Create( );
 				SELF_INCREASE(m_CacheUsed);
-				m_StorageCache[0] = m_HeadFree;
-			}
-		
-			/*
-			 * Check the tail storage's statue.
-			 * This method is only been invoked when the tail storage
-			 * contains no elements.
-			 */
-			INLINE void __CheckTailStatueAndRelease( ) {
-				assert( m_TailStorage->Count() == 0 );
-				assert( m_TailFree == m_TailStorage );
-				if ( m_TailStorage == m_HeadStorage ) return;
-				//SELF_DECREASE( m_TailStorage );
-				m_TailStorage = m_StorageCache[m_CacheUsed - 2];
-				if ( !m_TailStorage->IsFull() ) {
-					assert( m_TailFree->Count() == 0 );
-					g_StorageAlloc.Destroy( m_TailFree );
-					m_TailFree = m_TailStorage;
-				}
+				m_StorageCache[0] = g_StorageAlloc.Create( );
+				__InvalidateIndex( );
+				__UpdateEdgeStorage( );
 			}
 		
 			/*
-			 * Check the tail storage's statue.
-			 * This method is only been invoked when the tail storage
-			 * is full and the tailfree is the same as tail storage.
+			 * When the tail storage is full, invoke this method
+			 * to alloc a new free storage after it for quick append.
 			 */
-			INLINE void __CheckTailStatueAndAppend( ) {
-				assert( m_TailStorage->IsFull() );
-				assert( m_TailStorage == m_TailFree );
+			INLINE void __AddTailFreeStorage( ) {
+				assert( m_TailFree->IsFull() );
 				__CheckStorageCacheSize( );
-				if ( m_FirstUnFull == m_CacheUsed - 1 ) SELF_INCREASE( m_FirstUnFull );
 				m_StorageCache[m_CacheUsed] = g_StorageAlloc.Create( );
-				m_TailFree = m_StorageCache[m_CacheUsed];
 				SELF_INCREASE( m_CacheUsed );
+				__IndexAppendStorage( );
+				__UpdateEdgeStorage( );
 			}
 		
 			/*
-			 * Check the head storage's statue.
-			 * This method is only been invoked when the head free storage
-			 * is the same as head storage, and after one remove from the 
-			 * head storage, the storage becomes empty.
+			 * Reset the head/tail pointers.
+			 * The first storage is the head free storage, and the last
+			 * one is the tail free storage. When they are empty, the head
+			 * (tail) storage is the next (previous) one.
 			 */
-			INLINE void __CheckHeadStatueAndRelease( ) {
-				assert( m_HeadStorage->Count() == 0 );
-				assert( m_HeadStorage == m_HeadFree );
-				if ( m_HeadStorage == m_TailStorage ) return;
-				m_HeadStorage = m_StorageCache[1];
-				if ( m_HeadStorage->IsFull() ) return;
-				__ReleaseHeadFreeStorage( );
+			INLINE void __UpdateEdgeStorage( ) {
+				m_HeadFree = m_HeadStorage = m_StorageCache[0];
+				if ( m_CacheUsed > 1 && m_HeadFree->Count() == 0 ) 
+					m_HeadStorage = m_StorageCache[1];
+				m_TailFree = m_TailStorage = m_StorageCache[m_CacheUsed - 1];
+				if ( m_CacheUsed > 1 && m_TailFree->Count() == 0 ) 
+					m_TailStorage = m_StorageCache[m_CacheUsed - 2];
 			}
 		
 			/*
-			 * Check the head storage's statue.
-			 * This method is only been invoked when the head storage
-			 * is full and need to add new storege for quick insert.
+			 * After an object has been removed from the storage, check
+			 * if the storage should be released.
+			 * Only the head and tail free storage can be empty, and 
+			 * only one empty storage is kept at each side, so push/pop 
+			 * on the edge of a storage will not alloc/free again and again.
 			 */
-			INLINE void __CheckHeadStatueAndAppend( ) {
-				assert( m_HeadStorage == m_HeadFree );
-				assert( m_HeadStorage->IsFull() );
-				__CheckStorageCacheSize();
-				__AddHeadFreeStorage( );
-			}
-		
-			// After Append/Insert/Delete an object in the last storage,
-			// Invoke this method to update the tail storage's statue.
-			INLINE void __UpdateTailFreeStorage( ) {
-				if ( m_TailStorage->Count() == 0 )	// Release this storage.
-				{
-					if ( m_CacheUsed == 1 ) return;
-					__CheckTailStatueAndRelease();
-					return;
-				}
-				if ( m_TailStorage->IsFull() )		// Append new storage.
-				{
-					if ( m_TailStorage == m_TailFree )
-					{
-						__CheckTailStatueAndAppend();
-						return;
+			INLINE void __CheckAndUpdateStorage( Uint32 _storageId ) {
+				if ( m_CacheUsed > 1 && m_StorageCache[_storageId]->Count() == 0 ) {
+					if ( _storageId > 0 && _storageId < m_CacheUsed - 1 ) {
+						// Empty storage in the middle.
+						__ReleaseStorage( _storageId );
 					}
-					if ( m_TailFree->Count() > 0 )
-					{
-					 	m_TailStorage = m_TailFree;
-						return;
-					}
-					return;
-				}
-				if ( m_TailStorage != m_TailFree )	// Release the tail free
-				{
-					assert( m_TailFree->Count() == 0 );
-					g_StorageAlloc.Destroy(m_TailFree);
-					m_TailFree = m_TailStorage;
-					return;
-				}
-			}
-		
-			// After Insert/Delete an object in the first storage,
-			// Invoke this method to update head storage's statue.
-			INLINE void __UpdateHeadFreeStorage( ) {
-				if ( m_HeadStorage->Count() == 0 )
-				{
-					if ( m_CacheUsed == 1 ) return;
-					__CheckHeadStatueAndRelease();
-					return;
-				}
-				if ( m_HeadStorage->IsFull() )
-				{
-					if ( m_HeadStorage == m_HeadFree ) 
-					{
-						__CheckHeadStatueAndAppend();
-						return;
-					}
-					if ( m_HeadFree->Count() > 0 ) 
-					{
-						m_HeadStorage = m_HeadFree;
-						m_FirstUnFull = 0;
-					}
-					return;
-				}
-				if ( m_HeadStorage != m_HeadFree )
-				{
-					__ReleaseHeadFreeStorage( );
-					return;
 				}
-			}
-		
-			// Common Storage checking.
-			INLINE void __CheckAndUpdateStorage( ) {
-				__UpdateHeadFreeStorage();
-				__UpdateTailFreeStorage();
+				if ( m_CacheUsed > 1 && m_StorageCache[0]->Count() == 0 
+					&& m_StorageCache[1]->Count() == 0 ) __ReleaseStorage( 0 );
+				if ( m_CacheUsed > 1 && m_StorageCache[m_CacheUsed - 1]->Count() == 0 
+					&& m_StorageCache[m_CacheUsed - 2]->Count() == 0 ) 
+					__ReleaseStorage( m_CacheUsed - 1 );
+				__UpdateEdgeStorage( );
 			}
 		
 			// Split the storage and move half elements
@@ -247,6 +236,7 @@ namespace Plib
 					sizeof( PSTORAGE_T ) * (m_CacheUsed - _idx) );
 				m_StorageCache[_idx] = _newInsertStorage;
 				SELF_INCREASE( m_CacheUsed );
+				__InvalidateIndex( );
 			
 				// Copy Data from the old storage to the new storage.
 				Uint16 _halfSize = m_StorageCache[_idx + 1]->Count() / 2;
@@ -255,14 +245,8 @@ namespace Plib
 					m_StorageCache[_idx + 1]->Remove( 0 );
 				}
 			
-				// Update the first Unfull.
-				if ( _idx < m_FirstUnFull ) m_FirstUnFull = _idx;
-			
 				// Check the head/tail statue.
-				m_HeadFree = m_HeadStorage = m_StorageCache[0];
-				if ( m_HeadFree->Count() == 0 ) m_HeadStorage = m_StorageCache[1];
-				m_TailFree = m_TailStorage = m_StorageCache[m_CacheUsed - 1];
-				if ( m_TailFree->Count() == 0 ) m_TailStorage = m_StorageCache[m_CacheUsed - 2];
+				__UpdateEdgeStorage( );
 			}
 		
 			// Search all storages to locate the _idx th element.
@@ -271,19 +255,41 @@ namespace Plib
 			// the new value of _posInStorage.
 			Uint32 __SearchItemOfIndex( Uint32 _idx, Uint32 * _posInStorage ) const {
 				assert( _idx < m_AllSize );
-				Uint32 _unfullCount = (m_FirstUnFull - (Uint32)(!__IsHeadEqualHeadFree())) * AL_BLOCK_SIZE 
-					+ m_StorageCache[m_FirstUnFull]->Count();
-				if ( _idx < _unfullCount ) {
+				Uint32 _pos = 0;
+				// Head and tail storage can be located directly.
+				if ( _idx < m_HeadStorage->Count() ) {
+					_pos = _idx;
+					if ( _posInStorage != NULL ) *_posInStorage = _pos;
+					return __HeadStorageId( );
+				}
+				Uint32 _tailStart = m_AllSize - m_TailStorage->Count();
+				if ( _idx >= _tailStart ) {
+					_pos = _idx - _tailStart;
+					if ( _posInStorage != NULL ) *_posInStorage = _pos;
+					return __TailStorageId( );
+				}
+				
+				assert( !m_IndexDirty );
+				Uint32 _headId = __HeadStorageId( );
+				if ( m_FirstUnFull > _headId && _idx < (m_FirstUnFull - _headId) * AL_BLOCK_SIZE ) {
 					if ( _posInStorage != NULL ) *_posInStorage = _idx % AL_BLOCK_SIZE;
-					return _idx / AL_BLOCK_SIZE + ((m_HeadFree != m_HeadStorage) ? 1 : 0);
+					return _headId + _idx / AL_BLOCK_SIZE;
 				}
-				Uint32 _searchId = m_FirstUnFull + 1;
-				for ( ; _searchId < m_CacheUsed; ++_searchId ) {
-					if ( m_StorageCache[_searchId]->Count() + _unfullCount > _idx ) break;
-					_unfullCount += m_StorageCache[_searchId]->Count();
+				
+				// Walk down the Fenwick tree, find the last storage
+				// whose prefix count is not greater than _idx.
+				Uint32 _step = 1;
+				while ( (_step << 1) <= m_CacheUsed ) _step <<= 1;
+				Uint32 _storageId = 0;
+				_pos = _idx;
+				for ( ; _step > 0; _step >>= 1 ) {
+					if ( _storageId + _step > m_CacheUsed ) continue;
+					if ( m_BlockIndex[_storageId + _step] > _pos ) continue;
+					_storageId += _step;
+					_pos -= m_BlockIndex[_storageId];
 				}
-				if ( _posInStorage != NULL ) *_posInStorage = (_idx - _unfullCount);
-				return _searchId;
+				if ( _posInStorage != NULL ) *_posInStorage = _pos;
+				return _storageId;
 			}
 		protected:
 			
@@ -295,6 +301,7 @@ namespace Plib
 				this->__Clear(); 
 				g_StorageAlloc.Destroy( m_StorageCache[0] );
 				PFREE( m_StorageCache );
+				PFREE( m_BlockIndex );
 			}
 			
 		protected:
@@ -303,10 +310,13 @@ namespace Plib
 				PLIB_THREAD_SAFE;
 				m_CacheSize = 8;
 				m_CacheUsed = 1;
-				m_FirstUnFull = m_AllSize = 0;
+				m_AllSize = 0;
 				PMALLOC( PSTORAGE_T, m_StorageCache, sizeof(PSTORAGE_T) * m_CacheSize );
+				PMALLOC( Uint32, m_BlockIndex, sizeof(Uint32) * (m_CacheSize + 1) );
+				__InvalidateIndex( );
 				m_StorageCache[0] = g_StorageAlloc.Create( );
 				m_HeadStorage = m_HeadFree = m_TailStorage = m_TailFree = m_StorageCache[0];					
+				__RebuildIndex( );
 			}
 			
 			// Clear the storage.
@@ -328,7 +338,8 @@ namespace Plib
 				m_CacheUsed = 1;
 				m_HeadFree = m_HeadStorage = m_TailFree = m_TailStorage = m_StorageCache[0];
 				m_AllSize = 0;
-				m_FirstUnFull = 0;					
+				__InvalidateIndex( );
+				__RebuildIndex( );
 			}
 			
 			// Get the all item size.
@@ -341,35 +352,47 @@ namespace Plib
 			// Append new object to the end of the list.
 			INLINE void __AppendLast( const _TyObject & _vobj ) {
 				PLIB_THREAD_SAFE;
+				if ( m_TailFree->IsFull() ) __AddTailFreeStorage( );
 				m_TailFree->Append( g_ItemAlloc.Create( _vobj ) );
-				__CheckAndUpdateStorage();
+				__UpdateIndex( m_CacheUsed - 1, true );
+				__UpdateEdgeStorage( );
 				SELF_INCREASE( m_AllSize );					
+				__RebuildIndex( );
 			}
 			
 			INLINE void __AppendHead( const _TyObject & _vobj )
 			{
 				PLIB_THREAD_SAFE;
+				if ( m_HeadFree->IsFull() ) __AddHeadFreeStorage( );
 				m_HeadFree->Insert( g_ItemAlloc.Create( _vobj ), 0 );
-				__CheckAndUpdateStorage();
+				__UpdateIndex( 0, true );
+				__UpdateEdgeStorage( );
 				SELF_INCREASE( m_AllSize );					
+				__RebuildIndex( );
 			}
 			
 			INLINE void __RemoveLast( ) {
 				PLIB_THREAD_SAFE;
+				Uint32 _storageId = __TailStorageId( );
 				_TyObject * _pObj = m_TailStorage->operator[] ( m_TailStorage->Count() - 1 );
 				m_TailStorage->Remove( m_TailStorage->Count() - 1 );
+				__UpdateIndex( _storageId, false );
 				g_ItemAlloc.Destroy( _pObj );
-				__CheckAndUpdateStorage();
+				__CheckAndUpdateStorage( _storageId );
 				SELF_DECREASE( m_AllSize );					
+				__RebuildIndex( );
 			}
 			
 			INLINE void __RemoveHead( ) {
 				PLIB_THREAD_SAFE;
+				Uint32 _storageId = __HeadStorageId( );
 				_TyObject * _pObj = m_HeadStorage->operator[] ( 0 );
 				m_HeadStorage->Remove( 0 );
+				__UpdateIndex( _storageId, false );
 				g_ItemAlloc.Destroy( _pObj );
-				__CheckAndUpdateStorage();
+				__CheckAndUpdateStorage( _storageId );
 				SELF_DECREASE( m_AllSize );					
+				__RebuildIndex( );
 			}
 			
 			INLINE void __Insert( const _TyObject & _vobj, Uint32 _idx ) {
@@ -388,22 +411,16 @@ namespace Plib
 				if ( m_StorageCache[_storageId]->IsFull() ) {
 					// Insert a new storage block
 					__SplitTheStorageOf( _storageId );
+					__RebuildIndex( );
 					_storageId = __SearchItemOfIndex( _idx, &_posInStorage );
 				}
 				// Set the value.
 				m_StorageCache[_storageId]->Insert( g_ItemAlloc.Create( _vobj ), _posInStorage );
+				__UpdateIndex( _storageId, true );
 
-				__CheckAndUpdateStorage();
+				__UpdateEdgeStorage( );
 				SELF_INCREASE(m_AllSize);
-
-				// Check if the first unfull storage has been full.
-				if ( _storageId != m_FirstUnFull ) return;
-				if ( !m_StorageCache[m_FirstUnFull]->IsFull() ) return;
-				for ( Uint32 i = m_FirstUnFull + 1; i < m_CacheUsed; ++i ) {
-					if ( m_StorageCache[i]->IsFull() ) continue;
-					m_FirstUnFull = i;
-					break;
-				}					
+				__RebuildIndex( );
 			}
 			
 			// Remove the specified object.
@@ -414,12 +431,12 @@ namespace Plib
 				// Release the item.
 				_TyObject * _pObj = m_StorageCache[_storageId]->operator [] ( _posInStorage );
 				m_StorageCache[_storageId]->Remove( _posInStorage );
+				__UpdateIndex( _storageId, false );
 				g_ItemAlloc.Destroy( _pObj );
 
-				// Check the first unfull.
-				if ( _storageId < m_FirstUnFull ) m_FirstUnFull = _storageId;
-				__CheckAndUpdateStorage();
+				__CheckAndUpdateStorage( _storageId );
 				SELF_DECREASE(m_AllSize);					
+				__RebuildIndex( );
 			}
 			
 			// Non-const version of _Get.
@@ -446,19 +463,16 @@ namespace Plib
 			INLINE bool __IsHeadEqualHeadFree( ) const { return m_HeadFree == m_HeadStorage; }
 			INLINE bool __IsTailEqualTailFree( ) const { return m_TailFree == m_TailStorage; }
 			
-			INLINE Uint32 __ItemCountBefore( Uint32 _storageId ) {
-				_storageId -= (_storageId == 0) ? 0 : (Uint32)(!__IsHeadEqualHeadFree());
+			// Position of the head/tail storage in the cache.
+			INLINE Uint32 __HeadStorageId( ) const { return __IsHeadEqualHeadFree() ? 0 : 1; }
+			INLINE Uint32 __TailStorageId( ) const { 
+				return __IsTailEqualTailFree() ? m_CacheUsed - 1 : m_CacheUsed - 2; }
+			
+			// Item count of all storages before _storageId.
+			INLINE Uint32 __ItemCountBefore( Uint32 _storageId ) const {
 				if ( _storageId == 0 ) return 0;
-				if ( _storageId <= m_FirstUnFull ) {
-					return (_storageId - 1) * AL_BLOCK_SIZE;
-				}
-				Uint32 _unfullCount = (m_FirstUnFull - (Uint32)(!__IsHeadEqualHeadFree())) * AL_BLOCK_SIZE 
-					+ m_StorageCache[m_FirstUnFull]->Count();
-				Uint32 _searchId = m_FirstUnFull + 1;
-				for ( ; _searchId < _storageId; ++_searchId ) {
-					_unfullCount += m_StorageCache[_searchId]->Count();
-				}
-				return _unfullCount;
+				assert( !m_IndexDirty );
+				return __PrefixCount( _storageId );
 			}
 		};
 		// Global Static Allocator of any ArrayList.
@@ -5,9 +5,11 @@
 * File Name			: Delegate.hpp
 * Propose  			: Delegate Redefinition.
 * 
-* Current Version	: 1.2
+* Current Version	: 1.3
 * Change Log		: Redefinition, Use Plib::Generic::List.
 					: Move to Generic Namespace.
+					: 1.3: Store the targets in slots with a small buffer, no heap and
+					  no virtual call for function and member function targets.
 * Author			: Push Chen
 * Change Date		: 2011-04-26
 */
@@ -22,6 +24,7 @@
 #else
 #include <Plib-Generic/ArrayList.hpp>
 #endif
+#include <new>
 
 namespace Plib
 {
@@ -52,8 +55,149 @@ namespace Plib
 		#define DEF_TYPE( n )						REPEAT_##n( n, TYPE, TYPE_END )
 		#define DEF_ARGTYPE( n )					REPEAT_##n( n, TYPEDEF, TYPEDEF_END )
 
+		// Only used to get the largest size of a member function pointer.
+		class __DelegateUnknown;
+
+		// One bound target of a delegate.
+		// A function pointer, an object with a member function pointer, or
+		// a small function object is stored in the buffer directly.
+		// A large function object is allocated and the buffer keeps the pointer.
+		struct DelegateSlot
+		{
+			enum { SLOT_BUFFER_SIZE =
+				sizeof(void *) * 2 + sizeof(void (__DelegateUnknown::*)()) };
+
+			// The real type is _TyRet (*)( const DelegateSlot *, Args... ).
+			typedef void (*InvokeT)( );
+			// Copy _src to _dst, or destroy _dst when _src is NULL.
+			// NULL means the buffer can be copied by memcpy.
+			typedef void (*ManageT)( DelegateSlot * _dst, const DelegateSlot * _src );
+
+			union {
+				char				m_Buffer[SLOT_BUFFER_SIZE];
+				void *				m_Pointer;
+				Int64				m_AlignInt;
+				double				m_AlignDouble;
+			};
+			InvokeT					m_Invoke;
+			ManageT					m_Manage;
+		};
+
+		// Function object storage, in the buffer if it is small enough.
+		template < typename _TyIns,
+			bool _Inline = (sizeof(_TyIns) <= DelegateSlot::SLOT_BUFFER_SIZE) >
+		struct DelegateFuncStore {
+			static INLINE _TyIns * Get( const DelegateSlot * _slot ) {
+				return (_TyIns *)_slot->m_Buffer;
+			}
+			static INLINE void Create( DelegateSlot * _slot, const _TyIns & _obj ) {
+				new ( _slot->m_Buffer ) _TyIns( _obj );
+			}
+			static void Manage( DelegateSlot * _dst, const DelegateSlot * _src ) {
+				if ( _src == NULL ) Get( _dst )->~_TyIns( );
+				else Create( _dst, *Get( _src ) );
+			}
+		};
+		template < typename _TyIns >
+		struct DelegateFuncStore< _TyIns, false > {
+			static INLINE _TyIns * Get( const DelegateSlot * _slot ) {
+				return (_TyIns *)_slot->m_Pointer;
+			}
+			static INLINE void Create( DelegateSlot * _slot, const _TyIns & _obj ) {
+				PNEWPARAM( _TyIns, _slot->m_Pointer, _obj );
+			}
+			static void Manage( DelegateSlot * _dst, const DelegateSlot * _src ) {
+				if ( _src == NULL ) { _TyIns * _p = Get( _dst ); PDELETE( _p ); }
+				else Create( _dst, *Get( _src ) );
+			}
+		};
+
+		// Slot list of all delegates, same for any signature.
+		// The first target is kept inside the object, the others are in
+		// one continuous block. Clear keeps the block for the next binding.
+		class DelegateStore
+		{
+		protected:
+			DelegateSlot			m_First;
+			DelegateSlot *			m_More;
+			Uint32					m_Count;
+			Uint32					m_MoreSize;
+
+			static INLINE void __CopySlot( DelegateSlot * _dst, const DelegateSlot * _src )
+			{
+				if ( _src->m_Manage == NULL ) {
+					::memcpy( _dst, _src, sizeof(DelegateSlot) );
+					return;
+				}
+				_dst->m_Invoke = _src->m_Invoke;
+				_dst->m_Manage = _src->m_Manage;
+				_src->m_Manage( _dst, _src );
+			}
+			static INLINE void __FreeSlot( DelegateSlot * _slot )
+			{
+				if ( _slot->m_Manage != NULL ) _slot->m_Manage( _slot, NULL );
+			}
+			INLINE const DelegateSlot * __Slot( Uint32 _index ) const
+			{
+				return (_index == 0) ? &m_First : m_More + _index - 1;
+			}
+
+			// Add a slot at the end, the caller fills it.
+			INLINE DelegateSlot * __NewSlot( )
+			{
+				if ( m_Count == 0 ) { m_Count = 1; return &m_First; }
+				if ( m_Count - 1 == m_MoreSize ) {
+					Uint32 _size = (m_MoreSize == 0) ? 2 : m_MoreSize * 2;
+					DelegateSlot * _more;
+					PMALLOC( DelegateSlot, _more, sizeof(DelegateSlot) * _size );
+					for ( Uint32 i = 0; i < m_MoreSize; ++i ) {
+						__CopySlot( _more + i, m_More + i );
+						__FreeSlot( m_More + i );
+					}
+					if ( m_More != NULL ) { PFREE( m_More ); }
+					m_More = _more;
+					m_MoreSize = _size;
+				}
+				return m_More + (m_Count++ - 1);
+			}
+
+			DelegateStore( ) : m_More( NULL ), m_Count( 0 ), m_MoreSize( 0 )
+			{
+				m_First.m_Invoke = NULL;
+				m_First.m_Manage = NULL;
+			}
+			DelegateStore( const DelegateStore & rhs )
+				: m_More( NULL ), m_Count( 0 ), m_MoreSize( 0 )
+			{
+				m_First.m_Invoke = NULL;
+				m_First.m_Manage = NULL;
+				(*this) = rhs;
+			}
+			~DelegateStore( )
+			{
+				this->Clear( );
+				if ( m_More != NULL ) { PFREE( m_More ); }
+			}
+			DelegateStore & operator = ( const DelegateStore & rhs )
+			{
+				if ( this == &rhs ) return *this;
+				this->Clear( );
+				for ( Uint32 i = 0; i < rhs.m_Count; ++i )
+					__CopySlot( this->__NewSlot( ), rhs.__Slot( i ) );
+				return *this;
+			}
+
+		public:
+			operator bool ( ) const { return m_Count != 0; }
+			unsigned int Count( ) const { return m_Count; }
+			void Clear( )
+			{
+				for ( Uint32 i = 0; i < m_Count; ++i )
+					__FreeSlot( const_cast< DelegateSlot * >( __Slot( i ) ) );
+				m_Count = 0;
+			}
+		};
 
-		template < typename T > struct DelegateInvokeBase { };
 		template < typename T > struct DelegateInvokeProc { };
 		template < typename _TyIns, typename T > struct DelegateInvokeObj { };
 		template < typename _TyIns, typename T > struct DelegateInvokeFuncObj { };
@@ -61,234 +205,168 @@ namespace Plib
 
 
 		// Basic Delegate Definition.
-		#define _DELEGATE_BASIC_DEFINITION_COMMON_( n )									\
-		template < typename _TyRet, DEF_PARAM( n ) >									\
-		struct DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > {							\
-			virtual _TyRet Invoke( DEF_VAL( n ) ) const = 0;							\
-			virtual DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > * Copy( ) = 0;		\
-			virtual ~DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > ( ) { }				\
-		};																				\
-		template < typename _TyRet, DEF_PARAM( n ) >									\
-		struct DelegateInvokeProc< _TyRet ( DEF_TYPE( n ) ) >							\
-			: public DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > {					\
-			_TyRet (*mfp)( DEF_TYPE( n ) );												\
-			DelegateInvokeProc( ) : mfp( NULL ) { }										\
-			DelegateInvokeProc( _TyRet (*fp)( DEF_TYPE( n ) ) ) : mfp(fp) { }           \
-			DelegateInvokeProc( const DelegateInvokeProc< _TyRet( DEF_TYPE( n ) ) > &	\
-					rhs ) : mfp( rhs.mfp ) { }											\
-			inline virtual _TyRet Invoke( DEF_VAL( n ) ) const {						\
-				return (*mfp)( DEF_ARG( n ) ); }										\
-			inline virtual DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > * Copy() {	\
-				typedef DelegateInvokeProc< _TyRet( DEF_TYPE(n) ) > TDelg;				\
-				PCNEWPARAM( TDelg, p, *this );											\
-				return p;																\
-			}																			\
-			virtual ~DelegateInvokeProc< _TyRet ( DEF_TYPE( n ) ) >() {}				\
-		};																				\
-		template < typename _TyIns, typename _TyRet, DEF_PARAM( n ) >					\
-		struct DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE( n ) ) >						\
-			: public DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > {					\
-			_TyRet (_TyIns::*mfp)( DEF_TYPE( n ) );										\
-			_TyIns * pIns;																\
-			DelegateInvokeObj( ) : mfp( NULL ), pIns( NULL ) { }						\
-			DelegateInvokeObj( _TyIns * pObj, _TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) )	\
-				: mfp(fp), pIns(pObj) { }												\
-			DelegateInvokeObj( const DelegateInvokeObj< _TyIns, 						\
-					_TyRet( DEF_TYPE( n ) ) > & rhs )									\
-				: mfp( rhs.mfp ), pIns( rhs.pIns ) { }									\
-			inline virtual _TyRet Invoke( DEF_VAL( n ) ) const {						\
-				return (pIns->*mfp)( DEF_ARG( n ) ); }									\
-			inline virtual DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > * Copy() {	\
-				typedef DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE( n ) ) > TDelg;		\
-				PCNEWPARAM( TDelg, p, *this );											\
-				return p;																\
-			}																			\
-			virtual ~DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE( n ) ) >() {}			\
-		};																				\
-		template < typename _TyIns, typename _TyRet, DEF_PARAM( n ) >					\
-		struct DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE( n ) ) >					\
-			: public DelegateInvokeBase< _TyRet( DEF_TYPE( n ) ) > {					\
-			_TyIns pIns;																\
-			DelegateInvokeFuncObj( ) { }												\
-			DelegateInvokeFuncObj( _TyIns & rObj ) : pIns(rObj) { }						\
-			DelegateInvokeFuncObj( const DelegateInvokeFuncObj< 						\
-					_TyIns, _TyRet( DEF_TYPE( n ) ) > & rhs ) : pIns( rhs.pIns ) { }	\
-			inline virtual _TyRet Invoke( DEF_VAL( n ) ) const {						\
-				return (_TyRet)(pIns)( DEF_ARG( n ) ); }								\
-			inline virtual DelegateInvokeBase< _TyRet ( DEF_TYPE( n ) ) > * Copy() {	\
-				typedef DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE( n ) ) > TDelg;	\
-				PCNEWPARAM( TDelg, p, *this );											\
-				return p;																\
-			}																			\
-			virtual ~DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE( n ) ) >() {}		\
-		};																				\
-		template < typename _TyRet, DEF_PARAM( n ) >									\
-		class Delegate< _TyRet ( DEF_TYPE( n ) ) > {									\
-		protected:																		\
-			Array< DelegateInvokeBase< _TyRet( DEF_TYPE( n ) ) > * > m_FooList;			\
-		public:																			\
-			DEF_ARGTYPE( n );															\
-			typedef argument_type0 argument_type;										\
-			typedef argument_type0 first_argument_type;									\
-			typedef CHAR_CONNECT(argument_type, n) second_argument_type;				\
-			typedef _TyRet result_type;													\
-			typedef _TyRet (*function_type)(DEF_TYPE( n ));								\
-			Delegate< _TyRet( DEF_TYPE( n ) ) >(										\
-					const Delegate<_TyRet( DEF_TYPE( n ) )> & rhs) 						\
-			{																			\
-				CONSTRUCTURE;															\
-				(*this) = rhs;															\
-			}																			\
-			Delegate<_TyRet( DEF_TYPE( n ) )> & operator = (							\
-				const Delegate<_TyRet( DEF_TYPE( n ) )> & rhs ) {						\
-				if ( this == &rhs ) return *this;										\
-				for ( unsigned int i = 0; i < m_FooList.Size(); ++i )					\
-				{																		\
-					PDELETE( m_FooList[i] );											\
-				}																		\
-				this->m_FooList.Clear();												\
-				for ( unsigned int i = 0; i < rhs.m_FooList.Size(); ++i )				\
-					m_FooList.PushBack(rhs.m_FooList[i]->Copy());						\
-				return (*this);															\
-			}																			\
-		public:																			\
-			void Add ( _TyRet (*fp)( DEF_TYPE( n ) ) ) {								\
-				if ( fp == NULL ) return;												\
-				typedef DelegateInvokeProc< _TyRet( DEF_TYPE( n ) ) > TDelg;			\
-				PCNEW( TDelg, pDelg );													\
-				pDelg->mfp = fp;														\
-				m_FooList.PushBack( pDelg );											\
-			}																			\
-			template <class _TyIns> void Add ( _TyIns * pObj,							\
-				_TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) ) {								\
-				if ( pObj == NULL || fp == NULL ) return;								\
-				typedef DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE(n) ) > TDelg;		\
-				PCNEW( TDelg, pDelg );													\
-				pDelg->mfp = fp;														\
-				pDelg->pIns = pObj;														\
-				m_FooList.PushBack( pDelg );											\
-			}																			\
-			template <class _TyIns> void Add ( _TyIns & rObj ) {						\
-				typedef DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE(n) ) > TDelg;	\
-				PCNEW(TDelg, pDelg);													\
-				pDelg->pIns = rObj;														\
-				m_FooList.PushBack( pDelg );											\
-			}																			\
-			operator bool ( ) const {													\
-				return this->m_FooList.Size() != 0;										\
-			}																			\
-			_TyRet operator () ( DEF_VAL( n ) ) {										\
-				for ( Uint32 i = 0; i < m_FooList.Size( ) - 1;							\
-					m_FooList[i++]->Invoke( DEF_ARG( n ) ) );							\
-				return (_TyRet)(m_FooList[m_FooList.Size() - 1]->Invoke(DEF_ARG( n )));	\
-			}																			\
-			_TyRet operator () ( DEF_VAL( n ) ) const {									\
-				for ( unsigned int i = 0; i < m_FooList.Size() - 1;						\
-					m_FooList[i++]->Invoke( DEF_ARG( n ) ) );							\
-				return (_TyRet)m_FooList[m_FooList.Size() - 1]->Invoke( DEF_ARG( n ) );	\
-			}																			\
-			Delegate< _TyRet( DEF_TYPE( n ) ) > & operator += (							\
-				_TyRet (*fp)( DEF_TYPE( n ) ) ) {										\
-				this->Add(fp);															\
-				return (*this);															\
-			}																			\
-			template < class _TyIns > Delegate< _TyRet ( DEF_TYPE( n ) ) > &			\
-			operator += ( std::pair< _TyIns *,											\
-				_TyRet (_TyIns::*)( DEF_TYPE( n ) ) > pairFp) {							\
-				this->Add(pairFp.first, pairFp.second);									\
-				return (*this);															\
-			}																			\
-			template < class _TyIns > Delegate< _TyRet ( DEF_TYPE( n ) ) > &			\
-				operator += ( _TyIns & rObj ) {											\
-				this->Add( rObj );														\
-				return (*this);															\
-			}																			\
-			Delegate<_TyRet( DEF_TYPE( n ) )> () {CONSTRUCTURE;}						\
-			Delegate<_TyRet( DEF_TYPE( n ) )> ( _TyRet (*fp)( DEF_TYPE( n ) ) ) { 		\
-				CONSTRUCTURE; this->Add( fp ); }										\
-			template < class _TyIns > 													\
-			Delegate<_TyRet( DEF_TYPE( n ) )>(_TyIns * pObj,							\
-				_TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) ) {								\
-				CONSTRUCTURE;															\
-				this->Add(pObj, fp); 													\
-			}																			\
-			template < class _TyIns > 													\
-			Delegate< _TyRet( DEF_TYPE( n ) ) >(_TyIns & rObj) { 						\
-				CONSTRUCTURE; this->Add(rObj); }										\
-			~Delegate< _TyRet( DEF_TYPE( n ) ) >  () {									\
-				DESTRUCTURE;															\
-				for ( unsigned int i = 0; i < m_FooList.Size(); ++i ) {					\
-					PDELETE( m_FooList[i] );											\
-				}																		\
-				m_FooList.Clear();														\
-			}																			\
-			unsigned int Count() const { return m_FooList.Size(); }						\
-			void Clear() { 																\
-				for ( unsigned int i = 0; i < m_FooList.Size(); ++i ) {					\
-					PDELETE( m_FooList[i] );											\
-				}																		\
-				m_FooList.Clear(); 														\
-			}																			\
+		#define _DELEGATE_BASIC_DEFINITION_COMMON_( n )							\
+		template < typename _TyRet, DEF_PARAM( n ) >							\
+		struct DelegateInvokeProc< _TyRet ( DEF_TYPE( n ) ) > {					\
+			typedef _TyRet (*TFunc)( DEF_TYPE( n ) );							\
+			static _TyRet Invoke( const DelegateSlot * _slot, DEF_VAL( n ) ) {	\
+				return (*(*(const TFunc *)_slot->m_Buffer))( DEF_ARG( n ) ); }	\
+			static INLINE void Bind( DelegateSlot * _slot, TFunc fp ) {			\
+				*(TFunc *)_slot->m_Buffer = fp;									\
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;				\
+				_slot->m_Manage = NULL;											\
+			}																	\
+		};																		\
+		template < typename _TyIns, typename _TyRet, DEF_PARAM( n ) >			\
+		struct DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE( n ) ) > {			\
+			_TyIns * pIns;														\
+			_TyRet (_TyIns::*mfp)( DEF_TYPE( n ) );								\
+			static _TyRet Invoke( const DelegateSlot * _slot, DEF_VAL( n ) ) {	\
+				const DelegateInvokeObj * _p = (const DelegateInvokeObj *)_slot->m_Buffer; \
+				return (_p->pIns->*_p->mfp)( DEF_ARG( n ) ); }					\
+			static INLINE void Bind( DelegateSlot * _slot, _TyIns * pObj,		\
+				_TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) ) {						\
+				DelegateInvokeObj * _p = (DelegateInvokeObj *)_slot->m_Buffer;	\
+				_p->pIns = pObj;												\
+				_p->mfp = fp;													\
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;				\
+				_slot->m_Manage = NULL;											\
+			}																	\
+		};																		\
+		template < typename _TyIns, typename _TyRet, DEF_PARAM( n ) >			\
+		struct DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE( n ) ) > {		\
+			typedef DelegateFuncStore< _TyIns > TStore;							\
+			static _TyRet Invoke( const DelegateSlot * _slot, DEF_VAL( n ) ) {	\
+				return (_TyRet)(*TStore::Get( _slot ))( DEF_ARG( n ) ); }		\
+			static INLINE void Bind( DelegateSlot * _slot, const _TyIns & rObj ) { \
+				TStore::Create( _slot, rObj );									\
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;				\
+				_slot->m_Manage = &TStore::Manage;								\
+			}																	\
+		};																		\
+		template < typename _TyRet, DEF_PARAM( n ) >							\
+		class Delegate< _TyRet ( DEF_TYPE( n ) ) > : public DelegateStore {		\
+		protected:																\
+			typedef _TyRet (*TInvoke)( const DelegateSlot *, DEF_TYPE( n ) );	\
+		public:																	\
+			DEF_ARGTYPE( n );													\
+			typedef argument_type0 argument_type;								\
+			typedef argument_type0 first_argument_type;							\
+			typedef CHAR_CONNECT(argument_type, n) second_argument_type;		\
+			typedef _TyRet result_type;											\
+			typedef _TyRet (*function_type)(DEF_TYPE( n ));						\
+			Delegate< _TyRet( DEF_TYPE( n ) ) >(								\
+					const Delegate<_TyRet( DEF_TYPE( n ) )> & rhs)				\
+				: DelegateStore( rhs ) { CONSTRUCTURE; }						\
+			Delegate< _TyRet( DEF_TYPE( n ) ) >(								\
+					Delegate<_TyRet( DEF_TYPE( n ) )> & rhs)					\
+				: DelegateStore( rhs ) { CONSTRUCTURE; }						\
+			Delegate<_TyRet( DEF_TYPE( n ) )> & operator = (					\
+				const Delegate<_TyRet( DEF_TYPE( n ) )> & rhs ) {				\
+				DelegateStore::operator = ( rhs );								\
+				return (*this);													\
+			}																	\
+		public:																	\
+			void Add ( _TyRet (*fp)( DEF_TYPE( n ) ) ) {						\
+				if ( fp == NULL ) return;										\
+				DelegateInvokeProc< _TyRet( DEF_TYPE( n ) ) >::Bind(			\
+					this->__NewSlot( ), fp );									\
+			}																	\
+			template <class _TyIns> void Add ( _TyIns * pObj,					\
+				_TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) ) {						\
+				if ( pObj == NULL || fp == NULL ) return;						\
+				DelegateInvokeObj< _TyIns, _TyRet( DEF_TYPE(n) ) >::Bind(		\
+					this->__NewSlot( ), pObj, fp );								\
+			}																	\
+			template <class _TyIns> void Add ( _TyIns & rObj ) {				\
+				DelegateInvokeFuncObj< _TyIns, _TyRet( DEF_TYPE(n) ) >::Bind(	\
+					this->__NewSlot( ), rObj );									\
+			}																	\
+			_TyRet operator () ( DEF_VAL( n ) ) const {							\
+				if ( m_Count > 1 ) {											\
+					((TInvoke)m_First.m_Invoke)( &m_First, DEF_ARG( n ) );		\
+					for ( Uint32 i = 0; i < m_Count - 2; ++i )					\
+						((TInvoke)m_More[i].m_Invoke)( m_More + i, DEF_ARG( n ) ); \
+					return ((TInvoke)m_More[m_Count - 2].m_Invoke)(				\
+						m_More + m_Count - 2, DEF_ARG( n ) );					\
+				}																\
+				return ((TInvoke)m_First.m_Invoke)( &m_First, DEF_ARG( n ) );	\
+			}																	\
+			Delegate< _TyRet( DEF_TYPE( n ) ) > & operator += (					\
+				_TyRet (*fp)( DEF_TYPE( n ) ) ) {								\
+				this->Add(fp);													\
+				return (*this);													\
+			}																	\
+			template < class _TyIns > Delegate< _TyRet ( DEF_TYPE( n ) ) > &	\
+			operator += ( std::pair< _TyIns *,									\
+				_TyRet (_TyIns::*)( DEF_TYPE( n ) ) > pairFp) {					\
+				this->Add(pairFp.first, pairFp.second);							\
+				return (*this);													\
+			}																	\
+			template < class _TyIns > Delegate< _TyRet ( DEF_TYPE( n ) ) > &	\
+				operator += ( _TyIns & rObj ) {									\
+				this->Add( rObj );												\
+				return (*this);													\
+			}																	\
+			Delegate<_TyRet( DEF_TYPE( n ) )> () {CONSTRUCTURE;}				\
+			Delegate<_TyRet( DEF_TYPE( n ) )> ( _TyRet (*fp)( DEF_TYPE( n ) ) ) { \
+				CONSTRUCTURE; this->Add( fp ); }								\
+			template < class _TyIns >											\
+			Delegate<_TyRet( DEF_TYPE( n ) )>(_TyIns * pObj,					\
+				_TyRet (_TyIns::*fp)( DEF_TYPE( n ) ) ) {						\
+				CONSTRUCTURE;													\
+				this->Add(pObj, fp);											\
+			}																	\
+			template < class _TyIns >											\
+			Delegate< _TyRet( DEF_TYPE( n ) ) >(_TyIns & rObj) {				\
+				CONSTRUCTURE; this->Add(rObj); }								\
+			~Delegate< _TyRet( DEF_TYPE( n ) ) >  () { DESTRUCTURE; }			\
 		};
 
 		// Specifial Definition of Non-Parameter Version
 		template < typename _TyRet >
-		struct DelegateInvokeBase< _TyRet() > {
-			virtual _TyRet Invoke () const = 0;
-			virtual DelegateInvokeBase< _TyRet() > * Copy() = 0;
-			virtual ~DelegateInvokeBase< _TyRet() >(){}
-		};
-		template < typename _TyRet >
-		struct DelegateInvokeProc< _TyRet () > 
-			: public DelegateInvokeBase< _TyRet() > {
-			_TyRet (*mfp)();
-			DelegateInvokeProc( ) : mfp( NULL ) { }
-			DelegateInvokeProc( _TyRet (*fp)() ) : mfp(fp) { }
-			DelegateInvokeProc( const DelegateInvokeProc< _TyRet( ) > & rhs )
-				: mfp( rhs.mfp ) { }
-			inline virtual _TyRet Invoke() const { return (*mfp)(); }
-			inline virtual DelegateInvokeBase< _TyRet() > * Copy() { 
-				PCNEWPARAM( DelegateInvokeProc< _TyRet( ) >, p, *this );
-				return p;
+		struct DelegateInvokeProc< _TyRet () > {
+			typedef _TyRet (*TFunc)();
+			static _TyRet Invoke( const DelegateSlot * _slot ) {
+				return (*(*(const TFunc *)_slot->m_Buffer))();
+			}
+			static INLINE void Bind( DelegateSlot * _slot, TFunc fp ) {
+				*(TFunc *)_slot->m_Buffer = fp;
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;
+				_slot->m_Manage = NULL;
 			}
-			virtual ~DelegateInvokeProc< _TyRet() >() { }
 		};
 		template < typename _TyIns, typename _TyRet >
-		struct DelegateInvokeObj<_TyIns, _TyRet()> 
-			: public DelegateInvokeBase< _TyRet() > {
-			_TyRet (_TyIns::*mfp)();
+		struct DelegateInvokeObj<_TyIns, _TyRet()> {
 			_TyIns * pIns;
-			DelegateInvokeObj( ) : mfp( NULL ), pIns( NULL ) { }
-			DelegateInvokeObj(_TyIns * pObj, _TyRet (_TyIns::*fp)()) : mfp(fp), pIns(pObj){ }
-			DelegateInvokeObj( const DelegateInvokeObj< _TyIns, _TyRet( ) > & rhs )
-				: mfp( rhs.mfp ), pIns( rhs.pIns ) { }
-			inline virtual _TyRet Invoke() const { return (pIns->*mfp)(); }
-			inline virtual DelegateInvokeBase< _TyRet() > * Copy() {
-				typedef DelegateInvokeObj< _TyIns, _TyRet( ) > TDelg;
-				PCNEWPARAM( TDelg, p, *this );
-				return p;
+			_TyRet (_TyIns::*mfp)();
+			static _TyRet Invoke( const DelegateSlot * _slot ) {
+				const DelegateInvokeObj * _p = (const DelegateInvokeObj *)_slot->m_Buffer;
+				return (_p->pIns->*_p->mfp)();
+			}
+			static INLINE void Bind( DelegateSlot * _slot, _TyIns * pObj, _TyRet (_TyIns::*fp)() ) {
+				DelegateInvokeObj * _p = (DelegateInvokeObj *)_slot->m_Buffer;
+				_p->pIns = pObj;
+				_p->mfp = fp;
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;
+				_slot->m_Manage = NULL;
 			}
-			virtual ~DelegateInvokeObj<_TyIns, _TyRet()>(){ }
 		};
 		template < typename _TyIns, typename _TyRet >
-		struct DelegateInvokeFuncObj< _TyIns, _TyRet() > 
-			: public DelegateInvokeBase< _TyRet() > {
-			_TyIns pIns;
-			DelegateInvokeFuncObj( ) { }
-			DelegateInvokeFuncObj( _TyIns & rObj ) : pIns(rObj) { } 
-			DelegateInvokeFuncObj( const DelegateInvokeFuncObj< _TyIns, _TyRet( ) > & rhs )
-				: pIns( rhs.pIns ) { }
-			inline virtual _TyRet Invoke( ) const { return (_TyRet)(pIns)( ); }
-			inline virtual DelegateInvokeBase< _TyRet() > * Copy() {
-				typedef DelegateInvokeFuncObj< _TyIns, _TyRet( ) > TDelg;
-				PCNEWPARAM( TDelg, p, *this );
-				return p;
+		struct DelegateInvokeFuncObj< _TyIns, _TyRet() > {
+			typedef DelegateFuncStore< _TyIns > TStore;
+			static _TyRet Invoke( const DelegateSlot * _slot ) {
+				return (_TyRet)(*TStore::Get( _slot ))( );
+			}
+			static INLINE void Bind( DelegateSlot * _slot, const _TyIns & rObj ) {
+				TStore::Create( _slot, rObj );
+				_slot->m_Invoke = (DelegateSlot::InvokeT)&Invoke;
+				_slot->m_Manage = &TStore::Manage;
 			}
-			virtual ~DelegateInvokeFuncObj< _TyIns, _TyRet() >() {}
 		};
-		template < typename _TyRet > class Delegate<_TyRet()> {
+		template < typename _TyRet > class Delegate<_TyRet()> : public DelegateStore {
 		protected:
-			Array< DelegateInvokeBase< _TyRet( ) > * > m_FooList;
+			typedef _TyRet (*TInvoke)( const DelegateSlot * );
 		public:
 			typedef void argument_type;
 			typedef void first_argument_type;
@@ -298,44 +376,29 @@ namespace Plib
 
 			// Copy'str
 			Delegate< _TyRet( ) >(const Delegate<_TyRet()> & rhs) 
-			{
-				CONSTRUCTURE;
-				(*this) = rhs;
-			}
+				: DelegateStore( rhs ) { CONSTRUCTURE; }
+			// Without this, a non-const object goes to the function object version.
+			Delegate< _TyRet( ) >(Delegate<_TyRet()> & rhs)
+				: DelegateStore( rhs ) { CONSTRUCTURE; }
 
 			Delegate< _TyRet() > & operator = (const Delegate<_TyRet()> & rhs) 
 			{
-				if ( this == &rhs ) return *this;
-				for ( unsigned int i = 0; i < m_FooList.Size(); ++i ) {
-					PDELETE( m_FooList[i] );
-				}
-				this->m_FooList.Clear();
-				for ( unsigned int i = 0; i < rhs.m_FooList.Size(); ++i )
-					m_FooList.PushBack(rhs.m_FooList[i]->Copy());
+				DelegateStore::operator = ( rhs );
 				return (*this);
 			}
 		public:
 			void Add(_TyRet (*fp)()) {
 				if ( fp == NULL ) return;
-				PCNEW( DelegateInvokeProc< _TyRet( ) >, pDelg );
-				pDelg->mfp = fp;
-				this->m_FooList.PushBack( pDelg );
+				DelegateInvokeProc< _TyRet( ) >::Bind( this->__NewSlot( ), fp );
 			}
 			template < class _TyIns >
 			void Add(_TyIns * pObj, _TyRet (_TyIns::*fp)()) {
 				if ( pObj == NULL || fp == NULL ) return;
-				typedef DelegateInvokeObj< _TyIns, _TyRet( ) > TDelg;
-				PCNEW( TDelg, pDelg );
-				pDelg->pIns = pObj;
-				pDelg->mfp = fp;
-				this->m_FooList.PushBack( pDelg );
+				DelegateInvokeObj< _TyIns, _TyRet( ) >::Bind( this->__NewSlot( ), pObj, fp );
 			}
 			template < class _TyIns >
 			void Add( _TyIns & rObj ) { 
-				typedef DelegateInvokeObj< _TyIns, _TyRet( ) > TDelg;
-				PCNEW( TDelg, pDelg );
-				pDelg->pIns = rObj;
-				this->m_FooList.PushBack( pDelg );
+				DelegateInvokeFuncObj< _TyIns, _TyRet( ) >::Bind( this->__NewSlot( ), rObj );
 			}
 			Delegate<_TyRet( )>() { CONSTRUCTURE; }
 			Delegate< _TyRet () >(_TyRet (*fp)()) { CONSTRUCTURE; this->Add(fp); }
@@ -347,26 +410,15 @@ namespace Plib
 				CONSTRUCTURE;
 				this->Add( rObj );
 			}
-			operator bool ( ) const {
-				return this->m_FooList.Size() != 0;
-			}
-			~Delegate< _TyRet( ) >() { 
-				DESTRUCTURE;
-				for (unsigned int i = 0; i < m_FooList.Size(); ++i ) {
-					PDELETE( m_FooList[i] );
-				}
-				m_FooList.Clear();
-			}
-			_TyRet operator ()() {
-				//_TyRet rtn;
-				for ( unsigned int i = 0; i < m_FooList.Size() - 1; 
-					m_FooList[i++]->Invoke() );
-				return m_FooList[m_FooList.Size() - 1]->Invoke();
-			}
+			~Delegate< _TyRet( ) >() { DESTRUCTURE; }
 			_TyRet operator ()() const {
-				for ( Uint32 i = 0; i < m_FooList.Size() - 1;
-					m_FooList[i++]->Invoke() );
-				return m_FooList[m_FooList.Size() - 1]->Invoke();
+				if ( m_Count > 1 ) {
+					((TInvoke)m_First.m_Invoke)( &m_First );
+					for ( Uint32 i = 0; i < m_Count - 2; ++i )
+						((TInvoke)m_More[i].m_Invoke)( m_More + i );
+					return ((TInvoke)m_More[m_Count - 2].m_Invoke)( m_More + m_Count - 2 );
+				}
+				return ((TInvoke)m_First.m_Invoke)( &m_First );
 			}
 			Delegate< _TyRet() > & operator += (_TyRet (*fp)()) {
 				this->Add(fp);
@@ -381,13 +433,6 @@ namespace Plib
 				this->Add(rObj);
 				return (*this);
 			}
-			unsigned int Count() const { return m_FooList.Size(); }
-			void Clear() { 
-				for ( unsigned int i = 0; i < m_FooList.Size(); ++i ) {
-					PDELETE( m_FooList[i] );
-				}
-				m_FooList.Clear(); 
-			}
 		};
 
 		_DELEGATE_BASIC_DEFINITION_COMMON_(0)
@@ -27,6 +27,8 @@
 #include "Delegate.hpp"
 #include "Pool.hpp"
 #include "ArrayList.hpp"
+#include "Vector.hpp"
+#include "LockFreeQueue.hpp"
 #include "Order.hpp"
 #include "Merge.hpp"
 #include "Operator.hpp"
@@ -41,6 +43,8 @@
 #include <Plib-Generic/Delegate.hpp>
 #include <Plib-Generic/Pool.hpp>
 #include <Plib-Generic/ArrayList.hpp>
+#include <Plib-Generic/Vector.hpp>
+#include <Plib-Generic/LockFreeQueue.hpp>
 #include <Plib-Generic/Order.hpp>
 #include <Plib-Generic/Merge.hpp>
 #include <Plib-Generic/Operator.hpp>
@@ -0,0 +1,693 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: LockFreeQueue.hpp
+* Propose  			: Lock free SPSC/MPSC/MPMC queues, work stealing deque and
+*					  the futex blocking wrapper.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_GENERIC_LOCKFREEQUEUE_HPP_
+#define _PLIB_GENERIC_LOCKFREEQUEUE_HPP_
+
+#if _DEF_IOS
+#include "Allocator.hpp"
+#include "Atomic.hpp"
+#else
+#include <Plib-Basic/Allocator.hpp>
+#include <Plib-Basic/Atomic.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Generic
+	{
+		using Plib::Basic::AtomicLoad;
+		using Plib::Basic::AtomicStore;
+		using Plib::Basic::AtomicCompareExchange;
+		using Plib::Basic::AtomicExchange;
+		using Plib::Basic::AtomicFetchAdd;
+		using Plib::Basic::AtomicFetchSub;
+		using Plib::Basic::AO_RELAXED;
+		using Plib::Basic::AO_ACQUIRE;
+		using Plib::Basic::AO_RELEASE;
+		using Plib::Basic::AO_ACQ_REL;
+		using Plib::Basic::AO_SEQ_CST;
+
+		// Round the capacity up to power of 2, so the index is a mask.
+		INLINE Uint32 __RingCapacity( Uint32 _capacity )
+		{
+			Uint32 _size = 2;
+			while ( _size < _capacity && _size < 0x80000000 ) _size <<= 1;
+			return _size;
+		}
+
+		/*
+		 * Bounded ring for one producer thread and one consumer thread.
+		 * Head is only written by the consumer and tail only by the producer,
+		 * each side keeps a cache of the other index so most operations do
+		 * not touch the other side's cache line.
+		 * PushN/PopN publish the whole batch with one index store.
+		 */
+		template < typename _TyObject >
+		class SpscQueue
+		{
+		public:
+			typedef _TyObject				TObject;
+
+		protected:
+			_TyObject *						m_Ring;
+			Uint32							m_Mask;
+			PLIB_CACHELINE_PAD( m_Pad0, _TyObject * );
+
+			// Consumer side.
+			volatile Uint32					m_Head;
+			Uint32							m_TailCache;
+			PLIB_CACHELINE_PAD( m_Pad1, Uint64 );
+
+			// Producer side.
+			volatile Uint32					m_Tail;
+			Uint32							m_HeadCache;
+			PLIB_CACHELINE_PAD( m_Pad2, Uint64 );
+
+			// Free slots can be written by producer.
+			INLINE Uint32 __FreeCount( Uint32 _tail )
+			{
+				Uint32 _free = m_Mask + 1 - (_tail - m_HeadCache);
+				if ( _free == 0 ) {
+					m_HeadCache = AtomicLoad( &m_Head, AO_ACQUIRE );
+					_free = m_Mask + 1 - (_tail - m_HeadCache);
+				}
+				return _free;
+			}
+
+			// Objects can be read by consumer.
+			INLINE Uint32 __ReadyCount( Uint32 _head )
+			{
+				Uint32 _ready = m_TailCache - _head;
+				if ( _ready == 0 ) {
+					m_TailCache = AtomicLoad( &m_Tail, AO_ACQUIRE );
+					_ready = m_TailCache - _head;
+				}
+				return _ready;
+			}
+
+		private:
+			// No copy.
+			SpscQueue< _TyObject >( const SpscQueue< _TyObject > & );
+			SpscQueue< _TyObject > & operator = ( const SpscQueue< _TyObject > & );
+
+		public:
+			SpscQueue< _TyObject >( Uint32 _capacity = 1024 )
+				: m_Ring( NULL ), m_Mask( __RingCapacity(_capacity) - 1 ),
+				m_Head( 0 ), m_TailCache( 0 ), m_Tail( 0 ), m_HeadCache( 0 )
+			{
+				CONSTRUCTURE;
+				PMALLOC( _TyObject, m_Ring, sizeof(_TyObject) * (m_Mask + 1) );
+			}
+			~SpscQueue< _TyObject >( )
+			{
+				DESTRUCTURE;
+				for ( Uint32 i = m_Head; i != m_Tail; ++i )
+					m_Ring[i & m_Mask].~_TyObject( );
+				PFREE( m_Ring );
+			}
+
+			// Return false when the queue is full.
+			INLINE bool Push( const _TyObject & _obj )
+			{
+				Uint32 _tail = m_Tail;
+				if ( __FreeCount( _tail ) == 0 ) return false;
+				new ((void *)(m_Ring + (_tail & m_Mask))) _TyObject( _obj );
+				AtomicStore( &m_Tail, _tail + 1, AO_RELEASE );
+				return true;
+			}
+
+			// Push at most _count objects, return the pushed count.
+			INLINE Uint32 PushN( const _TyObject * _objs, Uint32 _count )
+			{
+				Uint32 _tail = m_Tail;
+				Uint32 _free = __FreeCount( _tail );
+				if ( _count > _free ) _count = _free;
+				for ( Uint32 i = 0; i < _count; ++i )
+					new ((void *)(m_Ring + ((_tail + i) & m_Mask))) _TyObject( _objs[i] );
+				if ( _count > 0 ) AtomicStore( &m_Tail, _tail + _count, AO_RELEASE );
+				return _count;
+			}
+
+			// Return false when the queue is empty.
+			INLINE bool Pop( _TyObject & _obj )
+			{
+				Uint32 _head = m_Head;
+				if ( __ReadyCount( _head ) == 0 ) return false;
+				_TyObject & _slot = m_Ring[_head & m_Mask];
+			#if PLIB_RVALUE_REF
+				_obj = std::move( _slot );
+			#else
+				_obj = _slot;
+			#endif
+				_slot.~_TyObject( );
+				AtomicStore( &m_Head, _head + 1, AO_RELEASE );
+				return true;
+			}
+
+			// Pop at most _count objects, return the popped count.
+			INLINE Uint32 PopN( _TyObject * _objs, Uint32 _count )
+			{
+				Uint32 _head = m_Head;
+				Uint32 _ready = __ReadyCount( _head );
+				if ( _count > _ready ) _count = _ready;
+				for ( Uint32 i = 0; i < _count; ++i ) {
+					_TyObject & _slot = m_Ring[(_head + i) & m_Mask];
+				#if PLIB_RVALUE_REF
+					_objs[i] = std::move( _slot );
+				#else
+					_objs[i] = _slot;
+				#endif
+					_slot.~_TyObject( );
+				}
+				if ( _count > 0 ) AtomicStore( &m_Head, _head + _count, AO_RELEASE );
+				return _count;
+			}
+
+			// The size may be changed by the other side at any time.
+			INLINE Uint32 Size( ) const {
+				return AtomicLoad( &m_Tail, AO_ACQUIRE ) - AtomicLoad( &m_Head, AO_ACQUIRE );
+			}
+			INLINE bool Empty( ) const { return Size( ) == 0; }
+			INLINE Uint32 Capacity( ) const { return m_Mask + 1; }
+		};
+
+		// The node must be the base class of the object put in MpscQueue.
+		struct MpscNode
+		{
+			MpscNode * volatile				m_Next;
+			MpscNode( ) : m_Next( NULL ) { }
+		};
+
+		/*
+		 * Unbounded intrusive queue, many producers and one consumer.
+		 * (Dmitry Vyukov's algorithm). Push is one atomic exchange and
+		 * never fails, no memory is allocated by the queue.
+		 * The queue does not own the nodes.
+		 * Pop may return NULL while a producer is between the exchange and
+		 * linking the node, the object will be seen by the next Pop.
+		 */
+		template < typename _TyNode >
+		class MpscQueue
+		{
+		public:
+			typedef _TyNode *				TObject;
+
+		protected:
+			// Producer side, the last pushed node.
+			MpscNode * volatile				m_Head;
+			PLIB_CACHELINE_PAD( m_Pad0, MpscNode * );
+
+			// Consumer side, the next node to pop.
+			MpscNode *						m_Tail;
+			MpscNode						m_Stub;
+			PLIB_CACHELINE_PAD( m_Pad1, MpscNode * [2] );
+
+			// Link the chain [_first, _last] to the head.
+			INLINE void __PushChain( MpscNode * _first, MpscNode * _last )
+			{
+				AtomicStore( &_last->m_Next, (MpscNode *)NULL, AO_RELAXED );
+				MpscNode * _prev = AtomicExchange( &m_Head, _last, AO_ACQ_REL );
+				AtomicStore( &_prev->m_Next, _first, AO_RELEASE );
+			}
+
+		private:
+			MpscQueue< _TyNode >( const MpscQueue< _TyNode > & );
+			MpscQueue< _TyNode > & operator = ( const MpscQueue< _TyNode > & );
+
+		public:
+			MpscQueue< _TyNode >( ) : m_Head( &m_Stub ), m_Tail( &m_Stub )
+			{
+				CONSTRUCTURE;
+			}
+			~MpscQueue< _TyNode >( ) { DESTRUCTURE; }
+
+			INLINE bool Push( _TyNode * _node )
+			{
+				MpscNode * _n = _node;
+				__PushChain( _n, _n );
+				return true;
+			}
+
+			// Push all the nodes with one exchange, the batch keeps its order.
+			INLINE Uint32 PushN( _TyNode * const * _nodes, Uint32 _count )
+			{
+				if ( _count == 0 ) return 0;
+				for ( Uint32 i = 0; i + 1 < _count; ++i ) {
+					AtomicStore( &(static_cast< MpscNode * >(_nodes[i])->m_Next),
+						static_cast< MpscNode * >(_nodes[i + 1]), AO_RELAXED );
+				}
+				__PushChain( _nodes[0], _nodes[_count - 1] );
+				return _count;
+			}
+
+			// Only the consumer thread can pop.
+			INLINE _TyNode * Pop( )
+			{
+				MpscNode * _tail = m_Tail;
+				MpscNode * _next = AtomicLoad( &_tail->m_Next, AO_ACQUIRE );
+				if ( _tail == &m_Stub ) {
+					if ( _next == NULL ) return NULL;
+					m_Tail = _next;
+					_tail = _next;
+					_next = AtomicLoad( &_tail->m_Next, AO_ACQUIRE );
+				}
+				if ( _next != NULL ) {
+					m_Tail = _next;
+					return static_cast< _TyNode * >(_tail);
+				}
+				// The last node, someone may be pushing.
+				if ( _tail != AtomicLoad( &m_Head, AO_ACQUIRE ) ) return NULL;
+				// Put the stub back so the last node can be taken.
+				__PushChain( &m_Stub, &m_Stub );
+				_next = AtomicLoad( &_tail->m_Next, AO_ACQUIRE );
+				if ( _next == NULL ) return NULL;
+				m_Tail = _next;
+				return static_cast< _TyNode * >(_tail);
+			}
+
+			INLINE bool Pop( _TyNode * & _node )
+			{
+				_node = this->Pop( );
+				return _node != NULL;
+			}
+
+			INLINE Uint32 PopN( _TyNode ** _nodes, Uint32 _count )
+			{
+				Uint32 _popped = 0;
+				while ( _popped < _count && (_nodes[_popped] = this->Pop( )) != NULL )
+					++_popped;
+				return _popped;
+			}
+
+			// Only valid in consumer thread.
+			INLINE bool Empty( ) const
+			{
+				return m_Tail == AtomicLoad( &m_Head, AO_ACQUIRE ) &&
+					AtomicLoad( &m_Tail->m_Next, AO_ACQUIRE ) == NULL;
+			}
+		};
+
+		/*
+		 * Bounded ring for many producers and many consumers.
+		 * (Dmitry Vyukov's algorithm). Each slot has a sequence number,
+		 * a slot is free for position p when sequence is p, and ready to be
+		 * read when sequence is p + 1.
+		 * PushN/PopN check the whole batch and claim it with one CAS.
+		 */
+		template < typename _TyObject >
+		class MpmcQueue
+		{
+		public:
+			typedef _TyObject				TObject;
+
+		protected:
+			_TyObject *						m_Ring;
+			volatile Uint32 *				m_Sequence;
+			Uint32							m_Mask;
+			PLIB_CACHELINE_PAD( m_Pad0, _TyObject * [2] );
+
+			volatile Uint32					m_Tail;
+			PLIB_CACHELINE_PAD( m_Pad1, Uint32 );
+
+			volatile Uint32					m_Head;
+			PLIB_CACHELINE_PAD( m_Pad2, Uint32 );
+
+			// Claim at most _count continuous positions.
+			// _offset is 0 for producer, and 1 for consumer.
+			INLINE Uint32 __Claim( volatile Uint32 * _index, Uint32 _offset,
+				Uint32 _count, Uint32 & _pos )
+			{
+				_pos = AtomicLoad( _index, AO_RELAXED );
+				for ( ;; ) {
+					Uint32 _ready = 0;
+					bool _moved = false;
+					while ( _ready < _count ) {
+						Uint32 _p = _pos + _ready;
+						Int32 _diff = (Int32)(AtomicLoad( m_Sequence + (_p & m_Mask),
+							AO_ACQUIRE ) - (_p + _offset));
+						if ( _diff == 0 ) { ++_ready; continue; }
+						// Someone else has taken the position.
+						if ( _diff > 0 && _ready == 0 ) _moved = true;
+						break;
+					}
+					if ( _moved ) {
+						_pos = AtomicLoad( _index, AO_RELAXED );
+						continue;
+					}
+					if ( _ready == 0 ) return 0;
+					if ( AtomicCompareExchange( _index, _pos, _pos + _ready, AO_RELAXED ) )
+						return _ready;
+				}
+			}
+
+		private:
+			MpmcQueue< _TyObject >( const MpmcQueue< _TyObject > & );
+			MpmcQueue< _TyObject > & operator = ( const MpmcQueue< _TyObject > & );
+
+		public:
+			MpmcQueue< _TyObject >( Uint32 _capacity = 1024 )
+				: m_Ring( NULL ), m_Sequence( NULL ),
+				m_Mask( __RingCapacity(_capacity) - 1 ), m_Tail( 0 ), m_Head( 0 )
+			{
+				CONSTRUCTURE;
+				PMALLOC( _TyObject, m_Ring, sizeof(_TyObject) * (m_Mask + 1) );
+				PMALLOC( volatile Uint32, m_Sequence, sizeof(Uint32) * (m_Mask + 1) );
+				for ( Uint32 i = 0; i <= m_Mask; ++i ) m_Sequence[i] = i;
+			}
+			~MpmcQueue< _TyObject >( )
+			{
+				DESTRUCTURE;
+				for ( Uint32 i = m_Head; i != m_Tail; ++i )
+					m_Ring[i & m_Mask].~_TyObject( );
+				PFREE( m_Ring );
+				PFREE( (void *)m_Sequence );
+			}
+
+			INLINE bool Push( const _TyObject & _obj )
+			{
+				return PushN( &_obj, 1 ) == 1;
+			}
+
+			INLINE Uint32 PushN( const _TyObject * _objs, Uint32 _count )
+			{
+				Uint32 _pos;
+				_count = __Claim( &m_Tail, 0, _count, _pos );
+				for ( Uint32 i = 0; i < _count; ++i ) {
+					Uint32 _p = _pos + i;
+					new ((void *)(m_Ring + (_p & m_Mask))) _TyObject( _objs[i] );
+					AtomicStore( m_Sequence + (_p & m_Mask), _p + 1, AO_RELEASE );
+				}
+				return _count;
+			}
+
+			INLINE bool Pop( _TyObject & _obj )
+			{
+				return PopN( &_obj, 1 ) == 1;
+			}
+
+			INLINE Uint32 PopN( _TyObject * _objs, Uint32 _count )
+			{
+				Uint32 _pos;
+				_count = __Claim( &m_Head, 1, _count, _pos );
+				for ( Uint32 i = 0; i < _count; ++i ) {
+					Uint32 _p = _pos + i;
+					_TyObject & _slot = m_Ring[_p & m_Mask];
+				#if PLIB_RVALUE_REF
+					_objs[i] = std::move( _slot );
+				#else
+					_objs[i] = _slot;
+				#endif
+					_slot.~_TyObject( );
+					AtomicStore( m_Sequence + (_p & m_Mask), _p + m_Mask + 1, AO_RELEASE );
+				}
+				return _count;
+			}
+
+			// Approximate size.
+			INLINE Uint32 Size( ) const {
+				Uint32 _head = AtomicLoad( &m_Head, AO_ACQUIRE );
+				Uint32 _tail = AtomicLoad( &m_Tail, AO_ACQUIRE );
+				return ((Int32)(_tail - _head) > 0) ? (_tail - _head) : 0;
+			}
+			INLINE bool Empty( ) const { return Size( ) == 0; }
+			INLINE Uint32 Capacity( ) const { return m_Mask + 1; }
+		};
+
+		/*
+		 * Work stealing deque (Chase-Lev, with the C11 memory order fix
+		 * of Le et al.). The owner thread pushes and takes at the bottom,
+		 * any other thread can steal from the top.
+		 * The object must be a pointer or an integer, the slots are read
+		 * by the thieves while the owner is writing other slots.
+		 * The ring grows when full, old rings are kept until the deque
+		 * is destroyed because a thief may still be reading them.
+		 */
+		template < typename _TyObject >
+		class WorkStealingDeque
+		{
+		public:
+			typedef _TyObject				TObject;
+
+		protected:
+			struct __Ring
+			{
+				Uint32						m_Mask;
+				_TyObject volatile *		m_Slots;
+				__Ring *					m_Prev;
+			};
+
+			volatile Uint32					m_Top;
+			PLIB_CACHELINE_PAD( m_Pad0, Uint32 );
+
+			volatile Uint32					m_Bottom;
+			__Ring * volatile				m_Ring;
+			PLIB_CACHELINE_PAD( m_Pad1, Uint64 );
+
+			static INLINE __Ring * __CreateRing( Uint32 _capacity, __Ring * _prev )
+			{
+				__Ring * _ring;
+				PNEW( __Ring, _ring );
+				_ring->m_Mask = _capacity - 1;
+				PMALLOC( _TyObject volatile, _ring->m_Slots, sizeof(_TyObject) * _capacity );
+				_ring->m_Prev = _prev;
+				return _ring;
+			}
+
+			// Double the ring, copy the objects in [_top, _bottom).
+			INLINE __Ring * __Grow( __Ring * _ring, Uint32 _bottom, Uint32 _top )
+			{
+				__Ring * _newRing = __CreateRing( (_ring->m_Mask + 1) * 2, _ring );
+				for ( Uint32 i = _top; i != _bottom; ++i ) {
+					_newRing->m_Slots[i & _newRing->m_Mask] =
+						AtomicLoad( _ring->m_Slots + (i & _ring->m_Mask), AO_RELAXED );
+				}
+				AtomicStore( &m_Ring, _newRing, AO_RELEASE );
+				return _newRing;
+			}
+
+		private:
+			WorkStealingDeque< _TyObject >( const WorkStealingDeque< _TyObject > & );
+			WorkStealingDeque< _TyObject > & operator = ( const WorkStealingDeque< _TyObject > & );
+
+		public:
+			WorkStealingDeque< _TyObject >( Uint32 _capacity = 256 )
+				: m_Top( 0 ), m_Bottom( 0 ), m_Ring( NULL )
+			{
+				CONSTRUCTURE;
+				m_Ring = __CreateRing( __RingCapacity( _capacity ), NULL );
+			}
+			~WorkStealingDeque< _TyObject >( )
+			{
+				DESTRUCTURE;
+				__Ring * _ring = m_Ring;
+				while ( _ring != NULL ) {
+					__Ring * _prev = _ring->m_Prev;
+					PFREE( (void *)_ring->m_Slots );
+					PDELETE( _ring );
+					_ring = _prev;
+				}
+			}
+
+			// Owner only.
+			INLINE void Push( _TyObject _obj )
+			{
+				Uint32 _bottom = AtomicLoad( &m_Bottom, AO_RELAXED );
+				Uint32 _top = AtomicLoad( &m_Top, AO_ACQUIRE );
+				__Ring * _ring = AtomicLoad( &m_Ring, AO_RELAXED );
+				if ( _bottom - _top > _ring->m_Mask ) _ring = __Grow( _ring, _bottom, _top );
+				AtomicStore( _ring->m_Slots + (_bottom & _ring->m_Mask), _obj, AO_RELAXED );
+				Plib::Basic::AtomicFence( AO_RELEASE );
+				AtomicStore( &m_Bottom, _bottom + 1, AO_RELAXED );
+			}
+
+			// Owner only, take the last pushed object.
+			INLINE bool Take( _TyObject & _obj )
+			{
+				Uint32 _bottom = AtomicLoad( &m_Bottom, AO_RELAXED ) - 1;
+				__Ring * _ring = AtomicLoad( &m_Ring, AO_RELAXED );
+				AtomicStore( &m_Bottom, _bottom, AO_RELAXED );
+				Plib::Basic::AtomicFence( AO_SEQ_CST );
+				Uint32 _top = AtomicLoad( &m_Top, AO_RELAXED );
+				Int32 _size = (Int32)(_bottom - _top);
+				if ( _size < 0 ) {
+					// Empty.
+					AtomicStore( &m_Bottom, _bottom + 1, AO_RELAXED );
+					return false;
+				}
+				_obj = AtomicLoad( _ring->m_Slots + (_bottom & _ring->m_Mask), AO_RELAXED );
+				if ( _size > 0 ) return true;
+				// The last one, race with the thieves.
+				bool _won = AtomicCompareExchange( &m_Top, _top, _top + 1, AO_SEQ_CST );
+				AtomicStore( &m_Bottom, _bottom + 1, AO_RELAXED );
+				return _won;
+			}
+
+			// Any thread, take the first pushed object.
+			// Return false when empty or lost the race with others.
+			INLINE bool Steal( _TyObject & _obj )
+			{
+				Uint32 _top = AtomicLoad( &m_Top, AO_ACQUIRE );
+				Plib::Basic::AtomicFence( AO_SEQ_CST );
+				Uint32 _bottom = AtomicLoad( &m_Bottom, AO_ACQUIRE );
+				if ( (Int32)(_bottom - _top) <= 0 ) return false;
+				__Ring * _ring = AtomicLoad( &m_Ring, AO_ACQUIRE );
+				_obj = AtomicLoad( _ring->m_Slots + (_top & _ring->m_Mask), AO_RELAXED );
+				return AtomicCompareExchange( &m_Top, _top, _top + 1, AO_SEQ_CST );
+			}
+
+			// Approximate size.
+			INLINE Uint32 Size( ) const
+			{
+				Int32 _size = (Int32)(AtomicLoad( &m_Bottom, AO_ACQUIRE ) -
+					AtomicLoad( &m_Top, AO_ACQUIRE ));
+				return (_size > 0) ? (Uint32)_size : 0;
+			}
+			INLINE bool Empty( ) const { return Size( ) == 0; }
+		};
+
+		/*
+		 * Blocking wrapper of SpscQueue, MpscQueue and MpmcQueue.
+		 * Each side has an event counter, the waiting thread sleeps on the
+		 * counter by futex and the other side only makes the wake up system
+		 * call when someone is waiting, so the fast path is still lock free.
+		 * The timeout is in mile seconds, as the other waits of the library.
+		 */
+		template < typename _TyQueue >
+		class BlockingQueue : public _TyQueue
+		{
+		public:
+			typedef _TyQueue						TFather;
+			typedef typename _TyQueue::TObject		TObject;
+			enum { INFINITE_WAIT = 0xFFFFFFFF };
+
+		protected:
+			volatile Int32					m_NotEmptyEvent;
+			volatile Int32					m_PopWaiters;
+			PLIB_CACHELINE_PAD( m_Pad0, Uint64 );
+
+			volatile Int32					m_NotFullEvent;
+			volatile Int32					m_PushWaiters;
+			PLIB_CACHELINE_PAD( m_Pad1, Uint64 );
+
+			INLINE void __Notify( volatile Int32 * _event, volatile Int32 * _waiters, Int32 _count )
+			{
+				// Pairs with the waiter count increasing in __Wait, either we see
+				// the waiter or the waiter sees the new object.
+				Plib::Basic::AtomicFence( AO_SEQ_CST );
+				if ( AtomicLoad( _waiters, AO_RELAXED ) == 0 ) return;
+				AtomicFetchAdd( _event, (Int32)1, AO_SEQ_CST );
+				Plib::Basic::FutexWake( _event, _count );
+			}
+
+			// Wait on the event until _try succeed or time out.
+			template < typename _TyTry >
+			INLINE bool __Wait( volatile Int32 * _event, volatile Int32 * _waiters,
+				Uint32 _timeout, _TyTry _try )
+			{
+				Uint64 _deadline = 0;
+				if ( _timeout != INFINITE_WAIT )
+					_deadline = Plib::Basic::MonotonicMicroSeconds( ) + (Uint64)_timeout * 1000;
+				for ( ;; ) {
+					Int32 _ev = AtomicLoad( _event, AO_ACQUIRE );
+					AtomicFetchAdd( _waiters, (Int32)1, AO_SEQ_CST );
+					if ( _try( this ) ) {
+						AtomicFetchSub( _waiters, (Int32)1, AO_RELAXED );
+						return true;
+					}
+					Uint64 _rel = (Uint64)-1;
+					if ( _timeout != INFINITE_WAIT ) {
+						Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+						_rel = (_now >= _deadline) ? 0 : _deadline - _now;
+					}
+					if ( _rel != 0 ) Plib::Basic::FutexWait( _event, _ev, _rel );
+					AtomicFetchSub( _waiters, (Int32)1, AO_RELAXED );
+					if ( _rel == 0 ) return _try( this );
+				}
+			}
+
+			// Bind the argument of push/pop for __Wait.
+			struct __TryPush {
+				const TObject & _obj;
+				__TryPush( const TObject & _o ) : _obj( _o ) { }
+				bool operator( ) ( BlockingQueue * _q ) { return _q->TFather::Push( _obj ); }
+			};
+			struct __TryPop {
+				TObject & _obj;
+				__TryPop( TObject & _o ) : _obj( _o ) { }
+				bool operator( ) ( BlockingQueue * _q ) { return _q->TFather::Pop( _obj ); }
+			};
+
+		public:
+			BlockingQueue< _TyQueue >( )
+				: TFather( ), m_NotEmptyEvent( 0 ), m_PopWaiters( 0 ),
+				m_NotFullEvent( 0 ), m_PushWaiters( 0 ) { }
+			BlockingQueue< _TyQueue >( Uint32 _capacity )
+				: TFather( _capacity ), m_NotEmptyEvent( 0 ), m_PopWaiters( 0 ),
+				m_NotFullEvent( 0 ), m_PushWaiters( 0 ) { }
+
+			// Wait when the queue is full, return false on time out.
+			INLINE bool Push( const TObject & _obj, Uint32 _timeout = INFINITE_WAIT )
+			{
+				if ( !TFather::Push( _obj ) &&
+					!__Wait( &m_NotFullEvent, &m_PushWaiters, _timeout, __TryPush( _obj ) ) )
+					return false;
+				__Notify( &m_NotEmptyEvent, &m_PopWaiters, 1 );
+				return true;
+			}
+
+			// Wait when the queue is empty, return false on time out.
+			INLINE bool Pop( TObject & _obj, Uint32 _timeout = INFINITE_WAIT )
+			{
+				if ( !TFather::Pop( _obj ) &&
+					!__Wait( &m_NotEmptyEvent, &m_PopWaiters, _timeout, __TryPop( _obj ) ) )
+					return false;
+				__Notify( &m_NotFullEvent, &m_PushWaiters, 1 );
+				return true;
+			}
+
+			// Batch operations never wait.
+			INLINE Uint32 PushN( const TObject * _objs, Uint32 _count )
+			{
+				_count = TFather::PushN( _objs, _count );
+				if ( _count > 0 ) __Notify( &m_NotEmptyEvent, &m_PopWaiters, (Int32)_count );
+				return _count;
+			}
+			INLINE Uint32 PopN( TObject * _objs, Uint32 _count )
+			{
+				_count = TFather::PopN( _objs, _count );
+				if ( _count > 0 ) __Notify( &m_NotFullEvent, &m_PushWaiters, (Int32)_count );
+				return _count;
+			}
+
+			// Wake all waiting threads, they will check the queue again.
+			INLINE void WakeAll( )
+			{
+				__Notify( &m_NotEmptyEvent, &m_PopWaiters, 0x7FFFFFFF );
+				__Notify( &m_NotFullEvent, &m_PushWaiters, 0x7FFFFFFF );
+			}
+		};
+	}
+}
+
+#endif // plib.generic.lockfreequeue.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
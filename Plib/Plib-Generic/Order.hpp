@@ -51,17 +51,6 @@ namespace Plib
 			PLIB_THREAD_SAFE_DEFINE;
 		protected:
 				
-			// If the array is sorted, you can invoke this method
-			// to check if the given object is in the specified storage.
-			INLINE Uint32 __IsObjectIn( const _TyObject & _vobj, Uint32 _storageId ) {
-				typename TFather::PSTORAGE_T _ps = TFather::__GetStorage( _storageId );
-				bool _checkFirst = m_Comp( *(_ps->operator[] (0)), _vobj );
-				bool _checkLast = m_Comp( *(_ps->operator[] (_ps->Count() - 1)), _vobj );
-				
-				return ( _checkFirst && _checkLast ) ? 1 
-					: (_checkFirst || _checkLast) ? 0 : -1;
-			}
-
 			INLINE Uint32 __Binary( 
 					const _TyObject & _vobj, 
 					const typename TFather::STORAGE_T & storage, 
@@ -87,22 +76,24 @@ namespace Plib
 				return _beforeCount + __Binary( _vobj, *pStorage, 0, pStorage->Count() );
 			}
 			
+			// Find the first storage in [_begin, _end) whose last object
+			// is not less than _vobj, then search inside it.
+			// Return the position to insert _vobj.
 			INLINE Uint32 __BinarySearch( 
 				const _TyObject & _vobj, 
 				Uint32 _begin, 
 				Uint32 _end 
 			) {
-				Uint32 _halfStorage = (_begin + _end) / 2;
-				if ( _halfStorage == _begin ) return __BinaryFind( _vobj, _begin );
-				//if ( _halfStorage == _end ) return __BinaryFind( _vobj, _end );
-				
-				// Search.
-				int _halfRet = __IsObjectIn( _vobj, _halfStorage );
-				if ( _halfRet == 0 ) return __BinaryFind( _vobj, _halfStorage );
-				if ( _halfRet > 0 ) return __BinarySearch( _vobj, _halfStorage + 1, _end );
-				if ( _halfRet < 0 ) return __BinarySearch( _vobj, _begin, _halfStorage - 1 );
-				
-				return 0;
+				while ( _begin < _end ) {
+					Uint32 _halfStorage = (_begin + _end) / 2;
+					typename TFather::PSTORAGE_T _ps = TFather::__GetStorage( _halfStorage );
+					if ( m_Comp( *(*_ps)[_ps->Count() - 1], _vobj ) ) _begin = _halfStorage + 1;
+					else _end = _halfStorage;
+				}
+				if ( _begin >= TFather::m_CacheUsed || 
+					TFather::__GetStorage( _begin )->Count() == 0 ) 
+					return TFather::m_AllSize;
+				return __BinaryFind( _vobj, _begin );
 			}
 		public:
 			// Default C'Str.
@@ -130,7 +121,8 @@ namespace Plib
 			}
 			
 			// Find if the object is in the list.
-			// This method is not very effective.
+			// Binary search on the storages, then the block index
+			// gives the position, O(log n).
 			INLINE Uint32 Find( const _TyObject & _vobj ) {
 				PLIB_THREAD_SAFE;
 				if ( TFather::m_AllSize == 0 ) return (Uint32)-1;
@@ -139,7 +131,7 @@ namespace Plib
 					TFather::m_CacheUsed: 
 					TFather::m_CacheUsed - 1;
 				Uint32 _pos = __BinarySearch( _vobj, _start, _end );
-				if ( TFather::__Get( _pos ) == _vobj ) return _pos;
+				if ( _pos < TFather::m_AllSize && TFather::__Get( _pos ) == _vobj ) return _pos;
 				return (Uint32)-1;
 			}
 			
@@ -163,7 +155,7 @@ namespace Plib
 			
 			template < typename _TyIterator >
 			INLINE void SortInsert( _TyIterator _begin, _TyIterator _end ) {
-				for ( ; _begin != _end; ++_begin ) this->Sortisert( *_begin );
+				for ( ; _begin != _end; ++_begin ) this->SortInsert( *_begin );
 			}
 			
 			// Non-const version. return the copy of the object.
@@ -238,7 +230,7 @@ namespace Plib
 				TFather::_Handle->_PHandle->Append( _begin, _end ); }
 				
 			// Find if the object is in the list.
-			// This method is not very effective.
+			// Binary search on the storages, O(log n).
 			INLINE Uint32 Find( const _TyObject & _vobj ) {
 				return TFather::_Handle->_PHandle->Find( _vobj ); }
 				
@@ -0,0 +1,574 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Vector.hpp
+* Propose  			: Contiguous array container, O(1) index and linear scan.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_GENERIC_VECTOR_HPP_
+#define _PLIB_GENERIC_VECTOR_HPP_
+
+#if _DEF_IOS
+#include "Reference.hpp"
+#else
+#include <Plib-Generic/Reference.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Generic
+	{
+		// Pre-define
+		template <
+			typename _TyObject,
+			typename _TyAlloc = Plib::Basic::Allocator< _TyObject >
+		> class RVector;
+
+		/*
+		 * Vector stores all objects in one continuous buffer.
+		 * Unlike Array_, there is no per-object allocation and no
+		 * storage block to walk, so operator [] is a single offset and
+		 * a loop over the vector reads the memory in order.
+		 * Insert/Remove in the middle cost O(n), use Array_ when the
+		 * container is mostly changed at the head.
+		 * The buffer grows by double size, so PushBack is amortized O(1).
+		 */
+		template<
+			typename _TyObject,
+			typename _TyAlloc = Plib::Basic::Allocator< _TyObject >
+		>
+		class Vector
+		{
+		public:
+			// The buffer is continuous, pointer is the random access iterator.
+			typedef _TyObject *				Iterator;
+			typedef const _TyObject *		ConstIterator;
+			// For std algorithms.
+			typedef _TyObject *				iterator;
+			typedef const _TyObject *		const_iterator;
+			typedef _TyObject				value_type;
+
+			enum { VEC_MIN_CAPACITY = 8 };
+
+		protected:
+			// Global Allocator, only used to get/free raw buffer.
+			static _TyAlloc					g_BufferAlloc;
+
+			_TyObject *						m_Buffer;
+			Uint32							m_Size;
+			Uint32							m_Capacity;
+
+		protected:
+			// Move(or copy) the objects to the new raw buffer
+			// and destroy the old ones.
+			static INLINE void __Relocate( _TyObject * _dst, _TyObject * _src, Uint32 _count )
+			{
+				for ( Uint32 i = 0; i < _count; ++i ) {
+				#if PLIB_RVALUE_REF
+					new ((void *)(_dst + i)) _TyObject( std::move(_src[i]) );
+				#else
+					new ((void *)(_dst + i)) _TyObject( _src[i] );
+				#endif
+					_src[i].~_TyObject( );
+				}
+			}
+
+			// Destroy the objects in range [_from, m_Size).
+			INLINE void __DestroyFrom( Uint32 _from )
+			{
+				for ( Uint32 i = _from; i < m_Size; ++i )
+					m_Buffer[i].~_TyObject( );
+				m_Size = _from;
+			}
+
+			// Calculate the new capacity which can hold _need objects.
+			INLINE Uint32 __NextCapacity( Uint32 _need ) const
+			{
+				Uint32 _newCapacity = (m_Capacity < (Uint32)VEC_MIN_CAPACITY) ?
+					(Uint32)VEC_MIN_CAPACITY : m_Capacity * 2;
+				return (_newCapacity < _need) ? _need : _newCapacity;
+			}
+
+			// Change the buffer size, the capacity must not be less than size.
+			INLINE void __Reallocate( Uint32 _capacity )
+			{
+				_TyObject * _newBuffer = (_capacity == 0) ?
+					NULL : g_BufferAlloc.Allocate( _capacity );
+				__Relocate( _newBuffer, m_Buffer, m_Size );
+				g_BufferAlloc.Deallocate( m_Buffer );
+				m_Buffer = _newBuffer;
+				m_Capacity = _capacity;
+			}
+
+			// Get the raw slot of the new tail object.
+			// When the buffer is full, the new object must be constructed
+			// before moving the old objects, the parameter may refer to one
+			// of them. So we return the old buffer and let the caller
+			// finish the relocation by __CommitGrow.
+			INLINE _TyObject * __TailSlot( _TyObject * & _oldBuffer )
+			{
+				_oldBuffer = NULL;
+				if ( m_Size < m_Capacity ) return m_Buffer + m_Size;
+				_oldBuffer = m_Buffer;
+				m_Capacity = __NextCapacity( m_Size + 1 );
+				m_Buffer = g_BufferAlloc.Allocate( m_Capacity );
+				return m_Buffer + m_Size;
+			}
+
+			INLINE void __CommitGrow( _TyObject * _oldBuffer )
+			{
+				if ( _oldBuffer != NULL ) {
+					__Relocate( m_Buffer, _oldBuffer, m_Size );
+					g_BufferAlloc.Deallocate( _oldBuffer );
+				}
+				++m_Size;
+			}
+
+		public:
+			// Default C'Str.
+			// Create an empty vector, no memory will be allocated.
+			Vector< _TyObject, _TyAlloc >( )
+				: m_Buffer( NULL ), m_Size( 0 ), m_Capacity( 0 ) { CONSTRUCTURE; }
+
+			// Copy C'str
+			Vector< _TyObject, _TyAlloc >( const Vector< _TyObject, _TyAlloc > & rhs )
+				: m_Buffer( NULL ), m_Size( 0 ), m_Capacity( 0 )
+			{
+				CONSTRUCTURE;
+				this->Append( rhs );
+			}
+
+			// C'Str with array
+			template < typename _TyIterator >
+			Vector< _TyObject, _TyAlloc >( _TyIterator _begin, _TyIterator _end )
+				: m_Buffer( NULL ), m_Size( 0 ), m_Capacity( 0 )
+			{
+				CONSTRUCTURE;
+				this->Append( _begin, _end );
+			}
+
+		#if PLIB_RVALUE_REF
+			// Move C'str, take the buffer of rhs.
+			Vector< _TyObject, _TyAlloc >( Vector< _TyObject, _TyAlloc > && rhs )
+				: m_Buffer( rhs.m_Buffer ), m_Size( rhs.m_Size ), m_Capacity( rhs.m_Capacity )
+			{
+				CONSTRUCTURE;
+				rhs.m_Buffer = NULL;
+				rhs.m_Size = rhs.m_Capacity = 0;
+			}
+		#endif
+
+			~Vector< _TyObject, _TyAlloc >( )
+			{
+				DESTRUCTURE;
+				__DestroyFrom( 0 );
+				g_BufferAlloc.Deallocate( m_Buffer );
+			}
+
+			// Copy the objects of rhs.
+			Vector< _TyObject, _TyAlloc > & operator = (
+				const Vector< _TyObject, _TyAlloc > & rhs )
+			{
+				if ( this == &rhs ) return *this;
+				this->Clear( );
+				this->Append( rhs );
+				return *this;
+			}
+
+		#if PLIB_RVALUE_REF
+			Vector< _TyObject, _TyAlloc > & operator = (
+				Vector< _TyObject, _TyAlloc > && rhs )
+			{
+				if ( this == &rhs ) return *this;
+				__DestroyFrom( 0 );
+				g_BufferAlloc.Deallocate( m_Buffer );
+				m_Buffer = rhs.m_Buffer;
+				m_Size = rhs.m_Size;
+				m_Capacity = rhs.m_Capacity;
+				rhs.m_Buffer = NULL;
+				rhs.m_Size = rhs.m_Capacity = 0;
+				return *this;
+			}
+		#endif
+
+			// Exchange the buffer with other vector.
+			INLINE void Swap( Vector< _TyObject, _TyAlloc > & rhs ) {
+				_TyObject * _buffer = m_Buffer; m_Buffer = rhs.m_Buffer; rhs.m_Buffer = _buffer;
+				Uint32 _size = m_Size; m_Size = rhs.m_Size; rhs.m_Size = _size;
+				Uint32 _cap = m_Capacity; m_Capacity = rhs.m_Capacity; rhs.m_Capacity = _cap;
+			}
+
+			// Make sure the vector can hold _count objects without re-allocating.
+			INLINE void Reserve( Uint32 _count ) {
+				if ( _count > m_Capacity ) __Reallocate( _count );
+			}
+
+			// Release the unused buffer.
+			INLINE void ShrinkToFit( ) {
+				if ( m_Size < m_Capacity ) __Reallocate( m_Size );
+			}
+
+			// Change the size of the vector, new objects are copied from _vobj.
+			INLINE void Resize( Uint32 _count, const _TyObject & _vobj = _TyObject() ) {
+				if ( _count <= m_Size ) { __DestroyFrom( _count ); return; }
+				// The object may be inside the vector.
+				_TyObject _copy( _vobj );
+				this->Reserve( _count );
+				for ( ; m_Size < _count; ++m_Size )
+					new ((void *)(m_Buffer + m_Size)) _TyObject( _copy );
+			}
+
+			// Push a new object to the end of the vector.
+			INLINE void PushBack( const _TyObject & _vobj ) {
+				_TyObject * _oldBuffer;
+				new ((void *)__TailSlot( _oldBuffer )) _TyObject( _vobj );
+				__CommitGrow( _oldBuffer );
+			}
+
+		#if PLIB_RVALUE_REF
+			INLINE void PushBack( _TyObject && _vobj ) {
+				_TyObject * _oldBuffer;
+				new ((void *)__TailSlot( _oldBuffer )) _TyObject( std::move(_vobj) );
+				__CommitGrow( _oldBuffer );
+			}
+
+			// Construct the new object at the end of the vector in place.
+			template < typename... _TyArgs >
+			INLINE _TyObject & EmplaceBack( _TyArgs &&... _args ) {
+				_TyObject * _oldBuffer;
+				new ((void *)__TailSlot( _oldBuffer ))
+					_TyObject( std::forward< _TyArgs >(_args)... );
+				__CommitGrow( _oldBuffer );
+				return m_Buffer[m_Size - 1];
+			}
+		#else
+			// Construct the new object at the end of the vector in place.
+			INLINE _TyObject & EmplaceBack( ) {
+				_TyObject * _oldBuffer;
+				new ((void *)__TailSlot( _oldBuffer )) _TyObject( );
+				__CommitGrow( _oldBuffer );
+				return m_Buffer[m_Size - 1];
+			}
+
+			template < typename _TyArg >
+			INLINE _TyObject & EmplaceBack( const _TyArg & _arg ) {
+				_TyObject * _oldBuffer;
+				new ((void *)__TailSlot( _oldBuffer )) _TyObject( _arg );
+				__CommitGrow( _oldBuffer );
+				return m_Buffer[m_Size - 1];
+			}
+		#endif
+
+			// Pop the tail object.
+			INLINE void PopBack( ) {
+				if ( m_Size == 0 ) return;
+				m_Buffer[--m_Size].~_TyObject( );
+			}
+
+			// Append an single object to the end of the vector.
+			INLINE void Append( const _TyObject & _vobj ) {
+				this->PushBack( _vobj ); }
+
+			// Append other vector the end of current one.
+			INLINE void Append( const Vector< _TyObject, _TyAlloc > & _vector ) {
+				if ( &_vector == this ) {
+					Uint32 _count = m_Size;
+					this->Reserve( m_Size * 2 );
+					for ( Uint32 i = 0; i < _count; ++i )
+						new ((void *)(m_Buffer + m_Size++)) _TyObject( m_Buffer[i] );
+					return;
+				}
+				this->Append( _vector.Begin(), _vector.End() );
+			}
+
+			// Append a range of objects to the end of current vector.
+			template< typename _TyIterator >
+			INLINE void Append( _TyIterator _begin, _TyIterator _end ) {
+				for ( ; _begin != _end; ++_begin )
+					this->PushBack( *_begin );
+			}
+
+			// Specified for pointer range, reserve once.
+			INLINE void Append( const _TyObject * _begin, const _TyObject * _end ) {
+				if ( _begin >= m_Buffer && _begin < m_Buffer + m_Size ) {
+					// Range inside self, copy to avoid the reallocation.
+					Vector< _TyObject, _TyAlloc > _tmp( _begin, _end );
+					this->Append( _tmp );
+					return;
+				}
+				this->Reserve( m_Size + (Uint32)(_end - _begin) );
+				for ( ; _begin != _end; ++_begin )
+					new ((void *)(m_Buffer + m_Size++)) _TyObject( *_begin );
+			}
+
+			// Remove specified item, all objects after it will move forward.
+			INLINE void Remove( Uint32 _idx ) {
+				this->Remove( _idx, 1 ); }
+
+			// Remove _count elements start from _start.
+			INLINE void Remove( Uint32 _start, Uint32 _count ) {
+				if ( _start >= m_Size || _count == 0 ) return;
+				if ( _count > m_Size - _start ) _count = m_Size - _start;
+				for ( Uint32 i = _start + _count; i < m_Size; ++i ) {
+				#if PLIB_RVALUE_REF
+					m_Buffer[i - _count] = std::move( m_Buffer[i] );
+				#else
+					m_Buffer[i - _count] = m_Buffer[i];
+				#endif
+				}
+				__DestroyFrom( m_Size - _count );
+			}
+
+			// Insert an object to the specified position.
+			// All objects after _idx will move backward.
+			INLINE void Insert( const _TyObject & _vobj, Uint32 _idx ) {
+				if ( _idx >= m_Size ) { this->PushBack( _vobj ); return; }
+				// The object may be inside the vector.
+				_TyObject _copy( _vobj );
+				if ( m_Size == m_Capacity ) __Reallocate( __NextCapacity( m_Size + 1 ) );
+				_TyObject * _pEnd = m_Buffer + m_Size;
+			#if PLIB_RVALUE_REF
+				new ((void *)_pEnd) _TyObject( std::move(*(_pEnd - 1)) );
+				for ( _TyObject * _p = _pEnd - 1; _p != m_Buffer + _idx; --_p )
+					*_p = std::move( *(_p - 1) );
+				m_Buffer[_idx] = std::move( _copy );
+			#else
+				new ((void *)_pEnd) _TyObject( *(_pEnd - 1) );
+				for ( _TyObject * _p = _pEnd - 1; _p != m_Buffer + _idx; --_p )
+					*_p = *(_p - 1);
+				m_Buffer[_idx] = _copy;
+			#endif
+				++m_Size;
+			}
+
+			// Get the specified item
+			INLINE _TyObject & operator [] ( Uint32 _idx ) {
+				return m_Buffer[_idx]; }
+
+			// Const version of operator [], get the specified item.
+			INLINE const _TyObject & operator [] ( Uint32 _idx ) const {
+				return m_Buffer[_idx]; }
+
+			// Get the first item
+			INLINE _TyObject & First( ) { return m_Buffer[0]; }
+			INLINE const _TyObject & First( ) const { return m_Buffer[0]; }
+
+			// Get the last item
+			INLINE _TyObject & Last( ) { return m_Buffer[m_Size - 1]; }
+			INLINE const _TyObject & Last( ) const { return m_Buffer[m_Size - 1]; }
+
+			// Raw buffer of the objects.
+			INLINE _TyObject * Data( ) { return m_Buffer; }
+			INLINE const _TyObject * Data( ) const { return m_Buffer; }
+
+			// Iterators.
+			INLINE Iterator Begin( ) { return m_Buffer; }
+			INLINE Iterator End( ) { return m_Buffer + m_Size; }
+			INLINE ConstIterator Begin( ) const { return m_Buffer; }
+			INLINE ConstIterator End( ) const { return m_Buffer + m_Size; }
+			INLINE Iterator begin( ) { return m_Buffer; }
+			INLINE Iterator end( ) { return m_Buffer + m_Size; }
+			INLINE ConstIterator begin( ) const { return m_Buffer; }
+			INLINE ConstIterator end( ) const { return m_Buffer + m_Size; }
+
+			// Get the item count of the vector.
+			INLINE Uint32 Size( ) const { return m_Size; }
+
+			// Get the object count the buffer can hold.
+			INLINE Uint32 Capacity( ) const { return m_Capacity; }
+
+			// Check if the vector is empty.
+			INLINE bool Empty( ) const { return m_Size == 0; }
+
+			// Destroy all objects, the buffer is kept for reuse.
+			INLINE void Clear( ) { __DestroyFrom( 0 ); }
+
+			INLINE bool operator == ( const Vector< _TyObject, _TyAlloc > & rhs ) const {
+				if ( m_Size != rhs.m_Size ) return false;
+				for ( Uint32 i = 0; i < m_Size; ++i )
+					if ( !(m_Buffer[i] == rhs.m_Buffer[i]) ) return false;
+				return true;
+			}
+
+			INLINE bool operator != ( const Vector< _TyObject, _TyAlloc > & rhs ) const {
+				return !(*this == rhs); }
+		};
+
+		// Global Static Allocator of any Vector.
+		template< typename _TyObject, typename _TyAlloc >
+		_TyAlloc Vector< _TyObject, _TyAlloc >::g_BufferAlloc;
+
+		// Reference Version of Vector.
+		template< typename _TyObject, typename _TyAlloc >
+		class RVector : public Reference< Vector< _TyObject, _TyAlloc > >
+		{
+		public:
+			typedef Reference< Vector< _TyObject, _TyAlloc > >	TFather;
+			typedef typename Vector< _TyObject, _TyAlloc >::Iterator		Iterator;
+			typedef typename Vector< _TyObject, _TyAlloc >::ConstIterator	ConstIterator;
+
+		protected:
+			// For Null Vector
+			RVector< _TyObject, _TyAlloc >( bool _beNull ) : TFather( false )
+			{ CONSTRUCTURE; }
+
+		public:
+			// Default C'Str.
+			// Create an empty vector.
+			RVector< _TyObject, _TyAlloc >( )
+				: TFather( true ) { CONSTRUCTURE; }
+
+			// Copy C'str
+			RVector< _TyObject, _TyAlloc >(
+				const Vector< _TyObject, _TyAlloc > & rhs )
+				: TFather( rhs ) { CONSTRUCTURE; }
+
+			// Default Copy
+			RVector< _TyObject, _TyAlloc > ( const RVector< _TyObject, _TyAlloc > & rhs )
+				: TFather( rhs ) { CONSTRUCTURE; }
+
+			// C'Str with array
+			template < typename _TyIterator >
+			RVector< _TyObject, _TyAlloc >(
+			 	_TyIterator _begin, _TyIterator _end )
+				: TFather( true ) {
+					CONSTRUCTURE;
+					TFather::_Handle->_PHandle->Append( _begin, _end );
+				}
+			// D'str
+			virtual ~RVector< _TyObject, _TyAlloc >( ) { DESTRUCTURE; }
+
+			INLINE void Reserve( Uint32 _count ) {
+				TFather::_Handle->_PHandle->Reserve( _count ); }
+
+			INLINE void ShrinkToFit( ) {
+				TFather::_Handle->_PHandle->ShrinkToFit( ); }
+
+			INLINE void Resize( Uint32 _count, const _TyObject & _vobj = _TyObject() ) {
+				TFather::_Handle->_PHandle->Resize( _count, _vobj ); }
+
+			// Push a new object to the end of the vector.
+			INLINE void PushBack( const _TyObject & _vobj ) {
+				TFather::_Handle->_PHandle->PushBack( _vobj ); }
+
+		#if PLIB_RVALUE_REF
+			INLINE void PushBack( _TyObject && _vobj ) {
+				TFather::_Handle->_PHandle->PushBack( std::move(_vobj) ); }
+
+			template < typename... _TyArgs >
+			INLINE _TyObject & EmplaceBack( _TyArgs &&... _args ) {
+				return TFather::_Handle->_PHandle->EmplaceBack(
+					std::forward< _TyArgs >(_args)... ); }
+		#else
+			INLINE _TyObject & EmplaceBack( ) {
+				return TFather::_Handle->_PHandle->EmplaceBack( ); }
+
+			template < typename _TyArg >
+			INLINE _TyObject & EmplaceBack( const _TyArg & _arg ) {
+				return TFather::_Handle->_PHandle->EmplaceBack( _arg ); }
+		#endif
+
+			// Pop the tail object.
+			INLINE void PopBack( ) { TFather::_Handle->_PHandle->PopBack( ); }
+
+			// Append an single object to the end of the vector.
+			INLINE void Append( const _TyObject & _vobj ) {
+				TFather::_Handle->_PHandle->Append( _vobj ); }
+
+			// Append other vector the end of current one.
+			INLINE void Append( const Vector< _TyObject, _TyAlloc > & _vector ) {
+				TFather::_Handle->_PHandle->Append( _vector ); }
+
+			INLINE void Append( const RVector< _TyObject, _TyAlloc > & _rVector ) {
+				TFather::_Handle->_PHandle->Append( *(_rVector._Handle->_PHandle) ); }
+
+			// Append a range of objects to the end of current vector.
+			template< typename _TyIterator >
+			INLINE void Append( _TyIterator _begin, _TyIterator _end ) {
+				TFather::_Handle->_PHandle->Append( _begin, _end ); }
+
+			// Remove specified item.
+			INLINE void Remove ( Uint32 _idx ) {
+				TFather::_Handle->_PHandle->Remove( _idx ); }
+
+			// Remove _count elements start from _start.
+			INLINE void Remove ( Uint32 _start, Uint32 _count ) {
+				TFather::_Handle->_PHandle->Remove( _start, _count ); }
+
+			// Insert an object to the specified position.
+			INLINE void Insert( const _TyObject & _vobj, Uint32 _idx ) {
+				TFather::_Handle->_PHandle->Insert( _vobj, _idx ); }
+
+			// Get the specified item
+			INLINE _TyObject & operator [] ( Uint32 _idx ) {
+				return (*TFather::_Handle->_PHandle)[_idx]; }
+
+			// Const version of operator [], get the specified item.
+			INLINE const _TyObject & operator [] ( Uint32 _idx ) const {
+				return (*TFather::_Handle->_PHandle)[_idx]; }
+
+			// Get the first Item
+			INLINE _TyObject & First( ) {
+				return TFather::_Handle->_PHandle->First( ); }
+
+			// Get the last Item
+			INLINE _TyObject & Last( ) {
+				return TFather::_Handle->_PHandle->Last( ); }
+
+			INLINE _TyObject * Data( ) {
+				return TFather::_Handle->_PHandle->Data( ); }
+
+			// Iterators.
+			INLINE Iterator Begin( ) { return TFather::_Handle->_PHandle->Begin( ); }
+			INLINE Iterator End( ) { return TFather::_Handle->_PHandle->End( ); }
+			INLINE ConstIterator Begin( ) const { return TFather::_Handle->_PHandle->Begin( ); }
+			INLINE ConstIterator End( ) const { return TFather::_Handle->_PHandle->End( ); }
+			INLINE Iterator begin( ) { return TFather::_Handle->_PHandle->Begin( ); }
+			INLINE Iterator end( ) { return TFather::_Handle->_PHandle->End( ); }
+			INLINE ConstIterator begin( ) const { return TFather::_Handle->_PHandle->Begin( ); }
+			INLINE ConstIterator end( ) const { return TFather::_Handle->_PHandle->End( ); }
+
+			// Get the item count of the vector.
+			INLINE Uint32 Size() const {
+				return TFather::_Handle->_PHandle->Size(); }
+
+			INLINE Uint32 Capacity() const {
+				return TFather::_Handle->_PHandle->Capacity(); }
+
+			// Check if the vector is empty.
+			INLINE bool Empty( ) const {
+				return TFather::_Handle->_PHandle->Empty(); }
+
+			// Destroy all objects, the buffer is kept.
+			INLINE void Clear( ) {
+				TFather::_Handle->_PHandle->Clear(); }
+
+			const static RVector< _TyObject, _TyAlloc > Null;
+
+			static RVector< _TyObject, _TyAlloc > CreateNullVector( ){
+				return RVector< _TyObject, _TyAlloc >( false );
+			}
+		};
+
+		template< typename _TyObject, typename _TyAlloc >
+			const RVector< _TyObject, _TyAlloc >
+				RVector< _TyObject, _TyAlloc >::Null( false );
+	}
+}
+
+#endif // plib.generic.vector.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
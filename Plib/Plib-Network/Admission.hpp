@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Admission.hpp
+* Propose  			: Bounded request queue with CoDel load shedding.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_ADMISSION_HPP_
+#define _PLIB_NETWORK_ADMISSION_HPP_
+
+#if _DEF_IOS
+#include "Plib.hpp"
+#include "Locker.hpp"
+#else
+#include <Plib-Basic/Plib.hpp>
+#include <Plib-Threading/Locker.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Network
+	{
+		// An item waiting in the service queue, with the time it came.
+		template < typename _TyItem >
+		struct Admitted
+		{
+			_TyItem								Item;
+			Uint64								Since;		// us, monotonic
+
+			Admitted( ) : Since( 0 ) { }
+			Admitted( const _TyItem & _item )
+				: Item( _item ), Since( Plib::Basic::MonotonicMicroSeconds( ) ) { }
+		};
+
+		/*
+		 * Admission of the requests waiting for a worker.
+		 * Enter is called when a request is queued, it fails when the
+		 * queue is full. Leave is called when a worker takes it, and
+		 * tells if the request should be shed for the time it waited.
+		 *
+		 * The shedding follows CoDel, as servers use it: the requests
+		 * do not slow down when some are dropped like TCP does, so the
+		 * drop rate of RFC 8289 is too gentle. Instead the smallest queue
+		 * delay in each interval tells if the queue is standing. A burst
+		 * drains within the interval, and some request sees a short
+		 * delay. When even the smallest delay of the last interval was
+		 * above the target, the service is overloaded and every request
+		 * that waited more than twice the target is shed, so the others
+		 * are served in time. Target 0 turns the shedding off, depth 0
+		 * is not bounded.
+		 */
+		class AdmissionControl
+		{
+		protected:
+			Uint32								m_MaxDepth;
+			Uint64								m_Target;		// us
+			Uint64								m_Interval;		// us
+			volatile Int32						m_Depth;
+			volatile Int32						m_Shed;
+
+			// CoDel state, changed by the workers under the lock.
+			Plib::Threading::Mutex				m_Lock;
+			Uint64								m_IntervalEnd;
+			Uint64								m_MinDelay;		// of this interval
+			bool								m_Overloaded;	// by the last interval
+			Uint64								m_NextReport;
+
+		public:
+			AdmissionControl( Uint32 _maxDepth = 4096, Uint32 _target = 0, Uint32 _interval = 100000 )
+				: m_MaxDepth( _maxDepth ), m_Target( _target ), m_Interval( _interval ),
+				m_Depth( 0 ), m_Shed( 0 ), m_IntervalEnd( 0 ), m_MinDelay( 0 ),
+				m_Overloaded( false ), m_NextReport( 0 )
+			{
+				CONSTRUCTURE;
+			}
+			~AdmissionControl( ) { DESTRUCTURE; }
+
+			// Must be set before the service starts.
+			INLINE void Set( Uint32 _maxDepth, Uint32 _target, Uint32 _interval )
+			{
+				m_MaxDepth = _maxDepth;
+				m_Target = _target;
+				m_Interval = ( _interval == 0 ) ? 100000 : _interval;
+			}
+
+			// A request is going to be queued, false when it must be shed.
+			INLINE bool Enter( )
+			{
+				Int32 _depth = Plib::Basic::AtomicFetchAdd( &m_Depth, (Int32)1 );
+				if ( m_MaxDepth == 0 || (Uint32)_depth < m_MaxDepth ) return true;
+				Plib::Basic::AtomicFetchSub( &m_Depth, (Int32)1 );
+				Plib::Basic::AtomicFetchAdd( &m_Shed, (Int32)1 );
+				return false;
+			}
+
+			// The queued request is taken back, not by a worker.
+			INLINE void Cancel( )
+			{
+				Plib::Basic::AtomicFetchSub( &m_Depth, (Int32)1 );
+			}
+
+			// A worker takes the request queued at _since, false when it
+			// must be shed.
+			INLINE bool Leave( Uint64 _since )
+			{
+				Plib::Basic::AtomicFetchSub( &m_Depth, (Int32)1 );
+				if ( m_Target == 0 ) return true;
+				Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+				Uint64 _delay = ( _now > _since ) ? _now - _since : 0;
+
+				m_Lock.Lock( );
+				if ( _now >= m_IntervalEnd ) {
+					m_Overloaded = ( m_IntervalEnd != 0 && m_MinDelay > m_Target );
+					m_MinDelay = _delay;
+					m_IntervalEnd = _now + m_Interval;
+				}
+				else if ( _delay < m_MinDelay ) {
+					m_MinDelay = _delay;
+				}
+				bool _drop = m_Overloaded && _delay > 2 * m_Target;
+				m_Lock.UnLock( );
+
+				if ( _drop ) Plib::Basic::AtomicFetchAdd( &m_Shed, (Int32)1 );
+				return !_drop;
+			}
+
+			// The shed count since the last report, at most one report
+			// in an interval, 0 when nothing to report.
+			INLINE Uint32 TakeShed( )
+			{
+				if ( Plib::Basic::AtomicLoad( &m_Shed ) == 0 ) return 0;
+				Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+				m_Lock.Lock( );
+				bool _due = ( _now >= m_NextReport );
+				if ( _due ) m_NextReport = _now + m_Interval;
+				m_Lock.UnLock( );
+				if ( !_due ) return 0;
+				return (Uint32)Plib::Basic::AtomicExchange( &m_Shed, (Int32)0 );
+			}
+
+			INLINE Uint32 Depth( ) const
+			{
+				Int32 _depth = Plib::Basic::AtomicLoad( &m_Depth );
+				return ( _depth < 0 ) ? 0 : (Uint32)_depth;
+			}
+			INLINE bool Overloaded( ) const { return m_Overloaded; }
+
+		private:
+			AdmissionControl( const AdmissionControl & );
+			AdmissionControl & operator = ( const AdmissionControl & );
+		};
+	}
+}
+
+#endif // plib.network.admission.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
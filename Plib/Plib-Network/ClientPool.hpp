@@ -0,0 +1,380 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: ClientPool.hpp
+* Propose  			: Pool of the outgoing connections, keyed by host:port.
+*
+* Current Version	: 1.3
+* Change Log		: First Definition.
+* Change Log		: 1.1: Connect to unix socket path without resolving.
+* Change Log		: 1.2: The global pool is used only by the requests set to it.
+* Change Log		: 1.3: Health check runs on its own thread, the timer only wakes it.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_CLIENTPOOL_HPP_
+#define _PLIB_NETWORK_CLIENTPOOL_HPP_
+
+#if _DEF_IOS
+#include "Syncsock.hpp"
+#include "ConnectInfo.hpp"
+#include "TimerService.hpp"
+#else
+#include <Plib-Network/Syncsock.hpp>
+#include <Plib-Network/ConnectInfo.hpp>
+#include <Plib-Threading/TimerService.hpp>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Plib
+{
+	namespace Network
+	{
+		/*
+		 * Client connection pool.
+		 * The idle connections of each host:port are reused last in first
+		 * out, so the hot ones stay warm and the cold ones expire. The
+		 * resolved address of a host is cached for DnsTTL, a failed
+		 * connect drops the cache.
+		 * HealthCheck closes the dead and expired idle connections and
+		 * connects ahead up to MinIdle, StartHealthCheck runs it on a
+		 * thread of the pool woken by the timer service, so the connects
+		 * never hold up the other timers.
+		 */
+		template < typename _TyConnect = SyncSock >
+		class ClientPool
+		{
+		public:
+			typedef Plib::Generic::Reference< _TyConnect >			RpConnect;
+
+		protected:
+			struct _IdleConnect
+			{
+				RpConnect							Connect;
+				Uint64								Since;		// ms
+
+				_IdleConnect( ) : Connect( false ), Since( 0 ) { }
+			};
+			struct _HostPool
+			{
+				std::string							Host;
+				Uint32								Port;
+				char								Address[16];
+				Uint64								ResolvedAt;	// ms
+				Uint32								Borrowed;
+				std::vector< _IdleConnect >			Idle;		// back is the newest.
+			};
+			typedef std::map< std::string, _HostPool * >		THostMap;
+
+			THostMap								m_Hosts;
+			Plib::Threading::Mutex					m_Lock;
+			Plib::Threading::TimerTask				m_HealthTask;
+			Plib::Threading::TimerService *			m_HealthService;
+			Plib::Threading::Thread< void( ) >		m_HealthThread;
+
+			Uint32									m_MinIdle;
+			Uint32									m_MaxIdle;
+			Uint32									m_MaxIdleTime;
+			Uint32									m_ConnectTimeOut;
+			Uint32									m_DnsTTL;
+
+			Uint64									m_Reused;
+			Uint64									m_Created;
+
+			static INLINE Uint64 __Now( )
+			{
+				return Plib::Basic::MonotonicMicroSeconds( ) / 1000;
+			}
+
+			static INLINE std::string __Key( const char * _host, Uint32 _port )
+			{
+				char _port_s[16];
+				sprintf( _port_s, ":%u", _port );
+				return std::string( _host ) + _port_s;
+			}
+
+			// Must hold the lock.
+			INLINE _HostPool * __GetHost( const char * _host, Uint32 _port )
+			{
+				std::string _key = __Key( _host, _port );
+				typename THostMap::iterator _it = m_Hosts.find( _key );
+				if ( _it != m_Hosts.end( ) ) return _it->second;
+				_HostPool * _pool;
+				PNEW( _HostPool, _pool );
+				_pool->Host = _host;
+				_pool->Port = _port;
+				_pool->Address[0] = '\0';
+				_pool->ResolvedAt = 0;
+				_pool->Borrowed = 0;
+				m_Hosts[_key] = _pool;
+				return _pool;
+			}
+
+			// Idle connection is healthy when the peer has not closed it
+			// and has sent nothing unexpected.
+			static INLINE bool __Healthy( RpConnect & _cnnt )
+			{
+				if ( _cnnt->hSo == -1 ) return false;
+				if ( _cnnt->IsReadable( ) ) return false;
+				return _cnnt->IsConnect( );
+			}
+
+			// Connect without the lock, resolve the host once per DnsTTL.
+			INLINE RpConnect __NewConnect( _HostPool * _pool, Uint32 _timeOut )
+			{
+				// A unix socket path has nothing to resolve.
+				if ( Endpoint::IsUnixHost( _pool->Host.c_str( ) ) ) {
+					RpConnect _cnnt;
+					if ( !_cnnt->Connect( Endpoint::Parse( _pool->Host.c_str( ), 0 ), _timeOut ) )
+						return RpConnect::NullRefObj;
+					Plib::Threading::Locker _lock( m_Lock );
+					++m_Created;
+					return _cnnt;
+				}
+				char _address[16];
+				Uint64 _now = __Now( );
+				m_Lock.Lock( );
+				bool _cached = ( _pool->Address[0] != '\0' &&
+					_now - _pool->ResolvedAt < m_DnsTTL );
+				if ( _cached ) memcpy( _address, _pool->Address, sizeof(_address) );
+				m_Lock.UnLock( );
+				if ( !_cached ) {
+					Domain2Ip( _pool->Host.c_str( ), _address, sizeof(_address) );
+					if ( _address[0] == '\0' ) return RpConnect::NullRefObj;
+					Plib::Threading::Locker _lock( m_Lock );
+					memcpy( _pool->Address, _address, sizeof(_address) );
+					_pool->ResolvedAt = _now;
+				}
+				RpConnect _cnnt;
+				if ( !_cnnt->Connect( _address, _pool->Port, _timeOut ) ) {
+					Plib::Threading::Locker _lock( m_Lock );
+					_pool->Address[0] = '\0';
+					return RpConnect::NullRefObj;
+				}
+				Plib::Threading::Locker _lock( m_Lock );
+				++m_Created;
+				return _cnnt;
+			}
+
+			// On the timer thread, only wake the checking thread.
+			INLINE void __OnHealthCheck( ) { m_HealthThread.GiveSignal( ); }
+
+			void __HealthCheckThread( )
+			{
+				while ( Plib::Threading::ThreadSys::Running( ) ) {
+					Plib::Threading::ThreadSys::WaitForSignal( );
+					if ( !Plib::Threading::ThreadSys::Running( ) ) break;
+					HealthCheck( );
+				}
+			}
+
+		private:
+			ClientPool( const ClientPool & );
+			ClientPool & operator = ( const ClientPool & );
+
+		public:
+			ClientPool( Uint32 _minIdle = 0, Uint32 _maxIdle = 16 )
+				: m_HealthService( NULL ), m_MinIdle( _minIdle ), m_MaxIdle( _maxIdle ),
+				m_MaxIdleTime( 60000 ), m_ConnectTimeOut( 1000 ), m_DnsTTL( 30000 ),
+				m_Reused( 0 ), m_Created( 0 )
+			{
+				CONSTRUCTURE;
+				m_HealthTask.Handler += std::make_pair( this, &ClientPool< _TyConnect >::__OnHealthCheck );
+				m_HealthThread.Jobs += std::make_pair( this, &ClientPool< _TyConnect >::__HealthCheckThread );
+			}
+			~ClientPool( )
+			{
+				DESTRUCTURE;
+				StopHealthCheck( );
+				for ( typename THostMap::iterator _it = m_Hosts.begin( );
+					_it != m_Hosts.end( ); ++_it ) {
+					_HostPool * _pool = _it->second;
+					PDELETE( _pool );
+				}
+			}
+
+			// Shared pool of the process, a request uses it only after
+			// SetClientPool( &Global() ).
+			static INLINE ClientPool< _TyConnect > & Global( )
+			{
+				static ClientPool< _TyConnect > _pool;
+				return _pool;
+			}
+
+			INLINE void SetMinIdle( Uint32 _minIdle ) { m_MinIdle = _minIdle; }
+			INLINE void SetMaxIdle( Uint32 _maxIdle ) { m_MaxIdle = _maxIdle; }
+			INLINE void SetMaxIdleTime( Uint32 _mileSec ) { m_MaxIdleTime = _mileSec; }
+			INLINE void SetConnectTimeOut( Uint32 _mileSec ) { m_ConnectTimeOut = _mileSec; }
+			INLINE void SetDnsTTL( Uint32 _mileSec ) { m_DnsTTL = _mileSec; }
+
+			// Take the newest healthy idle connection, or connect a new one.
+			// Return a null reference when the connect failed.
+			INLINE RpConnect Borrow( const char * _host, Uint32 _port, Uint32 _timeOut = 0 )
+			{
+				if ( _timeOut == 0 ) _timeOut = m_ConnectTimeOut;
+				_HostPool * _pool;
+				for ( ; ; ) {
+					RpConnect _cnnt( false );
+					{
+						Plib::Threading::Locker _lock( m_Lock );
+						_pool = __GetHost( _host, _port );
+						if ( _pool->Idle.empty( ) ) break;
+						_cnnt = _pool->Idle.back( ).Connect;
+						_pool->Idle.pop_back( );
+					}
+					if ( __Healthy( _cnnt ) ) {
+						Plib::Threading::Locker _lock( m_Lock );
+						++_pool->Borrowed;
+						++m_Reused;
+						return _cnnt;
+					}
+					_cnnt->Close( );
+				}
+				RpConnect _cnnt = __NewConnect( _pool, _timeOut );
+				if ( _cnnt.RefNull( ) ) return _cnnt;
+				Plib::Threading::Locker _lock( m_Lock );
+				++_pool->Borrowed;
+				return _cnnt;
+			}
+			INLINE RpConnect Borrow( const RConnInfo & _info )
+			{
+				return Borrow( _info->Host.C_Str( ), _info->Port, _info->TimeOut / 2 );
+			}
+
+			// Give back a borrowed connection, a closed or broken one and
+			// the ones over MaxIdle are dropped.
+			INLINE void Return( const char * _host, Uint32 _port, RpConnect & _cnnt, bool _reusable = true )
+			{
+				if ( _cnnt.RefNull( ) ) return;
+				_cnnt->UnAttachReadBuffer( );
+				_cnnt->onBufferUpdate.Clear( );
+				_cnnt->onParseData.Clear( );
+				bool _keep = _reusable && _cnnt->hSo != -1;
+				{
+					Plib::Threading::Locker _lock( m_Lock );
+					_HostPool * _pool = __GetHost( _host, _port );
+					if ( _pool->Borrowed > 0 ) --_pool->Borrowed;
+					if ( _keep && _pool->Idle.size( ) < m_MaxIdle ) {
+						_IdleConnect _idle;
+						_idle.Connect = _cnnt;
+						_idle.Since = __Now( );
+						_pool->Idle.push_back( _idle );
+						_cnnt = RpConnect::NullRefObj;
+						return;
+					}
+				}
+				_cnnt->Close( );
+				_cnnt = RpConnect::NullRefObj;
+			}
+
+			// Connect ahead until the host has _count idle connections.
+			INLINE Uint32 Warmup( const char * _host, Uint32 _port, Uint32 _count )
+			{
+				_HostPool * _pool;
+				Uint32 _idle;
+				{
+					Plib::Threading::Locker _lock( m_Lock );
+					_pool = __GetHost( _host, _port );
+					_idle = (Uint32)_pool->Idle.size( );
+				}
+				if ( _count > m_MaxIdle ) _count = m_MaxIdle;
+				Uint32 _created = 0;
+				for ( ; _idle + _created < _count; ++_created ) {
+					RpConnect _cnnt = __NewConnect( _pool, m_ConnectTimeOut );
+					if ( _cnnt.RefNull( ) ) break;
+					_IdleConnect _conn;
+					_conn.Connect = _cnnt;
+					_conn.Since = __Now( );
+					Plib::Threading::Locker _lock( m_Lock );
+					_pool->Idle.insert( _pool->Idle.begin( ), _conn );
+				}
+				return _created;
+			}
+
+			// Close the dead and expired idle connections, then warm every
+			// host up to MinIdle. Return the count of the closed ones.
+			INLINE Uint32 HealthCheck( )
+			{
+				std::vector< _HostPool * > _hosts;
+				std::vector< RpConnect > _checking;
+				Uint64 _now = __Now( );
+				Uint32 _closed = 0;
+				{
+					Plib::Threading::Locker _lock( m_Lock );
+					for ( typename THostMap::iterator _it = m_Hosts.begin( );
+						_it != m_Hosts.end( ); ++_it ) {
+						_hosts.push_back( _it->second );
+					}
+				}
+				for ( Uint32 h = 0; h < _hosts.size( ); ++h ) {
+					_HostPool * _pool = _hosts[h];
+					std::vector< _IdleConnect > _idle;
+					{
+						Plib::Threading::Locker _lock( m_Lock );
+						_idle.swap( _pool->Idle );
+					}
+					// The oldest is at the front, keep the order.
+					std::vector< _IdleConnect > _alive;
+					for ( Uint32 i = 0; i < _idle.size( ); ++i ) {
+						if ( _now - _idle[i].Since < m_MaxIdleTime && __Healthy( _idle[i].Connect ) ) {
+							_alive.push_back( _idle[i] );
+							continue;
+						}
+						_idle[i].Connect->Close( );
+						++_closed;
+					}
+					{
+						Plib::Threading::Locker _lock( m_Lock );
+						_alive.insert( _alive.end( ), _pool->Idle.begin( ), _pool->Idle.end( ) );
+						_pool->Idle.swap( _alive );
+					}
+					if ( m_MinIdle > 0 ) Warmup( _pool->Host.c_str( ), _pool->Port, m_MinIdle );
+				}
+				return _closed;
+			}
+
+			// Run HealthCheck every _interval ms, the timer service wakes
+			// the checking thread. The ticks during a check make one more.
+			INLINE bool StartHealthCheck( Uint32 _interval = 5000,
+				Plib::Threading::TimerService & _service = Plib::Threading::TimerService::Default( ) )
+			{
+				StopHealthCheck( );
+				if ( !m_HealthThread.Start( ) ) return false;
+				m_HealthService = &_service;
+				_service.Schedule( m_HealthTask, _interval, _interval );
+				return true;
+			}
+			// Wait for the running check to end.
+			INLINE void StopHealthCheck( )
+			{
+				if ( m_HealthService != NULL ) m_HealthService->Cancel( m_HealthTask );
+				m_HealthService = NULL;
+				m_HealthThread.Stop( );
+			}
+
+			INLINE Uint32 IdleCount( const char * _host, Uint32 _port )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				return (Uint32)__GetHost( _host, _port )->Idle.size( );
+			}
+			INLINE Uint64 ReusedCount( ) const { return m_Reused; }
+			INLINE Uint64 CreatedCount( ) const { return m_Created; }
+		};
+	}
+}
+
+#endif // plib.network.clientpool.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
@@ -5,8 +5,9 @@
 * File Name			: ConnectInfo.hpp
 * Propose  			: Network connection info
 * 
-* Current Version	: 1.1.0
+* Current Version	: 1.2.0
 * Change Log		: Re-organize.
+* Change Log		: 1.2.0: Unix socket path as the host.
 * Author			: Push Chen
 * Change Date		: 2011-07-04
 */
@@ -18,17 +19,22 @@
 
 #if _DEF_IOS
 #include "Generic.hpp"
+#include "Endpoint.hpp"
 #else
 #include <Plib-Generic/Generic.hpp>
+#include <Plib-Network/Endpoint.hpp>
 #endif
 
+#include <string>
+
 namespace Plib
 {
 	namespace Network
 	{		
 		/*
 			Connection Info 
-			Host: the peer address, can be a domain or an IP.
+			Host: the peer address, can be a domain or an IP, or
+				"unix:<path>" for a unix socket, see Endpoint.
 			Port: the peer port.
 			TimeOut: for connect, read, write
 			KeepAlive: if the server or the request should maintains the connection.
@@ -79,6 +85,16 @@ namespace Plib
 				TFather::_Handle->_PHandle->Port = _port;
 			}
 			
+			// Unix socket path, '@' for the abstract namespace.
+			void SetUnixPath( const char * _path ) {
+				std::string _host = std::string( "unix:" ) + _path;
+				SetHost( Plib::Text::RString( _host.c_str() ) );
+				SetPort( 0 );
+			}
+			bool IsUnix( ) const {
+				return Endpoint::IsUnixHost( TFather::_Handle->_PHandle->Host.C_Str() );
+			}
+			
 			// TimeOut
 			Uint32 TimeOut() const {
 				return TFather::_Handle->_PHandle->TimeOut;
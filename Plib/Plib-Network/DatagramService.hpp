@@ -0,0 +1,578 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: DatagramService.hpp
+* Propose  			: UDP service, receive and reply in batches.
+*
+* Current Version	: 1.1
+* Change Log		: First Definition.
+* Change Log		: 1.1: A batch the pool refuses goes back to its own shard.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_DATAGRAMSERVICE_HPP_
+#define _PLIB_NETWORK_DATAGRAMSERVICE_HPP_
+
+#if _DEF_IOS
+#include "Socketbasic.hpp"
+#include "Framing.hpp"
+#include "ThreadPool.hpp"
+#include "Metrics.hpp"
+#else
+#include <Plib-Network/Socketbasic.hpp>
+#include <Plib-Network/Framing.hpp>
+#include <Plib-Threading/ThreadPool.hpp>
+#include <Plib-Utility/Metrics.hpp>
+#endif
+
+#include <string>
+
+// recvmmsg/sendmmsg, UDP GRO/GSO and SO_REUSEPORT sharding.
+#if _DEF_LINUX
+	#define PLIB_HAS_MMSG		1
+	#include <netinet/udp.h>
+	#ifndef SOL_UDP
+	#define SOL_UDP				17
+	#endif
+	#ifndef UDP_SEGMENT
+	#define UDP_SEGMENT			103
+	#endif
+	#ifndef UDP_GRO
+	#define UDP_GRO				104
+	#endif
+#else
+	#define PLIB_HAS_MMSG		0
+#endif
+
+namespace Plib
+{
+	namespace Network
+	{
+		template < typename _TyParser > class DatagramService;
+
+		/*
+		 * The parser of a datagram service:
+		 *		SOCKEVENTSTATUE ParseDatagram( const FrameView & _datagram );
+		 *		void Clear( );
+		 * A datagram is always a whole message. SOEVENT_OK or SOEVENT_DONE
+		 * takes it, anything else drops it before the work process.
+		 */
+		template < typename _TyParser >
+		class DatagramRequest
+		{
+			template < typename _TyP > friend class DatagramService;
+		public:
+			_TyParser							Parser;
+			// The datagram, only valid until the work process returns.
+			FrameView							Data;
+			struct sockaddr_in					Peer;
+
+		protected:
+			std::string							m_Reply;
+			bool								m_Valid;
+
+		private:
+			DatagramRequest( const DatagramRequest & );
+			DatagramRequest & operator = ( const DatagramRequest & );
+
+		public:
+			DatagramRequest( ) : m_Valid( false )
+			{
+				CONSTRUCTURE;
+				memset( &Peer, 0, sizeof(Peer) );
+			}
+			~DatagramRequest( ) { DESTRUCTURE; }
+
+			// The reply is sent to the peer after the work process,
+			// nothing is sent when it is empty.
+			INLINE void Reply( const char * _data, Uint32 _length ) { m_Reply.assign( _data, _length ); }
+			// Build the reply in place, the capacity is kept for the next datagram.
+			INLINE std::string & ReplyBuffer( ) { return m_Reply; }
+		};
+
+		/*
+		 * Each shard is a socket bound to the same port with SO_REUSEPORT,
+		 * the kernel spreads the peers over them. The receive thread of a
+		 * shard fills a batch with one recvmmsg, and one pool task runs the
+		 * work process of the whole batch and sends the replies with one
+		 * sendmmsg. Batches are allocated on start and reused.
+		 * With GRO one receive buffer holds several datagrams of the same
+		 * peer, with GSO the replies of the same size to the same peer are
+		 * sent as one message.
+		 */
+		template < typename _TyParser >
+		class DatagramService
+		{
+		public:
+			typedef DatagramRequest< _TyParser >						TRequest;
+			typedef Plib::Threading::ThreadPool							WorkerPoolT;
+			typedef typename WorkerPoolT::TaskT							TaskT;
+			typedef Plib::Threading::Thread< void( Uint32 ) >			ReceiveThreadT;
+			typedef Plib::Generic::Delegate< void ( TRequest & ) >		WorkFlowT;
+
+			enum {
+				RECV_TIMEOUT		= 100,		// ms, the receive thread checks stop.
+				GRO_BUFFER_SIZE		= 65536,
+				GSO_MAX_SEGMENTS	= 64,
+				GSO_MAX_BYTES		= 65000
+			};
+
+		protected:
+			struct __Shard;
+
+			struct __Batch
+			{
+				__Shard *							Shard;
+				char *								Buffer;
+				Uint32								Count;		// requests received
+				Plib::Generic::Vector< TRequest * >	Requests;
+			#if PLIB_HAS_MMSG
+				Plib::Generic::Vector< struct mmsghdr >		RecvMsgs;
+				Plib::Generic::Vector< struct iovec >		RecvIovs;
+				Plib::Generic::Vector< struct sockaddr_in >	RecvAddrs;
+				Plib::Generic::Vector< char >				RecvControl;
+				Plib::Generic::Vector< struct mmsghdr >		SendMsgs;
+				Plib::Generic::Vector< struct iovec >		SendIovs;
+				Plib::Generic::Vector< char >				SendControl;
+			#endif
+
+				__Batch( ) : Shard( NULL ), Buffer( NULL ), Count( 0 ) { }
+			};
+			typedef Plib::Generic::BlockingQueue<
+				Plib::Generic::MpmcQueue< __Batch * > >					BatchQueueT;
+
+			struct __Shard
+			{
+				SOCKET_T							Socket;
+				ReceiveThreadT						Receiver;
+				BatchQueueT							FreeBatch;
+				Plib::Generic::Vector< __Batch * >	Batches;
+
+				__Shard( Uint32 _batchCount ) : Socket( -1 ), FreeBatch( _batchCount ) { }
+			};
+
+			Plib::Generic::Vector< __Shard * >		m_Shards;
+			WorkerPoolT								m_WorkerPool;
+			BatchQueueT								m_ReadyBatch;
+			TaskT									m_BatchTask;
+			bool									m_Running;
+
+			Uint32									m_ShardCount;
+			Uint32									m_BatchSize;
+			Uint32									m_BatchCount;
+			Uint32									m_MaxDatagram;
+			Uint32									m_RecvBufferSize;
+			bool									m_Gro;
+			bool									m_Gso;
+			bool									m_BindCpu;
+
+			// Hot metrics, looked up once.
+			Plib::Utility::MetricCounter *			m_Received;
+			Plib::Utility::MetricCounter *			m_Sent;
+			Plib::Utility::MetricCounter *			m_Dropped;
+			Plib::Utility::MetricCounter *			m_Batches;
+
+		private:
+			DatagramService( const DatagramService & );
+			DatagramService & operator = ( const DatagramService & );
+
+		public:
+			DatagramService( )
+				: m_ReadyBatch( 1024 ), m_Running( false ), m_ShardCount( 1 ),
+				m_BatchSize( 64 ), m_BatchCount( 4 ), m_MaxDatagram( 2048 ),
+				m_RecvBufferSize( 0 ), m_Gro( false ), m_Gso( false ), m_BindCpu( false )
+			{
+				CONSTRUCTURE;
+				m_BatchTask += std::make_pair( this, &DatagramService::__ProcessBatch );
+				m_Received = &Metrics.Counter( "datagram.received" );
+				m_Sent = &Metrics.Counter( "datagram.sent" );
+				m_Dropped = &Metrics.Counter( "datagram.dropped" );
+				m_Batches = &Metrics.Counter( "datagram.batches" );
+			}
+			~DatagramService( ) { DESTRUCTURE; StopServer( ); }
+
+			// The following settings must be set before StartServer.
+
+			// Sockets on the port, each with its receive thread. More than
+			// one needs SO_REUSEPORT, only on Linux.
+			void SetShards( Uint32 _shards ) { m_ShardCount = ( _shards == 0 ) ? 1 : _shards; }
+			// Datagrams taken by one receive call.
+			void SetBatchSize( Uint32 _size ) { m_BatchSize = ( _size == 0 ) ? 1 : _size; }
+			// Batches of each shard, received while the others are in the pool.
+			void SetBatchCount( Uint32 _count ) { m_BatchCount = ( _count == 0 ) ? 1 : _count; }
+			// The larger datagram is truncated, and dropped.
+			void SetMaxDatagram( Uint32 _size ) { m_MaxDatagram = _size; }
+			void SetRecvBufferSize( Uint32 _size ) { m_RecvBufferSize = _size; }
+			void SetGro( bool _gro ) { m_Gro = _gro; }
+			void SetGso( bool _gso ) { m_Gso = _gso; }
+			void SetBindCpu( bool _bind ) { m_BindCpu = _bind; }
+
+			// Start on the port with _threadCount workers, 0 means one
+			// worker for each cpu. Port 0 takes any free port, see Port().
+			bool StartServer( Uint32 _port, Uint32 _threadCount = 0 )
+			{
+				if ( m_Running || !WorkProcess ) return false;
+			#if !PLIB_HAS_MMSG
+				m_ShardCount = 1;
+				m_Gro = m_Gso = false;
+			#endif
+				for ( Uint32 i = 0; i < m_ShardCount; ++i ) {
+					__Shard * _shard = __CreateShard( );
+					m_Shards.PushBack( _shard );
+					if ( !__OpenShard( _shard, _port ) ) {
+						if ( OnServerError ) OnServerError( PLIB_LASTERROR );
+						StopServer( );
+						return false;
+					}
+					// Other shards bind to the port the first one got.
+					if ( _port == 0 ) _port = Port( );
+				}
+				if ( !m_WorkerPool.Start( _threadCount, m_BindCpu ) ) {
+					StopServer( );
+					return false;
+				}
+				m_Running = true;
+				for ( Uint32 i = 0; i < m_Shards.Size( ); ++i ) {
+					if ( !m_Shards[i]->Receiver.Start( i ) ) {
+						StopServer( );
+						return false;
+					}
+				}
+				return true;
+			}
+
+			void StopServer( )
+			{
+				for ( Uint32 i = 0; i < m_Shards.Size( ); ++i )
+					m_Shards[i]->Receiver.Stop( );
+				m_WorkerPool.Stop( );
+				__Batch * _batch;
+				while ( m_ReadyBatch.PopN( &_batch, 1 ) == 1 ) { }
+				for ( Uint32 i = 0; i < m_Shards.Size( ); ++i ) {
+					__Shard * _shard = m_Shards[i];
+					if ( _shard->Socket != -1 ) PLIB_NETWORK_CLOSESOCK( _shard->Socket );
+					for ( Uint32 b = 0; b < _shard->Batches.Size( ); ++b ) {
+						_batch = _shard->Batches[b];
+						for ( Uint32 r = 0; r < _batch->Requests.Size( ); ++r )
+							PDELETE( _batch->Requests[r] );
+						PFREE( _batch->Buffer );
+						PDELETE( _batch );
+					}
+					PDELETE( _shard );
+				}
+				m_Shards.Clear( );
+				m_Running = false;
+			}
+
+			// The bound port.
+			Uint32 Port( ) const
+			{
+				if ( m_Shards.Size( ) == 0 || m_Shards[0]->Socket == -1 ) return 0;
+				struct sockaddr_in _addr;
+				socklen_t _len = sizeof( _addr );
+				if ( getsockname( m_Shards[0]->Socket, (struct sockaddr *)&_addr, &_len ) != 0 )
+					return 0;
+				return ntohs( _addr.sin_port );
+			}
+
+		public:
+			// Called in the worker pool, for each datagram taken by the parser.
+			WorkFlowT													WorkProcess;
+			Plib::Generic::Delegate< void ( Uint32 ) >					OnServerError;
+
+			// Received, sent, dropped datagrams and receive batches.
+			Plib::Utility::MetricsRegistry								Metrics;
+
+		protected:
+			INLINE Uint32 __SlotSize( ) const
+			{
+				return m_Gro ? (Uint32)GRO_BUFFER_SIZE : m_MaxDatagram;
+			}
+
+			INLINE __Shard * __CreateShard( )
+			{
+				__Shard * _shard;
+				PNEWPARAM( __Shard, _shard, m_BatchCount );
+				_shard->Receiver.Jobs += std::make_pair( this, &DatagramService::__ReceiveLoop );
+				for ( Uint32 b = 0; b < m_BatchCount; ++b ) {
+					__Batch * _batch;
+					PNEW( __Batch, _batch );
+					_batch->Shard = _shard;
+					PMALLOC( char, _batch->Buffer, (size_t)__SlotSize( ) * m_BatchSize );
+				#if PLIB_HAS_MMSG
+					Uint32 _cmsgSize = CMSG_SPACE( sizeof(int) );
+					_batch->RecvMsgs.Resize( m_BatchSize );
+					_batch->RecvIovs.Resize( m_BatchSize );
+					_batch->RecvAddrs.Resize( m_BatchSize );
+					_batch->RecvControl.Resize( _cmsgSize * m_BatchSize );
+					for ( Uint32 i = 0; i < m_BatchSize; ++i ) {
+						struct mmsghdr & _msg = _batch->RecvMsgs[i];
+						memset( &_msg, 0, sizeof(_msg) );
+						_batch->RecvIovs[i].iov_base = _batch->Buffer + (size_t)__SlotSize( ) * i;
+						_msg.msg_hdr.msg_iov = &_batch->RecvIovs[i];
+						_msg.msg_hdr.msg_iovlen = 1;
+						_msg.msg_hdr.msg_name = &_batch->RecvAddrs[i];
+						if ( m_Gro ) _msg.msg_hdr.msg_control = &_batch->RecvControl[_cmsgSize * i];
+					}
+				#endif
+					_shard->Batches.PushBack( _batch );
+					_shard->FreeBatch.Push( _batch );
+				}
+				return _shard;
+			}
+
+			INLINE bool __OpenShard( __Shard * _shard, Uint32 _port )
+			{
+				_shard->Socket = ::socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+				if ( _shard->Socket == -1 ) return false;
+				SOCKET_T _so = _shard->Socket;
+				int _val = 1;
+				if ( setsockopt( _so, SOL_SOCKET, SO_REUSEADDR, (const char *)&_val, sizeof(_val) ) != 0 )
+					return false;
+			#if PLIB_HAS_MMSG
+				if ( m_ShardCount > 1 && setsockopt( _so, SOL_SOCKET, SO_REUSEPORT,
+					(const char *)&_val, sizeof(_val) ) != 0 ) return false;
+				// Older kernels have no GRO, the datagrams just come one by one.
+				if ( m_Gro ) setsockopt( _so, SOL_UDP, UDP_GRO, (const char *)&_val, sizeof(_val) );
+			#endif
+				if ( m_RecvBufferSize > 0 ) setsockopt( _so, SOL_SOCKET, SO_RCVBUF,
+					(const char *)&m_RecvBufferSize, sizeof(m_RecvBufferSize) );
+				// Wake up the receive thread to check stop.
+			#if _DEF_WIN32
+				DWORD _timeout = RECV_TIMEOUT;
+			#else
+				struct timeval _timeout = { 0, RECV_TIMEOUT * 1000 };
+			#endif
+				setsockopt( _so, SOL_SOCKET, SO_RCVTIMEO, (const char *)&_timeout, sizeof(_timeout) );
+
+				struct sockaddr_in _addr;
+				memset( &_addr, 0, sizeof(_addr) );
+				_addr.sin_family = AF_INET;
+				_addr.sin_addr.s_addr = htonl( INADDR_ANY );
+				_addr.sin_port = htons( _port );
+				return ::bind( _so, (struct sockaddr *)&_addr, sizeof(_addr) ) == 0;
+			}
+
+			// Parse one datagram into the next request of the batch.
+			INLINE void __AddRequest( __Batch * _batch, const char * _data, Uint32 _length,
+				const struct sockaddr_in & _peer )
+			{
+				if ( _batch->Count == _batch->Requests.Size( ) ) {
+					TRequest * _newReq;
+					PNEW( TRequest, _newReq );
+					_batch->Requests.PushBack( _newReq );
+				}
+				TRequest * _req = _batch->Requests[_batch->Count++];
+				_req->Parser.Clear( );
+				_req->m_Reply.clear( );
+				_req->Data.Data = _data;
+				_req->Data.Length = _length;
+				_req->Peer = _peer;
+				SOCKEVENTSTATUE _ret = _req->Parser.ParseDatagram( _req->Data );
+				_req->m_Valid = ( _ret == SOEVENT_OK || _ret == SOEVENT_DONE );
+			}
+
+			// Block until some datagrams arrive, take all of them at most
+			// the batch size. Return false on time out.
+			INLINE bool __Receive( __Batch * _batch )
+			{
+				SOCKET_T _so = _batch->Shard->Socket;
+				Uint32 _slot = __SlotSize( );
+				_batch->Count = 0;
+			#if PLIB_HAS_MMSG
+				Uint32 _cmsgSize = CMSG_SPACE( sizeof(int) );
+				for ( Uint32 i = 0; i < m_BatchSize; ++i ) {
+					struct mmsghdr & _msg = _batch->RecvMsgs[i];
+					_batch->RecvIovs[i].iov_len = _slot;
+					_msg.msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+					_msg.msg_hdr.msg_controllen = m_Gro ? _cmsgSize : 0;
+					_msg.msg_hdr.msg_flags = 0;
+				}
+				int _count = ::recvmmsg( _so, _batch->RecvMsgs.Data( ), m_BatchSize, MSG_WAITFORONE, NULL );
+				if ( _count <= 0 ) return false;
+				Uint32 _truncated = 0;
+				for ( int i = 0; i < _count; ++i ) {
+					struct mmsghdr & _msg = _batch->RecvMsgs[i];
+					if ( _msg.msg_hdr.msg_flags & MSG_TRUNC ) { ++_truncated; continue; }
+					const char * _data = (const char *)_batch->RecvIovs[i].iov_base;
+					Uint32 _length = _msg.msg_len;
+					Uint32 _segment = _length;
+					if ( m_Gro ) {
+						for ( struct cmsghdr * _cmsg = CMSG_FIRSTHDR( &_msg.msg_hdr );
+							_cmsg != NULL; _cmsg = CMSG_NXTHDR( &_msg.msg_hdr, _cmsg ) ) {
+							if ( _cmsg->cmsg_level == SOL_UDP && _cmsg->cmsg_type == UDP_GRO ) {
+								int _size;
+								memcpy( &_size, CMSG_DATA( _cmsg ), sizeof(_size) );
+								if ( _size > 0 ) _segment = (Uint32)_size;
+							}
+						}
+					}
+					// Coalesced by GRO, split back into datagrams.
+					for ( Uint32 _offset = 0; _offset < _length; _offset += _segment ) {
+						Uint32 _left = _length - _offset;
+						__AddRequest( _batch, _data + _offset, ( _left < _segment ) ? _left : _segment,
+							_batch->RecvAddrs[i] );
+					}
+				}
+				if ( _truncated > 0 ) m_Dropped->Add( _truncated );
+				return _count > 0;
+			#else
+				struct sockaddr_in _peer;
+				for ( Uint32 i = 0; i < m_BatchSize; ++i ) {
+					char * _data = _batch->Buffer + (size_t)_slot * i;
+					socklen_t _len = sizeof( _peer );
+					int _flags = 0;
+				#ifdef MSG_DONTWAIT
+					if ( i > 0 ) _flags = MSG_DONTWAIT;
+				#else
+					if ( i > 0 ) break;
+				#endif
+					int _ret = ::recvfrom( _so, _data, _slot, _flags, (struct sockaddr *)&_peer, &_len );
+					if ( _ret < 0 ) break;
+					__AddRequest( _batch, _data, (Uint32)_ret, _peer );
+				}
+				return _batch->Count > 0;
+			#endif
+			}
+
+			// Send all replies of the batch, return the datagrams sent.
+			INLINE Uint32 __Send( __Batch * _batch )
+			{
+				SOCKET_T _so = _batch->Shard->Socket;
+				Uint32 _sent = 0;
+			#if PLIB_HAS_MMSG
+				Uint32 _cmsgSize = CMSG_SPACE( sizeof(Uint16) );
+				if ( _batch->SendMsgs.Size( ) < _batch->Count ) {
+					_batch->SendMsgs.Resize( _batch->Count );
+					_batch->SendIovs.Resize( _batch->Count );
+					_batch->SendControl.Resize( _cmsgSize * _batch->Count );
+				}
+				struct mmsghdr * _msgs = _batch->SendMsgs.Data( );
+				Uint32 _msgCount = 0, _iovCount = 0;
+				// Segment size, bytes and segments of the last message.
+				Uint32 _segment = 0, _bytes = 0, _segments = 0;
+				bool _closed = true;
+				for ( Uint32 i = 0; i < _batch->Count; ++i ) {
+					TRequest * _req = _batch->Requests[i];
+					if ( !_req->m_Valid || _req->m_Reply.empty( ) ) continue;
+					Uint32 _length = (Uint32)_req->m_Reply.size( );
+					struct iovec & _iov = _batch->SendIovs[_iovCount++];
+					_iov.iov_base = (void *)_req->m_Reply.data( );
+					_iov.iov_len = _length;
+					// GSO: same peer, no larger than the segment, only the last
+					// segment can be shorter.
+					if ( m_Gso && !_closed && _length <= _segment &&
+						_segments < GSO_MAX_SEGMENTS && _bytes + _length <= GSO_MAX_BYTES &&
+						memcmp( _msgs[_msgCount - 1].msg_hdr.msg_name, &_req->Peer, sizeof(_req->Peer) ) == 0 ) {
+						_msgs[_msgCount - 1].msg_hdr.msg_iovlen += 1;
+						_bytes += _length;
+						++_segments;
+						if ( _length < _segment ) _closed = true;
+						continue;
+					}
+					struct mmsghdr & _msg = _msgs[_msgCount++];
+					memset( &_msg, 0, sizeof(_msg) );
+					_msg.msg_hdr.msg_name = &_req->Peer;
+					_msg.msg_hdr.msg_namelen = sizeof(_req->Peer);
+					_msg.msg_hdr.msg_iov = &_iov;
+					_msg.msg_hdr.msg_iovlen = 1;
+					_segment = _bytes = _length;
+					_segments = 1;
+					_closed = false;
+				}
+				if ( m_Gso ) {
+					for ( Uint32 i = 0; i < _msgCount; ++i ) {
+						struct msghdr & _hdr = _msgs[i].msg_hdr;
+						if ( _hdr.msg_iovlen < 2 ) continue;
+						_hdr.msg_control = &_batch->SendControl[_cmsgSize * i];
+						_hdr.msg_controllen = _cmsgSize;
+						struct cmsghdr * _cmsg = CMSG_FIRSTHDR( &_hdr );
+						_cmsg->cmsg_level = SOL_UDP;
+						_cmsg->cmsg_type = UDP_SEGMENT;
+						_cmsg->cmsg_len = CMSG_LEN( sizeof(Uint16) );
+						Uint16 _size = (Uint16)_hdr.msg_iov[0].iov_len;
+						memcpy( CMSG_DATA( _cmsg ), &_size, sizeof(_size) );
+					}
+				}
+				for ( Uint32 _done = 0; _done < _msgCount; ) {
+					int _ret = ::sendmmsg( _so, _msgs + _done, _msgCount - _done, 0 );
+					if ( _ret < 0 && errno == EINTR ) continue;
+					if ( _ret <= 0 ) {
+						// Skip the failed one and go on.
+						++_done;
+						continue;
+					}
+					for ( int i = 0; i < _ret; ++i )
+						_sent += (Uint32)_msgs[_done + i].msg_hdr.msg_iovlen;
+					_done += (Uint32)_ret;
+				}
+			#else
+				for ( Uint32 i = 0; i < _batch->Count; ++i ) {
+					TRequest * _req = _batch->Requests[i];
+					if ( !_req->m_Valid || _req->m_Reply.empty( ) ) continue;
+					if ( ::sendto( _so, _req->m_Reply.data( ), (int)_req->m_Reply.size( ), 0,
+						(struct sockaddr *)&_req->Peer, sizeof(_req->Peer) ) >= 0 ) ++_sent;
+				}
+			#endif
+				return _sent;
+			}
+
+			// Receive thread of one shard.
+			void __ReceiveLoop( Uint32 _index )
+			{
+				__Shard * _shard = m_Shards[_index];
+				while ( Plib::Threading::ThreadSys::Running( ) )
+				{
+					__Batch * _batch;
+					// All batches are in the pool.
+					if ( !_shard->FreeBatch.Pop( _batch, RECV_TIMEOUT ) ) continue;
+					if ( !__Receive( _batch ) ) {
+						_shard->FreeBatch.Push( _batch );
+						continue;
+					}
+					// The pool is stopping, the batch is dropped. Only this
+					// batch goes back, the ready ones belong to their tasks.
+					if ( !m_WorkerPool.Submit( m_BatchTask ) ) {
+						m_Dropped->Add( _batch->Count );
+						_batch->Shard->FreeBatch.Push( _batch );
+						continue;
+					}
+					// The task waits for it in the ready queue.
+					m_Batches->Add( );
+					m_ReadyBatch.Push( _batch );
+				}
+			}
+
+			// Pool task, one for each received batch.
+			void __ProcessBatch( )
+			{
+				__Batch * _batch;
+				m_ReadyBatch.Pop( _batch );
+				Uint32 _dropped = 0;
+				for ( Uint32 i = 0; i < _batch->Count; ++i ) {
+					TRequest * _req = _batch->Requests[i];
+					if ( !_req->m_Valid ) { ++_dropped; continue; }
+					WorkProcess( *_req );
+				}
+				Uint32 _sent = __Send( _batch );
+				m_Received->Add( _batch->Count );
+				if ( _sent > 0 ) m_Sent->Add( _sent );
+				if ( _dropped > 0 ) m_Dropped->Add( _dropped );
+				_batch->Shard->FreeBatch.Push( _batch );
+			}
+		};
+	}
+}
+
+#endif // plib.network.datagramservice.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Deadline.hpp
+* Propose  			: Time budget of a request, inherited by the calls it makes.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_DEADLINE_HPP_
+#define _PLIB_NETWORK_DEADLINE_HPP_
+
+#if _DEF_IOS
+#include "Plib.hpp"
+#include "Atomic.hpp"
+#else
+#include <Plib-Basic/Plib.hpp>
+#include <Plib-Basic/Atomic.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Network
+	{
+		/*
+		 * The monotonic time a request must be answered by.
+		 * A default deadline is never reached. Every timeout of the
+		 * request is cut to what is left, so a slow peer can not keep it
+		 * past the budget.
+		 *
+		 * The service makes the deadline of the request current in the
+		 * worker thread while the work process runs. An outgoing request
+		 * made there takes the current deadline when it has none, and
+		 * its connect, write and read only get the time that is left.
+		 */
+		class Deadline
+		{
+		protected:
+			Uint64								m_Expire;	// us, 0 means never.
+
+			static INLINE Uint64 & __Current( )
+			{
+				static PLIB_THREAD_LOCAL Uint64 _expire = 0;
+				return _expire;
+			}
+
+		public:
+			Deadline( ) : m_Expire( 0 ) { }
+
+			// _mileSec from now, 0 means never.
+			static INLINE Deadline After( Uint32 _mileSec )
+			{
+				return Since( Plib::Basic::MonotonicMicroSeconds( ), _mileSec );
+			}
+
+			// _mileSec from the monotonic time _start in micro seconds.
+			static INLINE Deadline Since( Uint64 _start, Uint32 _mileSec )
+			{
+				Deadline _deadline;
+				if ( _mileSec != 0 ) _deadline.m_Expire = _start + (Uint64)_mileSec * 1000;
+				return _deadline;
+			}
+
+			// The deadline of the request served by this thread.
+			static INLINE Deadline Current( )
+			{
+				Deadline _deadline;
+				_deadline.m_Expire = __Current( );
+				return _deadline;
+			}
+
+			INLINE bool IsSet( ) const { return m_Expire != 0; }
+
+			INLINE bool Expired( ) const
+			{
+				return m_Expire != 0 && Plib::Basic::MonotonicMicroSeconds( ) >= m_Expire;
+			}
+
+			// Mile seconds left, (Uint32)-1 when never expires, 0 when expired.
+			INLINE Uint32 Remaining( ) const
+			{
+				if ( m_Expire == 0 ) return (Uint32)-1;
+				Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+				if ( _now >= m_Expire ) return 0;
+				Uint64 _left = ( m_Expire - _now + 999 ) / 1000;
+				return ( _left > 0xFFFFFFFEULL ) ? 0xFFFFFFFE : (Uint32)_left;
+			}
+
+			// The timeout cut to the time left, 0 when expired.
+			INLINE Uint32 Clamp( Uint32 _timeOut ) const
+			{
+				Uint32 _left = Remaining( );
+				return ( _left < _timeOut ) ? _left : _timeOut;
+			}
+
+			// The earlier of the two.
+			INLINE Deadline Min( const Deadline & _other ) const
+			{
+				if ( m_Expire == 0 ) return _other;
+				if ( _other.m_Expire == 0 || m_Expire <= _other.m_Expire ) return *this;
+				return _other;
+			}
+
+			friend class DeadlineScope;
+		};
+
+		// Make the deadline current in this thread until the scope ends.
+		class DeadlineScope
+		{
+		protected:
+			Uint64								m_Previous;
+
+		public:
+			DeadlineScope( const Deadline & _deadline )
+				: m_Previous( Deadline::__Current( ) )
+			{
+				Deadline::__Current( ) = _deadline.m_Expire;
+			}
+			~DeadlineScope( ) { Deadline::__Current( ) = m_Previous; }
+
+		private:
+			DeadlineScope( const DeadlineScope & );
+			DeadlineScope & operator = ( const DeadlineScope & );
+		};
+	}
+}
+
+#endif // plib.network.deadline.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Endpoint.hpp
+* Propose  			: Listen or connect address, TCP port or unix socket path.
+*
+* Current Version	: 1.1
+* Change Log		: First Definition.
+* Change Log		: 1.1: Reject the long path, remove only a stale socket file.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_ENDPOINT_HPP_
+#define _PLIB_NETWORK_ENDPOINT_HPP_
+
+#if _DEF_IOS
+#include "Plib.hpp"
+#else
+#include <Plib-Basic/Plib.hpp>
+#endif
+
+#if _DEF_WIN32
+	#include <WS2tcpip.h>
+	#define PLIB_HAS_UNIX_SOCKET	0
+#else
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <netinet/in.h>
+	#define PLIB_HAS_UNIX_SOCKET	1
+#endif
+
+namespace Plib
+{
+	namespace Network
+	{
+		/*
+		 * A TCP port on all addresses, or a unix stream socket path.
+		 * The path starting with '@' is in the abstract namespace of Linux,
+		 * it has no file and is gone with the last socket.
+		 * As a host string, "unix:/run/app.sock" or "unix:@app" is a path,
+		 * so the connect info and the client pool take it as a host.
+		 */
+		class Endpoint
+		{
+		public:
+			enum { PATH_MAX_LENGTH = 107 };
+
+		protected:
+			Uint32								m_Port;
+			bool								m_Unix;
+			char								m_Path[PATH_MAX_LENGTH + 1];
+
+		public:
+			Endpoint( ) : m_Port( 0 ), m_Unix( false ) { m_Path[0] = '\0'; }
+
+			static INLINE Endpoint Tcp( Uint32 _port )
+			{
+				Endpoint _endpoint;
+				_endpoint.m_Port = _port;
+				return _endpoint;
+			}
+
+			// The empty path or the one longer than PATH_MAX_LENGTH makes
+			// an endpoint not Valid, it is never cut to fit.
+			static INLINE Endpoint Unix( const char * _path )
+			{
+				Endpoint _endpoint;
+				_endpoint.m_Unix = true;
+				size_t _length = ( _path == NULL ) ? 0 : strlen( _path );
+				if ( _length > PATH_MAX_LENGTH ) _length = 0;
+				memcpy( _endpoint.m_Path, _path, _length );
+				_endpoint.m_Path[_length] = '\0';
+				return _endpoint;
+			}
+
+			static INLINE bool IsUnixHost( const char * _host )
+			{
+				return _host != NULL && strncmp( _host, "unix:", 5 ) == 0;
+			}
+
+			// From a host string and port.
+			static INLINE Endpoint Parse( const char * _host, Uint32 _port )
+			{
+				if ( IsUnixHost( _host ) ) return Unix( _host + 5 );
+				return Tcp( _port );
+			}
+
+			INLINE bool Valid( ) const { return !m_Unix || m_Path[0] != '\0'; }
+			INLINE bool IsUnix( ) const { return m_Unix; }
+			INLINE bool IsAbstract( ) const { return m_Unix && m_Path[0] == '@'; }
+			INLINE Uint32 Port( ) const { return m_Port; }
+			INLINE const char * Path( ) const { return m_Path; }
+
+			INLINE int Family( ) const
+			{
+			#if PLIB_HAS_UNIX_SOCKET
+				if ( m_Unix ) return AF_UNIX;
+			#endif
+				return AF_INET;
+			}
+
+			// Fill the socket address, return the length, 0 when not valid.
+			INLINE socklen_t Address( struct sockaddr_storage & _addr ) const
+			{
+				memset( &_addr, 0, sizeof(_addr) );
+				if ( !m_Unix ) {
+					struct sockaddr_in * _in = (struct sockaddr_in *)&_addr;
+					_in->sin_family = AF_INET;
+					_in->sin_addr.s_addr = htonl( INADDR_ANY );
+					_in->sin_port = htons( m_Port );
+					return sizeof(struct sockaddr_in);
+				}
+			#if PLIB_HAS_UNIX_SOCKET
+				size_t _length = strlen( m_Path );
+				if ( _length == 0 ) return 0;
+				struct sockaddr_un * _un = (struct sockaddr_un *)&_addr;
+				_un->sun_family = AF_UNIX;
+				memcpy( _un->sun_path, m_Path, _length );
+				// The abstract name starts with a zero byte, and is not
+				// ended by zero, the length tells where it ends.
+				if ( IsAbstract( ) ) _un->sun_path[0] = '\0';
+				return (socklen_t)( offsetof( struct sockaddr_un, sun_path ) + _length +
+					( IsAbstract( ) ? 0 : 1 ) );
+			#else
+				return 0;
+			#endif
+			}
+
+			// Remove the socket file left by the last run, only for the
+			// path of a unix endpoint not in the abstract namespace.
+			INLINE void Unlink( ) const
+			{
+			#if PLIB_HAS_UNIX_SOCKET
+				if ( m_Unix && m_Path[0] != '\0' && !IsAbstract( ) ) ::unlink( m_Path );
+			#endif
+			}
+
+			// Remove the socket file when no one listens on it any more,
+			// a connect to it is refused. Return true when removed.
+			// The file of a running listener or not a socket is kept.
+			INLINE bool UnlinkStale( ) const
+			{
+			#if PLIB_HAS_UNIX_SOCKET
+				if ( !m_Unix || m_Path[0] == '\0' || IsAbstract( ) ) return false;
+				struct stat _stat;
+				if ( ::lstat( m_Path, &_stat ) != 0 || !S_ISSOCK( _stat.st_mode ) ) return false;
+				struct sockaddr_storage _addr;
+				socklen_t _length = Address( _addr );
+				int _so = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+				if ( _so == -1 ) return false;
+				bool _stale = ( ::connect( _so, (struct sockaddr *)&_addr, _length ) == -1 &&
+					errno == ECONNREFUSED );
+				::close( _so );
+				return _stale && ::unlink( m_Path ) == 0;
+			#else
+				return false;
+			#endif
+			}
+		};
+	}
+}
+
+#endif // plib.network.endpoint.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
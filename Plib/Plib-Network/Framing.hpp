@@ -0,0 +1,318 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Framing.hpp
+* Propose  			: Incremental framing codecs of the request stream.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_FRAMING_HPP_
+#define _PLIB_NETWORK_FRAMING_HPP_
+
+#if _DEF_IOS
+#include "Plib.hpp"
+#else
+#include <Plib-Basic/Plib.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Network
+	{
+		typedef enum {
+			FRAME_UNFINISHED	= 0,
+			FRAME_DONE			= 1,
+			FRAME_ILLEAGE		= 2
+		} FRAMESTATUE;
+
+		// A complete frame inside the read buffer, without the header
+		// or the delimiter. Only valid until the buffer is changed.
+		struct FrameView
+		{
+			const char *						Data;
+			Uint32								Length;
+
+			FrameView( ) : Data( NULL ), Length( 0 ) { }
+		};
+
+		/*
+		 * All codecs share one interface:
+		 *		FRAMESTATUE Scan( const char * _data, Uint32 _size, FrameView & _frame );
+		 *		Uint32 Consumed( ) const;	// bytes of the frame with its header.
+		 *		void Clear( );				// ready for the next frame.
+		 *		template < typename _TyString >
+		 *		void Pack( _TyString & _out, const char * _data, Uint32 _length );
+		 * _data always starts at the first byte of the frame and only grows
+		 * between the calls, the codec remembers how far it has scanned.
+		 */
+
+		// Length prefixed frame, the header is an unsigned integer of
+		// _HeaderBytes (1, 2 or 4) bytes, big endian by default.
+		template < Uint32 _HeaderBytes = 4, bool _BigEndian = true >
+		class LengthPrefixCodec
+		{
+		protected:
+			Uint32								m_MaxLength;
+			Uint32								m_BodyLength;
+			bool								m_HeaderDone;
+
+		public:
+			LengthPrefixCodec( Uint32 _maxLength = 16 * 1024 * 1024 )
+				: m_MaxLength( _maxLength ), m_BodyLength( 0 ), m_HeaderDone( false )
+			{ CONSTRUCTURE; }
+			~LengthPrefixCodec( ) { DESTRUCTURE; }
+
+			INLINE void SetMaxLength( Uint32 _maxLength ) { m_MaxLength = _maxLength; }
+
+			INLINE FRAMESTATUE Scan( const char * _data, Uint32 _size, FrameView & _frame )
+			{
+				if ( !m_HeaderDone ) {
+					if ( _size < _HeaderBytes ) return FRAME_UNFINISHED;
+					const unsigned char * _header = (const unsigned char *)_data;
+					m_BodyLength = 0;
+					for ( Uint32 i = 0; i < _HeaderBytes; ++i ) {
+						Uint32 _byte = _BigEndian ? _header[i] : _header[_HeaderBytes - 1 - i];
+						m_BodyLength = ( m_BodyLength << 8 ) | _byte;
+					}
+					if ( m_BodyLength > m_MaxLength ) return FRAME_ILLEAGE;
+					m_HeaderDone = true;
+				}
+				if ( _size - _HeaderBytes < m_BodyLength ) return FRAME_UNFINISHED;
+				_frame.Data = _data + _HeaderBytes;
+				_frame.Length = m_BodyLength;
+				return FRAME_DONE;
+			}
+
+			INLINE Uint32 Consumed( ) const
+			{
+				return m_HeaderDone ? _HeaderBytes + m_BodyLength : 0;
+			}
+
+			INLINE void Clear( ) { m_BodyLength = 0; m_HeaderDone = false; }
+
+			template < typename _TyString >
+			INLINE void Pack( _TyString & _out, const char * _data, Uint32 _length )
+			{
+				char _header[_HeaderBytes];
+				for ( Uint32 i = 0; i < _HeaderBytes; ++i ) {
+					Uint32 _shift = 8 * ( _BigEndian ? _HeaderBytes - 1 - i : i );
+					_header[i] = (char)( ( (Uint64)_length >> _shift ) & 0xFF );
+				}
+				_out.Append( _header, _HeaderBytes );
+				_out.Append( _data, _length );
+			}
+		};
+
+		// Length prefixed frame, the header is a base 128 varint.
+		class VarintPrefixCodec
+		{
+		protected:
+			enum { VARINT_MAX_BYTES = 5 };
+
+			Uint32								m_MaxLength;
+			Uint32								m_BodyLength;
+			Uint32								m_HeaderLength;
+			bool								m_HeaderDone;
+
+		public:
+			VarintPrefixCodec( Uint32 _maxLength = 16 * 1024 * 1024 )
+				: m_MaxLength( _maxLength ), m_BodyLength( 0 ),
+				m_HeaderLength( 0 ), m_HeaderDone( false )
+			{ CONSTRUCTURE; }
+			~VarintPrefixCodec( ) { DESTRUCTURE; }
+
+			INLINE void SetMaxLength( Uint32 _maxLength ) { m_MaxLength = _maxLength; }
+
+			INLINE FRAMESTATUE Scan( const char * _data, Uint32 _size, FrameView & _frame )
+			{
+				// Continue from the last header byte already read.
+				while ( !m_HeaderDone ) {
+					if ( m_HeaderLength == _size ) return FRAME_UNFINISHED;
+					if ( m_HeaderLength == VARINT_MAX_BYTES ) return FRAME_ILLEAGE;
+					Uint64 _byte = (unsigned char)_data[m_HeaderLength];
+					Uint64 _value = m_BodyLength | ( ( _byte & 0x7F ) << ( 7 * m_HeaderLength ) );
+					if ( _value > m_MaxLength ) return FRAME_ILLEAGE;
+					m_BodyLength = (Uint32)_value;
+					++m_HeaderLength;
+					if ( ( _byte & 0x80 ) == 0 ) m_HeaderDone = true;
+				}
+				if ( _size - m_HeaderLength < m_BodyLength ) return FRAME_UNFINISHED;
+				_frame.Data = _data + m_HeaderLength;
+				_frame.Length = m_BodyLength;
+				return FRAME_DONE;
+			}
+
+			INLINE Uint32 Consumed( ) const
+			{
+				return m_HeaderDone ? m_HeaderLength + m_BodyLength : 0;
+			}
+
+			INLINE void Clear( )
+			{
+				m_BodyLength = 0;
+				m_HeaderLength = 0;
+				m_HeaderDone = false;
+			}
+
+			template < typename _TyString >
+			INLINE void Pack( _TyString & _out, const char * _data, Uint32 _length )
+			{
+				char _header[VARINT_MAX_BYTES];
+				Uint32 _headerLength = 0;
+				Uint32 _value = _length;
+				do {
+					_header[_headerLength] = (char)( _value & 0x7F );
+					_value >>= 7;
+					if ( _value != 0 ) _header[_headerLength] |= (char)0x80;
+					++_headerLength;
+				} while ( _value != 0 );
+				_out.Append( _header, _headerLength );
+				_out.Append( _data, _length );
+			}
+		};
+
+		// Frame ends with a delimiter, "\r\n" by default.
+		// The delimiter is at most 16 bytes and not part of the frame.
+		class DelimiterCodec
+		{
+		protected:
+			enum { DELIMITER_MAX_BYTES = 16 };
+
+			char								m_Delimiter[DELIMITER_MAX_BYTES];
+			Uint32								m_DelimiterLength;
+			Uint32								m_MaxLength;
+			// Next offset to search, the bytes before it hold no delimiter.
+			Uint32								m_Scanned;
+			Uint32								m_FrameLength;
+			bool								m_Done;
+
+		public:
+			DelimiterCodec( const char * _delimiter = "\r\n", Uint32 _maxLength = 64 * 1024 )
+				: m_DelimiterLength( 0 ), m_MaxLength( _maxLength ),
+				m_Scanned( 0 ), m_FrameLength( 0 ), m_Done( false )
+			{
+				CONSTRUCTURE;
+				SetDelimiter( _delimiter );
+			}
+			~DelimiterCodec( ) { DESTRUCTURE; }
+
+			INLINE void SetDelimiter( const char * _delimiter )
+			{
+				m_DelimiterLength = (Uint32)strlen( _delimiter );
+				if ( m_DelimiterLength > DELIMITER_MAX_BYTES ) m_DelimiterLength = DELIMITER_MAX_BYTES;
+				if ( m_DelimiterLength == 0 ) {
+					m_Delimiter[0] = '\n';
+					m_DelimiterLength = 1;
+				}
+				else memcpy( m_Delimiter, _delimiter, m_DelimiterLength );
+			}
+			INLINE void SetMaxLength( Uint32 _maxLength ) { m_MaxLength = _maxLength; }
+
+			INLINE FRAMESTATUE Scan( const char * _data, Uint32 _size, FrameView & _frame )
+			{
+				if ( !m_Done ) {
+					while ( m_Scanned + m_DelimiterLength <= _size ) {
+						const char * _hit = (const char *)memchr( _data + m_Scanned,
+							m_Delimiter[0], _size - m_Scanned - m_DelimiterLength + 1 );
+						if ( _hit == NULL ) {
+							m_Scanned = _size - m_DelimiterLength + 1;
+							break;
+						}
+						m_Scanned = (Uint32)( _hit - _data );
+						if ( memcmp( _hit, m_Delimiter, m_DelimiterLength ) == 0 ) {
+							m_FrameLength = m_Scanned;
+							m_Done = true;
+							break;
+						}
+						++m_Scanned;
+					}
+					if ( !m_Done ) {
+						if ( m_Scanned > m_MaxLength ) return FRAME_ILLEAGE;
+						return FRAME_UNFINISHED;
+					}
+				}
+				if ( m_FrameLength > m_MaxLength ) return FRAME_ILLEAGE;
+				_frame.Data = _data;
+				_frame.Length = m_FrameLength;
+				return FRAME_DONE;
+			}
+
+			INLINE Uint32 Consumed( ) const
+			{
+				return m_Done ? m_FrameLength + m_DelimiterLength : 0;
+			}
+
+			INLINE void Clear( )
+			{
+				m_Scanned = 0;
+				m_FrameLength = 0;
+				m_Done = false;
+			}
+
+			template < typename _TyString >
+			INLINE void Pack( _TyString & _out, const char * _data, Uint32 _length )
+			{
+				_out.Append( _data, _length );
+				_out.Append( m_Delimiter, m_DelimiterLength );
+			}
+		};
+
+		// Every frame has the same size.
+		class FixedSizeCodec
+		{
+		protected:
+			Uint32								m_FrameSize;
+			bool								m_Done;
+
+		public:
+			FixedSizeCodec( Uint32 _frameSize = 1 )
+				: m_FrameSize( _frameSize == 0 ? 1 : _frameSize ), m_Done( false )
+			{ CONSTRUCTURE; }
+			~FixedSizeCodec( ) { DESTRUCTURE; }
+
+			INLINE void SetFrameSize( Uint32 _frameSize ) { m_FrameSize = ( _frameSize == 0 ? 1 : _frameSize ); }
+
+			INLINE FRAMESTATUE Scan( const char * _data, Uint32 _size, FrameView & _frame )
+			{
+				if ( _size < m_FrameSize ) return FRAME_UNFINISHED;
+				m_Done = true;
+				_frame.Data = _data;
+				_frame.Length = m_FrameSize;
+				return FRAME_DONE;
+			}
+
+			INLINE Uint32 Consumed( ) const { return m_Done ? m_FrameSize : 0; }
+			INLINE void Clear( ) { m_Done = false; }
+
+			template < typename _TyString >
+			INLINE void Pack( _TyString & _out, const char * _data, Uint32 _length )
+			{
+				if ( _length > m_FrameSize ) _length = m_FrameSize;
+				_out.Append( _data, _length );
+				// Pad the short frame with zero.
+				static const char _zero[64] = { 0 };
+				for ( Uint32 _left = m_FrameSize - _length; _left > 0; ) {
+					Uint32 _step = ( _left > sizeof(_zero) ) ? (Uint32)sizeof(_zero) : _left;
+					_out.Append( _zero, _step );
+					_left -= _step;
+				}
+			}
+		};
+	}
+}
+
+#endif // plib.network.framing.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
@@ -0,0 +1,486 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: IoUringPoller.hpp
+* Propose  			: io_uring poller of the listener frame.
+*
+* Current Version	: 1.3
+* Change Log		: First Definition.
+* Change Log		: 1.1: Listen option.
+* Change Log		: 1.2: Listen on several endpoints.
+* Change Log		: 1.3: Publish the filled entries on submit, wait submits nothing.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_IOURINGPOLLER_HPP_
+#define _PLIB_NETWORK_IOURINGPOLLER_HPP_
+
+#if _DEF_IOS
+#include "Listener.hpp"
+#else
+#include <Plib-Network/Listener.hpp>
+#endif
+
+// Linux only, define PLIB_NO_IO_URING to leave it out.
+#if _DEF_LINUX && !defined(PLIB_NO_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#define PLIB_HAS_IO_URING		1
+#else
+#define PLIB_HAS_IO_URING		0
+#endif
+
+#if PLIB_HAS_IO_URING
+
+#include <map>
+#include <vector>
+
+namespace Plib
+{
+	namespace Network
+	{
+		/*
+		 * The rings of one io_uring instance, without liburing.
+		 * One thread at a time fills the submission queue and submits,
+		 * and one thread reads the completion queue. The entries from
+		 * GetSqe are published to the kernel by Submit, after they are
+		 * filled. Wait submits nothing, it may run beside the filler.
+		 * Needs the EXT_ARG feature (5.11) for the wait timeout.
+		 */
+		class IoUring
+		{
+		protected:
+			int									m_Fd;
+			Uint32								m_Features;
+
+			void *								m_SqPtr;
+			size_t								m_SqSize;
+			void *								m_CqPtr;
+			size_t								m_CqSize;
+			struct io_uring_sqe *				m_Sqes;
+			size_t								m_SqesSize;
+
+			volatile unsigned *					m_SqHead;
+			volatile unsigned *					m_SqTail;
+			unsigned *							m_SqArray;
+			unsigned							m_SqMask;
+			unsigned							m_SqEntries;
+			// Tail of the entries handed out, not published yet.
+			unsigned							m_SqLocalTail;
+			unsigned							m_ToSubmit;
+
+			volatile unsigned *					m_CqHead;
+			volatile unsigned *					m_CqTail;
+			unsigned							m_CqMask;
+			struct io_uring_cqe *				m_Cqes;
+
+			// Count of io_uring_enter calls.
+			Uint64								m_EnterCount;
+
+			INLINE int __Enter( unsigned _toSubmit, unsigned _minComplete,
+				unsigned _flags, void * _arg, size_t _argSize )
+			{
+				Plib::Basic::AtomicFetchAdd( &m_EnterCount, (Uint64)1, Plib::Basic::AO_RELAXED );
+				return (int)::syscall( __NR_io_uring_enter, m_Fd, _toSubmit,
+					_minComplete, _flags, _arg, _argSize );
+			}
+
+		private:
+			IoUring( const IoUring & );
+			IoUring & operator = ( const IoUring & );
+
+		public:
+			IoUring( )
+				: m_Fd( -1 ), m_Features( 0 ), m_SqPtr( MAP_FAILED ), m_SqSize( 0 ),
+				m_CqPtr( MAP_FAILED ), m_CqSize( 0 ), m_Sqes( (struct io_uring_sqe *)MAP_FAILED ),
+				m_SqesSize( 0 ), m_SqHead( NULL ), m_SqTail( NULL ), m_SqArray( NULL ),
+				m_SqMask( 0 ), m_SqEntries( 0 ), m_SqLocalTail( 0 ), m_ToSubmit( 0 ), m_CqHead( NULL ),
+				m_CqTail( NULL ), m_CqMask( 0 ), m_Cqes( NULL ), m_EnterCount( 0 )
+			{ CONSTRUCTURE; }
+			~IoUring( ) { DESTRUCTURE; Destroy( ); }
+
+			INLINE bool Valid( ) const { return m_Fd != -1; }
+			INLINE Uint64 EnterCount( ) const { return m_EnterCount; }
+
+			bool Setup( Uint32 _entries )
+			{
+				if ( m_Fd != -1 ) return true;
+				struct io_uring_params _params;
+				memset( &_params, 0, sizeof(_params) );
+				m_Fd = (int)::syscall( __NR_io_uring_setup, _entries, &_params );
+				if ( m_Fd < 0 ) { m_Fd = -1; return false; }
+				m_Features = _params.features;
+				if ( ( m_Features & IORING_FEAT_EXT_ARG ) == 0 ) { Destroy( ); return false; }
+
+				m_SqSize = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+				m_CqSize = _params.cq_off.cqes + _params.cq_entries * sizeof(struct io_uring_cqe);
+				bool _single = ( m_Features & IORING_FEAT_SINGLE_MMAP ) != 0;
+				if ( _single ) m_SqSize = m_CqSize = ( m_SqSize > m_CqSize ? m_SqSize : m_CqSize );
+				m_SqPtr = ::mmap( NULL, m_SqSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING );
+				if ( m_SqPtr == MAP_FAILED ) { Destroy( ); return false; }
+				if ( _single ) m_CqPtr = m_SqPtr;
+				else {
+					m_CqPtr = ::mmap( NULL, m_CqSize, PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING );
+					if ( m_CqPtr == MAP_FAILED ) { Destroy( ); return false; }
+				}
+				m_SqesSize = _params.sq_entries * sizeof(struct io_uring_sqe);
+				m_Sqes = (struct io_uring_sqe *)::mmap( NULL, m_SqesSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES );
+				if ( m_Sqes == MAP_FAILED ) { Destroy( ); return false; }
+
+				char * _sq = (char *)m_SqPtr;
+				m_SqHead = (volatile unsigned *)( _sq + _params.sq_off.head );
+				m_SqTail = (volatile unsigned *)( _sq + _params.sq_off.tail );
+				m_SqArray = (unsigned *)( _sq + _params.sq_off.array );
+				m_SqMask = *(unsigned *)( _sq + _params.sq_off.ring_mask );
+				m_SqEntries = _params.sq_entries;
+				char * _cq = (char *)m_CqPtr;
+				m_CqHead = (volatile unsigned *)( _cq + _params.cq_off.head );
+				m_CqTail = (volatile unsigned *)( _cq + _params.cq_off.tail );
+				m_CqMask = *(unsigned *)( _cq + _params.cq_off.ring_mask );
+				m_Cqes = (struct io_uring_cqe *)( _cq + _params.cq_off.cqes );
+				m_SqLocalTail = *m_SqTail;
+				m_ToSubmit = 0;
+				return true;
+			}
+
+			void Destroy( )
+			{
+				if ( m_Sqes != MAP_FAILED ) ::munmap( m_Sqes, m_SqesSize );
+				if ( m_CqPtr != MAP_FAILED && m_CqPtr != m_SqPtr ) ::munmap( m_CqPtr, m_CqSize );
+				if ( m_SqPtr != MAP_FAILED ) ::munmap( m_SqPtr, m_SqSize );
+				m_Sqes = (struct io_uring_sqe *)MAP_FAILED;
+				m_CqPtr = m_SqPtr = MAP_FAILED;
+				if ( m_Fd != -1 ) ::close( m_Fd );
+				m_Fd = -1;
+			}
+
+			// Next free submission entry, cleared. The kernel does not see
+			// it until Submit. Submit the queued ones first when the queue
+			// is full, so fill the entry before asking for the next one.
+			INLINE struct io_uring_sqe * GetSqe( )
+			{
+				unsigned _tail = m_SqLocalTail;
+				if ( _tail - Plib::Basic::AtomicLoad( m_SqHead, Plib::Basic::AO_ACQUIRE ) >= m_SqEntries ) {
+					Submit( );
+					if ( _tail - Plib::Basic::AtomicLoad( m_SqHead, Plib::Basic::AO_ACQUIRE ) >= m_SqEntries )
+						return NULL;
+				}
+				unsigned _index = _tail & m_SqMask;
+				struct io_uring_sqe * _sqe = &m_Sqes[_index];
+				memset( _sqe, 0, sizeof(*_sqe) );
+				m_SqArray[_index] = _index;
+				m_SqLocalTail = _tail + 1;
+				return _sqe;
+			}
+
+			// Publish the filled entries and pass them to the kernel.
+			INLINE int Submit( )
+			{
+				unsigned _published = *m_SqTail;
+				if ( m_SqLocalTail != _published ) {
+					m_ToSubmit += m_SqLocalTail - _published;
+					Plib::Basic::AtomicStore( m_SqTail, m_SqLocalTail, Plib::Basic::AO_RELEASE );
+				}
+				if ( m_ToSubmit == 0 ) return 0;
+				int _ret = __Enter( m_ToSubmit, 0, 0, NULL, 0 );
+				if ( _ret > 0 ) m_ToSubmit -= ( (unsigned)_ret > m_ToSubmit ? m_ToSubmit : (unsigned)_ret );
+				return _ret;
+			}
+
+			// Wait for one completion or the timeout, the queued entries
+			// are left to Submit. Return false on timeout or error.
+			INLINE bool Wait( Uint32 _timeOutUs )
+			{
+				if ( PeekReady( ) ) return true;
+				struct __kernel_timespec _ts;
+				_ts.tv_sec = _timeOutUs / 1000000;
+				_ts.tv_nsec = ( _timeOutUs % 1000000 ) * 1000;
+				struct io_uring_getevents_arg _arg;
+				memset( &_arg, 0, sizeof(_arg) );
+				_arg.ts = (Uint64)(size_t)&_ts;
+				__Enter( 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+					&_arg, sizeof(_arg) );
+				return PeekReady( );
+			}
+
+			INLINE bool PeekReady( ) const
+			{
+				return *m_CqHead != Plib::Basic::AtomicLoad( m_CqTail, Plib::Basic::AO_ACQUIRE );
+			}
+
+			// Copy out and consume the oldest completion.
+			INLINE bool PopCqe( struct io_uring_cqe & _cqe )
+			{
+				unsigned _head = *m_CqHead;
+				if ( _head == Plib::Basic::AtomicLoad( m_CqTail, Plib::Basic::AO_ACQUIRE ) ) return false;
+				_cqe = m_Cqes[_head & m_CqMask];
+				Plib::Basic::AtomicStore( m_CqHead, _head + 1, Plib::Basic::AO_RELEASE );
+				return true;
+			}
+		};
+
+		/*
+		 * io_uring poller.
+		 * Accepts with one multishot accept, and watches the kept alive
+		 * sockets with one shot poll requests, so an idle connection
+		 * costs no syscall. The readable socket is handed to the worker
+		 * as with the Selector, the worker reads it by SocketBasic.
+		 * KeepSockAlive submits the poll from the worker thread.
+		 */
+		template< typename _TySocketInside >
+		class IoUringPoller
+		{
+			friend class ListenerFrame< IoUringPoller< _TySocketInside > >;
+		public:
+			typedef _TySocketInside												ClientSocketT;
+			typedef Plib::Generic::Reference< ClientSocketT >					PollRefSockT;
+
+			typedef Plib::Generic::Delegate< bool ( PollRefSockT ) >			AddReadDelegate;
+			typedef Plib::Generic::Delegate< void ( PollRefSockT, bool ) >		ReleaseDelegate;
+			typedef Plib::Generic::Delegate< PollRefSockT ( ) >				GetFreeDelegate;
+
+		protected:
+			enum { RING_ENTRIES = 1024, WAIT_TIMEOUT = 10000, IDLE_SWEEP = 100 };
+			// Kind of the request, in the high byte of user_data.
+			enum { UD_ACCEPT = 1, UD_POLL = 2, UD_CANCEL = 3 };
+
+			struct _Watched
+			{
+				PollRefSockT						Sock;
+				Uint32								Generation;
+				Uint64								Since;		// ms
+				_Watched( ) : Sock( false ), Generation( 0 ), Since( 0 ) { }
+			};
+			typedef std::map< SOCKET_T, _Watched >						WatchMap;
+
+			// One multishot accept for each endpoint.
+			Plib::Generic::Vector< SOCKET_T >		_ListenFDs;
+			Plib::Generic::Vector< Endpoint >		_ListenEndpoints;
+			Uint64									_SocketIdleTime;
+			IoUring									_Ring;
+			// Guards the submission queue and the watched sockets.
+			Plib::Threading::Mutex					_RingLock;
+			WatchMap								_Watching;
+			Uint32									_Generation;
+			bool									_MultishotAccept;
+			Uint64									_LastSweep;
+			ListenOption							_Option;
+			Uint64									_OverflowBase;
+
+			IoUringPoller( )
+				: _SocketIdleTime( 120000 ), _Generation( 0 ),
+				_MultishotAccept( true ), _LastSweep( 0 ), _OverflowBase( 0 ) { CONSTRUCTURE; }
+			~IoUringPoller( ) { DESTRUCTURE; ShutdownListen( ); }
+
+			void SetMaxIdleTime( Uint64 _IdleTime ) { _SocketIdleTime = _IdleTime; }
+			void SetListenOption( const ListenOption & _NewOption ) { _Option = _NewOption; }
+
+			static INLINE Uint64 __UserData( Uint64 _kind, Uint32 _gen, SOCKET_T _fd )
+			{
+				return ( _kind << 56 ) | ( (Uint64)( _gen & 0xFFFFFF ) << 32 ) | (Uint32)_fd;
+			}
+
+			static INLINE Uint64 __NowMs( )
+			{
+				return Plib::Threading::MonotonicClock::CachedNanoSeconds( ) / 1000000;
+			}
+
+			// Must hold the ring lock.
+			INLINE bool __ArmAccept( SOCKET_T _ListenFD )
+			{
+				struct io_uring_sqe * _sqe = _Ring.GetSqe( );
+				if ( _sqe == NULL ) return false;
+				_sqe->opcode = IORING_OP_ACCEPT;
+				_sqe->fd = (int)_ListenFD;
+				_sqe->accept_flags = SOCK_CLOEXEC;
+				if ( _MultishotAccept ) _sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+				_sqe->user_data = __UserData( UD_ACCEPT, 0, _ListenFD );
+				return true;
+			}
+
+			// Must hold the ring lock.
+			INLINE bool __ArmPoll( PollRefSockT & _RefSock )
+			{
+				struct io_uring_sqe * _sqe = _Ring.GetSqe( );
+				if ( _sqe == NULL ) return false;
+				_Watched & _w = _Watching[_RefSock->hSo];
+				_w.Sock = _RefSock;
+				_w.Generation = ++_Generation;
+				_w.Since = __NowMs( );
+				_sqe->opcode = IORING_OP_POLL_ADD;
+				_sqe->fd = (int)_RefSock->hSo;
+				_sqe->poll32_events = POLLIN | POLLRDHUP;
+				_sqe->user_data = __UserData( UD_POLL, _w.Generation, _RefSock->hSo );
+				return true;
+			}
+
+			// Must hold the ring lock.
+			INLINE void __CancelPoll( SOCKET_T _fd, Uint32 _gen )
+			{
+				struct io_uring_sqe * _sqe = _Ring.GetSqe( );
+				if ( _sqe == NULL ) return;
+				_sqe->opcode = IORING_OP_POLL_REMOVE;
+				_sqe->fd = -1;
+				_sqe->addr = __UserData( UD_POLL, _gen, _fd );
+				_sqe->user_data = __UserData( UD_CANCEL, 0, _fd );
+			}
+
+			INLINE LF_RETCODE ListenOn( const Endpoint * _Endpoints, Uint32 _Count, Uint32 _MaxSupport )
+			{
+				if ( _ListenFDs.Size( ) != 0 ) return LF_ALRSTART;
+				if ( !_Ring.Setup( RING_ENTRIES ) ) return LF_ESOCKET;
+
+				for ( Uint32 i = 0; i < _Count; ++i ) {
+					LF_RETCODE _Ret;
+					SOCKET_T _ListenFD = OpenListenSocket( _Endpoints[i], _Option, _MaxSupport, _Ret );
+					if ( _ListenFD == -1 ) {
+						ShutdownListen( );
+						_Ring.Destroy( );
+						return _Ret;
+					}
+					_ListenFDs.PushBack( _ListenFD );
+					_ListenEndpoints.PushBack( _Endpoints[i] );
+				}
+
+				_OverflowBase = ListenOverflows( );
+				Plib::Threading::Locker _RingLocker( _RingLock );
+				for ( Uint32 i = 0; i < _ListenFDs.Size( ); ++i ) __ArmAccept( _ListenFDs[i] );
+				_Ring.Submit( );
+				return LF_SUCCESS;
+			}
+
+			INLINE LF_RETCODE ListenOnPort( Uint32 _Port, Uint32 _MaxSupport )
+			{
+				Endpoint _Endpoint = Endpoint::Tcp( _Port );
+				return ListenOn( &_Endpoint, 1, _MaxSupport );
+			}
+
+			// From the worker thread, the poll is submitted at once.
+			INLINE void KeepSockAlive( PollRefSockT _RefSock )
+			{
+				Plib::Threading::Locker _RingLocker( _RingLock );
+				if ( _ListenFDs.Size( ) == 0 || !__ArmPoll( _RefSock ) ) {
+					_RefSock->Close( );
+					return;
+				}
+				_Ring.Submit( );
+			}
+
+			INLINE LF_RETCODE ShutdownListen( )
+			{
+				if ( _ListenFDs.Size( ) == 0 ) return LF_SUCCESS;
+				Plib::Threading::Locker _RingLocker( _RingLock );
+				_Watching.clear( );
+				for ( Uint32 i = 0; i < _ListenFDs.Size( ); ++i ) {
+					PLIB_NETWORK_CLOSESOCK( _ListenFDs[i] );
+					_ListenEndpoints[i].Unlink( );
+				}
+				_ListenFDs.Clear( );
+				_ListenEndpoints.Clear( );
+				_Ring.Destroy( );
+				return LF_SUCCESS;
+			}
+
+			INLINE LF_RETCODE LoopPoll( AddReadDelegate & _AddD,
+				ReleaseDelegate & _RelD, GetFreeDelegate & _GetD )
+			{
+				PLIB_PROFILE_ZONE( "IoUringPoller::LoopPoll" );
+				if ( _ListenFDs.Size( ) == 0 ) return LF_ESELECT;
+				_Ring.Wait( WAIT_TIMEOUT );
+				Plib::Threading::MonotonicClock::UpdateCachedNow( );
+				Uint64 _now = __NowMs( );
+
+				// Collect under the lock, call the delegates after it.
+				std::vector< SOCKET_T > _accepted;
+				std::vector< PollRefSockT > _readable, _closed;
+				{
+					Plib::Threading::Locker _RingLocker( _RingLock );
+					struct io_uring_cqe _cqe;
+					while ( _Ring.PopCqe( _cqe ) ) {
+						Uint64 _kind = _cqe.user_data >> 56;
+						if ( _kind == UD_ACCEPT ) {
+							if ( _cqe.res >= 0 ) _accepted.push_back( _cqe.res );
+							else if ( _cqe.res == -EINVAL && _MultishotAccept )
+								_MultishotAccept = false;	// Before 5.19.
+							if ( ( _cqe.flags & IORING_CQE_F_MORE ) == 0 )
+								__ArmAccept( (SOCKET_T)(Uint32)_cqe.user_data );
+							continue;
+						}
+						if ( _kind != UD_POLL ) continue;
+						SOCKET_T _fd = (SOCKET_T)(Uint32)_cqe.user_data;
+						Uint32 _gen = (Uint32)( _cqe.user_data >> 32 ) & 0xFFFFFF;
+						typename WatchMap::iterator _it = _Watching.find( _fd );
+						// The poll of a socket already released.
+						if ( _it == _Watching.end( ) || ( _it->second.Generation & 0xFFFFFF ) != _gen )
+							continue;
+						if ( _cqe.res > 0 && ( _cqe.res & POLLIN ) ) _readable.push_back( _it->second.Sock );
+						else _closed.push_back( _it->second.Sock );
+						_Watching.erase( _it );
+					}
+					// Idle check, a few times a second.
+					if ( _now - _LastSweep >= IDLE_SWEEP ) {
+						_LastSweep = _now;
+						for ( typename WatchMap::iterator _it = _Watching.begin( );
+							_it != _Watching.end( ); ) {
+							if ( _now - _it->second.Since < _SocketIdleTime ) { ++_it; continue; }
+							__CancelPoll( _it->first, _it->second.Generation );
+							_closed.push_back( _it->second.Sock );
+							_Watching.erase( _it++ );
+						}
+					}
+					_Ring.Submit( );
+				}
+
+				for ( Uint32 i = 0; i < _accepted.size( ); ++i ) {
+					PollRefSockT _FreeSock = _GetD( );
+					_FreeSock->Bind( _accepted[i], true );
+					KeepSockAlive( _FreeSock );
+				}
+				for ( Uint32 i = 0; i < _readable.size( ); ++i ) {
+					if ( !_AddD( _readable[i] ) ) _RelD( _readable[i], false );
+				}
+				for ( Uint32 i = 0; i < _closed.size( ); ++i ) _RelD( _closed[i], false );
+				return LF_SUCCESS;
+			}
+
+		public:
+			// io_uring_enter calls since the listen, for the benchmark.
+			INLINE Uint64 EnterCount( ) const { return _Ring.EnterCount( ); }
+
+			// Connections dropped by full accept queues since listening,
+			// see Selector::AcceptOverflows.
+			INLINE Uint64 AcceptOverflows( ) const
+			{
+				Uint64 _Now = ListenOverflows( );
+				return ( _Now > _OverflowBase ) ? _Now - _OverflowBase : 0;
+			}
+
+			INLINE static bool IsErrorFatal( Uint32 _errCode )
+			{
+				if ( _errCode == EINVAL || _errCode == ENOMEM || _errCode == EINTR || _errCode == ETIME )
+					return false;
+				return true;
+			}
+		};
+	}
+}
+
+#endif // PLIB_HAS_IO_URING
+
+#endif // plib.network.iouringpoller.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
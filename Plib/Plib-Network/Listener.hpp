@@ -5,8 +5,17 @@
 * File Name			: listener.hpp
 * Propose  			: A Listener Frame.
 * 
-* Current Version	: 1.0
+* Current Version	: 1.9
 * Change Log		: First Definition.
+* Change Log		: 1.1: Statue is read without lock.
+* Change Log		: 1.2: Accept, readable queue and connection metrics.
+* Change Log		: 1.3: Access to the poller.
+* Change Log		: 1.4: Listen option, backlog up to somaxconn, accept overflows.
+* Change Log		: 1.5: Listen on unix socket paths together with the port.
+* Change Log		: 1.6: Count the readable sockets dropped by a full list.
+* Change Log		: 1.7: One event table for all the accepted sockets.
+* Change Log		: 1.8: Count the connections in the accept path only.
+* Change Log		: 1.9: Keep the socket file of a live listener, reject invalid endpoints.
 * Author			: Push Chen
 * Change Date		: 2011-01-11
 */
@@ -46,27 +55,169 @@ namespace Plib
 			LF_FULLQUEUE	// Select Queue is full.
 		} LF_RETCODE;
 
+		// Options of the listen socket, set before Listen.
+		struct ListenOption
+		{
+			Uint32							Backlog;		// 0 to use the max support, at most somaxconn.
+			Uint32							AcceptBatch;	// Max clients accepted in one poll loop.
+			Uint32							DeferAccept;	// Seconds to wait for the first data, Linux only.
+			bool							NoDelay;
+
+			ListenOption( ) : Backlog( 0 ), AcceptBatch( 256 ), DeferAccept( 0 ), NoDelay( true ) { }
+		};
+
+		// The max backlog the system takes.
+		INLINE Uint32 ListenBacklogLimit( )
+		{
+		#if _DEF_LINUX
+			Uint32 _Limit = 0;
+			FILE * _Fp = fopen( "/proc/sys/net/core/somaxconn", "r" );
+			if ( _Fp != NULL ) {
+				if ( fscanf( _Fp, "%u", &_Limit ) != 1 ) _Limit = 0;
+				fclose( _Fp );
+			}
+			if ( _Limit > 0 ) return _Limit;
+		#endif
+			return SOMAXCONN;
+		}
+
+		INLINE Uint32 ListenBacklog( const ListenOption & _Option, Uint32 _MaxSupport )
+		{
+			Uint32 _Backlog = ( _Option.Backlog == 0 ) ? _MaxSupport : _Option.Backlog;
+			Uint32 _Limit = ListenBacklogLimit( );
+			if ( _Backlog > _Limit ) _Backlog = _Limit;
+			return ( _Backlog == 0 ) ? 1 : _Backlog;
+		}
+
+		// Set on the listen socket before listen. On Linux the accepted
+		// sockets inherit TCP_NODELAY, so it is not set on each client.
+		INLINE bool ApplyListenOption( SOCKET_T _ListenFD, const ListenOption & _Option )
+		{
+			int _Val = 1;
+		#if _DEF_LINUX
+			if ( _Option.NoDelay && setsockopt( _ListenFD, IPPROTO_TCP, 
+				TCP_NODELAY, (const char *)&_Val, sizeof(_Val) ) != 0 ) return false;
+			_Val = (int)_Option.DeferAccept;
+			if ( _Val > 0 && setsockopt( _ListenFD, IPPROTO_TCP, 
+				TCP_DEFER_ACCEPT, (const char *)&_Val, sizeof(_Val) ) != 0 ) return false;
+		#endif
+			return true;
+		}
+
+		// The options the client socket does not inherit.
+		template < typename _TySocket >
+		INLINE void ApplyAcceptedOption( _TySocket & _Sock, const ListenOption & _Option )
+		{
+		#if !_DEF_LINUX
+			// Other systems copy the non-blocking flag of the listen socket.
+			unsigned long _u = 0;
+			PLIB_NETWORK_IOCTL_CALL( _Sock.hSo, FIONBIO, &_u );
+			if ( _Option.NoDelay ) _Sock.SetNoDelay( );
+		#endif
+		}
+
+		// Create, bind and listen the socket of the endpoint.
+		// Return -1 on error, with the reason in _Ret.
+		INLINE SOCKET_T OpenListenSocket( const Endpoint & _Endpoint, 
+			const ListenOption & _Option, Uint32 _MaxSupport, LF_RETCODE & _Ret )
+		{
+			struct sockaddr_storage _Addr;
+			socklen_t _AddrLen = _Endpoint.Address( _Addr );
+			if ( _AddrLen == 0 ) {
+				_Ret = LF_INVALIDP;
+				return -1;
+			}
+			SOCKET_T _ListenFD = ::socket( _Endpoint.Family( ), SOCK_STREAM, 0 );
+			if ( _ListenFD == -1 ) {
+				_Ret = LF_ESOCKET;
+				return -1;
+			}
+
+			_Ret = LF_SUCCESS;
+			int _Val = 1;
+			if ( !_Endpoint.IsUnix( ) && ( setsockopt( _ListenFD, SOL_SOCKET, 
+				SO_REUSEADDR, (const char *)&_Val, sizeof(_Val) ) != 0 ||
+				!ApplyListenOption( _ListenFD, _Option ) ) )
+				_Ret = LF_ESETOPT;
+			if ( _Ret == LF_SUCCESS && 
+				::bind( _ListenFD, (struct sockaddr *)&_Addr, _AddrLen ) == -1 ) {
+				_Ret = LF_EBIND;
+				// The file left by the last run makes bind fail, remove it
+				// only when no one listens there.
+				if ( _Endpoint.IsUnix( ) && errno == EADDRINUSE && _Endpoint.UnlinkStale( ) &&
+					::bind( _ListenFD, (struct sockaddr *)&_Addr, _AddrLen ) == 0 )
+					_Ret = LF_SUCCESS;
+			}
+			if ( _Ret == LF_SUCCESS && 
+				::listen( _ListenFD, ListenBacklog( _Option, _MaxSupport ) ) == -1 )
+				_Ret = LF_ELISTEN;
+			if ( _Ret != LF_SUCCESS ) {
+				PLIB_NETWORK_CLOSESOCK( _ListenFD );
+				return -1;
+			}
+			return _ListenFD;
+		}
+
+		// Connections dropped by full accept queues of the system,
+		// TcpExt ListenOverflows. Always 0 other than Linux.
+		INLINE Uint64 ListenOverflows( )
+		{
+			Uint64 _Count = 0;
+		#if _DEF_LINUX
+			FILE * _Fp = fopen( "/proc/net/netstat", "r" );
+			if ( _Fp == NULL ) return 0;
+			char * _Line = NULL, * _Names = NULL;
+			size_t _Cap = 0;
+			// Lines come in pairs, the names and then the values.
+			while ( ::getline( &_Line, &_Cap, _Fp ) > 0 ) {
+				if ( strncmp( _Line, "TcpExt:", 7 ) != 0 ) continue;
+				if ( _Names == NULL ) { _Names = strdup( _Line ); continue; }
+				char * _NSave = NULL, * _VSave = NULL;
+				char * _Name = strtok_r( _Names, " \n", &_NSave );
+				char * _Value = strtok_r( _Line, " \n", &_VSave );
+				while ( _Name != NULL && _Value != NULL ) {
+					if ( strcmp( _Name, "ListenOverflows" ) == 0 ) {
+						_Count = strtoull( _Value, NULL, 10 );
+						break;
+					}
+					_Name = strtok_r( NULL, " \n", &_NSave );
+					_Value = strtok_r( NULL, " \n", &_VSave );
+				}
+				break;
+			}
+			free( _Names );
+			free( _Line );
+			fclose( _Fp );
+		#endif
+			return _Count;
+		}
+
 		template < typename _TyPoller >
 		class ListenerFrame
 		{
 		public:
 			// Internal Typedef.
 			typedef Plib::Generic::Reference< typename _TyPoller::ClientSocketT >	RefSocketT;
+			typedef typename _TyPoller::ClientSocketT::SockEvents					SockEventsT;
 			typedef Plib::Generic::RDequeue< RefSocketT >							SocketListT;
 			typedef Uint32															PortT;
 			
 			enum { VALID_MIN_PORT = 1, VALID_MAX_PORT = 65535 };
 			enum { DEFAULT_MAX_SUPPORT = 0xFFFF };
 		protected:
+			// Shared by all the sockets, lives longer than them.
+			SockEventsT						_Events;
 			_TyPoller						_FDPoller;
 			SocketListT						_SL_Free;
 			SocketListT						_SL_Readable;
 
 			Uint32							_MaxSupport;
 			PortT							_ListenPort;
+			// Listened together with the port.
+			Plib::Generic::Vector< Endpoint >	_Endpoints;
 
-			bool							_Statue;
-			Plib::Threading::RWLock			_StatueLock;
+			// Read by every socket release, set only on listen and shutdown.
+			Plib::Threading::SeqLock< bool >	_Statue;
 
 			Plib::Threading::Mutex			_FreeListLock;
 			Plib::Threading::Mutex			_ReadListLock;
@@ -74,6 +225,12 @@ namespace Plib
 
 			Plib::Threading::Thread< void () >		_PollingThread;
 
+			// Updated without lock, see RegisterMetrics.
+			Plib::Utility::MetricCounter	_AcceptCount;
+			Plib::Utility::MetricGauge		_ReadableDepth;
+			Plib::Utility::MetricGauge		_ActiveCount;
+			Plib::Utility::MetricCounter	_ReadableDropped;
+
 		public:
 			Plib::Generic::Delegate< bool ( Uint32 ) >	OnPollLoopError;
 			Plib::Generic::Delegate< void( Uint32 ) > 	OnPortLose;
@@ -85,28 +242,45 @@ namespace Plib
 			INLINE RefSocketT GetFreeSockItem( )
 			{
 				Plib::Threading::Locker _FLLock( _FreeListLock );
-				if ( _SL_Free.Empty() ) return RefSocketT( true );
+				if ( _SL_Free.Empty() ) {
+					RefSocketT _NewSock( true );
+					_NewSock->ShareEvents( &_Events );
+					return _NewSock;
+				}
 				RefSocketT _RefSock = _SL_Free.Head();
 				_SL_Free.PopFront( );
 				return _RefSock;
 			}
 
+			// The item for a client the poller has just accepted,
+			// counted as a new active connection.
+			INLINE RefSocketT GetAcceptedSockItem( )
+			{
+				_AcceptCount.Add( );
+				_ActiveCount.Add( );
+				return GetFreeSockItem( );
+			}
+
 			// Add Readable Socket to the list.
 			// if the list is full( semaphore up to the max support )
 			// return false.
 			INLINE bool AddReadableSocket( RefSocketT _RefSock )
 			{
 				Plib::Threading::Locker _RLLocker( _ReadListLock );
-				if ( !_ReadableSem.Release( ) ) return false;
+				if ( !_ReadableSem.Release( ) ) {
+					// The poller closes it.
+					_ReadableDropped.Add( );
+					return false;
+				}
 				_SL_Readable.PushBack( _RefSock );
+				_ReadableDepth.Add( );
 				return true;
 			}
 
 			// Statue Change
 			INLINE void SetStatue( bool _Stat )
 			{
-				Plib::Threading::WriteLocker _StatWLock( _StatueLock );
-				_Statue = _Stat;
+				_Statue.Write( _Stat );
 			}
 
 		protected:
@@ -120,7 +294,7 @@ namespace Plib
 				Plib::Generic::Delegate< void ( RefSocketT, bool ) > 
 					_ReleaseSockDelg( this, &ListenerFrame::ReleaseSocket );
 				Plib::Generic::Delegate< RefSocketT ( ) >
-					_GetFreeSockDelg( this, &ListenerFrame::GetFreeSockItem );
+					_GetFreeSockDelg( this, &ListenerFrame::GetAcceptedSockItem );
 
 				while ( Plib::Threading::ThreadSys::Running() )
 				{
@@ -183,6 +357,7 @@ namespace Plib
 				Plib::Threading::Locker _RLLock( _ReadListLock );
 				RefSocketT _RefSock = _SL_Readable.Head();
 				_SL_Readable.PopFront( );
+				_ReadableDepth.Sub( );
 				return _RefSock;
 			}
 		
@@ -192,6 +367,7 @@ namespace Plib
 				if ( _RefSock.RefNull( ) ) return;
 				if ( !_KeepAlive || _RefSock->Statue == SOST_EMPTY || !Statue( ) ) {
 					_RefSock->Close( );
+					_ActiveCount.Sub( );
 					Plib::Threading::Locker _FLLock( _FreeListLock );
 					_SL_Free.PushBack( _RefSock );
 					return;
@@ -202,9 +378,12 @@ namespace Plib
 			INLINE LF_RETCODE Listen( PortT _OnPort = 0 )
 			{
 				if ( Statue( ) ) return LF_ALRSTART;
-				if ( _OnPort == 0 && _ListenPort == 0) return LF_INVALIDP;
 				if ( _OnPort != 0 ) _ListenPort = _OnPort;
-				LF_RETCODE _RTC = _FDPoller.ListenOnPort( _ListenPort, _MaxSupport );
+				Plib::Generic::Vector< Endpoint > _All;
+				if ( _ListenPort != 0 ) _All.PushBack( Endpoint::Tcp( _ListenPort ) );
+				for ( Uint32 i = 0; i < _Endpoints.Size( ); ++i ) _All.PushBack( _Endpoints[i] );
+				if ( _All.Size( ) == 0 ) return LF_INVALIDP;
+				LF_RETCODE _RTC = _FDPoller.ListenOn( _All.Data( ), _All.Size( ), _MaxSupport );
 				if ( _RTC != LF_SUCCESS ) return _RTC;
 
 				_ReadableSem.Init( 0, _MaxSupport );
@@ -225,13 +404,46 @@ namespace Plib
 			}
 
 			INLINE bool Statue( ) {
-				Plib::Threading::ReadLocker _StatRLock( _StatueLock );
-				return _Statue;
+				return _Statue.Read( );
 			}
 			
 			INLINE void SetIdleTime( Uint32 _IdleTime ) {
 				_FDPoller.SetMaxIdleTime( _IdleTime );
 			}
+
+			// Take effect on the next Listen.
+			INLINE void SetListenOption( const ListenOption & _Option ) {
+				_FDPoller.SetListenOption( _Option );
+			}
+
+			// Also listen on the endpoint, a unix socket path for the
+			// local peers. Take effect on the next Listen, which needs
+			// no port when there is any endpoint.
+			// Return false for the endpoint not valid.
+			INLINE bool AddEndpoint( const Endpoint & _Endpoint ) {
+				if ( !_Endpoint.Valid( ) ) return false;
+				_Endpoints.PushBack( _Endpoint );
+				return true;
+			}
+
+			// The events of all the accepted sockets, set before Listen.
+			INLINE SockEventsT & Events( ) {
+				return _Events;
+			}
+
+			// The poller, for its own statistics.
+			INLINE _TyPoller & Poller( ) {
+				return _FDPoller;
+			}
+
+			// Add the listener metrics to the registry, with the name prefix.
+			INLINE void RegisterMetrics( Plib::Utility::MetricsRegistry & _Registry, 
+				const std::string & _Prefix = "listener." ) {
+				_Registry.Register( _Prefix + "accepted", _AcceptCount );
+				_Registry.Register( _Prefix + "readable_queue", _ReadableDepth );
+				_Registry.Register( _Prefix + "active_connections", _ActiveCount );
+				_Registry.Register( _Prefix + "readable_dropped", _ReadableDropped );
+			}
 		};
 	}
 }
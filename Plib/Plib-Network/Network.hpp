@@ -17,6 +17,13 @@
 #define _PLIB_NETWORK_NETWORK_HPP_
 
 #if _DEF_IOS
+#include "Admission.hpp"
+#include "ClientPool.hpp"
+#include "DatagramService.hpp"
+#include "Deadline.hpp"
+#include "Endpoint.hpp"
+#include "Framing.hpp"
+#include "IoUringPoller.hpp"
 #include "Listener.hpp"
 #include "Network.hpp"
 #include "Request.hpp"
@@ -25,7 +32,15 @@
 #include "Service.hpp"
 #include "Socketbasic.hpp"
 #include "Syncsock.hpp"
+#include "WriteBatch.hpp"
 #else
+#include <Plib-Network/Admission.hpp>
+#include <Plib-Network/ClientPool.hpp>
+#include <Plib-Network/DatagramService.hpp>
+#include <Plib-Network/Deadline.hpp>
+#include <Plib-Network/Endpoint.hpp>
+#include <Plib-Network/Framing.hpp>
+#include <Plib-Network/IoUringPoller.hpp>
 #include <Plib-Network/Listener.hpp>
 #include <Plib-Network/Network.hpp>
 #include <Plib-Network/Request.hpp>
@@ -34,6 +49,7 @@
 #include <Plib-Network/Service.hpp>
 #include <Plib-Network/Socketbasic.hpp>
 #include <Plib-Network/Syncsock.hpp>
+#include <Plib-Network/WriteBatch.hpp>
 #endif
 
 #endif // plib.network.network.hpp
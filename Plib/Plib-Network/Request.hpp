@@ -5,8 +5,14 @@
 * File Name			: Request.hpp
 * Propose  			: The server/client request object template
 * 
-* Current Version	: 1.0
+* Current Version	: 1.6
 * Change Log		: First Definition.
+* Change Log		: 1.1: Pipelined requests on one connection.
+* Change Log		: 1.2: Framing codec before the parser.
+* Change Log		: 1.3: Outgoing connections are borrowed from the client pool.
+* Change Log		: 1.4: Deadline of the request, outgoing calls inherit it.
+* Change Log		: 1.5: The keep-alive request holds no buffer while idle.
+* Change Log		: 1.6: The client pool is opt-in.
 * Author			: Push Chen
 * Change Date		: 2011-06-10
 */
@@ -17,8 +23,14 @@
 #define _PLIB_NETWORK_REQUEST_HPP_
 
 #if _DEF_IOS
+#include "ClientPool.hpp"
+#include "Deadline.hpp"
+#include "Framing.hpp"
 #include "Response.hpp"
 #else
+#include <Plib-Network/ClientPool.hpp>
+#include <Plib-Network/Deadline.hpp>
+#include <Plib-Network/Framing.hpp>
 #include <Plib-Network/Response.hpp>
 #endif
 
@@ -26,6 +38,88 @@ namespace Plib
 {
 	namespace Network
 	{
+		// A parser supports pipelining by defining
+		//		typedef void PipelineTag;
+		//		Uint32 Consumed( ) const;	// bytes of the request just parsed.
+		// The bytes after the parsed request stay in the buffer and are
+		// parsed as the next requests of the same connection.
+		template < typename _TyParser >
+		struct ParserPipelineTraits
+		{
+			template < typename _Ty > static char __Test( typename _Ty::PipelineTag * );
+			template < typename _Ty > static long __Test( ... );
+			enum { Enabled = ( sizeof(__Test< _TyParser >( 0 )) == sizeof(char) ) };
+		};
+
+		template < typename _TyParser, bool _Enabled = ParserPipelineTraits< _TyParser >::Enabled >
+		struct __PipelineConsumed
+		{
+			static INLINE Uint32 Get( const _TyParser & ) { return 0; }
+		};
+		template < typename _TyParser >
+		struct __PipelineConsumed< _TyParser, true >
+		{
+			static INLINE Uint32 Get( const _TyParser & _parser ) { return _parser.Consumed( ); }
+		};
+
+		// A parser reads framed requests by defining
+		//		typedef DelimiterCodec FramingCodec;	// any codec in Framing.hpp
+		//		SOCKEVENTSTATUE ParseFrame( SyncSock * _pSo, const FrameView & _frame );
+		// The request scans the stream with the codec and only calls the
+		// parser with a complete frame. Framed requests are pipelined by
+		// the codec, the parser needs no Consumed( ).
+		template < typename _TyParser >
+		struct ParserFramingTraits
+		{
+			template < typename _Ty > static char __Test( typename _Ty::FramingCodec * );
+			template < typename _Ty > static long __Test( ... );
+			enum { Enabled = ( sizeof(__Test< _TyParser >( 0 )) == sizeof(char) ) };
+		};
+
+		struct __NoFramingCodec
+		{
+			INLINE void Clear( ) { }
+		};
+
+		template < typename _TyParser, bool _Framed = ParserFramingTraits< _TyParser >::Enabled >
+		struct __ParseIncoming
+		{
+			typedef __NoFramingCodec									Codec;
+
+			template < typename _TyConnect >
+			static INLINE SOCKEVENTSTATUE Parse( _TyParser & _parser, Codec &,
+				_TyConnect * _pSo, Plib::Text::RString * _buffer )
+			{
+				return _parser.ParseIncoming( _pSo, _buffer );
+			}
+			static INLINE Uint32 Consumed( const _TyParser & _parser, const Codec & )
+			{
+				return __PipelineConsumed< _TyParser >::Get( _parser );
+			}
+		};
+		template < typename _TyParser >
+		struct __ParseIncoming< _TyParser, true >
+		{
+			typedef typename _TyParser::FramingCodec					Codec;
+
+			// The codec keeps the scan position, a partial frame is not
+			// scanned again on the next read.
+			template < typename _TyConnect >
+			static INLINE SOCKEVENTSTATUE Parse( _TyParser & _parser, Codec & _codec,
+				_TyConnect * _pSo, Plib::Text::RString * _buffer )
+			{
+				FrameView _frame;
+				FRAMESTATUE _ret = _codec.Scan( _buffer->C_Str( ), _buffer->Size( ), _frame );
+				if ( _ret == FRAME_UNFINISHED ) return SOEVENT_UNFINISHED;
+				if ( _ret == FRAME_ILLEAGE ) return SOEVENT_ILLEAGE;
+				return _parser.ParseFrame( _pSo, _frame );
+			}
+			static INLINE Uint32 Consumed( const _TyParser &, const Codec & _codec )
+			{
+				return _codec.Consumed( );
+			}
+		};
+
 		// Request definition
 		template< typename _TyParser, typename _TyConnect >
 		class _Request
@@ -34,33 +128,57 @@ namespace Plib
 			typedef Plib::Generic::Reference< _TyParser >  				RpParser;
 			typedef Plib::Generic::Reference< _TyConnect >				RpConnect;
 			typedef Response< _TyParser, _TyConnect > 					RResponse;
+			typedef __ParseIncoming< _TyParser >						TParseIncoming;
+			typedef typename TParseIncoming::Codec						TCodec;
+			typedef ClientPool< _TyConnect >							TClientPool;
+			enum { Pipelined = ParserPipelineTraits< _TyParser >::Enabled ||
+				ParserFramingTraits< _TyParser >::Enabled };
 			
 		protected:
 			Plib::Text::RString				m_requestStream;
 			RpParser						m_rpParser;
 			RpConnect						m_rpConnect;
+			TCodec							m_Codec;
 			
 			RConnInfo						m_rConnectInfo;
 			RResponse						m_Resp;
 			bool							m_createByService;
 			bool							m_beSerialized;
 			
+			// The outgoing connection is borrowed from the pool and
+			// returned when the request is released. No pool by default,
+			// the request connects a private one.
+			TClientPool *					m_Pool;
+			std::string						m_PoolHost;
+			Uint32							m_PoolPort;
+			bool							m_Borrowed;
+			
+			// Set by the service when the request is accepted. An outgoing
+			// request also stops at the deadline current in the thread.
+			Deadline						m_Deadline;
+			
 			// Error String, Record the last error message.
 			Plib::Text::RString				m_LastError;
 		public:
 			_Request<_TyParser, _TyConnect>( )
 				: m_rpParser( false ), m_rpConnect( false ), 
-					m_createByService( false ), m_beSerialized(false)
+					m_createByService( false ), m_beSerialized(false),
+					m_Pool( NULL ), m_PoolPort( 0 ), m_Borrowed( false )
 			{
 				CONSTRUCTURE;
 				// Nothing to do.
 			}
-			~_Request<_TyParser, _TyConnect>( ) { DESTRUCTURE; }
+			~_Request<_TyParser, _TyConnect>( ) 
+			{ 
+				DESTRUCTURE; 
+				__ReturnConnect( true );
+			}
 			
 			// This Create is for service usage.
 			// Fill a request by the socket connect to the service.
 			bool Create( const RpConnect & _cnnt )
 			{
+				PLIB_PROFILE_ZONE( "Request::Create" );
 				if ( _cnnt.RefNull() ) {
 					m_LastError = "Null Connect Object from Server Frame.";
 					return false;
@@ -70,21 +188,25 @@ namespace Plib
 					m_rpParser = RpParser();
 					
 				// Initialize the Connect
+				__ReturnConnect( true );
 				m_rpConnect = _cnnt;
 				m_requestStream.Clear( );
+				m_Codec.Clear( );
 				m_rpConnect->AttachReadBuffer( &m_requestStream );
 				m_rpConnect->onBufferUpdate.Clear();
 				m_rpConnect->onBufferUpdate += std::make_pair(
-					&(*m_rpParser), &_TyParser::ParseIncoming );
+					this, &_Request< _TyParser, _TyConnect >::__OnIncoming );
 
-				m_rConnectInfo->Host = m_rpConnect->RemoteAddress;
-				m_rConnectInfo->Port = m_rpConnect->RemotePort;
+				m_rConnectInfo->Host = m_rpConnect->RemoteAddress( );
+				m_rConnectInfo->Port = m_rpConnect->RemotePort( );
 				m_rConnectInfo->KeepAlive = true;
 				
 				if ( m_rConnectInfo->TimeOut == 0 )
 					m_rConnectInfo->TimeOut = 1000;
 
-				if ( !m_rpConnect->Read( m_rConnectInfo->TimeOut ) ) {
+				Uint32 _timeOut = 0;
+				if ( !__TimeLeft( m_Deadline, m_rConnectInfo->TimeOut, _timeOut ) ) return false;
+				if ( !m_rpConnect->Read( _timeOut ) ) {
 					m_LastError = "On Read Incoming, " + Plib::Text::LastErrorMessage;
 					return false;
 				}
@@ -101,13 +223,13 @@ namespace Plib
 				
 				// Initialize the connect info.
 				m_rConnectInfo.DeepCopy( _cnntInfo );
-				if ( m_rpConnect.RefNull() ) m_rpConnect = RpConnect( );
-				// Try to connect to the peer server.
-				if ( !m_rpConnect->Connect( _cnntInfo.Host(), _cnntInfo.Port(), _cnntInfo.TimeOut()/2 ) )
-					m_LastError = "On Connect, " + Plib::Text::LastErrorMessage;
-				
 				m_createByService = false;
 				m_beSerialized = false;
+				// Try to connect to the peer server.
+				Uint32 _timeOut = 0;
+				if ( !__TimeLeft( __ClientDeadline( ), _cnntInfo.TimeOut()/2, _timeOut ) ) return;
+				if ( !__ConnectPeer( _timeOut ) )
+					m_LastError = "On Connect, " + Plib::Text::LastErrorMessage;
 			}
 			
 			// Initialize the Request by the initializer and also initialize
@@ -136,8 +258,86 @@ namespace Plib
 				return 1;
 			}
 			
+			// Pipelining, call it after the current request is answered.
+			// Drop the bytes of the current request and parse the next one
+			// from the buffer. Return false if there is no complete request
+			// left, the partial bytes are kept for the next read.
+			bool NextPipelined( )
+			{
+				if ( !Pipelined ) return false;
+				if ( m_createByService == false || m_rpParser.RefNull() ) return false;
+				Uint32 _consumed = TParseIncoming::Consumed( *m_rpParser, m_Codec );
+				m_rpParser->Clear( );
+				m_Codec.Clear( );
+				if ( _consumed == 0 || _consumed >= m_requestStream.Size() ) {
+					m_requestStream.Clear( );
+					return false;
+				}
+				m_requestStream.Remove( 0, _consumed );
+				return __OnIncoming( &(*m_rpConnect), &m_requestStream ) == SOEVENT_DONE;
+			}
+			
 		protected:
 			
+			// The deadline of an outgoing request, the one of the request
+			// served by this thread if that is earlier.
+			INLINE Deadline __ClientDeadline( ) const
+			{
+				return m_Deadline.Min( Deadline::Current( ) );
+			}
+			
+			// The timeout cut to the time left of the deadline, false
+			// when nothing is left.
+			INLINE bool __TimeLeft( const Deadline & _deadline, Uint32 _timeOut, Uint32 & _left )
+			{
+				_left = _timeOut;
+				if ( !_deadline.IsSet( ) ) return true;
+				_left = _deadline.Clamp( _timeOut );
+				if ( _left > 0 ) return true;
+				m_LastError = "Deadline Exceeded.";
+				return false;
+			}
+			
+			// Connect to the peer, borrow the connection when the request
+			// has a pool. The old connection goes back to the pool first.
+			bool __ConnectPeer( Uint32 _timeOut )
+			{
+				if ( m_Pool == NULL ) {
+					if ( m_rpConnect.RefNull() ) m_rpConnect = RpConnect( );
+					return m_rpConnect->Connect( m_rConnectInfo->Host, 
+						m_rConnectInfo->Port, _timeOut );
+				}
+				__ReturnConnect( true );
+				m_rpConnect = m_Pool->Borrow( m_rConnectInfo->Host.C_Str(), 
+					m_rConnectInfo->Port, _timeOut );
+				if ( m_rpConnect.RefNull() ) {
+					m_rpConnect = RpConnect( );
+					return false;
+				}
+				m_PoolHost = m_rConnectInfo->Host.C_Str();
+				m_PoolPort = m_rConnectInfo->Port;
+				m_Borrowed = true;
+				return true;
+			}
+			
+			// Give the borrowed connection back, it is dropped when it
+			// has been closed or is not reusable.
+			void __ReturnConnect( bool _reusable )
+			{
+				if ( !m_Borrowed ) return;
+				m_Borrowed = false;
+				if ( m_Pool == NULL || m_rpConnect.RefNull() ) return;
+				m_Pool->Return( m_PoolHost.c_str(), m_PoolPort, m_rpConnect, 
+					_reusable && m_rConnectInfo->KeepAlive );
+			}
+			
+			// Buffer update of the connection, frame the stream and parse.
+			SOCKEVENTSTATUE __OnIncoming( _TyConnect * _pSo, void * _data )
+			{
+				return TParseIncoming::Parse( *m_rpParser, m_Codec, _pSo,
+					(Plib::Text::RString *)_data );
+			}
+			
 			// Create a empty response object.
 			RResponse _CreateResponseForService( )
 			{
@@ -159,26 +359,28 @@ namespace Plib
 				}
 				// End the prevoius response
 				m_Resp.EndResponse();
+				
+				// Every step only gets the time left.
+				Deadline _deadline = __ClientDeadline( );
+				Uint32 _timeOut = 0;
+				if ( !__TimeLeft( _deadline, m_rConnectInfo->TimeOut, _timeOut ) )
+					return RResponse::Null;
 								
 				// Check the connect statue.
 				// If the request object is a reusable object, the socket
 				// should be already connected.
-				// If the request object is first used, connect.
-				if ( m_rpConnect.RefNull() ) m_rpConnect = RpConnect( );
-				// Initialize the response
-				m_Resp->__Init( m_rpConnect, m_rConnectInfo );
-				
-				// Check the connection statue.
-				if ( m_rpConnect->IsConnect() == false )
+				// If the request object is first used, connect or borrow one.
+				if ( m_rpConnect.RefNull() || m_rpConnect->IsConnect() == false )
 				{
-					if ( ! m_rpConnect->Connect(m_rConnectInfo->Host.c_str(), 
-						m_rConnectInfo->Port, m_rConnectInfo->TimeOut) )
+					if ( ! __ConnectPeer( _timeOut ) )
 					{
 						// On Error
 						m_LastError = "On Connect, " + Plib::Text::LastErrorMessage;
 						return RResponse::Null;
 					}
 				}
+				// Initialize the response
+				m_Resp->__Init( m_rpConnect, m_rConnectInfo );
 
 				// Build the request package.
 				if ( m_beSerialized == false ) {
@@ -187,7 +389,13 @@ namespace Plib
 					m_beSerialized = true;
 				}
 
-				if ( ! m_rpConnect->Write( m_requestStream.c_str(), m_requestStream.size() ) )
+				if ( !__TimeLeft( _deadline, m_rConnectInfo->TimeOut, _timeOut ) )
+					return RResponse::Null;
+				// The pooled connection gets its timeout back after.
+				if ( _deadline.IsSet( ) ) m_rpConnect->SetSoWriteTimeOut( _timeOut );
+				bool _written = m_rpConnect->Write( m_requestStream.c_str(), m_requestStream.size() );
+				if ( _deadline.IsSet( ) ) m_rpConnect->SetSoWriteTimeOut( m_rConnectInfo->TimeOut );
+				if ( ! _written )
 				{
 					// On Error
 					m_beSerialized = false;
@@ -196,7 +404,9 @@ namespace Plib
 				}
 				
 				m_beSerialized = false;
-				if ( ! m_rpConnect->Read( m_rConnectInfo->TimeOut ) )
+				if ( !__TimeLeft( _deadline, m_rConnectInfo->TimeOut, _timeOut ) )
+					return RResponse::Null;
+				if ( ! m_rpConnect->Read( _timeOut ) )
 				{
 					// On Error
 					m_LastError = "On Read Response, " + Plib::Text::LastErrorMessage;
@@ -251,9 +461,11 @@ namespace Plib
 			INLINE bool Connect( ) {
 				// Server Request cannot invoke this method.
 				if ( m_createByService == true ) return false;
-				if ( m_rpConnect->IsConnect( ) ) return true;
-				bool _ret = m_rpConnect->Connect( m_rConnectInfo.Host(), 
-					m_rConnectInfo.Port(), m_rConnectInfo.TimeOut() / 2 );
+				if ( !m_rpConnect.RefNull( ) && m_rpConnect->IsConnect( ) ) return true;
+				Uint32 _timeOut = 0;
+				if ( !__TimeLeft( __ClientDeadline( ), m_rConnectInfo.TimeOut() / 2, _timeOut ) )
+					return false;
+				bool _ret = __ConnectPeer( _timeOut );
 				if ( _ret == false ) {
 					// Update the error message.
 					m_LastError = "On Connect, " + Plib::Text::LastErrorMessage;
@@ -301,6 +513,15 @@ namespace Plib
 				return m_rConnectInfo->KeepAlive;
 			}
 			
+			// The deadline to answer, or to get the response.
+			const Deadline & GetDeadline() const {
+				return m_Deadline;
+			}
+			
+			void SetDeadline( const Deadline & _deadline ) {
+				m_Deadline = _deadline;
+			}
+			
 			void SetKeepAlive( bool _keepAlive ) {
 				m_rConnectInfo->KeepAlive = _keepAlive;
 			}
@@ -315,6 +536,18 @@ namespace Plib
 				return m_rpParser;
 			}
 			
+			// Borrow the outgoing connections from _pool, for example
+			// TClientPool::Global(). NULL connects a private one.
+			void SetClientPool( TClientPool * _pool ) {
+				__ReturnConnect( true );
+				m_Pool = _pool;
+			}
+			
+			// Get the framing codec, to change its delimiter or limits.
+			TCodec & GetCodec() {
+				return m_Codec;
+			}
+			
 			RpParser & operator() ( )
 			{
 				return m_rpParser;
@@ -324,17 +557,25 @@ namespace Plib
 			void ReuseRequest( ) {
 				m_Resp.ReuseResponse();
 				m_beSerialized = false;
+				if ( m_createByService ) m_Deadline = Deadline( );
 				if ( !m_rpParser.RefNull() ) m_rpParser->Clear();
+				m_Codec.Clear( );
+				// Waits for the next request, the read takes a buffer
+				// again. The pipelined bytes not parsed yet are kept.
+				m_requestStream.Shrink( );
 			}
 
 			// close current connection.
 			void EndRequest( ) {
 				m_Resp.EndResponse();
 				m_beSerialized = false;
+				m_Deadline = Deadline( );
 				if ( !m_rpParser.RefNull() ) m_rpParser->Clear();
+				m_Codec.Clear( );
 				m_requestStream.Clear();
 				if ( m_rpConnect.RefNull() ) return;
 				m_rpConnect->Close( );
+				__ReturnConnect( false );
 			}
 			
 			// Clear the request object and release the data.
@@ -342,6 +583,7 @@ namespace Plib
 				m_Resp.ReleaseResponse();
 				m_beSerialized = false;
 				m_rpParser = RpParser::NullRefObj;
+				__ReturnConnect( true );
 				m_rpConnect = RpConnect::NullRefObj;
 				m_requestStream.Clear();
 			}
@@ -399,6 +641,10 @@ namespace Plib
 			INLINE int Check( ) {
 				return TFather::_Handle->_PHandle->Check( );
 			}
+			// Move to the next pipelined request in the buffer.
+			INLINE bool NextPipelined( ) {
+				return TFather::_Handle->_PHandle->NextPipelined( );
+			}
 			
 			INLINE Plib::Generic::Reference< _TyConnect > & GetConnect( ) {
 				return TFather::_Handle->_PHandle->GetConnect();
@@ -470,6 +716,22 @@ namespace Plib
 			INLINE RpParser & GetParser() {
 				return TFather::_Handle->_PHandle->GetParser();
 			}
+			// Set the client pool, NULL to disable pooling.
+			INLINE void SetClientPool( ClientPool< _TyConnect > * _pool ) {
+				TFather::_Handle->_PHandle->SetClientPool( _pool );
+			}
+			// Get the framing codec.
+			INLINE typename _Request< _TyParser, _TyConnect >::TCodec & GetCodec() {
+				return TFather::_Handle->_PHandle->GetCodec();
+			}
+
+			// The deadline of the request.
+			INLINE const Deadline & GetDeadline( ) const {
+				return TFather::_Handle->_PHandle->GetDeadline();
+			}
+			INLINE void SetDeadline( const Deadline & _deadline ) {
+				TFather::_Handle->_PHandle->SetDeadline( _deadline );
+			}
 
 			// Just clear the parser and the bufferstream.
 			INLINE void ReuseRequest( ) {
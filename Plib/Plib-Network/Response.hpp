@@ -5,7 +5,9 @@
 * File Name			: Response.hpp
 * Propose  			: The server/client response object template
 * 
-* Current Version	: 1.0
+* Current Version	: 1.2
+* Change Log		: 1.2: No buffer kept between the requests.
+* Change Log		: 1.1: Rejection response of the shed request.
 * Change Log		: First Definition.
 * Author			: Push Chen
 * Change Date		: 2011-06-10
@@ -19,10 +21,12 @@
 #include "ConnectInfo.hpp"
 #include "Syncsock.hpp"
 #include "String.hpp"
+#include "Profile.hpp"
 #else
 #include <Plib-Network/ConnectInfo.hpp>
 #include <Plib-Network/Syncsock.hpp>
 #include <Plib-Text/String.hpp>
+#include <Plib-Utility/Profile.hpp>
 #endif
 
 namespace Plib
@@ -32,6 +36,35 @@ namespace Plib
 		// Pre-definition of the request.
 		template< typename _TyParser, typename _TyConnect = SyncSock >
 		class _Request;
+
+		// A parser answers the request shed by the service under overload
+		// by defining
+		//		typedef void RejectTag;
+		//		void BuildReject( Plib::Text::RString & _out );
+		// like a "503 Service Unavailable". It must be cheap, no work of
+		// the request is done. Without it the connection is just closed.
+		template < typename _TyParser >
+		struct ParserRejectTraits
+		{
+			template < typename _Ty > static char __Test( typename _Ty::RejectTag * );
+			template < typename _Ty > static long __Test( ... );
+			enum { Enabled = ( sizeof(__Test< _TyParser >( 0 )) == sizeof(char) ) };
+		};
+
+		template < typename _TyParser, bool _Enabled = ParserRejectTraits< _TyParser >::Enabled >
+		struct __BuildReject
+		{
+			static INLINE bool Build( _TyParser &, Plib::Text::RString & ) { return false; }
+		};
+		template < typename _TyParser >
+		struct __BuildReject< _TyParser, true >
+		{
+			static INLINE bool Build( _TyParser & _parser, Plib::Text::RString & _out )
+			{
+				_parser.BuildReject( _out );
+				return _out.Size( ) > 0;
+			}
+		};
 		
 		// Response Object, used with Request.
 		template< typename _TyParser, typename _TyConnect = SyncSock >
@@ -100,12 +133,22 @@ namespace Plib
 			// Serialize the response package.
 			void Serialize( )
 			{
+				PLIB_PROFILE_ZONE( "Response::Serialize" );
 				if ( m_Serialized == true ) return;
 				m_responseStream.Clear();
 				if ( m_rpParser.RefNull() ) return;
 				m_rpParser->Build( m_responseStream );
 				m_Serialized = true;
 			}
+
+			// Serialize the rejection instead, false if the parser has none.
+			bool SerializeReject( )
+			{
+				m_responseStream.Clear();
+				if ( m_rpParser.RefNull() ) return false;
+				m_Serialized = __BuildReject< _TyParser >::Build( *m_rpParser, m_responseStream );
+				return m_Serialized;
+			}
 			
 			// the operator of compare.
 			bool operator == ( const _Response< _TyParser, _TyConnect > & _resp ) const
@@ -147,6 +190,7 @@ namespace Plib
 			{
 				if ( !m_rpParser.RefNull() ) m_rpParser->Clear();
 				m_responseStream.Clear();
+				m_responseStream.Shrink();
 			}
 			
 			// clear the parser
@@ -189,7 +233,12 @@ namespace Plib
 			void Serialize( ) {
 				TFather::_Handle->_PHandle->Serialize( );
 			}
-			
+
+			// Build the rejection of the shed request.
+			bool SerializeReject( ) {
+				return TFather::_Handle->_PHandle->SerializeReject( );
+			}
+
 			// Get the Parser object.
 			RpParser GetParser( ) {
 				return TFather::_Handle->_PHandle->GetParser();
@@ -5,8 +5,10 @@
 * File Name			: selector.hpp
 * Propose  			: A Select Socket Listener.
 * 
-* Current Version	: 1.0
+* Current Version	: 1.2
 * Change Log		: First Definition.
+* Change Log		: 1.1: Drain the accept queue, listen option.
+* Change Log		: 1.2: Listen on several endpoints.
 * Author			: Push Chen
 * Change Date		: 2011-01-11
 */
@@ -42,59 +44,86 @@ namespace Plib
 			typedef Plib::Generic::RArray< SelectRefSockT >						SocketList;
 			//typedef std::map< SOCKET_T, SelectRefSockT >						SocketList;
 
-			SOCKET_T								_ListenFD;
+			// One socket for each endpoint, the first is the port.
+			Plib::Generic::Vector< SOCKET_T >		_ListenFDs;
+			Plib::Generic::Vector< Endpoint >		_ListenEndpoints;
 			Uint64									_SocketIdleTime;
 			SocketList								_AliveSockList;
 			Plib::Threading::RWLock					_ListLock;
 			struct timeval							_SelectTime;
 			fd_set									_SockSet;
-			struct sockaddr_in						_SvrAddr;
-			struct sockaddr_in						_CltAddr;
+			struct sockaddr_storage					_CltAddr;
+			ListenOption							_Option;
+			// ListenOverflows of the system when start listening.
+			Uint64									_OverflowBase;
 
-			Selector( ) : _ListenFD( -1 ), _SocketIdleTime( 120000 ) {CONSTRUCTURE;}
+			Selector( ) : _SocketIdleTime( 120000 ), _OverflowBase( 0 ) {CONSTRUCTURE;}
 			~Selector( ) { DESTRUCTURE; ShutdownListen( ); }
 
 			// Idle Time Setting.
 			void SetMaxIdleTime( Uint64 _IdleTime ) { _SocketIdleTime = _IdleTime; }
+			void SetListenOption( const ListenOption & _NewOption ) { _Option = _NewOption; }
 
-			INLINE LF_RETCODE ListenOnPort( Uint32 _Port, Uint32 _MaxSupport )
+			// Accept until the queue is empty, at most AcceptBatch clients
+			// so the alive sockets are still checked in a connection storm.
+			INLINE void __AcceptAll( SOCKET_T _ListenFD, GetFreeDelegate & _GetD )
 			{
-				if ( _ListenFD != -1 ) return LF_ALRSTART;
-				::memset( &_SvrAddr, 0, sizeof(_SvrAddr) );
-				::memset( &_CltAddr, 0, sizeof(_CltAddr) );
-
-				if ( ( _ListenFD = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP ) ) == -1 )
-					return LF_ESOCKET;
-
-				_SvrAddr.sin_family = AF_INET;
-				_SvrAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-				_SvrAddr.sin_port = htons(_Port);
-
-				int _Val = 1;
-				if ( setsockopt( _ListenFD, SOL_SOCKET, 
-					SO_REUSEADDR, (const char *)&_Val, sizeof(_Val) ) != 0 )
+				for ( Uint32 _Count = 0; _Count < _Option.AcceptBatch; ++_Count )
 				{
-					PLIB_NETWORK_CLOSESOCK( _ListenFD );
-					_ListenFD = -1;
-					return LF_ESETOPT;
-				}
+					socklen_t _AddrLen = sizeof( _CltAddr );
+				#if _DEF_LINUX
+					SOCKET_T _ClientFD = ::accept4( _ListenFD, 
+						(struct sockaddr *)&_CltAddr, &_AddrLen, SOCK_CLOEXEC );
+				#else
+					SOCKET_T _ClientFD = ::accept( _ListenFD, 
+						(struct sockaddr *)&_CltAddr, &_AddrLen );
+				#endif
+					if ( _ClientFD == -1 ) {
+					#if !_DEF_WIN32
+						// The client reset before accept, take the next one.
+						if ( errno == EINTR || errno == ECONNABORTED ) continue;
+					#endif
+						// Empty, or out of fd, try again in next loop.
+						break;
+					}
 
-				if ( ::bind( _ListenFD, (struct sockaddr *)&_SvrAddr, sizeof(_SvrAddr) ) == -1 )
-				{
-					PLIB_NETWORK_CLOSESOCK( _ListenFD );
-					_ListenFD = -1;
-					return LF_EBIND;
+					SelectRefSockT _FreeSock = _GetD();
+					_FreeSock->Bind( _ClientFD, true );
+					ApplyAcceptedOption( *_FreeSock, _Option );
+					
+					_AliveSockList.PushBack( _FreeSock );
 				}
+			}
+
+			INLINE LF_RETCODE ListenOn( const Endpoint * _Endpoints, Uint32 _Count, Uint32 _MaxSupport )
+			{
+				if ( _ListenFDs.Size( ) != 0 ) return LF_ALRSTART;
+				::memset( &_CltAddr, 0, sizeof(_CltAddr) );
 
-				if ( ::listen( _ListenFD, ( _MaxSupport > 1024 ? 1024 : _MaxSupport ) ) == -1 )
+				for ( Uint32 i = 0; i < _Count; ++i )
 				{
-					PLIB_NETWORK_CLOSESOCK( _ListenFD );
-					_ListenFD = -1;
-					return LF_ELISTEN;
+					LF_RETCODE _Ret;
+					SOCKET_T _ListenFD = OpenListenSocket( _Endpoints[i], _Option, _MaxSupport, _Ret );
+					if ( _ListenFD == -1 ) {
+						ShutdownListen( );
+						return _Ret;
+					}
+					// Non-blocking, so the accept loop stops when the queue is empty.
+					unsigned long _u = 1;
+					PLIB_NETWORK_IOCTL_CALL( _ListenFD, FIONBIO, &_u );
+					_ListenFDs.PushBack( _ListenFD );
+					_ListenEndpoints.PushBack( _Endpoints[i] );
 				}
+				_OverflowBase = ListenOverflows( );
 				return LF_SUCCESS;
 			}
 
+			INLINE LF_RETCODE ListenOnPort( Uint32 _Port, Uint32 _MaxSupport )
+			{
+				Endpoint _Endpoint = Endpoint::Tcp( _Port );
+				return ListenOn( &_Endpoint, 1, _MaxSupport );
+			}
+
 			INLINE void KeepSockAlive( SelectRefSockT _RefSock )
 			{
 				Plib::Threading::WriteLocker _ListLocker( _ListLock );
@@ -103,43 +132,38 @@ namespace Plib
 
 			INLINE LF_RETCODE ShutdownListen( )
 			{
-				if ( _ListenFD == -1 ) return LF_SUCCESS;
+				if ( _ListenFDs.Size( ) == 0 ) return LF_SUCCESS;
 				//Plib::Threading::WriteLocker _ListLocker( _ListLock );
 				_AliveSockList.Clear();
-				PLIB_NETWORK_CLOSESOCK( _ListenFD );
-				_ListenFD = -1;
+				for ( Uint32 i = 0; i < _ListenFDs.Size( ); ++i ) {
+					PLIB_NETWORK_CLOSESOCK( _ListenFDs[i] );
+					_ListenEndpoints[i].Unlink( );
+				}
+				_ListenFDs.Clear( );
+				_ListenEndpoints.Clear( );
 				return LF_SUCCESS;
 			}
 
 			INLINE LF_RETCODE LoopPoll( AddReadDelegate & _AddD, 
 				ReleaseDelegate & _RelD, GetFreeDelegate & _GetD )
 			{
-				if ( _ListenFD == -1 ) return LF_ESELECT;
+				PLIB_PROFILE_ZONE( "Selector::LoopPoll" );
+				if ( _ListenFDs.Size( ) == 0 ) return LF_ESELECT;
+				// All idle checks in this loop read the cached now.
+				Plib::Threading::MonotonicClock::UpdateCachedNow( );
 				FD_ZERO( &_SockSet );
-				FD_SET( _ListenFD, &_SockSet );
+				SOCKET_T _MaxFD = 0;
+				for ( Uint32 i = 0; i < _ListenFDs.Size( ); ++i ) {
+					FD_SET( _ListenFDs[i], &_SockSet );
+					if ( _ListenFDs[i] > _MaxFD ) _MaxFD = _ListenFDs[i];
+				}
 
 				_SelectTime.tv_sec = 0;
 				_SelectTime.tv_usec = 1;
-				Int32 _Ret = ::select( _ListenFD + 1, &_SockSet, NULL, NULL, &_SelectTime );
+				Int32 _Ret = ::select( _MaxFD + 1, &_SockSet, NULL, NULL, &_SelectTime );
 				if ( _Ret < 0 ) return LF_ESELECT;
-				if ( _Ret > 0 )
-				{
-					// New client
-					socklen_t _AddrLen = sizeof( _CltAddr );
-					SOCKET_T _ClientFD = ::accept( _ListenFD, 
-						(struct sockaddr *)&_CltAddr, &_AddrLen );
-
-					if ( _ClientFD != -1 )
-					{
-
-						SelectRefSockT _FreeSock = _GetD();
-						_FreeSock->Bind( _ClientFD, true );
-						_FreeSock->SetNoDelay( );
-						_FreeSock->SetLingerTime( 0 );
-						_FreeSock->SetReUsable( true );
-						
-						_AliveSockList.PushBack( _FreeSock );
-					}
+				for ( Uint32 i = 0; _Ret > 0 && i < _ListenFDs.Size( ); ++i ) {
+					if ( FD_ISSET( _ListenFDs[i], &_SockSet ) ) __AcceptAll( _ListenFDs[i], _GetD );	// New clients
 				}
 
 				// Loop Check all socket statue.
@@ -172,6 +196,32 @@ namespace Plib
 				return LF_SUCCESS;
 			}
 		public:	
+			// Connections dropped by full accept queues since listening.
+			// The counter of the system, other listeners are counted too.
+			INLINE Uint64 AcceptOverflows( ) const
+			{
+				Uint64 _Now = ListenOverflows( );
+				return ( _Now > _OverflowBase ) ? _Now - _OverflowBase : 0;
+			}
+
+			// Clients waiting in the accept queue of the port, and the backlog.
+			INLINE bool AcceptQueue( Uint32 & _Depth, Uint32 & _Backlog ) const
+			{
+			#if _DEF_LINUX
+				struct tcp_info _Info;
+				socklen_t _Len = sizeof( _Info );
+				if ( _ListenFDs.Size( ) == 0 || _ListenEndpoints[0].IsUnix( ) ||
+					getsockopt( _ListenFDs[0], IPPROTO_TCP, 
+					TCP_INFO, &_Info, &_Len ) != 0 ) return false;
+				// For a listen socket the kernel puts the queue here.
+				_Depth = _Info.tcpi_unacked;
+				_Backlog = _Info.tcpi_sacked;
+				return true;
+			#else
+				return false;
+			#endif
+			}
+
 			INLINE static bool IsErrorFatal( Uint32 _errCode )
 			{
 			#if _DEF_WIN32
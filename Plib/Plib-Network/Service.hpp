@@ -5,7 +5,23 @@
 * File Name			: Service.hpp
 * Propose  			: The server framework
 * 
-* Current Version	: 1.0
+* Current Version	: 1.15
+* Change Log		: 1.15: Connection error forwarded to OnConnectionError as it is when called.
+* Change Log		: 1.14: The waiting queues hold the default depth, shed when full.
+* Change Log		: 1.13: Held responses are pushed before a pipelined request expected to be slow.
+* Change Log		: 1.12: Checking thread runs with the server, stopped before the pool.
+* Change Log		: 1.11: Deadline checked before the first request, the batch is settled before closing.
+* Change Log		: 1.10: Dispatch and checking threads shed without waiting on the socket.
+* Change Log		: 1.9: Reject an endpoint not valid.
+* Change Log		: 1.8: Connection error event set once on the listener.
+* Change Log		: 1.7: Deadline of each request from its arrival.
+* Change Log		: 1.6: Bounded queue and CoDel shedding of the requests.
+* Change Log		: 1.5: Responses of one dispatch are coalesced by WriteBatch.
+* Change Log		: 1.4: Listen on unix socket paths with the port.
+* Change Log		: 1.3: Pipelined requests are answered in order by one write.
+* Change Log		: 1.2: Request latency, queue and connection metrics.
+* Change Log		: 1.1: Dispatch the requests to a work stealing thread pool
+*					  instead of growing/shrinking worker threads.
 * Change Log		: First Definition.
 * Author			: Push Chen
 * Change Date		: 2011-06-14
@@ -19,9 +35,15 @@
 #if _DEF_IOS
 #include "Request.hpp"
 #include "Listener.hpp"
+#include "WriteBatch.hpp"
+#include "Admission.hpp"
+#include "ThreadPool.hpp"
 #else
 #include <Plib-Network/Request.hpp>
 #include <Plib-Network/Listener.hpp>
+#include <Plib-Network/WriteBatch.hpp>
+#include <Plib-Network/Admission.hpp>
+#include <Plib-Threading/ThreadPool.hpp>
 #endif
 
 namespace Plib
@@ -48,9 +70,17 @@ namespace Plib
 			typedef Plib::Generic::Delegate< void( Uint32 ) >			SvrErrorT;
 			typedef Plib::Generci::Delegate< void( 
 				Service< _TyRequest, _TyPoller > * ) >					SvrFatalT;
-			typedef Plib::Generic::RArray< WorkThreadT * >				ThreadArrayT;
 			typedef Plib::Generic::RQueue< TRequest >					ReqQueueT;
 			typedef Plib::Generic::RPool< TRequest >					ReqPoolT;
+			typedef Plib::Threading::ThreadPool							WorkerPoolT;
+			typedef typename WorkerPoolT::TaskT							TaskT;
+			// Items waiting for a pool worker, one task is submitted for each.
+			typedef Admitted< RefConnect >								AdmittedConnT;
+			typedef Admitted< TRequest >								AdmittedReqT;
+			typedef Plib::Generic::BlockingQueue<
+				Plib::Generic::MpmcQueue< AdmittedConnT > >				ConnQueueT;
+			typedef Plib::Generic::BlockingQueue<
+				Plib::Generic::MpmcQueue< AdmittedReqT > >				ReadyQueueT;
 			
 			
 			// Lock Object
@@ -62,15 +92,17 @@ namespace Plib
 			
 			// Self Re-Type
 			typedef Service< _TyRequest, _TyPoller >					ServiceT;
+			
+			// Items each waiting queue holds, the default admission depth.
+			enum { QUEUE_CAPACITY = 4096 };
 		protected:
 			
 			/*
 			 * This is the internal queue for long term socket.
 			 * it will manage a queue to all connected socket,
 			 * and will auto check if there is new data incoming.
-			 * When the business logic takes too many time or
-			 * there are too many sockets in this queue, it will
-			 * ask the Service to create more threads.
+			 * The request with new data is dispatched to the
+			 * service's worker pool.
 			 */
 			ReqQueueT					_IncomingReqQueue;
 			SemT						_IncomingReqSem;
@@ -88,28 +120,19 @@ namespace Plib
 			class InnerQueue 
 			{
 			protected:
-				ReqQueueT				_innerQueue;
 				// these two queues are used when checking all request
 				// in the queue, pop out from one queue and push to 
 				// another queue.
 				ReqQueueT				_innerReuseQueue[2];
 				ReqQueueT *				_workingReuseQueue;
 				
-				// these two objects are used to make sure the 
+				// these objects are used to make sure the
 				// data is safe when processing the requests in
 				// multi-thread env.
 				LockT					_reuseQueueLock;
-				SemT					_innerSem;
 				
-				// these objects are used to monitor the server's statue.
-				// if the requests are too many, tell the service to 
-				// create more thread.
-				TimeT					_timer;
-				ServiceT				_theService;
+				ServiceT *				_theService;
 				WorkThreadT				_CheckThread;
-
-				// Plib basic thread safe.
-				PLIB_THREAD_SAFE_DEFINE;
 				
 			protected:
 				INLINE void __SocketCheckCallBack( ) {
@@ -129,29 +152,33 @@ namespace Plib
 							int _statue = _req.Check( );
 							if ( _statue < 0 ) {
 								// Error Happened
+								Depth.Sub( );
 								_req.EndRequest( );
 								_theService->RecycleRequest( _req );
 								continue;
 							}
 							if ( _statue != 0 ) {
-								// New request.
-								RArray< TRequest > _reqCloneGroup = _req.Clone( );
-								for ( Uint32 i = 0; i < _reqCloseGroup.Size(); ++i ) {
-									_innerQueue.Push( _reqCloseGroup[i] );
-									_innerSem.Release( );1
-								}
+								// New request, the worker processes all the
+								// pipelined requests of it and returns it back.
+								Depth.Sub( );
+								_theService->__DispatchRequest( _req );
 								__hasReadableSocket = true;
+								continue;
 							}
+							_reuseQueueLock.Lock( );
 							_workingReuseQueue->Push( _req );
+							_reuseQueueLock.UnLock( );
 						}
 						if ( !__hasReadableSocket ) Plib::Threading::ThreadSys::Sleep(1);
 					}
 				}
 			public:
+				// Keep-alive requests waiting for new data.
+				Plib::Utility::MetricGauge	Depth;
+
 				// Default initialize.
 				InnerQueue( ) 
 					: 	_workingReuseQueue(_innerReuseQueue), 
-						_innerSem(0, 0xFFFF), 
 						_theService( NULL ) 
 				{
 					CONSTRUCTURE;
@@ -169,34 +196,33 @@ namespace Plib
 				// invoke after SetService.
 				INLINE void StartChecking( ) { _CheckThread.Start(); }
 				
-				// Get a request from the queue.
-				TRequest Get( Uint32 _timeOut ) {
-					if ( !_innerSem.Get( _timeOut ) ) 
-					{
-						PLIB_THREAD_SAFE;
-						// Checking the timer and make decidion if
-						// need to close some threads.
-						_theService->ReuseThreadChecking( _timer );
-						return RpRequest::Null;
+				// Stop the checking thread, wait until it has left
+				// the dispatching.
+				INLINE void StopChecking( ) { _CheckThread.Stop(); }
+				
+				// Take back a keep-alive request after the checking
+				// has stopped, false for none left.
+				bool Take( TRequest & _req ) {
+					_reuseQueueLock.Lock();
+					ReqQueueT * _queue = _innerReuseQueue[0].Empty( ) ? 
+						_innerReuseQueue + 1 : _innerReuseQueue;
+					bool _has = !_queue->Empty( );
+					if ( _has ) {
+						_req = _queue->Head( );
+						_queue->Pop( );
+						Depth.Sub( );
 					}
-					PLIB_THREAD_SAFE;
-					RpRequest _req = _innerQueue.Head( );
-					_innerQueue.Pop();
-					return _req;
+					_reuseQueueLock.UnLock();
+					return _has;
 				}
 				
-				void Return( RpRequest _req ) {
+				// Return a keep-alive request to be checked.
+				void Return( TRequest _req ) {
 					if ( _req.RefNull() ) return;
-					
-					// Return one request.
+					Depth.Add( );
 					_reuseQueueLock.Lock();
 					_workingReuseQueue->Push( _req );
 					_reuseQueueLock.UnLock();
-					
-					PLIB_THREAD_SAFE;
-					_theService->__CheckReuseThreadAndAdd( _innerQueue.Size() );
-					// Recalculate the time
-					_timer.SetStart();
 				}
 			};
 			
@@ -233,31 +259,71 @@ namespace Plib
 			InnerPool									RequestIdlePool;
 			InnerQueue									RequestUsingQueue;
 			
-			// Working thread array of the service.
-			Plib::Generic::RArray< WorkThreadT * >		NormalConnectionList;
-			Plib::Generic::RArray< WorkThreadT * >		ReuseConnectionList;
+			// All requests are processed in the worker pool.
+			// The dispatch thread only waits for the readable sockets.
+			WorkerPoolT									WorkerPool;
+			WorkThreadT									DispatchThread;
+			ConnQueueT									IncomingConnQueue;
+			ReadyQueueT									ReadyReqQueue;
+			TaskT										IncomingTask;
+			TaskT										ReadyTask;
+			// Both queues above share the depth bound and the shedding.
+			AdmissionControl							Admission;
 			
 			// Service statu config
 			bool				_restartOnError;
 			Uint32				_restartInterval;	// 0 means immediatly.
 			
-			Uint32				_MaxIdleTime;
-			Uint32				_MaxSockCountPreThread;
-			
 			Uint32				_workThreadCount;
+			bool				_bindCpu;
+			Uint32				_flushBytes;
+			Uint32				_flushDelay;	// us
+			Uint32				_requestBudget;	// ms, 0 means no deadline
+			
+			// Hot metrics, looked up once.
+			Plib::Utility::MetricCounter *		_RequestCount;
+			Plib::Utility::MetricCounter *		_RequestErrorCount;
+			Plib::Utility::MetricHistogram *	_RequestLatency;
+			Plib::Utility::MetricGauge *		_WorkerCount;
+			Plib::Utility::MetricCounter *		_WriteCount;
+			Plib::Utility::MetricCounter *		_WriteBytes;
+			Plib::Utility::MetricCounter *		_ShedCount;
+			Plib::Utility::MetricCounter *		_ExpiredCount;
+			Plib::Utility::MetricHistogram *	_QueueDelay;
 						
 		public:
 			
 			Service<_TyParser, _TyPoller>( bool rsOnError = true, Uint32 rsInt = 0 )
-				:_restartOnError(rsOnError), _restartInterval(rsInt), 
-				_MaxIdleTime( 180000 ), _MaxSockCountPreThread( 300 ),
-				_workThreadCount( 0 )
+				:IncomingConnQueue( QUEUE_CAPACITY ), ReadyReqQueue( QUEUE_CAPACITY ),
+				_restartOnError(rsOnError), _restartInterval(rsInt), 
+				_workThreadCount( 0 ), _bindCpu( false ),
+				_flushBytes( 64 * 1024 ), _flushDelay( 200 ), _requestBudget( 0 )
 			{
 				CONSTRUCTURE;
 				RequestUsingQueue.SetService( this );
-				RequestUsingQueue.StartChecking();
+				IncomingTask += std::make_pair( this,
+					&Service<_TyParser, _TyPoller>::__ProcessIncomingSocket );
+				ReadyTask += std::make_pair( this,
+					&Service<_TyParser, _TyPoller>::__ProcessReadyRequest );
+				DispatchThread.Jobs += std::make_pair( this,
+					&Service<_TyParser, _TyPoller>::__threadForDispatch );
 				ServicePort.OnPollLoopError += std::make_pair(
 						this, &Service<_TyParser, _TyPoller>::__PollerError);
+				// One table for all the connections.
+				ServicePort.Events().onError += std::make_pair(
+						this, &Service<_TyParser, _TyPoller>::__ConnectionError);
+				
+				ServicePort.RegisterMetrics( Metrics );
+				Metrics.Register( "service.idle_connections", RequestUsingQueue.Depth );
+				_RequestCount = &Metrics.Counter( "service.requests" );
+				_RequestErrorCount = &Metrics.Counter( "service.request_errors" );
+				_RequestLatency = &Metrics.Histogram( "service.request_latency_us" );
+				_WorkerCount = &Metrics.Gauge( "service.worker_threads" );
+				_WriteCount = &Metrics.Counter( "service.writes" );
+				_WriteBytes = &Metrics.Counter( "service.write_bytes" );
+				_ShedCount = &Metrics.Counter( "service.shed" );
+				_ExpiredCount = &Metrics.Counter( "service.expired" );
+				_QueueDelay = &Metrics.Histogram( "service.queue_delay_us" );
 			}
 			
 			~Service< _TyParser, _TyPoller >( ) {DESTRUCTURE; StopServer(); }
@@ -272,18 +338,57 @@ namespace Plib
 				_restartInterval = _rsInt;
 			}
 			
-			void SetMaxIdleTIme( Uint32 _maxIdleTime )
+			// Bind each worker to one cpu, must be set before StartServer.
+			void SetBindCpu( bool _bind )
+			{
+				_bindCpu = _bind;
+			}
+			
+			// Bound of the pipelined responses held before the last one of
+			// the dispatch, by size and by the delay in microseconds. The
+			// delay holds while each request takes about as long as the
+			// one before it.
+			void SetWriteBatch( Uint32 _bytes, Uint32 _delay )
+			{
+				_flushBytes = _bytes;
+				_flushDelay = _delay;
+			}
+			
+			// Time to answer a request from its arrival, in mile seconds.
+			// A request still waiting at its deadline is dropped with the
+			// connection, the client has given up. The requests made in
+			// the work process only get the time left. 0 means no deadline.
+			void SetRequestBudget( Uint32 _mileSec )
 			{
-				_MaxIdleTime = _maxIdleTime;
+				_requestBudget = _mileSec;
 			}
 			
-			void SetMaxSockCountPreThread( Uint32 _count )
+			// Admission of the requests waiting for a worker, must be set
+			// before StartServer. At most _depth requests wait, 0 is not
+			// bounded. When even the shortest queue delay of an _interval
+			// is above _target us, the requests waited more than twice the
+			// target are shed (see AdmissionControl), _target 0 never
+			// sheds by the delay. The shed request gets the rejection of
+			// the parser (see ParserRejectTraits) and the connection is
+			// closed. Default: 4096 requests, no delay shedding.
+			// Each waiting queue also holds at most QUEUE_CAPACITY, above
+			// it the new ones are shed whatever the _depth.
+			void SetAdmission( Uint32 _depth, Uint32 _target = 5000, Uint32 _interval = 100000 )
 			{
-				_MaxSockCountPreThread = _count;
+				Admission.Set( _depth, _target, _interval );
+			}
+			
+			// Also serve on the endpoint, a unix socket path for the local
+			// peers. Must be added before StartServer, then port 0 means
+			// no TCP port. Return false for the endpoint not valid.
+			bool AddEndpoint( const Endpoint & _endpoint )
+			{
+				return ServicePort.AddEndpoint( _endpoint );
 			}
 			
 			// Start the server on certain port with _threadCount working thread.
-			bool StartServer( Uint32 _port, Uint32 _threadCount = 1 )
+			// 0 means one working thread for each cpu.
+			bool StartServer( Uint32 _port, Uint32 _threadCount = 0 )
 			{
 				if ( ServicePort.Statue() )
 				{
@@ -296,8 +401,6 @@ namespace Plib
 					return false;
 				}
 				
-				NormalConnectionList.Clear();
-				ReuseConnectionList.Clear();
 				if ( LF_SUCCESS != ServicePort.Listen(_port) )
 				{
 					// On Error
@@ -305,63 +408,53 @@ namespace Plib
 					return false;
 				}
 				
-				if ( _threadCount < 1 ) _threadCount = 1;
 				_workThreadCount = _threadCount;
-				// Start normal thread
-				for ( Uint32 count = 0; count < _threadCount; ++count )
-				{
-					PCNEW( WorkThreadT, pThread );
-					//WorkThreadT * pThread = Plib::Basic::Memory::New< WorkThreadT >( );
-					//WorkThreadT * pThread = new WorkThreadT;
-					pThread->Jobs += std::make_pair( this, 
-						&Service< _TyParser, _TyPoller >::__threadForGetIncomingSocket );
-					NormalConnectionList.PushBack(pThread);
-					pThread->Start();
+				if ( !WorkerPool.Start( _threadCount, _bindCpu ) ) {
+					ServicePort.Shutdown();
+					return false;
 				}
-				
-				// Start one reuse thread
-				PCNEW( WorkThreadT, pThread );
-				//WorkThreadT * pThread = Plib::Basic::Memory::New< WorkThreadT >( );
-				//WorkThreadT * pThread = new WorkThreadT;
-				pThread->Jobs += std::make_pair( this, 
-					&Service< _TyParser, _TyPoller >::__threadForReuseSocket );
-				ReuseConnectionList.PushBack(pThread);
-				pThread->Start();
-				
+				RequestUsingQueue.StartChecking();
+				DispatchThread.Start();
+				_WorkerCount->Set( WorkerPool.WorkerCount( ) );
 				return true;
 			}
 			
-			// Stop the server and clear the working thread list.
+			// Stop the server and the worker pool.
 			void StopServer( )
 			{
 				ServicePort.Shutdown();
-				for ( Uint32 i = 0; i < NormalConnectionList.Size(); ++i )
-				{
-					NormalConnectionList[i]->GiveSignal();
-				}
-				for ( Uint32 i = 0; i < NormalConnectionList.Size(); ++i )
-				{
-					PDELETE( NormalConnectionList[i] );
-					//Plib::Basic::Memory::Delete( NormalConnectionList[i] );
-					//delete NormalConnectionList[i];
+				DispatchThread.Stop();
+				// No more submit after the pool stops.
+				RequestUsingQueue.StopChecking();
+				WorkerPool.Stop();
+				_WorkerCount->Set( 0 );
+				// Release what has not been processed.
+				AdmittedConnT _cnnt;
+				while ( IncomingConnQueue.PopN( &_cnnt, 1 ) == 1 ) {
+					Admission.Cancel( );
+					ServicePort.ReleaseSocket( _cnnt.Item, false );
 				}
-				for ( Uint32 i = 0; i < ReuseConnectionList.Size(); ++i )
-				{
-					ReuseConnectionList[i]->GiveSignal();
+				AdmittedReqT _req;
+				while ( ReadyReqQueue.PopN( &_req, 1 ) == 1 ) {
+					Admission.Cancel( );
+					ServicePort.ReleaseSocket( _req.Item.GetConnect(), false );
+					_req.Item.EndRequest();
+					RequestIdlePool.Return( _req.Item );
 				}
-				for ( Uint32 i = 0; i < ReuseConnectionList.Size(); ++i )
-				{
-					PDELETE( ReuseConnectionList[i] );
-					//Plib::Basic::Memory::Delete( ReuseConnectionList[i] );
-					//delete ReuseConnectionList[i];
+				// The keep-alive ones, returned by the workers until
+				// the pool stopped.
+				TRequest _idle;
+				while ( RequestUsingQueue.Take( _idle ) ) {
+					ServicePort.ReleaseSocket( _idle.GetConnect(), false );
+					_idle.EndRequest();
+					RequestIdlePool.Return( _idle );
 				}
-				ReuseConnectionList.Clear();
-				NormalConnectionList.Clear();
 			}
 			
 		public:
 			// Callback delegate
 			Plib::Generic::Delegate< RpResponse ( RpRequest ) > 		WorkProcess;
+			// Error of any connection, may be set at any time.
 			typename TConnect::so_event									OnConnectionError;
 			Plib::Generic::Delegate< void ( Uint32 ) >					OnServerError;
 			Plib::Generic::Delegate< bool ( Uint32 ) >					IsErrorFatalDelegate;
@@ -369,33 +462,49 @@ namespace Plib
 																		AfterOneRequest;
 			Plib::Generic::Delegate< void ( Service< _TyParser, _TyPoller > * ) >
 																		OnLoseServerPort;
-		protected:
+			// Requests shed since the last call, at most once an interval.
+			Plib::Generic::Delegate< void ( Uint32 ) >					OnRequestShed;
 			
-			void __CheckReuseThreadAndMinus( Plib::Threading::StopWatch & calc )
+			// Counters, gauges and latency of the service and its listener.
+			Plib::Utility::MetricsRegistry								Metrics;
+			
+			// Dump the metrics as text or json.
+			std::string Snapshot( Plib::Utility::MetricsFormat _format = Plib::Utility::MF_TEXT )
 			{
-				if ( ReuseConnectionList.Size() == 1 ) return;
-				calc.Tick();
-				if ( calc.GetMileSecUsed() <= _MaxIdleTime ) return;
-				
-				// Minus a thread
-				WorkThreadT * pThread = ReuseConnectionList.Last( );
-				pThread->GiveSignal();
-				ReuseConnectionList.Remove( ReuseConnectionList.Size() - 1 );
-				PDELETE( pThread );
-				calc.SetStart();
+				return Metrics.Snapshot( _format );
 			}
+		protected:
 			
-			void __CheckReuseThreadAndAdd( Uint32 _Size )
+			// Called by the long term checking thread, the request
+			// already has new data.
+			void __DispatchRequest( TRequest _req )
 			{
-				if ( _Size / ReuseConnectionList.Size() < _MaxSockCountPreThread )
+				if ( !Admission.Enter( ) ) {
+					__DropRequest( _req );
+					return;
+				}
+				if ( !ReadyReqQueue.Push( AdmittedReqT( _req ), 0 ) ) {
+					Admission.Cancel( );
+					__DropRequest( _req );
 					return;
-				PCNEW( WorkThreadT, pThread );
-				//WorkThreadT * pThread = Plib::Basic::Memory::New< WorkThreadT >( );
-				//WorkThreadT * pThread = new WorkThreadT;
-				pThread->Jobs += std::make_pair( this, 
-					&Service< _TyParser, _TyPoller >::__threadForReuseSocket );
-				ReuseConnectionList.PushBack(pThread);
-				pThread->Start();
+				}
+				if ( !WorkerPool.Submit( ReadyTask ) ) {
+					// The pool has been stopped.
+					AdmittedReqT _item;
+					ReadyReqQueue.PopN( &_item, 1 );
+					Admission.Cancel( );
+					ServicePort.ReleaseSocket( _item.Item.GetConnect(), false );
+					_item.Item.EndRequest();
+					RequestIdlePool.Return( _item.Item );
+				}
+			}
+			
+			// Error of a connection, the listener's table is bound to this
+			// once, the delegate set later is still called.
+			SOCKEVENTSTATUE __ConnectionError( typename TConnect::SockType * _so, void * _param )
+			{
+				if ( OnConnectionError ) return OnConnectionError( _so, _param );
+				return SOEVENT_OK;
 			}
 			
 			// Error Processer
@@ -420,112 +529,248 @@ namespace Plib
 				this->StartServer( _Port, _workThreadCount );
 			}
 			
-			// Working Thread.
-			void __threadForReuseSocket( )
+			// Dispatch thread, wait for the readable socket and
+			// let the pool read and process it.
+			void __threadForDispatch( )
 			{
-				Plib::Threading::StopWatch calc;
 				while ( Plib::Threading::ThreadSys::Running() )
 				{
-					RpRequest req = RequestUsingQueue.Get(1);
-					if ( req.RefNull() ) continue;
-					
-					calc.SetStart();
-					RpConnect _cnnt = req.GetConnect();
-					// Process the request, get the response
-					RpResponse resp = WorkProcess( req );
-					if ( resp.RefNull() ) {
-						// The package is not validate
-						ServicePort.ReleaseSocket( _cnnt, false );
-						req.EndRequest();
-						RequestIdlePool.Return( req );
+					RefConnect _cnnt = ServicePort.GetReadableSocket( 1 );
+					if ( _cnnt.RefNull() ) {	// No new connect
 						continue;
 					}
-					resp.Serialize( );
-					Plib::Text::RString _respString = resp.GetResponseString();
-					if ( _respString.Size() > 0 ) {
-						_cnnt->Write(_respString.C_Str(), _respString.Size() );
+					if ( !Admission.Enter( ) ) {
+						__DropConnection( _cnnt );
+						continue;
 					}
-					else {
-						// Build Response Error.
-						ServicePort.ReleaseSocket( _cnnt, false );
-						req.EndRequest();
-						RequestIdlePool.Return( req );						
+					if ( !IncomingConnQueue.Push( AdmittedConnT( _cnnt ), 0 ) ) {
+						Admission.Cancel( );
+						__DropConnection( _cnnt );
 						continue;
 					}
-
-					calc.Tick();
-					if ( AfterOneRequest ) AfterOneRequest( req, calc );					
-					
-					if ( req.KeepAlive() ) {
-						req.ReuseRequest();
-						RequestUsingQueue.Return( req );
-					} else {
-						ServicePort.ReleaseSocket( _cnnt, false );
-						req.EndRequest();
-						RequestIdlePool.Return( req );
+					if ( !WorkerPool.Submit( IncomingTask ) ) {
+						AdmittedConnT _item;
+						IncomingConnQueue.PopN( &_item, 1 );
+						Admission.Cancel( );
+						ServicePort.ReleaseSocket( _item.Item, false );
 					}
 				}
 			}
-			void __threadForGetIncomingSocket( )
+
+			// Read the request of the socket into a request object, the
+			// read stops at the deadline.
+			bool __CreateRequest( RefConnect _cnnt, TRequest & req, const Deadline & _deadline )
+			{
+				// Fetch a reusable request object from the pool.
+				req = RequestIdlePool.Get();
+				req.SetDeadline( _deadline );
+				if ( req.Create( _cnnt ) ) return true;
+				// On Error
+				req.EndRequest();
+				ServicePort.ReleaseSocket( _cnnt, false );
+				RequestIdlePool.Return( req );
+				return false;
+			}
+
+			// Pool task, one for each incoming socket.
+			void __ProcessIncomingSocket( )
+			{
+				AdmittedConnT _item;
+				IncomingConnQueue.Pop( _item );
+				if ( !__Admit( _item.Since ) ) {
+					__ShedConnection( _item.Item );
+					return;
+				}
+				Deadline _deadline = Deadline::Since( _item.Since, _requestBudget );
+				if ( _deadline.Expired( ) ) {
+					_ExpiredCount->Add( );
+					ServicePort.ReleaseSocket( _item.Item, false );
+					return;
+				}
+				TRequest req;
+				if ( !__CreateRequest( _item.Item, req, _deadline ) ) return;
+				__ProcessRequest( req );
+			}
+
+			// Pool task, one for each keep-alive request with new data.
+			void __ProcessReadyRequest( )
+			{
+				AdmittedReqT _item;
+				ReadyReqQueue.Pop( _item );
+				if ( !__Admit( _item.Since ) ) {
+					__ShedRequest( _item.Item );
+					return;
+				}
+				_item.Item.SetDeadline( Deadline::Since( _item.Since, _requestBudget ) );
+				__ProcessRequest( _item.Item );
+			}
+
+			// The worker takes a queued item, false if it must be shed.
+			bool __Admit( Uint64 _since )
+			{
+				Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+				_QueueDelay->Record( ( _now > _since ) ? _now - _since : 0 );
+				return Admission.Leave( _since );
+			}
+
+			// Shed the request of the socket, the request is still read
+			// so that the parser can reject it. Only in the workers, the
+			// read and the write may wait.
+			void __ShedConnection( RefConnect _cnnt )
+			{
+				TRequest req;
+				if ( __CreateRequest( _cnnt, req, Deadline( ) ) ) {
+					__ShedRequest( req );
+					return;
+				}
+				_ShedCount->Add( );
+				__ReportShed( );
+			}
+
+			// Answer the rejection of the parser without the work process,
+			// and close the connection, the pipelined requests go with it.
+			void __ShedRequest( TRequest req )
+			{
+				_ShedCount->Add( );
+				RefConnect _cnnt = req.GetConnect();
+				TResponse resp = req.GetResponse();
+				if ( !resp.RefNull() && resp.SerializeReject( ) ) {
+					const Plib::Text::RString & _reject = resp.GetResponseString();
+					_cnnt->Write( _reject.C_Str(), _reject.Size() );
+				}
+				req.EndRequest();
+				ServicePort.ReleaseSocket( _cnnt, false );
+				RequestIdlePool.Return( req );
+				__ReportShed( );
+			}
+
+			// Shed in the dispatch or the checking thread, which must not
+			// wait on one socket: close the connection, no rejection.
+			void __DropConnection( RefConnect _cnnt )
+			{
+				_ShedCount->Add( );
+				ServicePort.ReleaseSocket( _cnnt, false );
+				__ReportShed( );
+			}
+			void __DropRequest( TRequest req )
+			{
+				_ShedCount->Add( );
+				RefConnect _cnnt = req.GetConnect();
+				req.EndRequest();
+				ServicePort.ReleaseSocket( _cnnt, false );
+				RequestIdlePool.Return( req );
+				__ReportShed( );
+			}
+
+			void __ReportShed( )
+			{
+				Uint32 _shed = Admission.TakeShed( );
+				if ( _shed > 0 && OnRequestShed ) OnRequestShed( _shed );
+			}
+
+			// Too late to answer, close the connection.
+			void __ExpireRequest( TRequest req, RefConnect _cnnt )
+			{
+				_ExpiredCount->Add( );
+				req.EndRequest();
+				ServicePort.ReleaseSocket( _cnnt, false );
+				RequestIdlePool.Return( req );
+			}
+
+			INLINE void __CountWrites( const WriteBatch< TConnect > & _output )
+			{
+				_WriteCount->Add( _output.Writes( ) );
+				_WriteBytes->Add( _output.Bytes( ) );
+			}
+
+			// Failed to answer the request, close the connection.
+			void __FailRequest( TRequest req, RefConnect _cnnt )
+			{
+				_RequestErrorCount->Add( );
+				req.EndRequest();
+				ServicePort.ReleaseSocket( _cnnt, false );
+				RequestIdlePool.Return( req );
+			}
+
+			// Get the response of a request and write it back.
+			// With a pipelining parser, all the complete requests in the
+			// buffer are processed in arrival order and the responses are
+			// coalesced, the last one pushes them out.
+			// The deadline is checked before the first request only, the
+			// pipelined ones behind it are answered with it.
+			// The batch is flushed or discarded before the connection is
+			// released, it must not write to a closed socket.
+			void __ProcessRequest( TRequest req )
 			{
 				Plib::Threading::StopWatch calc;
-				while ( Plib::Threading::ThreadSys::Running() )
-				{
-					RpConnect _cnnt = ServicePort.GetReadableSocket( 1 );
-					if ( _cnnt.RefNull() ) {	// No new connect
-						continue;
-					}
-					
-					calc.SetStart();
-					// Re-bind the onError event.
-					if ( _cnnt->onError.Count() == 0 ) _cnnt->onError = OnConnectionError;
-					
-					// Fetch a reusable request object from the pool.
-					RpRequest req = RequestIdlePool.Get();
-					
-					if ( !req.Create( _cnnt ) )
-					{
-						// On Error
-						req.EndRequest();
-						ServicePort.ReleaseSocket( _cnnt, false );
-						RequestIdlePool.Return( req );
-						continue;
-					}
+				RefConnect _cnnt = req.GetConnect();
+				if ( req.GetDeadline().Expired( ) ) {
+					__ExpireRequest( req, _cnnt );
+					return;
+				}
+				WriteBatch< TConnect > _output( &(*_cnnt), _flushBytes, _flushDelay );
+				Plib::Text::RString _respString;
+				// The calls made by the work process inherit the deadline.
+				DeadlineScope _scope( req.GetDeadline() );
+				for ( ; ; ) {
 					// Process the request, get the response
-					RpResponse resp = WorkProcess( req );
-					// Failed to build the response
+					TResponse resp = WorkProcess( req );
+					// Failed to build the response, the earlier ones
+					// are still sent.
 					if ( resp.RefNull() ) {
-						req.EndRequest();
-						ServicePort.ReleaseSocket( _cnnt, false );
-						RequestIdlePool.Return( req );
-						continue;
+						_output.Flush( );
+						__CountWrites( _output );
+						__FailRequest( req, _cnnt );
+						return;
 					}
-					
-					resp.Serialize( );					
-					Plib::Text::RString _respString = resp.GetResponseString();
-					if ( _respString.Size() == 0 || !_cnnt->Write(
-					 						_respString.c_str(), _respString.size() ) )
-					{
-						req.EndRequest();
-						ServicePort.ReleaseSocket( _cnnt, false );
-						RequestIdlePool.Return( req );
-						continue;
+
+					resp.Serialize( );
+					_respString = resp.GetResponseString();
+					if ( _respString.Size() == 0 ) {
+						_output.Flush( );
+						__CountWrites( _output );
+						__FailRequest( req, _cnnt );
+						return;
 					}
 
 					calc.Tick();
+					_RequestCount->Add( );
+					_RequestLatency->Record( calc.GetMicroSecUsed( ) );
 					if ( AfterOneRequest ) AfterOneRequest( req, calc );
-					
-					// Release the connection object according to
-					// the KeepAlive property of the request.
-					if ( req.KeepAlive() ) {
-						req.ReuseRequest();
-						RequestUsingQueue.Return( req );
+
+					// The response buffer is reused by the next request,
+					// the batch takes it before that.
+					bool _more = req.NextPipelined( );
+					bool _written = _output.Add( _respString.C_Str(), _respString.Size(), _more );
+					if ( !_written ) {
+						_output.Discard( );
+						__CountWrites( _output );
+						__FailRequest( req, _cnnt );
+						return;
 					}
-					else {
-						req.EndRequest();
-						ServicePort.ReleaseSocket( _cnnt, false );
-						RequestIdlePool.Return( req );
+					if ( !_more ) break;
+					// The next one may take as long as this one, the held
+					// responses do not wait for it past the delay.
+					if ( !_output.Hold( calc.GetMicroSecUsed( ) ) ) {
+						_output.Discard( );
+						__CountWrites( _output );
+						__FailRequest( req, _cnnt );
+						return;
 					}
+					calc.SetStart( );
+				}
+				__CountWrites( _output );
+					
+				// Release the connection object according to
+				// the KeepAlive property of the request.
+				if ( req.KeepAlive() ) {
+					req.ReuseRequest();
+					RequestUsingQueue.Return( req );
+				}
+				else {
+					req.EndRequest();
+					ServicePort.ReleaseSocket( _cnnt, false );
+					RequestIdlePool.Return( req );
 				}
 			}
 		};
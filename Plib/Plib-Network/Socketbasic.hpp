@@ -5,10 +5,22 @@
 * File Name			: socket.hpp
 * Propose  			: 
 * 
-* Current Version	: 1.4
+* Current Version	: 1.9
 * Change Log		: Update to AsyncSocket to Speed Up Sending and Receving in Windows
 * Change Log V1.3	: Re-write all code and fix some bugs.
 * Change Log V1.4	: Re-write Under the framework of Plib-1.1
+* Change Log V1.5	: Connect to unix socket path.
+* Change Log V1.6	: Gathered write with MSG_MORE, cork the socket.
+* Change Log V1.7	: Compact idle socket, shared events, binary address, lazy buffers,
+*					  wait by poll for any descriptor.
+* Change Log V1.8	: Resolve the domain by getaddrinfo, safe in any thread.
+* Change Log V1.9	: Migration from V1.6, the interface broken by V1.7:
+*					  onStatueChange, onBinding, onConnecting, onConnected, onClosed,
+*					  onTimeOut, onError and onBufferWarn are in Events( ), bind them
+*					  by OwnEvents( ).onError += ... for one socket;
+*					  RemoteAddress, LocalAddress, RemotePort, LocalPort and
+*					  ErrorMessage are methods, add ( ); BufferData is removed,
+*					  read ErrorMessage( ).
 * Author			: Push Chen
 * Change Date		: 2010-7-6
 */
@@ -22,16 +34,19 @@
 #include "Generic.hpp"
 #include "Threading.hpp"
 #include "String.hpp"
+#include "Endpoint.hpp"
 #else
 #include <Plib-Generic/Generic.hpp>
 #include <Plib-Threading/Threading.hpp>
 #include <Plib-Text/Text.hpp>
+#include <Plib-Network/Endpoint.hpp>
 #endif
 
 #if _DEF_WIN32
 	#include <WS2tcpip.h>
 	#pragma comment( lib, "Ws2_32.lib" )
 	#define PLIB_NETWORK_NOSIGNAL			0
+	#define PLIB_NETWORK_MSGMORE			0
 	#define PLIB_NETWORK_IOCTL_CALL			ioctlsocket
 	#define PLIB_NETWORK_CLOSESOCK			::closesocket
 #else 
@@ -42,7 +57,13 @@
 	#include <arpa/inet.h>
 	#include <sys/ioctl.h>
 	#include <netinet/tcp.h>
+	#include <poll.h>
 	#define PLIB_NETWORK_NOSIGNAL			MSG_NOSIGNAL
+	#ifdef MSG_MORE
+	#define PLIB_NETWORK_MSGMORE			MSG_MORE
+	#else
+	#define PLIB_NETWORK_MSGMORE			0
+	#endif
 	#define PLIB_NETWORK_IOCTL_CALL			ioctl
 	#define PLIB_NETWORK_CLOSESOCK			close
 #endif
@@ -64,22 +85,25 @@ namespace Plib
 		#endif
 
 		/* Translate Domain to IP Address */
+		/* getaddrinfo and inet_ntop keep no static buffer, so the
+		   connecting threads can resolve at the same time. */
 		INLINE char * Domain2Ip(const char * cp_Domain, char * pb_IPOutput, Uint32 vb_Len)
 		{
-			struct hostent FAR * xp_HostEnt;
-			struct in_addr v_inAddr;
-			char * xp_addr;
+			struct addrinfo v_Hints;
+			struct addrinfo * xp_Result = NULL;
 
 			memset(pb_IPOutput, 0, vb_Len);
 
-			xp_HostEnt = gethostbyname(cp_Domain);
-			if (xp_HostEnt == NULL) return pb_IPOutput;
+			memset(&v_Hints, 0, sizeof(v_Hints));
+			v_Hints.ai_family = AF_INET;
+			v_Hints.ai_socktype = SOCK_STREAM;
+			if (getaddrinfo(cp_Domain, NULL, &v_Hints, &xp_Result) != 0) return pb_IPOutput;
+			if (xp_Result == NULL) return pb_IPOutput;
 
-			xp_addr = xp_HostEnt->h_addr_list[0];
-			if (xp_addr == NULL) return pb_IPOutput;
-
-			memmove(&v_inAddr, xp_addr, 4);
-			strcpy(pb_IPOutput, inet_ntoa(v_inAddr));
+			struct sockaddr_in * xp_addr = (struct sockaddr_in *)xp_Result->ai_addr;
+			if (inet_ntop(AF_INET, &xp_addr->sin_addr, pb_IPOutput, vb_Len) == NULL)
+				memset(pb_IPOutput, 0, vb_Len);
+			freeaddrinfo(xp_Result);
 
 			return pb_IPOutput;
 		}
@@ -164,6 +188,34 @@ namespace Plib
 			SOEVENT_DONE = 3
 		} SOCKEVENTSTATUE;
 
+		// Wait for the socket to be readable or writable, in mile seconds.
+		// Return 1 when ready, 0 on time out and -1 on error. Other than
+		// Windows by poll, select can not take a descriptor over
+		// FD_SETSIZE, which a server with many connections has.
+		INLINE int WaitSocket( SOCKET_T _hSo, bool _read, unsigned int _mileSec )
+		{
+			if ( _hSo == -1 ) return -1;
+			int _retCode;
+			do {
+			#if _DEF_WIN32
+				fd_set _fs;
+				FD_ZERO( &_fs );
+				FD_SET( _hSo, &_fs );
+				struct timeval _tv = { (long)( _mileSec / 1000 ), (long)( ( _mileSec % 1000 ) * 1000 ) };
+				_retCode = ::select( (int)_hSo + 1, ( _read ? &_fs : NULL ),
+					( _read ? NULL : &_fs ), NULL, &_tv );
+			#else
+				struct pollfd _pfd;
+				_pfd.fd = (int)_hSo;
+				_pfd.events = _read ? POLLIN : POLLOUT;
+				_pfd.revents = 0;
+				_retCode = ::poll( &_pfd, 1, (int)_mileSec );
+			#endif
+			} while ( _retCode == -1 && PLIB_LASTERROR == EINTR );
+			if ( _retCode < 0 ) return -1;
+			return ( _retCode == 0 ) ? 0 : 1;
+		}
+
 		typedef struct tagDATAPAIR {
 			const char *	data;
 			unsigned int	length;
@@ -190,66 +242,119 @@ namespace Plib
 			typedef SocketBasic< _TySo, SOCK_BUF_LENGTH > SockType;
 			typedef Plib::Generic::Delegate< SOCKEVENTSTATUE ( SockType *, void * ) > so_event;
 
+			// The events of the socket life. They are the same for all the
+			// sockets of one owner, like the sockets accepted by a listener,
+			// so the owner keeps one table and the sockets point to it.
+			struct SockEvents
+			{
+				so_event	onStatueChange;
+				so_event	onBinding;
+				so_event	onConnecting;
+				so_event	onConnected;
+				so_event	onClosed;
+
+				so_event	onTimeOut;
+				so_event	onError;
+				so_event	onBufferWarn;
+			};
+
+			// The family of the address kept.
+			enum { SO_FAMILY_NONE = 0, SO_FAMILY_INET, SO_FAMILY_UNIX };
+
 		protected:
 			// Inside Object.
 			SOCKET_T		m_hSo;
 			bool			m_bBound;	// if the socket is came from outside.
+			bool			m_ownEvents;	// m_events is allocated for this socket.
 
-			// Socket Information.
-			char			m_remoteAddr[SO_ADDR_LEN];
-			char			m_localAddr[SO_ADDR_LEN];
-			unsigned int	m_remotePort;
-			unsigned int	m_localPort;
+			// Socket Information, kept in binary and formatted when asked.
+			Uint8			m_family;
+			Uint16			m_remotePort;
+			Uint16			m_localPort;
+			Uint32			m_remoteAddr;	// network order
+			Uint32			m_localAddr;
 
 			// Statue
 			SOSTATUE		m_lastStatue;
 			SOSTATUE		m_statue;
 
-			// Error Message
-			char			m_errorMessage[SOCK_BUF_LENGTH];
+			// Error Message, allocated on the first error.
+			char *			m_errorMessage;
 			int				m_errorCode;
 
-			// Stopwatch
-			Plib::Threading::StopWatch		m_timeCalc;
+			// The cached now of the last statue change, the idle check is
+			// in the poller loop.
+			Uint64			m_lastActive;
 			Plib::Text::RString *			m_bufferString;
+			SockEvents *	m_events;
 
 		public:
 			// Read Only Properities
 			const SOCKET_T &		hSo;
 			const bool &			IsBind;
-			const char * const		RemoteAddress;
-			const char * const		LocalAddress;
-			const unsigned int &	RemotePort;
-			const unsigned int &	LocalPort;
 
 			const SOSTATUE &		LastStatue;
 			const SOSTATUE &		Statue;
 
-			const char * const		ErrorMessage;
 			const int &				ErrorCode;
-			const char * const		BufferData;
 
 		public:
-			// Event
-			so_event	onStatueChange;
-			so_event	onBinding;
-			so_event	onConnecting;
-			so_event	onConnected;
-			so_event	onClosed;
-
+			// Event of the data read, bound by the reader of the socket.
 			so_event	onParseData;
 			so_event	onBufferUpdate;
 
-			so_event	onTimeOut;
-			so_event	onError;
-			so_event	onBufferWarn;
-
 		protected:
 			// Inside Object
 			_TySo		_T_so;
 
 		protected:
 
+			// The table of the socket with no owner.
+			static INLINE SockEvents & __NoEvents( )
+			{
+				static SockEvents _events;
+				return _events;
+			}
+
+			static INLINE Plib::Text::RString __FormatAddress( Uint32 _addr )
+			{
+				char _text[16];
+				const unsigned char * _byte = (const unsigned char *)&_addr;
+				sprintf( _text, "%u.%u.%u.%u", (unsigned int)_byte[0], (unsigned int)_byte[1],
+					(unsigned int)_byte[2], (unsigned int)_byte[3] );
+				return Plib::Text::RString( _text );
+			}
+
+			// The peer of a unix socket has no name, both sides show the
+			// path of the listener.
+			INLINE Plib::Text::RString __UnixPath( ) const
+			{
+			#if PLIB_HAS_UNIX_SOCKET
+				struct sockaddr_un _un;
+				socklen_t _unLen = sizeof(_un);
+				if ( m_hSo == -1 || 0 != getsockname( m_hSo, (struct sockaddr *)&_un, &_unLen ) ||
+					_unLen <= offsetof( struct sockaddr_un, sun_path ) )
+					return Plib::Text::RString( );
+				size_t _length = _unLen - offsetof( struct sockaddr_un, sun_path );
+				if ( _length > sizeof(_un.sun_path) ) _length = sizeof(_un.sun_path);
+				char _path[sizeof(_un.sun_path) + 1];
+				memcpy( _path, _un.sun_path, _length );
+				_path[_length] = '\0';
+				if ( _path[0] == '\0' ) _path[0] = '@';
+				return Plib::Text::RString( _path );
+			#else
+				return Plib::Text::RString( );
+			#endif
+			}
+
+			// A new connection starts with no error.
+			INLINE void __ClearError( )
+			{
+				m_errorCode = 0;
+				if ( m_errorMessage == NULL ) return;
+				PFREE( m_errorMessage );
+				m_errorMessage = NULL;
+			}
 
 			// Intenal Event Methods
 			// On Statue Change.
@@ -260,8 +365,8 @@ namespace Plib
 					( _statue == SOST_IDLE || _statue == SOST_EMPTY ) ) return;
 				m_lastStatue = m_statue;
 				m_statue = _statue;
-				if ( onStatueChange ) onStatueChange( this, NULL );
-				m_timeCalc.SetStart( );
+				if ( m_events->onStatueChange ) m_events->onStatueChange( this, NULL );
+				m_lastActive = Plib::Threading::MonotonicClock::CachedNanoSeconds( );
 			}
 
 			// On Error Happen. if defined ErrorMsg, the error code will be set to -1
@@ -269,78 +374,59 @@ namespace Plib
 			INLINE void _so_errorHappen( const char * _errorMsg = NULL )
 			{
 				_so_changeStatue( SOST_ERROR );
+				if ( m_errorMessage == NULL ) {
+					PMALLOC( char, m_errorMessage, SOCK_BUF_LENGTH );
+				}
 				if ( _errorMsg ) {
 					m_errorCode = -1;
 					int _tLen = strlen( _errorMsg );
+					if ( _tLen >= SOCK_BUF_LENGTH ) _tLen = SOCK_BUF_LENGTH - 1;
 					::memcpy( m_errorMessage, _errorMsg, _tLen );
 					m_errorMessage[_tLen] = 0;
 				} else {
 					Plib::Text::RString _ErrMessage = Plib::Text::LastErrorMessage;
-					int _tLen = SOCK_BUF_LENGTH < _ErrMessage.Size( ) ? 
+					int _tLen = SOCK_BUF_LENGTH <= _ErrMessage.Size( ) ? 
 						SOCK_BUF_LENGTH - 1 : _ErrMessage.Size( );
 					::memcpy( m_errorMessage, _ErrMessage.C_Str( ), _tLen );
 					m_errorMessage[_tLen] = 0;
 					//getLastErrorMsg( m_errorMessage, SOCK_BUF_LENGTH );
 				}
-				if ( onError ) onError( this, NULL );
+				if ( m_events->onError ) m_events->onError( this, NULL );
 				this->Close();
 			}
 
-			// Get socket Information.
+			// Get socket Information, the text is made when asked.
 			INLINE void _so_sockInfo( )
 			{
+				m_family = SO_FAMILY_NONE;
 				if ( m_hSo == -1 ) return;
 
-				struct sockaddr_in _addr;
+				struct sockaddr_storage _addr;
 				socklen_t _addrLen = sizeof(_addr);
-				::memset( &_addr, 0, sizeof(_addr) );
-				if ( 0 == getsockname( m_hSo, (struct sockaddr *)&_addr, &_addrLen) )
-				{
-					m_localPort = ntohs(_addr.sin_port);
-					sprintf( m_localAddr, "%u.%u.%u.%u",
-						(unsigned int)(_addr.sin_addr.s_addr >> (0 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (1 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (2 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (3 * 8)) & 0x00FF );
+				if ( 0 != getsockname( m_hSo, (struct sockaddr *)&_addr, &_addrLen ) ) return;
+			#if PLIB_HAS_UNIX_SOCKET
+				if ( _addr.ss_family == AF_UNIX ) {
+					m_family = SO_FAMILY_UNIX;
+					m_localPort = m_remotePort = 0;
+					return;
 				}
-				memset( &_addr, 0, sizeof(_addr) );
+			#endif
+				if ( _addr.ss_family != AF_INET ) return;
+				m_family = SO_FAMILY_INET;
+				m_localAddr = ((struct sockaddr_in *)&_addr)->sin_addr.s_addr;
+				m_localPort = ntohs( ((struct sockaddr_in *)&_addr)->sin_port );
+
+				_addrLen = sizeof(_addr);
 				if ( 0 == getpeername( m_hSo, (struct sockaddr *)&_addr, &_addrLen ) )
 				{
-					m_remotePort = ntohs(_addr.sin_port);
-					sprintf( m_remoteAddr, "%u.%u.%u.%u",
-						(unsigned int)(_addr.sin_addr.s_addr >> (0 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (1 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (2 * 8)) & 0x00FF,
-						(unsigned int)(_addr.sin_addr.s_addr >> (3 * 8)) & 0x00FF );
+					m_remoteAddr = ((struct sockaddr_in *)&_addr)->sin_addr.s_addr;
+					m_remotePort = ntohs( ((struct sockaddr_in *)&_addr)->sin_port );
 				}
 			}
 
 			INLINE int _so_select( bool _read = true )
 			{
-				if ( m_hSo == -1 ) return -1;
-				fd_set _fs;
-				FD_ZERO(&_fs);
-				FD_SET( m_hSo, &_fs );
-
-				int _retCode = 0;
-				struct timeval _tv = {0, 0};
-				do {
-					_retCode = ::select( m_hSo + 1, (_read ? &_fs : NULL),
-													(_read ? NULL : &_fs),
-													NULL, &_tv );
-					if ( _retCode == -1 ) {
-						// Check the error number
-						int _err = PLIB_LASTERROR;
-						if ( _err != EINTR ) return -1;
-						continue;
-					}
-					if ( _retCode == 0 ) {
-						return 0;
-					}
-					return 1;
-				} while ( 1 );
-
-				return -1;
+				return WaitSocket( m_hSo, _read, 0 );
 			}
 
 		public:
@@ -349,21 +435,19 @@ namespace Plib
 			// C'Str
 			SocketBasic< _TySo, SOCK_BUF_LENGTH >( ) :
 				// Protected Init
-				m_hSo( -1 ), m_bBound( false ), 
+				m_hSo( -1 ), m_bBound( false ), m_ownEvents( false ),
+				m_family( SO_FAMILY_NONE ), m_remotePort( 0 ), m_localPort( 0 ),
+				m_remoteAddr( 0 ), m_localAddr( 0 ),
 				m_lastStatue( SOST_EMPTY ), m_statue( SOST_EMPTY ),
-				m_errorCode( 0 ), m_bufferString( NULL ),
+				m_errorMessage( NULL ), m_errorCode( 0 ),
+				m_lastActive( Plib::Threading::MonotonicClock::CachedNanoSeconds( ) ),
+				m_bufferString( NULL ), m_events( &__NoEvents( ) ),
 				// Reference Inti
 				hSo( m_hSo ), IsBind( m_bBound ),
-				RemoteAddress( m_remoteAddr ), LocalAddress( m_localAddr ),
-				RemotePort( m_remotePort ), LocalPort( m_localPort ),
 				LastStatue( m_lastStatue ), Statue( m_statue ),
-				ErrorMessage( m_errorMessage ), ErrorCode( m_errorCode ), 
-				BufferData( m_errorMessage )
+				ErrorCode( m_errorCode )
 			{
 				CONSTRUCTURE;
-				m_remoteAddr[0] = 0;
-				m_localAddr[0] = 0;
-				m_errorMessage[0] = 0;
 
 				_T_so.initialize( this );
 			}
@@ -371,21 +455,19 @@ namespace Plib
 			// Get socket outside, bind it.
 			SocketBasic< _TySo, SOCK_BUF_LENGTH >( SOCKET_T _hSo, bool _CompleteControl = false ) : 
 				// Protected Init
-				m_hSo( -1 ), m_bBound( false ), 
+				m_hSo( -1 ), m_bBound( false ), m_ownEvents( false ),
+				m_family( SO_FAMILY_NONE ), m_remotePort( 0 ), m_localPort( 0 ),
+				m_remoteAddr( 0 ), m_localAddr( 0 ),
 				m_lastStatue( SOST_EMPTY ), m_statue( SOST_EMPTY ),
-				m_errorCode( 0 ), m_bufferString( NULL ),
+				m_errorMessage( NULL ), m_errorCode( 0 ),
+				m_lastActive( Plib::Threading::MonotonicClock::CachedNanoSeconds( ) ),
+				m_bufferString( NULL ), m_events( &__NoEvents( ) ),
 				// Reference Inti
 				hSo( m_hSo ), IsBind( m_bBound ),
-				RemoteAddress( m_remoteAddr ), LocalAddress( m_localAddr ),
-				RemotePort( m_remotePort ), LocalPort( m_localPort ),
 				LastStatue( m_lastStatue ), Statue( m_statue ),
-				ErrorMessage( m_errorMessage ), ErrorCode( m_errorCode ), 
-				BufferData( m_errorMessage )
+				ErrorCode( m_errorCode )
 			{
 				CONSTRUCTURE;
-				m_remoteAddr[0] = 0;
-				m_localAddr[0] = 0;
-				m_errorMessage[0] = 0;
 				
 				_T_so.initialize( this );
 
@@ -398,6 +480,57 @@ namespace Plib
 			{
 				DESTRUCTURE;
 				Close();
+				ShareEvents( NULL );
+				if ( m_errorMessage != NULL ) { PFREE( m_errorMessage ); }
+			}
+
+			// The events of the socket, may be shared with its owner.
+			INLINE const SockEvents & Events( ) const
+			{
+				return *m_events;
+			}
+
+			// The events of this socket alone, copied from the shared
+			// table on the first call.
+			INLINE SockEvents & OwnEvents( )
+			{
+				if ( !m_ownEvents ) {
+					SockEvents * _shared = m_events;
+					PNEWPARAM( SockEvents, m_events, *_shared );
+					m_ownEvents = true;
+				}
+				return *m_events;
+			}
+
+			// Use the events of the owner, which must live longer than
+			// the socket. NULL for no events.
+			INLINE void ShareEvents( SockEvents * _events )
+			{
+				if ( m_ownEvents ) { PDELETE( m_events ); }
+				m_ownEvents = false;
+				m_events = ( _events == NULL ) ? &__NoEvents( ) : _events;
+			}
+
+			// The addresses are formatted on each call, empty when the
+			// socket is not connected.
+			INLINE Plib::Text::RString RemoteAddress( ) const
+			{
+				if ( m_family == SO_FAMILY_INET ) return __FormatAddress( m_remoteAddr );
+				if ( m_family == SO_FAMILY_UNIX ) return __UnixPath( );
+				return Plib::Text::RString( );
+			}
+			INLINE Plib::Text::RString LocalAddress( ) const
+			{
+				if ( m_family == SO_FAMILY_INET ) return __FormatAddress( m_localAddr );
+				if ( m_family == SO_FAMILY_UNIX ) return __UnixPath( );
+				return Plib::Text::RString( );
+			}
+			INLINE unsigned int RemotePort( ) const { return m_remotePort; }
+			INLINE unsigned int LocalPort( ) const { return m_localPort; }
+
+			INLINE const char * ErrorMessage( ) const
+			{
+				return ( m_errorMessage == NULL ) ? "" : m_errorMessage;
 			}
 
 			// Socket Option Change
@@ -426,6 +559,24 @@ namespace Plib
 					TCP_NODELAY, (const char *)&flag, sizeof(int) ) != -1;
  			}
 
+			// Hold the partial segments until uncorked, even with no delay.
+			// TCP_NOPUSH on BSD, not supported on Windows.
+			INLINE bool SetCork( bool _cork )
+			{
+				if ( m_hSo == -1 ) return false;
+			#if defined TCP_CORK
+				int flag = _cork ? 1 : 0;
+				return setsockopt( m_hSo, IPPROTO_TCP,
+					TCP_CORK, (const char *)&flag, sizeof(int) ) != -1;
+			#elif defined TCP_NOPUSH
+				int flag = _cork ? 1 : 0;
+				return setsockopt( m_hSo, IPPROTO_TCP,
+					TCP_NOPUSH, (const char *)&flag, sizeof(int) ) != -1;
+			#else
+				return false;
+			#endif
+			}
+
 			INLINE bool SetSoWriteBufferSize( unsigned int _size )
 			{
 				if ( m_hSo == -1 ) return false;
@@ -458,9 +609,51 @@ namespace Plib
 				m_bufferString = NULL;
 			}
 
+			// Connect to a unix socket path, "unix:" host in Connect.
+			// A local connect only waits when the backlog of the listener
+			// is full, the send time out bounds the wait.
+			INLINE bool Connect( const Endpoint & _endpoint, unsigned _timeOut = 0 )
+			{
+				_so_changeStatue( SOST_CONNECTING );
+				struct sockaddr_storage _sockAddr;
+				socklen_t _addrLen = _endpoint.Address( _sockAddr );
+				if ( !_endpoint.IsUnix( ) || _addrLen == 0 ) {
+					_so_errorHappen( "Invalidate Unix Socket Path" );
+					return false;
+				}
+
+				if ( m_hSo != -1 ) this->Close();
+				m_hSo = ::socket( _endpoint.Family( ), SOCK_STREAM, 0 );
+				if ( hSo == -1 ) {
+					_so_errorHappen();
+					return false;
+				}
+
+				struct timeval _tm = { (long)( _timeOut / 1000 ), (long)( ( _timeOut % 1000 ) * 1000 ) };
+				if ( _timeOut > 0 ) setsockopt( m_hSo, SOL_SOCKET, SO_SNDTIMEO, 
+					(const char *)&_tm, sizeof(_tm) );
+
+				if ( m_events->onConnecting ) m_events->onConnecting( this, NULL );
+				if ( ::connect( m_hSo, (struct sockaddr *)&_sockAddr, _addrLen ) == -1 ) {
+					_so_errorHappen();
+					return false;
+				}
+				if ( _timeOut > 0 ) {
+					_tm.tv_sec = _tm.tv_usec = 0;
+					setsockopt( m_hSo, SOL_SOCKET, SO_SNDTIMEO, (const char *)&_tm, sizeof(_tm) );
+				}
+
+				_so_sockInfo();
+				if ( m_events->onConnected ) m_events->onConnected( this, NULL );
+				_so_changeStatue( SOST_IDLE );
+				return true;
+			}
+
 			INLINE bool Connect( const char * _addr, unsigned _port, 
 				unsigned _timeOut = 0, unsigned _localPort = 0 )
 			{
+				if ( Endpoint::IsUnixHost( _addr ) ) 
+					return this->Connect( Endpoint::Parse( _addr, _port ), _timeOut );
 				//
 				_so_changeStatue( SOST_CONNECTING );
 				if ( _addr == NULL || _port == 0 )
@@ -522,7 +715,7 @@ namespace Plib
 				}
 
 				// Before Connect
-				if ( onConnecting )  onConnecting( this, NULL );
+				if ( m_events->onConnecting ) m_events->onConnecting( this, NULL );
 
 				if ( ::connect( m_hSo, (struct sockaddr *)&_sockAddr, 
 						sizeof(_sockAddr) ) == -1 )
@@ -531,16 +724,13 @@ namespace Plib
 						_so_errorHappen();
 						return false;
 					}
-					struct timeval _tm = { _timeOut / 1000, (_timeOut % 1000) * 1000 };
-					fd_set _fs;
-					int _error = 0, len = 0;
-					FD_ZERO( &_fs );
-					FD_SET( m_hSo, &_fs );
+					int _error = 0;
+					socklen_t len = sizeof(_error);
 					bool rtn = false;
-					if ( ::select(m_hSo + 1, NULL, &_fs, NULL, &_tm) > 0 )
+					if ( WaitSocket( m_hSo, false, _timeOut ) > 0 )
 					{
 						getsockopt( m_hSo, SOL_SOCKET, SO_ERROR, 
-							(char *)&_error, (socklen_t *)&len);
+							(char *)&_error, &len);
 						if ( _error == 0 ) rtn = true;
 					}
 					if ( !rtn )
@@ -559,7 +749,7 @@ namespace Plib
 				// Get Socket Remote Address and Local Port
 				_so_sockInfo();
 
-				if ( onConnected ) onConnected( this, NULL );
+				if ( m_events->onConnected ) m_events->onConnected( this, NULL );
 				_so_changeStatue( SOST_IDLE );
 				return true;
 			}
@@ -586,7 +776,8 @@ namespace Plib
 					return false;
 				}
 				if ( _ret == 0 ) return true;
-				if ( ::recv(m_hSo, m_errorMessage, 1, MSG_PEEK) <= 0 ) {
+				char _peek;
+				if ( ::recv(m_hSo, &_peek, 1, MSG_PEEK) <= 0 ) {
 					//PTRACE( "recv return error." );
 					this->Close();
 					return false;
@@ -607,7 +798,8 @@ namespace Plib
 					//PTRACE( "_so_select return timeout." );
 					return false;
 				}
-				if ( ::recv( m_hSo, m_errorMessage, 1, MSG_PEEK ) <= 0 ) {
+				char _peek;
+				if ( ::recv( m_hSo, &_peek, 1, MSG_PEEK ) <= 0 ) {
 					//PTRACE( "recv return error." );
 					this->Close();
 					return false;
@@ -634,11 +826,12 @@ namespace Plib
 				m_hSo = _hSo;
 				if ( !_CompleteControl ) m_bBound = true;
 				else m_bBound = false;
+				__ClearError( );
 
 				// Get Socket info.
 				_so_sockInfo();
 				_so_changeStatue( SOST_BINDING );
-				if ( onBinding ) onBinding( this, NULL );
+				if ( m_events->onBinding ) m_events->onBinding( this, NULL );
 				
 				_so_changeStatue( SOST_IDLE );
 
@@ -655,12 +848,13 @@ namespace Plib
 				PLIB_NETWORK_CLOSESOCK( m_hSo );
 
 				m_hSo = -1;
+				this->m_family = SO_FAMILY_NONE;
 				this->m_localPort = 0;
 				this->m_remotePort = 0;
-				this->m_localAddr[0] = '\0';
-				this->m_remoteAddr[0] = '\0';
+				this->m_localAddr = 0;
+				this->m_remoteAddr = 0;
 
-				if ( onClosed ) onClosed( this, NULL );
+				if ( m_events->onClosed ) m_events->onClosed( this, NULL );
 				_so_changeStatue( SOST_EMPTY );
 			}
 
@@ -675,7 +869,28 @@ namespace Plib
 				else if ( _ret == SOPROC_ERROR ) _so_errorHappen();
 				else {
 					_so_changeStatue( SOST_TIMEOUT );
-					if ( onTimeOut ) onTimeOut( this, (void *)&_length );
+					if ( m_events->onTimeOut ) m_events->onTimeOut( this, (void *)&_length );
+					_so_changeStatue( SOST_IDLE );
+				}
+				return _ret == SOPROC_OK;
+			}
+
+			// Write all the pairs in order by as few calls as possible.
+			// With _more, the last partial segment is held by the kernel
+			// for the next write, where MSG_MORE is supported.
+			INLINE bool WriteV( const SODATAPAIR * _pairs, unsigned _count, bool _more = false )
+			{
+				if ( m_hSo == -1 ) return false;
+				if ( _pairs == NULL || _count == 0 ) return false;
+
+				_so_changeStatue( SOST_WRITING );
+				unsigned _length = 0;
+				SOPROCRET _ret = _T_so.writeDataV( this, _pairs, _count, _length, _more );
+				if ( _ret == SOPROC_OK ) _so_changeStatue( SOST_IDLE );
+				else if ( _ret == SOPROC_ERROR ) _so_errorHappen();
+				else {
+					_so_changeStatue( SOST_TIMEOUT );
+					if ( m_events->onTimeOut ) m_events->onTimeOut( this, (void *)&_length );
 					_so_changeStatue( SOST_IDLE );
 				}
 				return _ret == SOPROC_OK;
@@ -690,7 +905,7 @@ namespace Plib
 				else if ( _ret == SOPROC_ERROR ) _so_errorHappen();
 				else {
 					_so_changeStatue( SOST_TIMEOUT );
-					if ( onTimeOut ) onTimeOut( this, NULL );
+					if ( m_events->onTimeOut ) m_events->onTimeOut( this, NULL );
 					_so_changeStatue( SOST_IDLE );
 				}
 				return _ret == SOPROC_OK;
@@ -700,17 +915,20 @@ namespace Plib
 			{
 				if ( m_bufferString == NULL ) {
 					_so_changeStatue( SOST_IDLE );
-					if ( onBufferWarn ) onBufferWarn( this, NULL );
+					if ( m_events->onBufferWarn ) m_events->onBufferWarn( this, NULL );
 					return false;
 				}
+				// What the reserved space of the string can not take, on
+				// the stack so an idle socket holds no buffer.
+				char _overflow[SOCK_BUF_LENGTH];
 				_so_changeStatue( SOST_READING );
 				SOPROCRET _ret = _T_so.readData( this, m_bufferString, 
-					m_errorMessage, SOCK_BUF_LENGTH, _timeOut );
+					_overflow, SOCK_BUF_LENGTH, _timeOut );
 				if ( _ret == SOPROC_OK ) _so_changeStatue( SOST_IDLE );
 				else if ( _ret == SOPROC_ERROR ) _so_errorHappen();
 				else {
 					_so_changeStatue( SOST_TIMEOUT );
-					if ( onTimeOut ) onTimeOut( this, NULL );
+					if ( m_events->onTimeOut ) m_events->onTimeOut( this, NULL );
 					_so_changeStatue( SOST_IDLE );
 				}
 				return _ret == SOPROC_OK;
@@ -730,14 +948,15 @@ namespace Plib
 			
 			INLINE void Echo( )
 			{
-					//char * _Buffer = new char[SOCK_BUF_LENGTH];
-				Echo( m_errorMessage, SOCK_BUF_LENGTH );
+				char _echoBuf[SOCK_BUF_LENGTH];
+				Echo( _echoBuf, SOCK_BUF_LENGTH );
 			}
 
+			// Mile seconds since the last statue change, on the cached now.
 			INLINE Uint64 GetIdleTime( )
 			{
-				m_timeCalc.Tick( );
-				return m_timeCalc.GetMileSecUsed( );
+				Uint64 _now = Plib::Threading::MonotonicClock::CachedNanoSeconds( );
+				return ( _now > m_lastActive ) ? ( _now - m_lastActive ) / 1000000 : 0;
 			}
 		};
 	}
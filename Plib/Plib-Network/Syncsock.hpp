@@ -5,9 +5,12 @@
 * File Name			: syncsock.hpp
 * Propose  			: 
 * 
-* Current Version	: 1.1
+* Current Version	: 1.4
 * Change Log		: Common Socket Inside Object of IOSocket
 * Change Log v1.1	: Update under Plib-1.1
+* Change Log v1.2	: Read into the attached buffer, sized by the message size.
+* Change Log v1.3	: Gathered write by sendmsg.
+* Change Log v1.4	: No stopwatch kept by the idle socket, wait by poll.
 * Author			: Push Chen
 * Change Date		: 2010-11-17
 * Change Date		: 2011-01-10
@@ -26,6 +29,10 @@
 #include <Plib-Threading/Threading.hpp>
 #endif
 
+#if !_DEF_WIN32
+#include <sys/uio.h>
+#endif
+
 namespace Plib
 {
 	namespace Network
@@ -37,11 +44,14 @@ namespace Plib
 			typedef SocketBasic< internal_common_sock, 256 > _TySo;
 
 		protected:
-			Plib::Threading::StopWatch			calcTime;
-
 			unsigned int					m_writeTimeOut;
 			unsigned int					m_readTimeOut;
 
+			// Bytes to reserve for the next read, follows the size of
+			// the recent messages.
+			unsigned int					m_readHint;
+			enum { READ_MIN_BATCH = 1024, READ_MAX_BATCH = 256 * 1024 };
+
 		protected:
 			// All methods are protected. 
 			// So that no one can invoke these methods outside the 
@@ -54,7 +64,54 @@ namespace Plib
 				// Set default timeout value to 10 seconds.
 				m_readTimeOut = 10000;
 				m_writeTimeOut = 1000;
+				m_readHint = READ_MIN_BATCH;
+			}
+
+			// Grow to a large message at once, shrink slowly.
+			INLINE void __UpdateReadHint( unsigned int _messageSize )
+			{
+				unsigned int _target = READ_MIN_BATCH;
+				while ( _target < _messageSize && _target < READ_MAX_BATCH ) _target <<= 1;
+				if ( _target >= m_readHint ) m_readHint = _target;
+				else m_readHint = ( m_readHint + _target ) / 2;
+			}
+
+#if !_DEF_WIN32
+			// Read all the pending bytes straight into the spare space of
+			// the string. The second iovec takes what the hint missed, and
+			// when both are filled FIONREAD sizes the next read.
+			// Return the bytes read, -1 on error or closed by peer.
+			INLINE int __ReadBatch( _TySo * pSo, Plib::Text::RString * _string,
+				char * _overflow, unsigned int _overflowSize )
+			{
+				int _total = 0;
+				unsigned int _want = m_readHint;
+				for ( ; ; ) {
+					struct iovec _iov[2];
+					_iov[0].iov_base = _string->Reserve( _want );
+					_iov[0].iov_len = _want;
+					_iov[1].iov_base = _overflow;
+					_iov[1].iov_len = _overflowSize;
+					ssize_t _ret = ::readv( pSo->hSo, _iov, 2 );
+					if ( _ret < 0 && errno == EINTR ) continue;
+					if ( _ret <= 0 ) return ( _total > 0 ) ? _total : -1;
+					_total += (int)_ret;
+					if ( (size_t)_ret <= _want ) {
+						_string->Commit( (unsigned int)_ret );
+						return _total;
+					}
+					_string->Commit( _want );
+					_string->Append( _overflow, (unsigned int)( _ret - _want ) );
+					if ( (size_t)_ret < _want + _overflowSize ) return _total;
+					int _pending = 0;
+					if ( PLIB_NETWORK_IOCTL_CALL( pSo->hSo, FIONREAD, &_pending ) != 0 || _pending <= 0 )
+						return _total;
+					_want = ( (unsigned int)_pending > READ_MAX_BATCH ) ? 
+						(unsigned int)READ_MAX_BATCH : (unsigned int)_pending;
+					if ( _want < m_readHint ) _want = m_readHint;
+				}
 			}
+#endif
 
 			INLINE bool SetWriteTimeOut( _TySo * pSo, unsigned int _mileSec )
 			{
@@ -79,7 +136,7 @@ namespace Plib
 			{
 				int _allSent = 0;
 				int _preSent = 0;
-				calcTime.SetStart();
+				Plib::Threading::StopWatch _calcTime;
 				while ( (unsigned int)_allSent < _length )
 				{
 					_preSent = ::send( pSo->hSo, _data + _allSent, 
@@ -88,8 +145,8 @@ namespace Plib
 						return SOPROC_ERROR;
 					}
 					_allSent += _preSent;
-					calcTime.Tick();
-					if ( calcTime.GetMileSecUsed() >= m_writeTimeOut && 
+					_calcTime.Tick();
+					if ( _calcTime.GetMileSecUsed() >= m_writeTimeOut && 
 						((unsigned int)_allSent < _length) ) {
 						_length = _allSent;
 						return SOPROC_TIMEOUT;
@@ -97,6 +154,64 @@ namespace Plib
 				}
 				return SOPROC_OK;
 			}
+
+			// Gathered write, _length is the bytes sent on return.
+			INLINE SOPROCRET writeDataV( _TySo * pSo, const SODATAPAIR * _pairs,
+				unsigned int _count, unsigned int & _length, bool _more )
+			{
+				_length = 0;
+#if _DEF_WIN32
+				for ( unsigned int i = 0; i < _count; ++i ) {
+					unsigned int _sent = _pairs[i].length;
+					SOPROCRET _ret = writeData( pSo, _pairs[i].data, _sent );
+					_length += _sent;
+					if ( _ret != SOPROC_OK ) return _ret;
+				}
+				return SOPROC_OK;
+#else
+				enum { WRITE_MAX_IOV = 64 };
+				struct iovec _iov[WRITE_MAX_IOV];
+				unsigned int _index = 0, _offset = 0;
+				Plib::Threading::StopWatch _calcTime;
+				while ( _index < _count )
+				{
+					unsigned int _iovCount = 0;
+					for ( unsigned int i = _index; i < _count && _iovCount < WRITE_MAX_IOV; ++i ) {
+						unsigned int _skip = ( i == _index ) ? _offset : 0;
+						if ( _pairs[i].length <= _skip ) continue;
+						_iov[_iovCount].iov_base = (void *)( _pairs[i].data + _skip );
+						_iov[_iovCount].iov_len = _pairs[i].length - _skip;
+						++_iovCount;
+					}
+					if ( _iovCount == 0 ) break;
+					struct msghdr _msg;
+					memset( &_msg, 0, sizeof(_msg) );
+					_msg.msg_iov = _iov;
+					_msg.msg_iovlen = _iovCount;
+					// Only the last call of the batch pushes the data out.
+					bool _last = ( _index + _iovCount >= _count );
+					int _flags = PLIB_NETWORK_NOSIGNAL;
+					if ( _more || !_last ) _flags |= PLIB_NETWORK_MSGMORE;
+					ssize_t _sent = ::sendmsg( pSo->hSo, &_msg, _flags );
+					if ( _sent < 0 && errno == EINTR ) continue;
+					if ( _sent < 0 ) return SOPROC_ERROR;
+					_length += (unsigned int)_sent;
+					// Move to the first byte not sent.
+					size_t _left = (size_t)_sent;
+					while ( _index < _count && _left >= _pairs[_index].length - _offset ) {
+						_left -= _pairs[_index].length - _offset;
+						++_index;
+						_offset = 0;
+					}
+					_offset += (unsigned int)_left;
+					_calcTime.Tick();
+					if ( _calcTime.GetMileSecUsed() >= m_writeTimeOut && _index < _count ) {
+						return SOPROC_TIMEOUT;
+					}
+				}
+				return SOPROC_OK;
+#endif
+			}
 			
 			INLINE SOPROCRET readData( _TySo * pSo, 
 				Plib::Text::RString * _string, 
@@ -104,33 +219,29 @@ namespace Plib
 			{
 				if ( pSo->hSo == -1 ) return SOPROC_ERROR;
 
-				struct timeval _tv;
-				fd_set recvFs;
-				FD_ZERO( &recvFs );
-				FD_SET( pSo->hSo, &recvFs );
-
-				calcTime.SetStart();
+				Plib::Threading::StopWatch _calcTime;
 				Uint64 _leftTime = _timeOut;
+				unsigned int _messageSize = 0;
 				do {
-					_tv.tv_sec = (long)_leftTime / 1000;
-					_tv.tv_usec = ((long)_leftTime % 1000) * 1000;
-
 					if ( pSo->hSo == -1 ) return SOPROC_ERROR;
-					FD_ZERO( &recvFs );
-					FD_SET( pSo->hSo, &recvFs );
-
-					int _retCode = ::select( pSo->hSo + 1, &recvFs, NULL, NULL, &_tv );
+					int _retCode = WaitSocket( pSo->hSo, true, (unsigned int)_leftTime );
 					if ( _retCode < 0 )		// Error
 						return SOPROC_ERROR;
 					if ( _retCode == 0 )	// TimeOut
 						return SOPROC_TIMEOUT;
 					
+#if _DEF_WIN32
 					_retCode = ::recv( pSo->hSo, _buffer, _bufSize, 0 );
-					if ( _retCode < 0 ) return SOPROC_ERROR;
-
+					if ( _retCode <= 0 ) return SOPROC_ERROR;
 					_string->Append( _buffer, _retCode );
+#else
+					_retCode = __ReadBatch( pSo, _string, _buffer, _bufSize );
+					if ( _retCode < 0 ) return SOPROC_ERROR;
+#endif
+					_messageSize += _retCode;
 
-					// Parse the recived data.
+					// Parse the recived data, once for all the bytes read
+					// on this wake up.
 					if ( pSo->onBufferUpdate ) {
 						SOCKEVENTSTATUE _ret = pSo->onBufferUpdate( pSo, _string );
 						if ( _ret == SOEVENT_ILLEAGE ) return SOPROC_ERROR;
@@ -139,11 +250,12 @@ namespace Plib
 					}
 					else break;
 
-					calcTime.Tick();
-					if ( calcTime.GetMileSecUsed() >= _timeOut ) return SOPROC_TIMEOUT;
-					_leftTime = _timeOut - calcTime.GetMileSecUsed();
+					_calcTime.Tick();
+					if ( _calcTime.GetMileSecUsed() >= _timeOut ) return SOPROC_TIMEOUT;
+					_leftTime = _timeOut - _calcTime.GetMileSecUsed();
 				} while ( true );
 
+				__UpdateReadHint( _messageSize );
 				return SOPROC_OK;				
 			}
 
@@ -152,11 +264,6 @@ namespace Plib
 			{
 				if ( pSo->hSo == -1 ) return SOPROC_ERROR;
 
-				struct timeval _tv;
-				fd_set recvFs;
-				FD_ZERO( &recvFs );
-				FD_SET( pSo->hSo, &recvFs );
-
 				unsigned int _RecvSize = 0;
 				unsigned int _AllBufSize = _bufSize;
 
@@ -164,17 +271,11 @@ namespace Plib
 				dp.data = _outBuf;
 				dp.length = 0;
 
-				calcTime.SetStart();
+				Plib::Threading::StopWatch _calcTime;
 				Uint64 _leftTime = _timeOut;
 				do {
-					_tv.tv_sec = (long)_leftTime / 1000;
-					_tv.tv_usec = ((long)_leftTime % 1000) * 1000;
-
 					if ( pSo->hSo == -1 ) return SOPROC_ERROR;
-					FD_ZERO( &recvFs );
-					FD_SET( pSo->hSo, &recvFs );
-
-					int _retCode = ::select( pSo->hSo + 1, &recvFs, NULL, NULL, &_tv );
+					int _retCode = WaitSocket( pSo->hSo, true, (unsigned int)_leftTime );
 					if ( _retCode < 0 )		// Error
 						return SOPROC_ERROR;
 					if ( _retCode == 0 )	// TimeOut
@@ -194,9 +295,9 @@ namespace Plib
 					}
 					else break;
 
-					calcTime.Tick();
-					if ( calcTime.GetMileSecUsed() >= _timeOut ) return SOPROC_TIMEOUT;
-					_leftTime = _timeOut - calcTime.GetMileSecUsed();
+					_calcTime.Tick();
+					if ( _calcTime.GetMileSecUsed() >= _timeOut ) return SOPROC_TIMEOUT;
+					_leftTime = _timeOut - _calcTime.GetMileSecUsed();
 				} while ( true );
 
 				_bufSize = _RecvSize;
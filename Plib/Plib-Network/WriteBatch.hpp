@@ -0,0 +1,202 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: WriteBatch.hpp
+* Propose  			: Coalesce the responses of one dispatch into few writes.
+*
+* Current Version	: 1.3
+* Change Log		: First Definition.
+* Change Log		: 1.1: Count only the writes that succeed.
+* Change Log		: 1.2: Flush or discard the batch before the connection is closed.
+* Change Log		: 1.3: Push the held responses before a slow one, not only after it.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_NETWORK_WRITEBATCH_HPP_
+#define _PLIB_NETWORK_WRITEBATCH_HPP_
+
+#if _DEF_IOS
+#include "Socketbasic.hpp"
+#include "Stopwatch.hpp"
+#else
+#include <Plib-Network/Socketbasic.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#endif
+
+#include <string>
+
+namespace Plib
+{
+	namespace Network
+	{
+		/*
+		 * Output of one connection during one worker dispatch.
+		 * The small responses are copied into the batch, a large one is
+		 * sent with the batch in front of it without a copy. Every write
+		 * but the last one of the dispatch goes with MSG_MORE (or the
+		 * socket is corked where MSG_MORE is missing), so the kernel only
+		 * sends full segments until the last response, which pushes all.
+		 * Nothing waits for a timer like Nagle does.
+		 *
+		 * The batch is written before the last response when it is larger
+		 * than the flush bytes, and pushed when the first response held
+		 * has waited longer than the flush delay, or the responses come
+		 * slower than it.
+		 * A held response waits for the next Add. Before building the next
+		 * response the caller tells Hold how long that is expected to take,
+		 * the held ones are pushed first when they would wait past the
+		 * delay. So the delay is kept as long as the expectation is: one
+		 * response much slower than the one before still holds the others.
+		 */
+		template < typename _TySock >
+		class WriteBatch
+		{
+		public:
+			// Larger response is not copied.
+			enum { DIRECT_BYTES = 16 * 1024 };
+
+		protected:
+			_TySock *							m_Sock;
+			std::string							m_Batch;
+			Uint32								m_FlushBytes;
+			Uint32								m_FlushDelay;	// us
+			Plib::Threading::StopWatch			m_Age;			// of the first byte in batch
+			Plib::Threading::StopWatch			m_Gap;			// since the last response
+			bool								m_Started;
+			bool								m_Corked;
+			bool								m_Pending;		// written with MSG_MORE, not pushed
+			Uint32								m_Writes;
+			Uint64								m_Bytes;
+
+		public:
+			WriteBatch( _TySock * _sock, Uint32 _flushBytes = 64 * 1024, Uint32 _flushDelay = 200 )
+				: m_Sock( _sock ), m_FlushBytes( _flushBytes ), m_FlushDelay( _flushDelay ),
+				m_Age( false ), m_Gap( false ), m_Started( false ), m_Corked( false ),
+				m_Pending( false ), m_Writes( 0 ), m_Bytes( 0 )
+			{
+				CONSTRUCTURE;
+			}
+			~WriteBatch( )
+			{
+				DESTRUCTURE;
+				if ( m_Corked ) m_Sock->SetCork( false );
+			}
+
+			// Add one response, _more tells if another response of the
+			// dispatch will follow. The data is copied or sent on return.
+			INLINE bool Add( const char * _data, Uint32 _length, bool _more )
+			{
+				if ( !_more ) return __Flush( _data, _length, false );
+				if ( !__Holding( ) ) m_Age.SetStart( );
+				if ( _length >= DIRECT_BYTES ) return __Flush( _data, _length, true );
+
+				bool _slow = false;
+				if ( m_Started ) {
+					m_Gap.Tick( );
+					_slow = ( m_Gap.GetMicroSecUsed( ) >= m_FlushDelay );
+				}
+				m_Started = true;
+				m_Gap.SetStart( );
+
+				m_Batch.append( _data, _length );
+				if ( _slow ) return __Flush( NULL, 0, false );
+				m_Age.Tick( );
+				if ( m_Age.GetMicroSecUsed( ) >= m_FlushDelay ) return __Flush( NULL, 0, false );
+				if ( m_Batch.size( ) >= m_FlushBytes ) return __Flush( NULL, 0, true );
+				return true;
+			}
+
+			// Before building the next response, expected to take _expect
+			// microseconds: push the held ones if they would wait past
+			// the flush delay.
+			INLINE bool Hold( Uint64 _expect )
+			{
+				if ( !__Holding( ) ) return true;
+				m_Age.Tick( );
+				if ( m_Age.GetMicroSecUsed( ) + _expect < m_FlushDelay ) return true;
+				return __Flush( NULL, 0, false );
+			}
+
+			// Send the batch now and uncork, before closing the connection.
+			INLINE bool Flush( ) { return __Flush( NULL, 0, false ); }
+
+			// Forget the batch and the cork, the connection is closed
+			// without it.
+			INLINE void Discard( )
+			{
+				m_Batch.clear( );
+				m_Corked = false;
+				m_Pending = false;
+			}
+
+			// Calls to write the batch, and the bytes written.
+			INLINE Uint32 Writes( ) const { return m_Writes; }
+			INLINE Uint64 Bytes( ) const { return m_Bytes; }
+
+		protected:
+			INLINE bool __Holding( ) const { return m_Pending || !m_Batch.empty( ); }
+
+			INLINE bool __Flush( const char * _data, Uint32 _length, bool _more )
+			{
+				SODATAPAIR _pairs[2];
+				unsigned _count = 0;
+				if ( !m_Batch.empty( ) ) {
+					_pairs[_count].data = m_Batch.c_str( );
+					_pairs[_count].length = (unsigned)m_Batch.size( );
+					++_count;
+				}
+				if ( _length > 0 ) {
+					_pairs[_count].data = _data;
+					_pairs[_count].length = _length;
+					++_count;
+				}
+				if ( _count == 0 ) return __Uncork( );
+
+				if ( _more && PLIB_NETWORK_MSGMORE == 0 && !m_Corked ) {
+					m_Corked = m_Sock->SetCork( true );
+				}
+				bool _written = m_Sock->WriteV( _pairs, _count, _more );
+				Uint64 _bytes = m_Batch.size( ) + _length;
+				m_Batch.clear( );
+				if ( !_written ) return false;
+				++m_Writes;
+				m_Bytes += _bytes;
+				if ( _more ) {
+					m_Pending = true;
+					return true;
+				}
+				m_Pending = false;
+				return __Uncork( );
+			}
+
+			INLINE bool __Uncork( )
+			{
+				bool _pushed = true;
+				if ( m_Corked ) _pushed = m_Sock->SetCork( false );
+				// Uncorking also pushes the segment MSG_MORE left, a socket
+				// without cork has none.
+				else if ( m_Pending ) m_Sock->SetCork( false );
+				m_Corked = false;
+				m_Pending = false;
+				return _pushed;
+			}
+
+		private:
+			WriteBatch( const WriteBatch & );
+			WriteBatch & operator = ( const WriteBatch & );
+		};
+	}
+}
+
+#endif // plib.network.writebatch.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
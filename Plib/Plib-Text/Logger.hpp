@@ -19,10 +19,12 @@
 #include "Common.hpp"
 #include "File.hpp"
 #include "Threading.hpp"
+#include "Profile.hpp"
 #else
 #include <Plib-Text/Common.hpp>
 #include <Plib-Text/File.hpp>
 #include <Plib-Threading/Threading.hpp>
+#include <Plib-Utility/Profile.hpp>
 #endif
 
 namespace Plib
@@ -258,6 +260,7 @@ namespace Plib
 			// The working timer delegate to flush the log data to the file.
 			void __FlushLogData( ) 
 			{
+				PLIB_PROFILE_ZONE( "Logger::FlushLogData" );
 				// Switch the buffer.
 				__LogLocker.Lock( );
 				if ( __Buffer.Size() == 0 ) {
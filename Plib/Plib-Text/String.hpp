@@ -5,8 +5,10 @@
 * File Name			: string.hpp
 * Propose  			: Reference String Definition.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.3
 * Change Log		: for 1.1, I found several bugs in the constructures.
+* Change Log		: 1.2: Reserve and Commit, write into the buffer without copy.
+* Change Log		: 1.3: Shrink the buffer of an empty string.
 * Change Log		: First Definition.
 * Author			: Push Chen
 * Change Date		: 2011-01-09
@@ -224,6 +226,39 @@ namespace Plib
 				if ( SB._Length == 0 ) return;
 				Append( SB._Buffer, SB._Length );
 			}
+			
+			// Get at least _Size characters of spare space after the data.
+			// The invoker writes into it and then Commit the written count,
+			// so a socket can read into the string without a copy.
+			INLINE CharType * Reserve( Size_T _Size ) {
+				assert( _Size != 0 );
+				PLIB_THREAD_SAFE;
+				_CheckAndRealloc( _Size );
+				return _Buffer + _Length;
+			}
+			
+			// Append the _Size characters written after Reserve.
+			INLINE void Commit( Size_T _Size ) {
+				PLIB_THREAD_SAFE;
+				assert( _Length + _Size <= _BufferSize );
+				_Length += _Size;
+				_Buffer[_Length] = _Basic_C::EOL;
+			}
+
+			// Give back the buffer of an empty string larger than _Keep
+			// characters. A string kept long but filled now and then,
+			// like the read buffer of an idle connection, holds nothing.
+			INLINE void Shrink( Size_T _Keep = Captial ) {
+				PLIB_THREAD_SAFE;
+				if ( _Length != 0 ) return;
+				Size_T _NewSize = _FORMAT_LENGTH( _Keep, Captial );
+				if ( _BufferSize <= _NewSize ) return;
+				PCREALLOC( CharType, _Buffer, _Tmp, (_NewSize + 1) * sizeof(CharType) );
+				if ( _Tmp == NULL ) return;
+				_Buffer = _Tmp;
+				_BufferSize = _NewSize;
+				_Buffer[0] = _Basic_C::EOL;
+			}
 
 			// Insert some words to specified position of the string.
 			INLINE void Insert( const CharType * _Data, Size_T _DLength, Size_T _Pos) {
@@ -715,6 +750,18 @@ namespace Plib
 			INLINE void Append( const _StringBasic< _Basic_C > & _string ) {
 				return TFather::_Handle->_PHandle->Append( _string );
 			}
+			// Spare space to write after the data, see Commit.
+			INLINE CharType * Reserve( Size_T _size ) {
+				return TFather::_Handle->_PHandle->Reserve( _size );
+			}
+			// Append the characters written into the reserved space.
+			INLINE void Commit( Size_T _size ) {
+				TFather::_Handle->_PHandle->Commit( _size );
+			}
+			// Give back the buffer when empty, see Shrink of the basic.
+			INLINE void Shrink( Size_T _keep = _StringBasic< _Basic_C >::Captial ) {
+				TFather::_Handle->_PHandle->Shrink( _keep );
+			}
 			
 			// Insert a non-terminal string.
 			INLINE void Insert( const CharType * _data, Size_T _pos ) {
@@ -5,8 +5,11 @@
 * File Name			: locker.hpp
 * Propose  			: Redefinition the mutex object.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.4
 * Change Log		: First Definition.
+* Change Log		: 1.2: Futex based Mutex on Linux, with adaptive spinning.
+* Change Log		: 1.3: Striped ResLock, add TicketLocker.
+* Change Log		: 1.4: ResLock stripe is reentrant for its owner thread.
 * Author			: Push Chen
 * Change Date		: 2011-01-10
 */
@@ -19,8 +22,10 @@
 
 #if _DEF_IOS
 #include "Pool.hpp"
+#include "Atomic.hpp"
 #else
 #include <Plib-Generic/Pool.hpp>
+#include <Plib-Basic/Atomic.hpp>
 #endif
 #include <map>
 
@@ -30,6 +35,9 @@ namespace Plib
 	{
 #if _DEF_WIN32
 		typedef ::CRITICAL_SECTION	MutexHandleT;
+#elif PLIB_HAS_FUTEX
+		// 0: unlocked, 1: locked, 2: locked and may have waiters.
+		typedef volatile Int32		MutexHandleT;
 #else
 		typedef pthread_mutex_t		MutexHandleT;
 #endif
@@ -42,6 +50,46 @@ namespace Plib
 		protected:
 			friend class Semaphore;
 			MutexHandleT m_Mutex;
+	#if PLIB_HAS_FUTEX
+			// Average spin rounds of the previous contended locks.
+			volatile Int32 m_Spins;
+
+			enum { MUTEX_SPIN_MAX = 100 };
+
+			// Spinning only helps when the owner runs on another cpu.
+			static INLINE Int32 __SpinLimit( )
+			{
+				static Int32 _limit = (::sysconf( _SC_NPROCESSORS_ONLN ) > 1) ? MUTEX_SPIN_MAX : 0;
+				return _limit;
+			}
+
+			// Spin a while, the spin count follows the average of the
+			// previous locks. Then mark the lock contended and sleep.
+			INLINE void __LockSlow( )
+			{
+				Int32 _spins = Plib::Basic::AtomicLoad( &m_Spins, Plib::Basic::AO_RELAXED );
+				Int32 _max = _spins * 2 + 10;
+				if ( _max > __SpinLimit( ) ) _max = __SpinLimit( );
+				for ( Int32 _count = 0; _count < _max; ++_count ) {
+					Plib::Basic::CpuRelax( );
+					Int32 _state = 0;
+					if ( Plib::Basic::AtomicLoad( &m_Mutex, Plib::Basic::AO_RELAXED ) == 0 &&
+						Plib::Basic::AtomicCompareExchange( &m_Mutex, _state, (Int32)1,
+							Plib::Basic::AO_ACQUIRE ) )
+					{
+						Plib::Basic::AtomicStore( &m_Spins, _spins + (_count - _spins) / 8,
+							Plib::Basic::AO_RELAXED );
+						return;
+					}
+				}
+				if ( _max > 0 ) {
+					Plib::Basic::AtomicStore( &m_Spins, _spins + (_max - _spins) / 8,
+						Plib::Basic::AO_RELAXED );
+				}
+				while ( Plib::Basic::AtomicExchange( &m_Mutex, (Int32)2, Plib::Basic::AO_ACQUIRE ) != 0 )
+					Plib::Basic::FutexWait( &m_Mutex, 2 );
+			}
+	#endif
 		public:
 			// Create a mutex
 			Mutex( ) {
@@ -52,6 +100,9 @@ namespace Plib
 		#else
 				::InitializeCriticalSection( &m_Mutex );
 		#endif
+	#elif PLIB_HAS_FUTEX
+				m_Mutex = 0;
+				m_Spins = 0;
 	#else
 				pthread_mutex_init(&m_Mutex, NULL);
 	#endif
@@ -59,6 +110,7 @@ namespace Plib
 			~Mutex(){
 	#if defined WIN32 || defined _WIN32
 				::DeleteCriticalSection( &m_Mutex );
+	#elif PLIB_HAS_FUTEX
 	#else
 				pthread_mutex_destroy(&m_Mutex);
 	#endif
@@ -69,6 +121,11 @@ namespace Plib
 			{
 	#if _DEF_WIN32
 				::EnterCriticalSection( &m_Mutex );
+	#elif PLIB_HAS_FUTEX
+				// Uncontended lock is one CAS.
+				Int32 _state = 0;
+				if ( !Plib::Basic::AtomicCompareExchange( &m_Mutex, _state, (Int32)1,
+					Plib::Basic::AO_ACQUIRE ) ) __LockSlow( );
 	#else 
 				pthread_mutex_lock(&m_Mutex);
 	#endif
@@ -79,6 +136,10 @@ namespace Plib
 			{
 	#if _DEF_WIN32
 				::LeaveCriticalSection( &m_Mutex );
+	#elif PLIB_HAS_FUTEX
+				// Only enter the kernel when someone may be sleeping.
+				if ( Plib::Basic::AtomicExchange( &m_Mutex, (Int32)0, Plib::Basic::AO_RELEASE ) == 2 )
+					Plib::Basic::FutexWake( &m_Mutex, 1 );
 	#else
 				pthread_mutex_unlock(&m_Mutex);
 	#endif
@@ -92,8 +153,12 @@ namespace Plib
 		#else
 				return false;
 		#endif
+	#elif PLIB_HAS_FUTEX
+				Int32 _state = 0;
+				return Plib::Basic::AtomicCompareExchange( &m_Mutex, _state, (Int32)1,
+					Plib::Basic::AO_ACQUIRE );
 	#else
-				return pthread_mutex_trylock(&m_Mutex) != 0;
+				return pthread_mutex_trylock(&m_Mutex) == 0;
 	#endif
 			}
 		};
@@ -225,62 +290,184 @@ namespace Plib
 			~WriteLocker( ) { m_locker.UnLock( ); }
 		};
 		
+		// Fair lock, the threads get the lock in the order they come.
+		// Spin a little while the owner is running, then sleep.
+		class TicketLocker
+		{
+		protected:
+			volatile Int32		m_Next;
+			volatile Int32		m_Serving;
+			volatile Int32		m_Waiters;
+
+			enum { TICKET_SPIN_COUNT = 64 };
+
+		private:
+			TicketLocker( const TicketLocker & );
+			TicketLocker & operator = ( const TicketLocker & );
+
+		public:
+			TicketLocker( ) : m_Next( 0 ), m_Serving( 0 ), m_Waiters( 0 ) { }
+
+			INLINE void Lock( )
+			{
+				Int32 _ticket = Plib::Basic::AtomicFetchAdd( &m_Next, (Int32)1 );
+				Int32 _serving = Plib::Basic::AtomicLoad( &m_Serving, Plib::Basic::AO_ACQUIRE );
+				if ( _serving == _ticket ) return;
+				for ( Int32 i = 0; i < TICKET_SPIN_COUNT; ++i ) {
+					Plib::Basic::CpuRelax( );
+					if ( Plib::Basic::AtomicLoad( &m_Serving, Plib::Basic::AO_ACQUIRE ) == _ticket )
+						return;
+				}
+				Plib::Basic::AtomicFetchAdd( &m_Waiters, (Int32)1 );
+				while ( (_serving = Plib::Basic::AtomicLoad( &m_Serving )) != _ticket )
+					Plib::Basic::FutexWait( &m_Serving, _serving );
+				Plib::Basic::AtomicFetchSub( &m_Waiters, (Int32)1 );
+			}
+
+			INLINE bool TryLock( )
+			{
+				Int32 _serving = Plib::Basic::AtomicLoad( &m_Serving, Plib::Basic::AO_ACQUIRE );
+				return Plib::Basic::AtomicCompareExchange( &m_Next, _serving, _serving + 1 );
+			}
+
+			INLINE void UnLock( )
+			{
+				Plib::Basic::AtomicFetchAdd( &m_Serving, (Int32)1 );
+				// The next owner may not be the one we wake, wake all.
+				if ( Plib::Basic::AtomicLoad( &m_Waiters ) > 0 )
+					Plib::Basic::FutexWake( &m_Serving, 0x7FFFFFFF );
+			}
+		};
+
+		// Hash of the resource identify used by ResLock.
+		// The default one hashes the bytes of the object, specialize it
+		// for the types own memory outside, like std::string.
+		template < typename _TyIdentify >
+		struct ResLockHash
+		{
+			INLINE Uint32 operator () ( const _TyIdentify & _Id ) const
+			{
+				return __Mix( (const unsigned char *)&_Id, sizeof(_TyIdentify) );
+			}
+			// FNV-1a with a final avalanche, so near keys go to far stripes.
+			static INLINE Uint32 __Mix( const unsigned char * _data, Uint32 _length )
+			{
+				Uint32 _hash = 2166136261U;
+				for ( Uint32 i = 0; i < _length; ++i ) {
+					_hash ^= _data[i];
+					_hash *= 16777619U;
+				}
+				_hash ^= _hash >> 16;
+				_hash *= 0x85EBCA6BU;
+				_hash ^= _hash >> 13;
+				return _hash;
+			}
+		};
+		template < >
+		struct ResLockHash< std::string >
+		{
+			INLINE Uint32 operator () ( const std::string & _Id ) const
+			{
+				return ResLockHash< char >::__Mix(
+					(const unsigned char *)_Id.c_str( ), (Uint32)_Id.size( ) );
+			}
+		};
+
 		// Multi-Lock
 		// To lock a many to many accessing.
-		// When you have lots of threads and lots of resources, 
+		// When you have lots of threads and lots of resources,
 		// each thread will access one resource at a time.
-		// Only when two or more thread try to access the same
-		// resource, the resource object must be locked, otherwise,
-		// the accessing is lock-free.
-		template < typename _TyIdentify, typename _TyLocker = Mutex >
+		// The identify is hashed to one of _Stripes lockers, only the
+		// resources in the same stripe block each other. The memory is
+		// fixed whatever the count of the resources, and no global lock
+		// is taken. Use TicketLocker as _TyLocker to get the lock of one
+		// resource in the order of request.
+		// A thread may hold several resources at a time, the stripe is
+		// reentrant for the thread owning it, so two resources of the same
+		// stripe do not deadlock their owner. Locking the same resource
+		// twice in one thread does not block either, unlock it as many
+		// times. Resources of different stripes held together must be
+		// locked in the order of StripeOf, as two threads taking two
+		// stripes in reverse order deadlock even if the resources differ.
+		// _Stripes must be power of 2.
+		template < typename _TyIdentify, typename _TyLocker = Mutex,
+			typename _TyHash = ResLockHash< _TyIdentify >, Uint32 _Stripes = 256 >
 		class ResLock
 		{
 		protected:
-			typedef Plib::Generic::RPool< _TyLocker > 			LockPoolT;
-			typedef Plib::Generic::Pair< Uint32, _TyLocker * >	RefLockT;
-			typedef std::map< _TyIdentify, _TyLocker * >		IdMapT;
-			
-			IdMapT									m_IdentifyMap;
-			LockPoolT								m_LockerPool;
-			_TyLocker								m_Locker;
-			
+			struct __Slot {
+				_TyLocker							Locker;
+				// Only the owner writes its own id here, so another
+				// thread never reads its id by mistake.
+				volatile Uint64						Owner;
+				Uint32								Depth;
+				__Slot( ) : Owner( 0 ), Depth( 0 ) { }
+			};
+			struct __Stripe : public __Slot {
+				PLIB_CACHELINE_PAD( Pad, __Slot );
+			};
+
+			__Stripe								m_Stripes[_Stripes];
+			_TyHash									m_Hash;
+
+			// Address of a thread local, unique for each living thread.
+			static INLINE Uint64 __Self( )
+			{
+				static PLIB_THREAD_LOCAL char _tag = 0;
+				return (Uint64)(size_t)&_tag;
+			}
+
+			INLINE __Stripe & __StripeOf( const _TyIdentify & _Id )
+			{
+				return m_Stripes[StripeOf( _Id )];
+			}
+
 		public:
-			
+
 			INLINE void Lock( const _TyIdentify & _Id )
 			{
-				//LockerT< _TyLocker > _L( m_Locker );
-				m_Locker.Lock( );
-				typename IdMapT::iterator idmIt = m_IdentifyMap.find( _Id );
-				if ( idmIt == m_IdentifyMap.end() ) {
-					_TyLocker & _theLock = m_LockerPool.Get( );
-					_theLock.Lock();
-					m_IdentifyMap[ _Id ] = RefLockT( 1, &_theLock );
-					m_Locker.UnLock( );
+				__Stripe & _stripe = __StripeOf( _Id );
+				Uint64 _self = __Self( );
+				if ( Plib::Basic::AtomicLoad( &_stripe.Owner, Plib::Basic::AO_RELAXED ) == _self ) {
+					++_stripe.Depth;
 					return;
-				} else {
-					SELF_INCREASE( idmIt->second.first );
-					m_Locker.UnLock();
 				}
-				
-				idmIt->second.second->Lock();
+				_stripe.Locker.Lock( );
+				Plib::Basic::AtomicStore( &_stripe.Owner, _self, Plib::Basic::AO_RELAXED );
+				_stripe.Depth = 1;
 			}
-			
-			INLINE void UnLock( const _TyIdentify & _Id )
+
+			INLINE bool TryLock( const _TyIdentify & _Id )
 			{
-				m_Locker.Lock( );
-				typename IdMapT::iterator idmIt = m_IdentifyMap.find( _Id );
-				if ( idmIt != m_IdentifyMap.end() )
-				{
-					SELF_DECREASE( idmIt->second.first );
-					idmIt->second.second->UnLock();
-					
-					if ( idmIt->second.first == 0 ) {
-						m_LockerPool.Return( *idmIt->second.second );
-						m_IdentifyMap.erase( idmIt );
-					}
+				__Stripe & _stripe = __StripeOf( _Id );
+				Uint64 _self = __Self( );
+				if ( Plib::Basic::AtomicLoad( &_stripe.Owner, Plib::Basic::AO_RELAXED ) == _self ) {
+					++_stripe.Depth;
+					return true;
 				}
-				m_Locker.UnLock( );
+				if ( !_stripe.Locker.TryLock( ) ) return false;
+				Plib::Basic::AtomicStore( &_stripe.Owner, _self, Plib::Basic::AO_RELAXED );
+				_stripe.Depth = 1;
+				return true;
 			}
+
+			INLINE void UnLock( const _TyIdentify & _Id )
+			{
+				__Stripe & _stripe = __StripeOf( _Id );
+				if ( --_stripe.Depth != 0 ) return;
+				Plib::Basic::AtomicStore( &_stripe.Owner, (Uint64)0, Plib::Basic::AO_RELAXED );
+				_stripe.Locker.UnLock( );
+			}
+
+			// Index of the stripe of the resource, lock the resources
+			// held together in ascending order of it.
+			INLINE Uint32 StripeOf( const _TyIdentify & _Id ) const
+			{
+				return (Uint32)( m_Hash( _Id ) & (_Stripes - 1) );
+			}
+
+			// Count of the locker objects, not the resources.
+			static INLINE Uint32 StripeCount( ) { return _Stripes; }
 		};
 	}
 }
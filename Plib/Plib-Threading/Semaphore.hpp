@@ -5,8 +5,9 @@
 * File Name			: semaphore.hpp
 * Propose  			: Redefinition the semaphore object.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.2
 * Change Log		: Re-Definition.
+* Change Log		: 1.2: Futex based semaphore on Linux, atomic count and monotonic timeout.
 * Author			: Push Chen
 * Change Date		: 2011-01-10
 */
@@ -28,6 +29,9 @@ namespace Plib
 	{
 	#if _DEF_WIN32
 		typedef void *			SemHandleT;
+	#elif PLIB_HAS_FUTEX
+		// Not used, the count itself is the futex word.
+		typedef volatile Int32	SemHandleT;
 	#else
 		typedef pthread_cond_t  SemHandleT;
 	#endif
@@ -45,18 +49,42 @@ namespace Plib
 			volatile Int32		m_Current;
 			volatile bool		m_Available;
 
+	#if PLIB_HAS_FUTEX
+			// Count of the threads blocked in Get.
+			volatile Int32		m_Waiters;
+
+			// Take one if the count is not zero.
+			INLINE bool __TryGet( )
+			{
+				Int32 _count = Plib::Basic::AtomicLoad( &m_Current, Plib::Basic::AO_RELAXED );
+				while ( _count > 0 ) {
+					if ( Plib::Basic::AtomicCompareExchange( &m_Current, _count, _count - 1,
+						Plib::Basic::AO_ACQUIRE ) ) return true;
+				}
+				return false;
+			}
+	#else
 			// Mutex to lock the m_Current.
 			Mutex				m_Mutex;
-	#if !(_DEF_WIN32)
+	#endif
+	#if !(_DEF_WIN32) && !(PLIB_HAS_FUTEX)
 			// Cond Mutex.
 			pthread_condattr_t m_CondAttr;
 	#endif
 
 		public:
 			// Constructor
-			Semaphore() : m_Max(0), m_Current(0), m_Available(false) { }
+			Semaphore() : m_Max(0), m_Current(0), m_Available(false)
+	#if PLIB_HAS_FUTEX
+				, m_Waiters(0)
+	#endif
+			{ }
 			Semaphore( unsigned int nInit, unsigned int nMax = MAXCOUNT )
-				: m_Max(0), m_Current(0), m_Available(false) {
+				: m_Max(0), m_Current(0), m_Available(false)
+	#if PLIB_HAS_FUTEX
+				, m_Waiters(0)
+	#endif
+			{
 					this->Init(nInit, nMax);
 			}
 			~Semaphore()
@@ -65,14 +93,40 @@ namespace Plib
 			}
 			// Return current count of the semaphore
 			INLINE Uint32 Count() {
+	#if PLIB_HAS_FUTEX
+				return (Uint32)Plib::Basic::AtomicLoad( &m_Current, Plib::Basic::AO_RELAXED );
+	#else
 				Locker _Lock( m_Mutex );
 				return m_Current;
+	#endif
 			}
 			// Get the semaphore with specified timeout
 			INLINE bool Get( Uint32 nTimeOut = MAXTIMEOUT ){
 				if (!Statue()) return false;
 	#if defined WIN32 || defined _WIN32
 				if (::WaitForSingleObject(m_Sem, nTimeOut) != 0 ) return false;
+	#elif PLIB_HAS_FUTEX
+				// Fast path, no lock and no system call.
+				if ( __TryGet( ) ) return true;
+				if ( nTimeOut == 0 ) return false;
+				Uint64 _deadline = (nTimeOut == MAXTIMEOUT) ? (Uint64)-1 :
+					Plib::Basic::MonotonicMicroSeconds( ) + (Uint64)nTimeOut * 1000;
+				bool _got = false;
+				Plib::Basic::AtomicFetchAdd( &m_Waiters, (Int32)1 );
+				for ( ; ; ) {
+					if ( __TryGet( ) ) { _got = true; break; }
+					if ( !Statue() ) break;
+					Uint64 _left = (Uint64)-1;
+					if ( _deadline != (Uint64)-1 ) {
+						Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+						if ( _now >= _deadline ) break;
+						_left = _deadline - _now;
+					}
+					// Sleep only while the count is still zero.
+					Plib::Basic::FutexWait( &m_Current, 0, _left );
+				}
+				Plib::Basic::AtomicFetchSub( &m_Waiters, (Int32)1 );
+				return _got;
 	#else
 				Locker _Locker( m_Mutex );
 				if ( m_Current > 0 ) 
@@ -122,6 +176,16 @@ namespace Plib
 			// Release a semaphore
 			INLINE bool Release(){
 				if ( !Statue() ) return false;
+	#if PLIB_HAS_FUTEX
+				Int32 _count = Plib::Basic::AtomicLoad( &m_Current, Plib::Basic::AO_RELAXED );
+				// Seq cst CAS, pair with the waiter count increase in Get.
+				do {
+					if ( _count >= this->m_Max ) return false;
+				} while ( !Plib::Basic::AtomicCompareExchange( &m_Current, _count, _count + 1 ) );
+				if ( Plib::Basic::AtomicLoad( &m_Waiters ) > 0 )
+					Plib::Basic::FutexWake( &m_Current, 1 );
+				return true;
+	#else
 				Locker _Lock( m_Mutex );
 				if ( m_Current == this->m_Max ) {
 					return false;
@@ -134,6 +198,7 @@ namespace Plib
 				pthread_cond_signal(&m_Sem);
 	#endif
 				return true;
+	#endif
 			}
 
 			// Init the semaphore.
@@ -142,6 +207,8 @@ namespace Plib
 				Destroy();
 	#if _DEF_WIN32
 				m_Sem = ::CreateSemaphore(NULL, nInit, nMax, NULL);
+	#elif PLIB_HAS_FUTEX
+				m_Waiters = 0;
 	#else
 				pthread_condattr_init(&m_CondAttr);
 				pthread_cond_init(&m_Sem, &m_CondAttr);
@@ -156,26 +223,42 @@ namespace Plib
 				if ( !this->Statue() ) return;
 	#if _DEF_WIN32
 				::CloseHandle(m_Sem);
+				TrySetStatue(false);
+	#elif PLIB_HAS_FUTEX
+				// Wake all the waiters and wait for them to leave.
+				TrySetStatue(false);
+				while ( Plib::Basic::AtomicLoad( &m_Waiters ) > 0 ) {
+					Plib::Basic::FutexWake( &m_Current, 0x7FFFFFFF );
+					Plib::Basic::ThreadYield( );
+				}
 	#else
 				//sem_destroy(&m_Sem);
 				pthread_condattr_destroy(&m_CondAttr);
 				pthread_cond_destroy(&m_Sem);
-	#endif
 				TrySetStatue(false);
+	#endif
 				this->m_Current = 0;
 			}
 
 			INLINE bool Statue()
 			{
+	#if PLIB_HAS_FUTEX
+				return Plib::Basic::AtomicLoad( &m_Available, Plib::Basic::AO_ACQUIRE );
+	#else
 				Locker _Lock( m_Mutex );
 				return m_Available;
+	#endif
 			}
 
 			INLINE void TrySetStatue(bool _statue)
 			{
+	#if PLIB_HAS_FUTEX
+				Plib::Basic::AtomicStore( &m_Available, _statue );
+	#else
 				Locker _Lock( m_Mutex );
 				if ( m_Available == _statue ) return;
 				m_Available = _statue;
+	#endif
 			}
 		};
 	}
@@ -0,0 +1,221 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: SeqLock.hpp
+* Propose  			: Sequence lock and per-cpu reader lock for read mostly data.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_THREADING_SEQLOCK_HPP_
+#define _PLIB_THREADING_SEQLOCK_HPP_
+
+#if _DEF_IOS
+#include "Atomic.hpp"
+#else
+#include <Plib-Basic/Atomic.hpp>
+#endif
+
+#if _DEF_LINUX
+#include <sched.h>
+#endif
+
+namespace Plib
+{
+	namespace Threading
+	{
+		/*
+		 * Sequence Lock.
+		 * For small POD object, read often and write rarely.
+		 * The writer makes the sequence odd, copies the object and makes
+		 * it even again. The reader copies the object and retries when
+		 * the sequence is odd or changed during the copy.
+		 * Readers never write any shared memory, so they do not bounce
+		 * the cache line between cpus and never block a writer.
+		 */
+		template < typename _TyObject >
+		class SeqLock
+		{
+		protected:
+			volatile Uint32							m_Seq;
+			PLIB_CACHELINE_PAD( m_Pad, Uint32 );
+			_TyObject								m_Object;
+
+		private:
+			SeqLock< _TyObject >( const SeqLock< _TyObject > & );
+			SeqLock< _TyObject > & operator = ( const SeqLock< _TyObject > & );
+
+		public:
+			SeqLock< _TyObject >( ) : m_Seq( 0 ), m_Object( ) { CONSTRUCTURE; }
+			SeqLock< _TyObject >( const _TyObject & _obj ) : m_Seq( 0 ), m_Object( _obj )
+			{
+				CONSTRUCTURE;
+			}
+			~SeqLock< _TyObject >( ) { DESTRUCTURE; }
+
+			// Copy the object out, wait-free unless a writer is in progress.
+			INLINE void Read( _TyObject & _obj ) const
+			{
+				for ( ; ; ) {
+					Uint32 _seq = Plib::Basic::AtomicLoad( &m_Seq, Plib::Basic::AO_ACQUIRE );
+					if ( _seq & 1 ) { Plib::Basic::CpuRelax( ); continue; }
+					::memcpy( (void *)&_obj, (const void *)&m_Object, sizeof(_TyObject) );
+					Plib::Basic::AtomicFence( Plib::Basic::AO_ACQUIRE );
+					if ( Plib::Basic::AtomicLoad( &m_Seq, Plib::Basic::AO_RELAXED ) == _seq ) return;
+				}
+			}
+			INLINE _TyObject Read( ) const
+			{
+				_TyObject _obj;
+				this->Read( _obj );
+				return _obj;
+			}
+
+			// Writers are serialized by the sequence itself.
+			INLINE void Write( const _TyObject & _obj )
+			{
+				Uint32 _seq = Plib::Basic::AtomicLoad( &m_Seq, Plib::Basic::AO_RELAXED );
+				for ( ; ; ) {
+					if ( !(_seq & 1) && Plib::Basic::AtomicCompareExchange( &m_Seq, _seq, _seq + 1,
+						Plib::Basic::AO_ACQUIRE ) ) break;
+					Plib::Basic::CpuRelax( );
+					_seq = Plib::Basic::AtomicLoad( &m_Seq, Plib::Basic::AO_RELAXED );
+				}
+				// The odd sequence must be visible before the new data.
+				Plib::Basic::AtomicFence( Plib::Basic::AO_RELEASE );
+				::memcpy( (void *)&m_Object, (const void *)&_obj, sizeof(_TyObject) );
+				Plib::Basic::AtomicStore( &m_Seq, _seq + 2, Plib::Basic::AO_RELEASE );
+			}
+
+			// Sequence number, changes on every write.
+			INLINE Uint32 Version( ) const
+			{
+				return Plib::Basic::AtomicLoad( &m_Seq, Plib::Basic::AO_ACQUIRE ) >> 1;
+			}
+		};
+
+		/*
+		 * Big Reader Lock.
+		 * Each cpu has its own reader counter on its own cache line, a
+		 * reader only touches the counter of the cpu it runs on.
+		 * The writer takes the writer flag and waits all counters drop
+		 * to zero, so writing is expensive. Use it for tables read by
+		 * every request and changed by configuration.
+		 * ReadLock returns the counter index, pass it to ReadUnLock,
+		 * the thread may move to another cpu inside the lock.
+		 */
+		class BRLock
+		{
+		public:
+			enum { BRLOCK_SLOTS = 32 };
+
+		protected:
+			struct __Slot {
+				volatile Int32						Readers;
+				PLIB_CACHELINE_PAD( Pad, Int32 );
+			};
+
+			volatile Int32							m_Writer;
+			PLIB_CACHELINE_PAD( m_Pad, Int32 );
+			__Slot									m_Slots[BRLOCK_SLOTS];
+
+			// Counter index of current thread.
+			static INLINE Uint32 __SlotIndex( )
+			{
+		#if _DEF_LINUX
+				int _cpu = ::sched_getcpu( );
+				if ( _cpu >= 0 ) return (Uint32)_cpu % BRLOCK_SLOTS;
+		#endif
+				// No cpu id, give each thread a fixed counter.
+				static volatile Uint32 _next = 0;
+				static PLIB_THREAD_LOCAL Uint32 _index = (Uint32)-1;
+				if ( _index == (Uint32)-1 )
+					_index = Plib::Basic::AtomicFetchAdd( &_next, (Uint32)1 ) % BRLOCK_SLOTS;
+				return _index;
+			}
+
+		private:
+			BRLock( const BRLock & );
+			BRLock & operator = ( const BRLock & );
+
+		public:
+			BRLock( ) : m_Writer( 0 )
+			{
+				CONSTRUCTURE;
+				for ( Uint32 i = 0; i < BRLOCK_SLOTS; ++i ) m_Slots[i].Readers = 0;
+			}
+			~BRLock( ) { DESTRUCTURE; }
+
+			INLINE Uint32 ReadLock( )
+			{
+				Uint32 _index = __SlotIndex( );
+				volatile Int32 * _readers = &m_Slots[_index].Readers;
+				for ( ; ; ) {
+					// Seq cst, pair with the writer flag and the counter check.
+					Plib::Basic::AtomicFetchAdd( _readers, (Int32)1 );
+					if ( Plib::Basic::AtomicLoad( &m_Writer ) == 0 ) return _index;
+					Plib::Basic::AtomicFetchSub( _readers, (Int32)1 );
+					while ( Plib::Basic::AtomicLoad( &m_Writer, Plib::Basic::AO_RELAXED ) != 0 )
+						Plib::Basic::FutexWait( &m_Writer, 1 );
+				}
+			}
+			INLINE void ReadUnLock( Uint32 _index )
+			{
+				Plib::Basic::AtomicFetchSub( &m_Slots[_index].Readers, (Int32)1,
+					Plib::Basic::AO_RELEASE );
+			}
+
+			INLINE void WriteLock( )
+			{
+				Int32 _writer = 0;
+				while ( !Plib::Basic::AtomicCompareExchange( &m_Writer, _writer, (Int32)1 ) ) {
+					Plib::Basic::FutexWait( &m_Writer, 1 );
+					_writer = 0;
+				}
+				// New readers see the flag and back off, wait the old ones leave.
+				for ( Uint32 i = 0; i < BRLOCK_SLOTS; ++i ) {
+					while ( Plib::Basic::AtomicLoad( &m_Slots[i].Readers ) != 0 )
+						Plib::Basic::ThreadYield( );
+				}
+			}
+			INLINE void WriteUnLock( )
+			{
+				Plib::Basic::AtomicStore( &m_Writer, (Int32)0, Plib::Basic::AO_RELEASE );
+				Plib::Basic::FutexWake( &m_Writer, 0x7FFFFFFF );
+			}
+		};
+
+		// Wrap for BRLock
+		class BRReadLocker
+		{
+			BRLock &	m_locker;
+			Uint32		m_index;
+		public:
+			BRReadLocker( BRLock & _l ) : m_locker( _l ), m_index( _l.ReadLock( ) ) { }
+			~BRReadLocker( ) { m_locker.ReadUnLock( m_index ); }
+		};
+
+		class BRWriteLocker
+		{
+			BRLock &	m_locker;
+		public:
+			BRWriteLocker( BRLock & _l ) : m_locker( _l ) { m_locker.WriteLock( ); }
+			~BRWriteLocker( ) { m_locker.WriteUnLock( ); }
+		};
+	}
+}
+
+#endif // plib.threading.seqlock.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
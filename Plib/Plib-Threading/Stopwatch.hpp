@@ -5,8 +5,10 @@
 * File Name			: stopwatch.hpp
 * Propose  			: Stop Watch Object Definition.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.3
 * Change Log		: Re-Definition.
+* Change Log		: 1.2: Monotonic clock, coarse, tsc and cached modes.
+* Change Log		: 1.3: The cached now falls back to the clock when it is stale.
 * Author			: Push Chen
 * Change Date		: 2011-01-09
 */
@@ -18,59 +20,166 @@
 
 #if _DEF_IOS
 #include "Plib.hpp"
+#include "Atomic.hpp"
 #else
 #include <Plib-Basic/Plib.hpp>
+#include <Plib-Basic/Atomic.hpp>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#if !_DEF_WIN32
+#include <x86intrin.h>
+#endif
+#define PLIB_HAS_TSC		1
+#else
+#define PLIB_HAS_TSC		0
+#endif
+
+// The cached now older than this, in ns, is not used. It must be
+// longer than the coarse clock tick.
+#ifndef PLIB_CACHED_NOW_PERIOD
+#define PLIB_CACHED_NOW_PERIOD	10000000
 #endif
 
 namespace Plib
 {
 	namespace Threading
 	{
-		// Calculate the Time Passed in mileseconds
-		class StopWatch
+		// The clock source of the stop watch.
+		enum StopWatchMode
 		{
-	#if _DEF_WIN32
-			LARGE_INTEGER _Start, _End, _Frequency;
+			SW_MONOTONIC		= 0,	// clock_gettime( CLOCK_MONOTONIC ), vdso, no syscall.
+			SW_COARSE			= 1,	// CLOCK_MONOTONIC_COARSE, cheaper, tick resolution.
+			SW_TSC				= 2,	// rdtsc, calibrated against the monotonic clock.
+			SW_CACHED			= 3		// The cached now of the process, see MonotonicClock.
+		};
+
+		// Process wide monotonic clocks in nano seconds.
+		class MonotonicClock
+		{
+		protected:
+			static INLINE volatile Uint64 & __CachedNow( )
+			{
+				static volatile Uint64 _now = 0;
+				return _now;
+			}
+
+			// Cycles of 1 ns, measured once by a 5ms sample.
+			static INLINE double __Calibrate( )
+			{
+	#if PLIB_HAS_TSC
+				Uint64 _ns0 = NanoSeconds( ), _tsc0 = Cycles( );
+				Uint64 _ns1, _tsc1;
+				do {
+					_ns1 = NanoSeconds( );
+					_tsc1 = Cycles( );
+				} while ( _ns1 - _ns0 < 5000000 );
+				return (double)(_tsc1 - _tsc0) / (double)(_ns1 - _ns0);
 	#else
-			struct timeval _Start, _End;
+				return 1.0;
 	#endif
-			double _TimePassed;
+			}
+
 		public:
-			StopWatch( bool _StartNow = true )
-				: _TimePassed( 0.0 )
+			static INLINE Uint64 NanoSeconds( )
 			{
 	#if _DEF_WIN32
-				_Start.QuadPart = 0;
-				_End.QuadPart = 0;
-				_Frequency.QuadPart = 0;
-				::QueryPerformanceFrequency(&_Frequency);
+				static LARGE_INTEGER _freq = { 0 };
+				if ( _freq.QuadPart == 0 ) ::QueryPerformanceFrequency( &_freq );
+				LARGE_INTEGER _now;
+				::QueryPerformanceCounter( &_now );
+				return (Uint64)((double)_now.QuadPart * 1000000000.0 / (double)_freq.QuadPart);
+	#else
+				struct timespec _ts;
+				::clock_gettime( CLOCK_MONOTONIC, &_ts );
+				return (Uint64)_ts.tv_sec * 1000000000 + (Uint64)_ts.tv_nsec;
 	#endif
-				if ( _StartNow ) SetStart( );
 			}
 
-			INLINE void SetStart( )
+			// Resolution is the kernel tick, 1 to 4ms.
+			static INLINE Uint64 CoarseNanoSeconds( )
 			{
-	#if _DEF_WIN32
-				::QueryPerformanceCounter( &_Start );
+	#if defined(CLOCK_MONOTONIC_COARSE)
+				struct timespec _ts;
+				::clock_gettime( CLOCK_MONOTONIC_COARSE, &_ts );
+				return (Uint64)_ts.tv_sec * 1000000000 + (Uint64)_ts.tv_nsec;
 	#else
-				::gettimeofday( &_Start, NULL );
+				return NanoSeconds( );
 	#endif
 			}
 
-			INLINE void Tick( )
+			// Time stamp counter. Only meaningful with an invariant tsc,
+			// which all x86 cpus of the last decade have.
+			static INLINE Uint64 Cycles( )
 			{
-	#if _DEF_WIN32
-				::QueryPerformanceCounter( &_End );
-				_TimePassed = (double)(_End.QuadPart - _Start.QuadPart) / 
-					(double)_Frequency.QuadPart;
+	#if PLIB_HAS_TSC
+				return (Uint64)__rdtsc( );
 	#else
-				::gettimeofday( &_End, NULL );
-				_TimePassed = 1000000 * ( _End.tv_sec - _Start.tv_sec ) + 
-					( _End.tv_usec - _Start.tv_usec );
-				_TimePassed /= 1000000;
+				return NanoSeconds( );
 	#endif
 			}
 
+			static INLINE double CyclesPerNanoSecond( )
+			{
+				static double _cycles = __Calibrate( );
+				return _cycles;
+			}
+
+			// Read by the idle checks of the sockets instead of the clock.
+			// Only as fresh as the last poller loop, falls back to the clock
+			// when no poller has updated it within PLIB_CACHED_NOW_PERIOD.
+			static INLINE Uint64 CachedNanoSeconds( )
+			{
+				Uint64 _now = Plib::Basic::AtomicLoad( &__CachedNow( ), Plib::Basic::AO_RELAXED );
+				if ( _now + PLIB_CACHED_NOW_PERIOD < CoarseNanoSeconds( ) ) return NanoSeconds( );
+				return _now;
+			}
+
+			// The poller calls this once per loop.
+			static INLINE void UpdateCachedNow( )
+			{
+				Plib::Basic::AtomicStore( &__CachedNow( ), NanoSeconds( ), Plib::Basic::AO_RELAXED );
+			}
+		};
+
+		// Calculate the Time Passed in mileseconds
+		class StopWatch
+		{
+			Uint64			_Start, _End;
+			StopWatchMode	_Mode;
+			double			_TimePassed;
+
+			INLINE Uint64 _Now( ) const
+			{
+				switch ( _Mode ) {
+				case SW_COARSE: return MonotonicClock::CoarseNanoSeconds( );
+				case SW_TSC: return MonotonicClock::Cycles( );
+				case SW_CACHED: return MonotonicClock::CachedNanoSeconds( );
+				default: return MonotonicClock::NanoSeconds( );
+				};
+			}
+		public:
+			StopWatch( bool _StartNow = true, StopWatchMode _ClockMode = SW_MONOTONIC )
+				: _Start( 0 ), _End( 0 ), _Mode( _ClockMode ), _TimePassed( 0.0 )
+			{
+				// Calibrate before the first sample.
+				if ( _Mode == SW_TSC ) MonotonicClock::CyclesPerNanoSecond( );
+				if ( _StartNow ) SetStart( );
+			}
+
+			INLINE void SetStart( )
+			{
+				_Start = _Now( );
+			}
+
+			INLINE void Tick( )
+			{
+				_End = _Now( );
+				double _Passed = ( _End > _Start ) ? (double)( _End - _Start ) : 0.0;
+				if ( _Mode == SW_TSC ) _Passed /= MonotonicClock::CyclesPerNanoSecond( );
+				_TimePassed = _Passed / 1000000000;
+			}
+
 			INLINE double GetTimePassed()
 			{
 				return _TimePassed;
@@ -80,6 +189,16 @@ namespace Plib
 			{
 				return ( Uint64 )(_TimePassed * 1000);
 			}
+
+			INLINE Uint64 GetMicroSecUsed()
+			{
+				return ( Uint64 )(_TimePassed * 1000000);
+			}
+
+			INLINE Uint64 GetNanoSecUsed()
+			{
+				return ( Uint64 )(_TimePassed * 1000000000);
+			}
 		};
 	}
 }
@@ -92,4 +211,3 @@ namespace Plib
  http://pushchen.com
  http://twitter.com/littlepush
  */
-
@@ -5,8 +5,9 @@
 * File Name			: thread.hpp
 * Propose  			: Redefinition the thread object. Use Global Mapping to store current thread info.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.2
 * Change Log		: Re-Definition.
+* Change Log		: 1.2: Thread local stop token for Running and WaitForSignal.
 * Author			: Push Chen
 * Change Date		: 2011-01-10
 */
@@ -76,6 +77,17 @@ namespace Plib
 		#define _THREAD_CALLBACK
 		#endif
 
+		// Stop flag of one thread, the thread reads it through a thread
+		// local pointer. On its own cache line, the loop of the thread
+		// only shares it with the one who stops the thread.
+		typedef struct tagTHREAD_STOPTOKEN
+		{
+			char			_Pad0[PLIB_CACHELINE_SIZE];
+			volatile Int32	_Running;
+			Semaphore *		_Signal;
+			PLIB_CACHELINE_PAD( _Pad1, Int32 );
+		} THREAD_STOPTOKEN, *LPTHREAD_STOPTOKEN;
+
 		// Thread Information Struct
 		typedef struct tagTHREAD_OBJECT
 		{
@@ -87,6 +99,7 @@ namespace Plib
 			Mutex			_RunningLock;
 			Semaphore		_SyncSem;
 			Semaphore		_SignalSem;
+			THREAD_STOPTOKEN	_StopToken;
 		} THREAD_OBJECT, *LPTHREAD_OBJECT;
 
 		INLINE void _INIT_THREAD_OBJECT( THREAD_OBJECT & _TObj )
@@ -95,6 +108,8 @@ namespace Plib
 			_TObj._ThreadID = 0;
 			_TObj._ThreadStatue = false;
 			_TObj._StackSize = 0;
+			_TObj._StopToken._Running = 0;
+			_TObj._StopToken._Signal = &_TObj._SignalSem;
 		}
 		
 		// Thread Global Info
@@ -128,6 +143,23 @@ namespace Plib
 				static std::map< TID_T, LPTHREAD_OBJECT > _map;
 				return _map;
 			}
+			// Stop token of the current thread, NULL out of a Thread object.
+			static INLINE LPTHREAD_STOPTOKEN & LocalStopToken() {
+				static PLIB_THREAD_LOCAL LPTHREAD_STOPTOKEN _token = NULL;
+				return _token;
+			}
+			// Publish the token at the start of the thread function.
+			static INLINE void EnterThread( LPTHREAD_OBJECT _ThreadObj ) {
+				Plib::Basic::AtomicStore( &_ThreadObj->_StopToken._Running, (Int32)1 );
+				LocalStopToken() = &_ThreadObj->_StopToken;
+			}
+			static INLINE void LeaveThread( ) {
+				LocalStopToken() = NULL;
+			}
+			static INLINE void SetRunning( LPTHREAD_OBJECT _ThreadObj, bool _Statue ) {
+				Plib::Basic::AtomicStore( &_ThreadObj->_StopToken._Running, 
+					(Int32)(_Statue ? 1 : 0) );
+			}
 			// Try to start the thread call back function.
 			// In different operation system, this function active differently.
 			// The return value of this function shows if 
@@ -193,16 +225,13 @@ namespace Plib
 		#endif
 			}
 
+			// One relaxed load of the thread's own stop token.
 			static INLINE bool Running( )
 			{
-				TID_T _Id = SelfID();
-				ReadLocker _GLocker( ThreadKernel::ThreadGlobalLock() );
-				if ( ThreadKernel::ThreadGlobalMap().find( _Id ) == 
-					ThreadKernel::ThreadGlobalMap().end() )
-					return false;
-				LPTHREAD_OBJECT _ThreadObj = ThreadKernel::ThreadGlobalMap()[_Id];
-				ReadLocker _TLocker( _ThreadObj->_Locker );
-				return _ThreadObj->_ThreadStatue;
+				LPTHREAD_STOPTOKEN _token = ThreadKernel::LocalStopToken();
+				if ( _token == NULL ) return false;
+				return Plib::Basic::AtomicLoad( &_token->_Running, 
+					Plib::Basic::AO_RELAXED ) != 0;
 			}
 
 			// Sleep the thread function for millseconds.
@@ -225,20 +254,11 @@ namespace Plib
 			// Default is Wait Infinished.
 			static INLINE bool WaitForSignal( Uint32 _Milliseconds = Semaphore::MAXTIMEOUT )
 			{
-				TID_T _Id = SelfID();
-				// BUG HERE!!
-				// When any thread invoke this method, is about to block
-				// the ThreadGlobalLock, then no other thread can be started or ended.
-				//ReadLocker _GLocker( ThreadGlobalLock );
-				ThreadKernel::ThreadGlobalLock().ReadLock( );
-				if ( ThreadKernel::ThreadGlobalMap().find( _Id ) == 
-					ThreadKernel::ThreadGlobalMap().end() ) {
-					ThreadKernel::ThreadGlobalLock().UnLock( );
-					return false;
-				}
-				LPTHREAD_OBJECT _ThreadObj = ThreadKernel::ThreadGlobalMap()[_Id];
-				ThreadKernel::ThreadGlobalLock().UnLock( );
-				return _ThreadObj->_SignalSem.Get( _Milliseconds );
+				// The token is the thread's own, no global lock is held
+				// while waiting.
+				LPTHREAD_STOPTOKEN _token = ThreadKernel::LocalStopToken();
+				if ( _token == NULL ) return false;
+				return _token->_Signal->Get( _Milliseconds );
 			}
 		};
 
@@ -262,11 +282,13 @@ namespace Plib
 					( Thread< _TyRet( DEF_TYPE(n) ) > *)_Thread;							\
 				pThread->_ThreadObj._ThreadStatue = true;									\
 				pThread->_ThreadObj._SignalSem.Init(0, 1);									\
+				ThreadKernel::EnterThread( &pThread->_ThreadObj );							\
 				Locker _RLock( pThread->_ThreadObj._RunningLock );							\
 				pThread->_ThreadObj._SyncSem.Release();										\
 				if ( pThread->Jobs ) pThread->Jobs( DEF_ARG_IN_THREAD( n ) );				\
 				pThread->SetStatue( false );												\
 				if ( pThread->Join ) pThread->Join( );										\
+				ThreadKernel::LeaveThread( );												\
 				ThreadKernel::EndThread( &pThread->_ThreadObj );							\
 				return 0;																	\
 			}																				\
@@ -275,6 +297,7 @@ namespace Plib
 			{																				\
 				WriteLocker locker( _ThreadObj._Locker );									\
 				_ThreadObj._ThreadStatue = _Statue;											\
+				ThreadKernel::SetRunning( &_ThreadObj, _Statue );							\
 			}																				\
 		public:																				\
 			Thread< _TyRet( DEF_TYPE(n) ) > ( ) { _INIT_THREAD_OBJECT( _ThreadObj ); }		\
@@ -337,11 +360,13 @@ namespace Plib
 				Thread< _TyRet( ) > * pThread = ( Thread< _TyRet( ) > *)_Thread;
 				pThread->_ThreadObj._ThreadStatue = true;
 				pThread->_ThreadObj._SignalSem.Init(0, 1);
+				ThreadKernel::EnterThread( &pThread->_ThreadObj );
 				Locker _RLock( pThread->_ThreadObj._RunningLock );
 				pThread->_ThreadObj._SyncSem.Release();
 				if ( pThread->Jobs ) pThread->Jobs( );
 				pThread->SetStatue( false );
 				if ( pThread->Join ) pThread->Join( );
+				ThreadKernel::LeaveThread( );
 				ThreadKernel::EndThread( &pThread->_ThreadObj );
 				return 0;
 			}
@@ -350,6 +375,7 @@ namespace Plib
 			{
 				WriteLocker locker( _ThreadObj._Locker );
 				_ThreadObj._ThreadStatue = _Statue;
+				ThreadKernel::SetRunning( &_ThreadObj, _Statue );
 			}
 		public:
 			// C'Str
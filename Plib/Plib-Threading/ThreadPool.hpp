@@ -0,0 +1,324 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: ThreadPool.hpp
+* Propose  			: Fixed size work stealing thread pool.
+*
+* Current Version	: 1.1
+* Change Log		: First Definition.
+* Change Log		: 1.1: No submit after stopping, the task nodes are reused.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_THREADING_THREADPOOL_HPP_
+#define _PLIB_THREADING_THREADPOOL_HPP_
+
+#if _DEF_IOS
+#include "Thread.hpp"
+#include "LockFreeQueue.hpp"
+#else
+#include <Plib-Threading/Thread.hpp>
+#include <Plib-Generic/LockFreeQueue.hpp>
+#endif
+
+namespace Plib
+{
+	namespace Threading
+	{
+		/*
+		 * Thread Pool.
+		 * The pool starts a fixed number of workers (default is the cpu
+		 * count), each worker owns a work stealing deque.
+		 * A task submitted by a worker goes to its own deque, and is
+		 * taken back in LIFO order while the data is still in cache.
+		 * Tasks from other threads go to a shared injection queue.
+		 * An idle worker steals from the top of the other deques, then
+		 * spins a while and sleeps on a futex until new task comes.
+		 * The task nodes are kept in a free list and reused, so a submit
+		 * does not allocate once the pool is warm.
+		 */
+		class ThreadPool
+		{
+		public:
+			typedef Plib::Generic::Delegate< void( ) >						TaskT;
+			typedef Thread< void( Uint32 ) >								WorkThreadT;
+
+			enum {
+				POOL_INJECT_SIZE	= 0x10000,	// Shared queue capacity.
+				POOL_FREE_SIZE		= 0x10000,	// Task nodes kept for reuse.
+				POOL_SPIN_COUNT		= 256		// Idle rounds before sleeping.
+			};
+
+		protected:
+			struct __Worker
+			{
+				Plib::Generic::WorkStealingDeque< TaskT * >	Deque;
+				WorkThreadT									Worker;
+				ThreadPool *								Pool;
+				Uint32										Seed;
+			};
+
+			Plib::Generic::Vector< __Worker * >				m_Workers;
+			Plib::Generic::MpmcQueue< TaskT * >				m_Inject;
+			Plib::Generic::MpmcQueue< TaskT * >				m_FreeTasks;
+			volatile Int32									m_Running;
+			// Submits between the running check and the push, Stop
+			// waits for them before it drains the queues.
+			volatile Int32									m_Submitting;
+			bool											m_BindCpu;
+			Uint32											m_SpinCount;
+			PLIB_CACHELINE_PAD( m_Pad0, Uint64 );
+
+			// Idle workers sleep on the event.
+			volatile Int32									m_WorkEvent;
+			volatile Int32									m_Sleepers;
+			PLIB_CACHELINE_PAD( m_Pad1, Uint64 );
+
+			// The worker object of current thread.
+			static INLINE __Worker * & __CurrentWorker( )
+			{
+				static PLIB_THREAD_LOCAL __Worker * _worker = NULL;
+				return _worker;
+			}
+
+			INLINE TaskT * __NewTask( const TaskT & _task )
+			{
+				TaskT * _node = NULL;
+				if ( m_FreeTasks.Pop( _node ) ) {
+					*_node = _task;
+					return _node;
+				}
+				PNEWPARAM( TaskT, _node, _task );
+				return _node;
+			}
+
+			// Release what the task holds and keep the node.
+			INLINE void __FreeTask( TaskT * _node )
+			{
+				_node->Clear( );
+				if ( !m_FreeTasks.Push( _node ) ) { PDELETE( _node ); }
+			}
+
+			// Wake one sleeping worker if any.
+			INLINE void __Notify( Int32 _count )
+			{
+				Plib::Basic::AtomicFence( Plib::Basic::AO_SEQ_CST );
+				if ( Plib::Basic::AtomicLoad( &m_Sleepers, Plib::Basic::AO_RELAXED ) == 0 ) return;
+				Plib::Basic::AtomicFetchAdd( &m_WorkEvent, (Int32)1 );
+				Plib::Basic::FutexWake( &m_WorkEvent, _count );
+			}
+
+			INLINE bool __HasWork( ) const
+			{
+				if ( !m_Inject.Empty( ) ) return true;
+				for ( Uint32 i = 0; i < m_Workers.Size( ); ++i )
+					if ( !m_Workers[i]->Deque.Empty( ) ) return true;
+				return false;
+			}
+
+			// Own deque first, then the shared queue, then steal.
+			INLINE TaskT * __FindTask( __Worker * _self )
+			{
+				TaskT * _task = NULL;
+				if ( _self->Deque.Take( _task ) ) return _task;
+				if ( m_Inject.Pop( _task ) ) return _task;
+				Uint32 _count = m_Workers.Size( );
+				// xorshift, start from a random victim.
+				_self->Seed ^= _self->Seed << 13;
+				_self->Seed ^= _self->Seed >> 17;
+				_self->Seed ^= _self->Seed << 5;
+				Uint32 _start = _self->Seed % _count;
+				for ( Uint32 i = 0; i < _count; ++i ) {
+					__Worker * _victim = m_Workers[(_start + i) % _count];
+					if ( _victim != _self && _victim->Deque.Steal( _task ) ) return _task;
+				}
+				return NULL;
+			}
+
+			INLINE void __BindCpu( Uint32 _cpu )
+			{
+	#if _DEF_WIN32
+				::SetThreadAffinityMask( ::GetCurrentThread(), (DWORD_PTR)1 << (_cpu % 64) );
+	#elif _DEF_LINUX
+				cpu_set_t _set;
+				CPU_ZERO( &_set );
+				CPU_SET( _cpu, &_set );
+				pthread_setaffinity_np( pthread_self(), sizeof(_set), &_set );
+	#else
+				// Mac OS X does not support binding thread to a cpu.
+				(void)_cpu;
+	#endif
+			}
+
+			// Worker thread.
+			void __WorkerLoop( Uint32 _index )
+			{
+				__Worker * _self = m_Workers[_index];
+				__CurrentWorker( ) = _self;
+				if ( m_BindCpu ) __BindCpu( _index % CpuCount( ) );
+				Uint32 _idle = 0;
+				while ( Plib::Basic::AtomicLoad( &m_Running, Plib::Basic::AO_ACQUIRE ) )
+				{
+					TaskT * _task = __FindTask( _self );
+					if ( _task != NULL ) {
+						(*_task)( );
+						__FreeTask( _task );
+						_idle = 0;
+						continue;
+					}
+					if ( ++_idle < m_SpinCount ) {
+						Plib::Basic::CpuRelax( );
+						continue;
+					}
+					// Sleep, same protocol as BlockingQueue.
+					Int32 _ev = Plib::Basic::AtomicLoad( &m_WorkEvent, Plib::Basic::AO_ACQUIRE );
+					Plib::Basic::AtomicFetchAdd( &m_Sleepers, (Int32)1 );
+					if ( !__HasWork( ) &&
+						Plib::Basic::AtomicLoad( &m_Running, Plib::Basic::AO_ACQUIRE ) )
+						Plib::Basic::FutexWait( &m_WorkEvent, _ev );
+					Plib::Basic::AtomicFetchSub( &m_Sleepers, (Int32)1 );
+					_idle = 0;
+				}
+				__CurrentWorker( ) = NULL;
+			}
+
+		private:
+			ThreadPool( const ThreadPool & );
+			ThreadPool & operator = ( const ThreadPool & );
+
+		public:
+			ThreadPool( )
+				: m_Inject( POOL_INJECT_SIZE ), m_FreeTasks( POOL_FREE_SIZE ),
+				m_Running( 0 ), m_Submitting( 0 ), m_BindCpu( false ),
+				m_SpinCount( 1 ), m_WorkEvent( 0 ), m_Sleepers( 0 )
+			{
+				CONSTRUCTURE;
+			}
+			~ThreadPool( )
+			{
+				DESTRUCTURE;
+				Stop( );
+				TaskT * _task;
+				while ( m_FreeTasks.Pop( _task ) ) { PDELETE( _task ); }
+			}
+
+			// Online cpu count.
+			static INLINE Uint32 CpuCount( )
+			{
+	#if _DEF_WIN32
+				SYSTEM_INFO _info;
+				::GetSystemInfo( &_info );
+				return (Uint32)_info.dwNumberOfProcessors;
+	#else
+				long _count = ::sysconf( _SC_NPROCESSORS_ONLN );
+				return (_count > 0) ? (Uint32)_count : 1;
+	#endif
+			}
+
+			// Start the workers, 0 means one worker per cpu.
+			// When _bindCpu is true, worker i only runs on cpu (i % cpu count).
+			bool Start( Uint32 _workerCount = 0, bool _bindCpu = false )
+			{
+				if ( m_Running ) return false;
+				if ( _workerCount == 0 ) _workerCount = CpuCount( );
+				m_BindCpu = _bindCpu;
+				// Spinning only helps when the submitter runs on another cpu.
+				m_SpinCount = (CpuCount( ) > 1) ? POOL_SPIN_COUNT : 1;
+				m_Running = 1;
+				// All workers must exist before any of them starts stealing.
+				for ( Uint32 i = 0; i < _workerCount; ++i ) {
+					__Worker * _worker;
+					PNEW( __Worker, _worker );
+					_worker->Pool = this;
+					_worker->Seed = 2463534242U + i * 0x9E3779B9U;
+					_worker->Worker.Jobs += std::make_pair( this, &ThreadPool::__WorkerLoop );
+					m_Workers.PushBack( _worker );
+				}
+				for ( Uint32 i = 0; i < _workerCount; ++i ) {
+					if ( !m_Workers[i]->Worker.Start( i ) ) {
+						Stop( );
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// Stop all workers, the tasks not started are dropped.
+			// A submit from now on fails.
+			void Stop( )
+			{
+				if ( m_Workers.Size( ) == 0 ) return;
+				Plib::Basic::AtomicStore( &m_Running, (Int32)0, Plib::Basic::AO_SEQ_CST );
+				// Either the submit sees the pool stopped, or it is counted
+				// here and its task is pushed before the drain.
+				while ( Plib::Basic::AtomicLoad( &m_Submitting, Plib::Basic::AO_SEQ_CST ) != 0 )
+					Plib::Basic::ThreadYield( );
+				Plib::Basic::AtomicFetchAdd( &m_WorkEvent, (Int32)1 );
+				Plib::Basic::FutexWake( &m_WorkEvent, 0x7FFFFFFF );
+				for ( Uint32 i = 0; i < m_Workers.Size( ); ++i )
+					m_Workers[i]->Worker.Stop( );
+				TaskT * _task;
+				for ( Uint32 i = 0; i < m_Workers.Size( ); ++i ) {
+					while ( m_Workers[i]->Deque.Take( _task ) ) __FreeTask( _task );
+					PDELETE( m_Workers[i] );
+				}
+				while ( m_Inject.Pop( _task ) ) __FreeTask( _task );
+				m_Workers.Clear( );
+			}
+
+			// Add a task to the pool, return false if the pool is not running.
+			bool Submit( const TaskT & _task )
+			{
+				Plib::Basic::AtomicFetchAdd( &m_Submitting, (Int32)1, Plib::Basic::AO_SEQ_CST );
+				if ( !Plib::Basic::AtomicLoad( &m_Running, Plib::Basic::AO_SEQ_CST ) ) {
+					Plib::Basic::AtomicFetchSub( &m_Submitting, (Int32)1 );
+					return false;
+				}
+				TaskT * _newTask = __NewTask( _task );
+				__Worker * _self = __CurrentWorker( );
+				bool _pushed = true;
+				if ( _self != NULL && _self->Pool == this ) {
+					_self->Deque.Push( _newTask );
+				} else {
+					// Shared queue is full, wait for the workers, which
+					// do not take any more once stopping.
+					while ( !m_Inject.Push( _newTask ) ) {
+						if ( !Plib::Basic::AtomicLoad( &m_Running, Plib::Basic::AO_ACQUIRE ) ) {
+							__FreeTask( _newTask );
+							_pushed = false;
+							break;
+						}
+						Plib::Basic::ThreadYield( );
+					}
+				}
+				Plib::Basic::AtomicFetchSub( &m_Submitting, (Int32)1 );
+				if ( _pushed ) __Notify( 1 );
+				return _pushed;
+			}
+
+			INLINE Uint32 WorkerCount( ) const { return m_Workers.Size( ); }
+
+			// Approximate count of the tasks not started.
+			INLINE Uint32 PendingCount( ) const
+			{
+				Uint32 _count = m_Inject.Size( );
+				for ( Uint32 i = 0; i < m_Workers.Size( ); ++i )
+					_count += m_Workers[i]->Deque.Size( );
+				return _count;
+			}
+		};
+	}
+}
+
+#endif // plib.threading.threadpool.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
@@ -20,13 +20,19 @@
 #include "Locker.hpp"
 #include "Semaphore.hpp"
 #include "Thread.hpp"
+#include "ThreadPool.hpp"
+#include "SeqLock.hpp"
 #include "Stopwatch.hpp"
+#include "TimerService.hpp"
 #include "Timer.hpp"
 #else
 #include <Plib-Threading/Locker.hpp>
 #include <Plib-Threading/Semaphore.hpp>
 #include <Plib-Threading/Thread.hpp>
+#include <Plib-Threading/ThreadPool.hpp>
+#include <Plib-Threading/SeqLock.hpp>
 #include <Plib-Threading/Stopwatch.hpp>
+#include <Plib-Threading/TimerService.hpp>
 #include <Plib-Threading/Timer.hpp>
 #endif
 
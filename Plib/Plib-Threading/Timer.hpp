@@ -5,8 +5,9 @@
 * File Name			: timer.hpp
 * Propose  			: Redefinition the timer object. Caculate the time more detail.
 * 
-* Current Version	: 1.1
+* Current Version	: 1.2
 * Change Log		: Re-Definition.
+* Change Log		: 1.2: Run on the shared TimerService instead of one thread each.
 * Author			: Push Chen
 * Change Date		: 2011-01-10
 */
@@ -19,72 +20,79 @@
 #if _DEF_IOS
 #include "Thread.hpp"
 #include "Stopwatch.hpp"
+#include "TimerService.hpp"
 #else
 #include <Plib-Threading/Thread.hpp>
 #include <Plib-Threading/Stopwatch.hpp>
+#include <Plib-Threading/TimerService.hpp>
 #endif
 
 namespace Plib
 {
 	namespace Threading
 	{
-		// An easy timer impelnment with thread.
+		// An easy timer impelnment with the timer service.
 		// the OnTick delegate accept a function which return void and with
 		// no parameters.
+		// All timers share the thread of the service, do not block in
+		// the OnTick delegate.
 		class Timer
 		{
 		public:
 			// An void() delegate will be invoked when a tick arrived.
-			typedef Thread< void ( ) >					TickThread;
 			typedef Plib::Generic::Delegate< void ( ) >	TickHandler;
 		protected:
 			bool										_Enabled;
 			Uint64										_Interval;
 			Mutex										_TickMutex;
-			TickThread									_TickThread;
 			TickHandler									_OnTick;
+			TimerService &								_Service;
+			TimerTask									_Task;
 
-			// The thread function to do a loop and calc the time.
-			void _TimerInternalThread( )
+			// Invoked by the timer service.
+			void _OnTimer( )
 			{
-				StopWatch _StopWatch( false );
-
-				while( ThreadSys::Running() )
-				{
-					_StopWatch.SetStart( );
-					//Locker _Lock( _TickMutex );
-					_TickMutex.Lock();
-					if ( _OnTick ) _OnTick( );
-					_StopWatch.Tick( );
-					Uint64 _LeftTime = _Interval - (_StopWatch.GetMileSecUsed() % _Interval);
-					_TickMutex.UnLock();
-					ThreadSys::WaitForSignal( (Uint32)_LeftTime );
-				}
+				TickHandler _Handler;
+				_TickMutex.Lock();
+				_Handler = _OnTick;
+				_TickMutex.UnLock();
+				if ( _Handler ) _Handler( );
 			}
 
 		public:
 			// C'Str
-			Timer( Uint64 _Milliseconds = 1000, bool _Statue = false )
-				: _Enabled( _Statue ), _Interval( _Milliseconds )
+			Timer( Uint64 _Milliseconds = 1000, bool _Statue = false, 
+				TimerService & _ServiceRef = TimerService::Default( ) )
+				: _Enabled( _Statue ), _Interval( _Milliseconds ), _Service( _ServiceRef )
+			{
+				_Task.Handler += std::make_pair(this, &Timer::_OnTimer);
+				if ( _Enabled ) _Service.Schedule( _Task, _Interval, _Interval );
+			}
+			~Timer( )
 			{
-				_TickThread.Jobs += std::make_pair(this, &Timer::_TimerInternalThread);
-				if ( _Enabled ) _TickThread.Start( );
+				_Service.Cancel( _Task );
 			}
 
 			void SetInterval( Uint64 _Milliseconds )
 			{
 				if ( _Milliseconds == 0 ) return;
-				Locker _Lock( _TickMutex);
+				_TickMutex.Lock();
 				_Interval = _Milliseconds;
+				bool _Statue = _Enabled;
+				_TickMutex.UnLock();
+				if ( _Statue ) _Service.Schedule( _Task, _Milliseconds, _Milliseconds );
 			}
 
 			void SetEnable( bool _Statue )
 			{
-				Locker _Lock( _TickMutex);
-				if ( this->_Enabled == _Statue ) return;
+				// Cancel waits for the running tick, do not hold the mutex.
+				_TickMutex.Lock();
+				if ( this->_Enabled == _Statue ) { _TickMutex.UnLock(); return; }
 				_Enabled = _Statue;
-				if ( _Enabled ) _TickThread.Start( );
-				else _TickThread.Stop( );
+				Uint64 _Milliseconds = _Interval;
+				_TickMutex.UnLock();
+				if ( _Statue ) _Service.Schedule( _Task, _Milliseconds, _Milliseconds );
+				else _Service.Cancel( _Task );
 			}
 
 			// Append the OnTick Delegate.
@@ -0,0 +1,484 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: TimerService.hpp
+* Propose  			: Hierarchical timing wheel, all timers share one thread.
+*
+* Current Version	: 1.2
+* Change Log		: First Definition.
+* Change Log		: 1.1: One driver advances at a time, expired list per advance.
+* Change Log		: 1.2: The driver does not rearm over the wakeup of Stop.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_THREADING_TIMERSERVICE_HPP_
+#define _PLIB_THREADING_TIMERSERVICE_HPP_
+
+#if _DEF_IOS
+#include "Thread.hpp"
+#include "Atomic.hpp"
+#else
+#include <Plib-Threading/Thread.hpp>
+#include <Plib-Basic/Atomic.hpp>
+#endif
+
+#if _DEF_LINUX
+#include <sys/timerfd.h>
+#endif
+
+namespace Plib
+{
+	namespace Threading
+	{
+		class TimerService;
+
+		// One timer, owned by the user.
+		// The object must not move while it is pending, the service
+		// links it into the wheel directly. Destroying a pending task
+		// cancels it.
+		class TimerTask
+		{
+			friend class TimerService;
+		public:
+			typedef Plib::Generic::Delegate< void ( ) >		TimerHandler;
+
+			// Invoked when the timer expires.
+			TimerHandler				Handler;
+
+		protected:
+			TimerTask *					m_Prev;
+			TimerTask *					m_Next;
+			TimerTask **				m_Slot;
+			Uint64						m_Expire;		// Tick in milliseconds.
+			Uint64						m_Interval;		// 0 means run once.
+			TimerService *				m_Service;		// NULL when not pending.
+
+		private:
+			TimerTask( const TimerTask & );
+			TimerTask & operator = ( const TimerTask & );
+
+		public:
+			TimerTask( )
+				: m_Prev( NULL ), m_Next( NULL ), m_Slot( NULL ),
+				m_Expire( 0 ), m_Interval( 0 ), m_Service( NULL ) { CONSTRUCTURE; }
+			TimerTask( const TimerHandler & _handler )
+				: Handler( _handler ), m_Prev( NULL ), m_Next( NULL ), m_Slot( NULL ),
+				m_Expire( 0 ), m_Interval( 0 ), m_Service( NULL ) { CONSTRUCTURE; }
+			INLINE ~TimerTask( );
+
+			INLINE bool Pending( ) const { return m_Service != NULL; }
+		};
+
+		/*
+		 * Timer Service.
+		 * A 4 levels timing wheel with 1ms tick: 256 slots for the next
+		 * 256ms, then 64 slots each level, up to about 18 hours. Longer
+		 * timers are kept at the last level and cascade again.
+		 * Schedule, Cancel and Reschedule are O(1).
+		 * The wheel is driven by its own thread (Start), sleeping on a
+		 * timerfd on Linux, or by any loop calling Advance and sleeping
+		 * the returned milliseconds. Drivers advance one at a time, and
+		 * Advance must not be called inside a callback.
+		 * The callbacks run on the driving thread, or are passed to the
+		 * executor, for example ThreadPool::Submit.
+		 */
+		class TimerService
+		{
+		public:
+			typedef TimerTask::TimerHandler								TimerHandler;
+			typedef Plib::Generic::Delegate< bool ( const TimerHandler & ) >	ExecutorT;
+
+			enum {
+				WHEEL_ROOT_BITS		= 8,
+				WHEEL_ROOT_SIZE		= 1 << WHEEL_ROOT_BITS,
+				WHEEL_BITS			= 6,
+				WHEEL_SIZE			= 1 << WHEEL_BITS,
+				WHEEL_LEVELS		= 3		// Levels after the root.
+			};
+
+		protected:
+			TimerTask *									m_Root[WHEEL_ROOT_SIZE];
+			TimerTask *									m_Wheels[WHEEL_LEVELS][WHEEL_SIZE];
+			Uint64										m_NextTick;
+			Uint32										m_Count;
+			Uint32										m_RootCount;
+			Mutex										m_Lock;
+			// Held by the driver for the whole advance, the lock above
+			// is released while the callbacks run.
+			Mutex										m_AdvanceLock;
+			ExecutorT									m_Executor;
+
+			// The inline callback running now, Cancel waits for it.
+			TimerTask *									m_RunningTask;
+			TID_T										m_RunningThread;
+
+			Thread< void ( ) >							m_Thread;
+			volatile Int32								m_Running;
+			Uint64										m_ArmedTick;
+	#if _DEF_LINUX
+			int											m_TimerFd;
+	#else
+			volatile Int32								m_WakeEvent;
+	#endif
+
+			INLINE bool __InRoot( TimerTask ** _slot ) const
+			{
+				return _slot >= m_Root && _slot < m_Root + WHEEL_ROOT_SIZE;
+			}
+
+			INLINE void __Link( TimerTask * _task, TimerTask ** _slot )
+			{
+				_task->m_Prev = NULL;
+				_task->m_Next = *_slot;
+				if ( *_slot != NULL ) (*_slot)->m_Prev = _task;
+				*_slot = _task;
+				_task->m_Slot = _slot;
+			}
+
+			INLINE void __Unlink( TimerTask * _task )
+			{
+				if ( _task->m_Prev != NULL ) _task->m_Prev->m_Next = _task->m_Next;
+				else *_task->m_Slot = _task->m_Next;
+				if ( _task->m_Next != NULL ) _task->m_Next->m_Prev = _task->m_Prev;
+				if ( __InRoot( _task->m_Slot ) ) --m_RootCount;
+				_task->m_Prev = _task->m_Next = NULL;
+				_task->m_Slot = NULL;
+				--m_Count;
+			}
+
+			// Put the task to the slot of its expire tick.
+			INLINE void __Insert( TimerTask * _task )
+			{
+				Uint64 _expire = _task->m_Expire;
+				Int64 _delta = (Int64)(_expire - m_NextTick);
+				TimerTask ** _slot;
+				if ( _delta < 0 ) {
+					_slot = &m_Root[m_NextTick & (WHEEL_ROOT_SIZE - 1)];
+				} else if ( _delta < WHEEL_ROOT_SIZE ) {
+					_slot = &m_Root[_expire & (WHEEL_ROOT_SIZE - 1)];
+				} else {
+					Uint32 _level = 0, _shift = WHEEL_ROOT_BITS;
+					while ( _level < WHEEL_LEVELS - 1 &&
+						_delta >= ((Int64)1 << (_shift + WHEEL_BITS)) ) {
+						++_level;
+						_shift += WHEEL_BITS;
+					}
+					// Too far, park at the end of the last level and
+					// cascade again when the slot comes.
+					if ( _delta >= ((Int64)1 << (_shift + WHEEL_BITS)) )
+						_expire = m_NextTick + ((Uint64)1 << (_shift + WHEEL_BITS)) - 1;
+					_slot = &m_Wheels[_level][(_expire >> _shift) & (WHEEL_SIZE - 1)];
+				}
+				__Link( _task, _slot );
+				if ( __InRoot( _slot ) ) ++m_RootCount;
+				++m_Count;
+			}
+
+			// Move the tasks of a higher level slot down, return the slot index.
+			INLINE Uint32 __Cascade( Uint32 _level )
+			{
+				Uint32 _index = (Uint32)(m_NextTick >>
+					(WHEEL_ROOT_BITS + _level * WHEEL_BITS)) & (WHEEL_SIZE - 1);
+				TimerTask * _task = m_Wheels[_level][_index];
+				m_Wheels[_level][_index] = NULL;
+				while ( _task != NULL ) {
+					TimerTask * _next = _task->m_Next;
+					--m_Count;
+					__Insert( _task );
+					_task = _next;
+				}
+				return _index;
+			}
+
+			// Tick of the first pending task, (Uint64)-1 if none.
+			INLINE Uint64 __NextExpire( ) const
+			{
+				if ( m_Count == 0 ) return (Uint64)-1;
+				Uint64 _best = (Uint64)-1;
+				if ( m_RootCount > 0 ) {
+					for ( Uint32 i = 0; i < WHEEL_ROOT_SIZE; ++i ) {
+						if ( m_Root[(m_NextTick + i) & (WHEEL_ROOT_SIZE - 1)] == NULL ) continue;
+						_best = m_NextTick + i;
+						break;
+					}
+				}
+				// The tasks in the slots of higher levels are not sorted,
+				// check the whole slot to cascade next of each level.
+				for ( Uint32 _level = 0; _level < WHEEL_LEVELS; ++_level ) {
+					Uint32 _shift = WHEEL_ROOT_BITS + _level * WHEEL_BITS;
+					Uint32 _pos = (Uint32)((m_NextTick + ((Uint64)1 << _shift) - 1) >> _shift);
+					for ( Uint32 i = 0; i < WHEEL_SIZE; ++i ) {
+						const TimerTask * _task = m_Wheels[_level][(_pos + i) & (WHEEL_SIZE - 1)];
+						if ( _task == NULL ) continue;
+						for ( ; _task != NULL; _task = _task->m_Next )
+							if ( _task->m_Expire < _best ) _best = _task->m_Expire;
+						break;
+					}
+				}
+				return (_best < m_NextTick) ? m_NextTick : _best;
+			}
+
+			// Wake the timer thread at the tick.
+			INLINE void __Arm( Uint64 _tick )
+			{
+				m_ArmedTick = _tick;
+	#if _DEF_LINUX
+				struct itimerspec _its;
+				::memset( &_its, 0, sizeof(_its) );
+				if ( _tick != (Uint64)-1 ) {
+					// Zero means disarm, use 1ns for the past ticks.
+					_its.it_value.tv_sec = (time_t)(_tick / 1000);
+					_its.it_value.tv_nsec = (long)((_tick % 1000) * 1000000) + 1;
+				}
+				::timerfd_settime( m_TimerFd, TFD_TIMER_ABSTIME, &_its, NULL );
+	#else
+				Plib::Basic::AtomicFetchAdd( &m_WakeEvent, (Int32)1 );
+				Plib::Basic::FutexWake( &m_WakeEvent, 1 );
+	#endif
+			}
+
+			INLINE void __Execute( const TimerHandler & _handler )
+			{
+				if ( !_handler ) return;
+				if ( m_Executor ) m_Executor( _handler );
+				else _handler( );
+			}
+
+			// Run all the expired tasks, return the next expire tick.
+			Uint64 __Advance( bool _arm )
+			{
+				Locker _advance( m_AdvanceLock );
+				Uint64 _now = NowTick( );
+				// Expired tasks waiting to run.
+				TimerTask * _expired = NULL;
+				m_Lock.Lock( );
+				while ( m_NextTick <= _now ) {
+					Uint32 _index = (Uint32)m_NextTick & (WHEEL_ROOT_SIZE - 1);
+					if ( _index == 0 ) {
+						for ( Uint32 _level = 0; _level < WHEEL_LEVELS; ++_level )
+							if ( __Cascade( _level ) != 0 ) break;
+					} else if ( m_RootCount == 0 ) {
+						// Nothing in the root, jump to the next cascade.
+						Uint64 _next = (m_NextTick | (WHEEL_ROOT_SIZE - 1)) + 1;
+						m_NextTick = (_next <= _now) ? _next : _now + 1;
+						continue;
+					}
+					TimerTask ** _slot = &m_Root[_index];
+					++m_NextTick;
+					if ( *_slot == NULL ) continue;
+					// Keep them linked, Cancel still works while we run.
+					_expired = *_slot;
+					*_slot = NULL;
+					for ( TimerTask * _task = _expired; _task != NULL; _task = _task->m_Next ) {
+						_task->m_Slot = &_expired;
+						--m_RootCount;
+					}
+					while ( _expired != NULL ) {
+						TimerTask * _task = _expired;
+						__Unlink( _task );
+						if ( _task->m_Interval > 0 ) {
+							_task->m_Expire += _task->m_Interval;
+							if ( _task->m_Expire <= _now ) {
+								_task->m_Expire += ((_now - _task->m_Expire) /
+									_task->m_Interval + 1) * _task->m_Interval;
+							}
+							__Insert( _task );
+						} else {
+							_task->m_Service = NULL;
+						}
+						const TimerHandler & _ref = _task->Handler;
+						TimerHandler _handler( _ref );
+						m_RunningTask = _task;
+						m_RunningThread = ThreadSys::SelfID( );
+						m_Lock.UnLock( );
+						__Execute( _handler );
+						m_Lock.Lock( );
+						m_RunningTask = NULL;
+					}
+				}
+				Uint64 _next = __NextExpire( );
+				// Stopping, keep the wakeup armed by Stop.
+				if ( _arm ) __Arm( Plib::Basic::AtomicLoad( &m_Running ) ? _next : 0 );
+				m_Lock.UnLock( );
+				return _next;
+			}
+
+			void __TimerThread( )
+			{
+				while ( Plib::Basic::AtomicLoad( &m_Running, Plib::Basic::AO_ACQUIRE ) ) {
+	#if _DEF_LINUX
+					__Advance( true );
+					Uint64 _count;
+					if ( ::read( m_TimerFd, &_count, sizeof(_count) ) < 0 && errno != EINTR )
+						break;
+	#else
+					Int32 _event = Plib::Basic::AtomicLoad( &m_WakeEvent );
+					Uint64 _next = __Advance( true );
+					Uint64 _now = NowTick( );
+					if ( _next <= _now ) continue;
+					Plib::Basic::FutexWait( &m_WakeEvent, _event,
+						(_next == (Uint64)-1) ? (Uint64)-1 : (_next - _now) * 1000 );
+	#endif
+				}
+			}
+
+		private:
+			TimerService( const TimerService & );
+			TimerService & operator = ( const TimerService & );
+
+		public:
+			TimerService( bool _startNow = false )
+				: m_NextTick( NowTick( ) ), m_Count( 0 ), m_RootCount( 0 ),
+				m_RunningTask( NULL ), m_RunningThread( 0 ), m_Running( 0 ),
+				m_ArmedTick( (Uint64)-1 )
+			{
+				CONSTRUCTURE;
+				::memset( m_Root, 0, sizeof(m_Root) );
+				::memset( m_Wheels, 0, sizeof(m_Wheels) );
+	#if _DEF_LINUX
+				m_TimerFd = ::timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC );
+	#else
+				m_WakeEvent = 0;
+	#endif
+				m_Thread.Jobs += std::make_pair( this, &TimerService::__TimerThread );
+				if ( _startNow ) Start( );
+			}
+			~TimerService( )
+			{
+				DESTRUCTURE;
+				Stop( );
+	#if _DEF_LINUX
+				if ( m_TimerFd >= 0 ) ::close( m_TimerFd );
+	#endif
+			}
+
+			// Shared service of the process, started on first use.
+			static INLINE TimerService & Default( )
+			{
+				// Thread globals must be destroyed after the service.
+				ThreadKernel::ThreadGlobalLock( );
+				ThreadKernel::ThreadGlobalMap( );
+				static TimerService _service( true );
+				return _service;
+			}
+
+			// Current tick, milliseconds of the monotonic clock.
+			static INLINE Uint64 NowTick( )
+			{
+				return Plib::Basic::MonotonicMicroSeconds( ) / 1000;
+			}
+
+			// Run the callbacks by the executor instead of the timer thread.
+			// Set it before scheduling any task.
+			INLINE void SetExecutor( const ExecutorT & _executor )
+			{
+				Locker _lock( m_Lock );
+				m_Executor = _executor;
+			}
+
+			// Start the timer thread.
+			bool Start( )
+			{
+	#if _DEF_LINUX
+				if ( m_TimerFd < 0 ) return false;
+	#endif
+				if ( Plib::Basic::AtomicExchange( &m_Running, (Int32)1 ) == 1 ) return false;
+				if ( !m_Thread.Start( ) ) {
+					Plib::Basic::AtomicStore( &m_Running, (Int32)0 );
+					return false;
+				}
+				return true;
+			}
+
+			// Stop the timer thread, the pending tasks are kept.
+			void Stop( )
+			{
+				if ( Plib::Basic::AtomicExchange( &m_Running, (Int32)0 ) == 0 ) return;
+				m_Lock.Lock( );
+				__Arm( 0 );
+				m_Lock.UnLock( );
+				m_Thread.Stop( );
+			}
+
+			// Run the expired tasks, for the loop driving the wheel itself.
+			// Return the milliseconds to the next task, (Uint64)-1 if none.
+			INLINE Uint64 Advance( )
+			{
+				Uint64 _next = __Advance( false );
+				if ( _next == (Uint64)-1 ) return _next;
+				Uint64 _now = NowTick( );
+				return (_next > _now) ? _next - _now : 0;
+			}
+
+			// Run the task after _delay milliseconds, then every _interval
+			// milliseconds if _interval is not 0.
+			// A pending task is moved to the new time.
+			bool Schedule( TimerTask & _task, Uint64 _delay, Uint64 _interval = 0 )
+			{
+				if ( _task.m_Service != NULL && _task.m_Service != this ) return false;
+				Uint64 _now = NowTick( );
+				Locker _lock( m_Lock );
+				if ( _task.m_Service != NULL ) __Unlink( &_task );
+				// Empty wheel, no need to walk the idle ticks.
+				if ( m_Count == 0 && _now > m_NextTick ) m_NextTick = _now;
+				_task.m_Expire = _now + _delay;
+				_task.m_Interval = _interval;
+				_task.m_Service = this;
+				__Insert( &_task );
+				if ( m_Running && _task.m_Expire < m_ArmedTick ) __Arm( _task.m_Expire );
+				return true;
+			}
+
+			// Move a pending task to _delay milliseconds later, keep the interval.
+			INLINE bool Reschedule( TimerTask & _task, Uint64 _delay )
+			{
+				if ( _task.m_Service != this ) return false;
+				return Schedule( _task, _delay, _task.m_Interval );
+			}
+
+			// Return false if the task is not pending.
+			// When the callback of the task is running on the timer thread,
+			// wait until it returns, unless called inside the callback.
+			bool Cancel( TimerTask & _task )
+			{
+				Locker _lock( m_Lock );
+				bool _pending = (_task.m_Service == this);
+				if ( _pending ) {
+					__Unlink( &_task );
+					_task.m_Service = NULL;
+				}
+				while ( m_RunningTask == &_task && m_RunningThread != ThreadSys::SelfID( ) ) {
+					m_Lock.UnLock( );
+					Plib::Basic::ThreadYield( );
+					m_Lock.Lock( );
+				}
+				return _pending;
+			}
+
+			INLINE Uint32 PendingCount( )
+			{
+				Locker _lock( m_Lock );
+				return m_Count;
+			}
+		};
+
+		INLINE TimerTask::~TimerTask( )
+		{
+			DESTRUCTURE;
+			if ( m_Service != NULL ) m_Service->Cancel( *this );
+		}
+	}
+}
+
+#endif // plib.threading.timerservice.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
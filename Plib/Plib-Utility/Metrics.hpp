@@ -0,0 +1,441 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Metrics.hpp
+* Propose  			: Lock free counters, gauges and latency histograms.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_UTILITY_METRICS_HPP_
+#define _PLIB_UTILITY_METRICS_HPP_
+
+#if _DEF_IOS
+#include "Atomic.hpp"
+#include "Locker.hpp"
+#else
+#include <Plib-Basic/Atomic.hpp>
+#include <Plib-Threading/Locker.hpp>
+#endif
+
+#include <vector>
+#include <sstream>
+
+namespace Plib
+{
+	namespace Utility
+	{
+		// Writers of a metric are spread over the shards, each thread
+		// always writes the same shard. Readers merge all shards.
+		enum { METRICS_SHARDS = 16 };
+
+		INLINE Uint32 MetricsShardIndex( )
+		{
+			static volatile Uint32 _next = 0;
+			static PLIB_THREAD_LOCAL Uint32 _index = (Uint32)-1;
+			if ( _index == (Uint32)-1 )
+				_index = Plib::Basic::AtomicFetchAdd( &_next, (Uint32)1 ) % METRICS_SHARDS;
+			return _index;
+		}
+
+		// Monotonic counter, such as requests or accepted connections.
+		class MetricCounter
+		{
+		protected:
+			struct __Shard {
+				volatile Int64						Value;
+				PLIB_CACHELINE_PAD( Pad, Int64 );
+			};
+			__Shard									m_Shards[METRICS_SHARDS];
+
+		private:
+			MetricCounter( const MetricCounter & );
+			MetricCounter & operator = ( const MetricCounter & );
+
+		public:
+			MetricCounter( ) { CONSTRUCTURE; Reset( ); }
+			~MetricCounter( ) { DESTRUCTURE; }
+
+			INLINE void Add( Int64 _value = 1 )
+			{
+				Plib::Basic::AtomicFetchAdd( &m_Shards[MetricsShardIndex( )].Value,
+					_value, Plib::Basic::AO_RELAXED );
+			}
+
+			INLINE Int64 Value( ) const
+			{
+				Int64 _sum = 0;
+				for ( Uint32 i = 0; i < METRICS_SHARDS; ++i )
+					_sum += Plib::Basic::AtomicLoad( &m_Shards[i].Value, Plib::Basic::AO_RELAXED );
+				return _sum;
+			}
+
+			INLINE void Reset( )
+			{
+				for ( Uint32 i = 0; i < METRICS_SHARDS; ++i ) m_Shards[i].Value = 0;
+			}
+		};
+
+		// Current level, such as queue depth or connections.
+		class MetricGauge
+		{
+		protected:
+			volatile Int64							m_Value;
+
+		private:
+			MetricGauge( const MetricGauge & );
+			MetricGauge & operator = ( const MetricGauge & );
+
+		public:
+			MetricGauge( ) : m_Value( 0 ) { CONSTRUCTURE; }
+			~MetricGauge( ) { DESTRUCTURE; }
+
+			INLINE void Set( Int64 _value )
+			{
+				Plib::Basic::AtomicStore( &m_Value, _value, Plib::Basic::AO_RELAXED );
+			}
+			INLINE void Add( Int64 _value = 1 )
+			{
+				Plib::Basic::AtomicFetchAdd( &m_Value, _value, Plib::Basic::AO_RELAXED );
+			}
+			INLINE void Sub( Int64 _value = 1 )
+			{
+				Plib::Basic::AtomicFetchSub( &m_Value, _value, Plib::Basic::AO_RELAXED );
+			}
+			INLINE Int64 Value( ) const
+			{
+				return Plib::Basic::AtomicLoad( &m_Value, Plib::Basic::AO_RELAXED );
+			}
+		};
+
+		/*
+		 * Log linear buckets like HDR histogram.
+		 * Values below 16 are exact, then each power of two is split
+		 * into 16 buckets, the error is less than 1/16 (6.25%).
+		 * Values larger than 2^40 go to the last bucket.
+		 */
+		class HistogramBuckets
+		{
+		public:
+			enum {
+				SUB_BITS		= 4,
+				SUB_COUNT		= 1 << SUB_BITS,
+				MAX_EXP			= 40,
+				BUCKET_COUNT	= (MAX_EXP - SUB_BITS + 2) * SUB_COUNT
+			};
+
+			static INLINE Uint32 Index( Uint64 _value )
+			{
+				if ( _value < SUB_COUNT ) return (Uint32)_value;
+		#if _DEF_WIN32
+				unsigned long _bit;
+				_BitScanReverse64( &_bit, _value );
+				Uint32 _exp = (Uint32)_bit;
+		#else
+				Uint32 _exp = 63 - (Uint32)__builtin_clzll( _value );
+		#endif
+				if ( _exp > MAX_EXP ) return BUCKET_COUNT - 1;
+				return (_exp - SUB_BITS + 1) * SUB_COUNT +
+					(Uint32)((_value >> (_exp - SUB_BITS)) & (SUB_COUNT - 1));
+			}
+
+			// The largest value of the bucket.
+			static INLINE Uint64 HighestValue( Uint32 _index )
+			{
+				if ( _index < SUB_COUNT ) return _index;
+				Uint32 _exp = _index / SUB_COUNT + SUB_BITS - 1;
+				Uint64 _low = (Uint64)(SUB_COUNT + _index % SUB_COUNT) << (_exp - SUB_BITS);
+				return _low + ((Uint64)1 << (_exp - SUB_BITS)) - 1;
+			}
+		};
+
+		// Merged copy of a histogram.
+		class HistogramSnapshot
+		{
+		protected:
+			Uint64									m_Buckets[HistogramBuckets::BUCKET_COUNT];
+			Uint64									m_Count;
+			Uint64									m_Sum;
+			Uint64									m_Max;
+
+			friend class MetricHistogram;
+		public:
+			HistogramSnapshot( ) : m_Count( 0 ), m_Sum( 0 ), m_Max( 0 )
+			{
+				::memset( m_Buckets, 0, sizeof(m_Buckets) );
+			}
+
+			INLINE Uint64 Count( ) const { return m_Count; }
+			INLINE Uint64 Max( ) const { return m_Max; }
+			INLINE double Mean( ) const { return m_Count ? (double)m_Sum / (double)m_Count : 0.0; }
+
+			// _percent in [0, 100].
+			INLINE Uint64 Percentile( double _percent ) const
+			{
+				if ( m_Count == 0 ) return 0;
+				Uint64 _rank = (Uint64)(_percent / 100.0 * (double)m_Count + 0.5);
+				if ( _rank == 0 ) _rank = 1;
+				if ( _rank > m_Count ) _rank = m_Count;
+				Uint64 _seen = 0;
+				for ( Uint32 i = 0; i < HistogramBuckets::BUCKET_COUNT; ++i ) {
+					_seen += m_Buckets[i];
+					if ( _seen < _rank ) continue;
+					Uint64 _value = HistogramBuckets::HighestValue( i );
+					return ( _value > m_Max ) ? m_Max : _value;
+				}
+				return m_Max;
+			}
+		};
+
+		// Latency histogram, usually in micro seconds.
+		class MetricHistogram
+		{
+		protected:
+			struct __Shard {
+				volatile Uint64						Buckets[HistogramBuckets::BUCKET_COUNT];
+				volatile Uint64						Sum;
+				volatile Uint64						Max;
+				PLIB_CACHELINE_PAD( Pad, Uint64 );
+			};
+			// Big, keep it out of the owner object.
+			__Shard *								m_Shards;
+
+		private:
+			MetricHistogram( const MetricHistogram & );
+			MetricHistogram & operator = ( const MetricHistogram & );
+
+		public:
+			MetricHistogram( )
+			{
+				CONSTRUCTURE;
+				PMALLOC( __Shard, m_Shards, sizeof(__Shard) * METRICS_SHARDS );
+				Reset( );
+			}
+			~MetricHistogram( )
+			{
+				DESTRUCTURE;
+				PFREE( m_Shards );
+			}
+
+			INLINE void Record( Uint64 _value )
+			{
+				__Shard & _shard = m_Shards[MetricsShardIndex( )];
+				Plib::Basic::AtomicFetchAdd( &_shard.Buckets[HistogramBuckets::Index( _value )],
+					(Uint64)1, Plib::Basic::AO_RELAXED );
+				Plib::Basic::AtomicFetchAdd( &_shard.Sum, _value, Plib::Basic::AO_RELAXED );
+				Uint64 _max = Plib::Basic::AtomicLoad( &_shard.Max, Plib::Basic::AO_RELAXED );
+				while ( _value > _max && !Plib::Basic::AtomicCompareExchange(
+					&_shard.Max, _max, _value, Plib::Basic::AO_RELAXED ) );
+			}
+
+			// Merge all shards. Writers are not stopped, the copy is
+			// consistent per bucket only.
+			INLINE void Snapshot( HistogramSnapshot & _snap ) const
+			{
+				::memset( _snap.m_Buckets, 0, sizeof(_snap.m_Buckets) );
+				_snap.m_Count = _snap.m_Sum = _snap.m_Max = 0;
+				for ( Uint32 s = 0; s < METRICS_SHARDS; ++s ) {
+					const __Shard & _shard = m_Shards[s];
+					for ( Uint32 i = 0; i < HistogramBuckets::BUCKET_COUNT; ++i ) {
+						Uint64 _c = Plib::Basic::AtomicLoad( &_shard.Buckets[i], Plib::Basic::AO_RELAXED );
+						_snap.m_Buckets[i] += _c;
+						_snap.m_Count += _c;
+					}
+					_snap.m_Sum += Plib::Basic::AtomicLoad( &_shard.Sum, Plib::Basic::AO_RELAXED );
+					Uint64 _max = Plib::Basic::AtomicLoad( &_shard.Max, Plib::Basic::AO_RELAXED );
+					if ( _max > _snap.m_Max ) _snap.m_Max = _max;
+				}
+			}
+
+			INLINE void Reset( )
+			{
+				::memset( (void *)m_Shards, 0, sizeof(__Shard) * METRICS_SHARDS );
+			}
+		};
+
+		typedef enum {
+			MF_TEXT = 0,	// One metric each line.
+			MF_JSON			// One json object.
+		} MetricsFormat;
+
+		/*
+		 * Named metrics.
+		 * Looking up a metric takes a lock, keep the reference and
+		 * update it without any lock. Metrics owned by other objects
+		 * can be registered, they must live longer than the registry
+		 * is dumped.
+		 */
+		class MetricsRegistry
+		{
+		protected:
+			enum { MK_COUNTER, MK_GAUGE, MK_HISTOGRAM };
+			struct __Item {
+				std::string							Name;
+				Uint32								Kind;
+				void *								Metric;
+				bool								Owned;
+			};
+			std::vector< __Item >					m_Items;
+			Plib::Threading::Mutex					m_Lock;
+
+			INLINE void * __Find( const std::string & _name, Uint32 _kind )
+			{
+				for ( Uint32 i = 0; i < m_Items.size( ); ++i )
+					if ( m_Items[i].Kind == _kind && m_Items[i].Name == _name )
+						return m_Items[i].Metric;
+				return NULL;
+			}
+
+			INLINE void __Add( const std::string & _name, Uint32 _kind, void * _metric, bool _owned )
+			{
+				__Item _item;
+				_item.Name = _name;
+				_item.Kind = _kind;
+				_item.Metric = _metric;
+				_item.Owned = _owned;
+				m_Items.push_back( _item );
+			}
+
+			template < typename _TyMetric, Uint32 _Kind >
+			INLINE _TyMetric & __Get( const std::string & _name )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				void * _metric = __Find( _name, _Kind );
+				if ( _metric != NULL ) return *(_TyMetric *)_metric;
+				_TyMetric * _new;
+				PNEW( _TyMetric, _new );
+				__Add( _name, _Kind, _new, true );
+				return *_new;
+			}
+
+			static INLINE void __JsonName( std::ostream & _os, const std::string & _name )
+			{
+				_os << '"';
+				for ( Uint32 i = 0; i < _name.size( ); ++i ) {
+					if ( _name[i] == '"' || _name[i] == '\\' ) _os << '\\';
+					_os << _name[i];
+				}
+				_os << "\":";
+			}
+
+		private:
+			MetricsRegistry( const MetricsRegistry & );
+			MetricsRegistry & operator = ( const MetricsRegistry & );
+
+		public:
+			MetricsRegistry( ) { CONSTRUCTURE; }
+			~MetricsRegistry( )
+			{
+				DESTRUCTURE;
+				for ( Uint32 i = 0; i < m_Items.size( ); ++i ) {
+					if ( !m_Items[i].Owned ) continue;
+					if ( m_Items[i].Kind == MK_COUNTER ) {
+						MetricCounter * _counter = (MetricCounter *)m_Items[i].Metric;
+						PDELETE( _counter );
+					} else if ( m_Items[i].Kind == MK_GAUGE ) {
+						MetricGauge * _gauge = (MetricGauge *)m_Items[i].Metric;
+						PDELETE( _gauge );
+					} else {
+						MetricHistogram * _histogram = (MetricHistogram *)m_Items[i].Metric;
+						PDELETE( _histogram );
+					}
+				}
+			}
+
+			// Metrics of the process.
+			static INLINE MetricsRegistry & Global( )
+			{
+				static MetricsRegistry _registry;
+				return _registry;
+			}
+
+			// Get or create the metric.
+			INLINE MetricCounter & Counter( const std::string & _name )
+			{
+				return __Get< MetricCounter, MK_COUNTER >( _name );
+			}
+			INLINE MetricGauge & Gauge( const std::string & _name )
+			{
+				return __Get< MetricGauge, MK_GAUGE >( _name );
+			}
+			INLINE MetricHistogram & Histogram( const std::string & _name )
+			{
+				return __Get< MetricHistogram, MK_HISTOGRAM >( _name );
+			}
+
+			// Register a metric owned by the caller.
+			INLINE void Register( const std::string & _name, MetricCounter & _metric )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				__Add( _name, MK_COUNTER, &_metric, false );
+			}
+			INLINE void Register( const std::string & _name, MetricGauge & _metric )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				__Add( _name, MK_GAUGE, &_metric, false );
+			}
+			INLINE void Register( const std::string & _name, MetricHistogram & _metric )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				__Add( _name, MK_HISTOGRAM, &_metric, false );
+			}
+
+			// Dump all metrics in the order of registration.
+			std::string Snapshot( MetricsFormat _format = MF_TEXT )
+			{
+				static const double _percents[] = { 50, 90, 99, 99.9 };
+				static const char * _labels[] = { "p50", "p90", "p99", "p999" };
+				std::ostringstream _os;
+				HistogramSnapshot * _hs;
+				PNEW( HistogramSnapshot, _hs );
+				Plib::Threading::Locker _lock( m_Lock );
+				if ( _format == MF_JSON ) _os << '{';
+				for ( Uint32 i = 0; i < m_Items.size( ); ++i ) {
+					const __Item & _item = m_Items[i];
+					if ( _format == MF_JSON ) {
+						if ( i > 0 ) _os << ',';
+						__JsonName( _os, _item.Name );
+					} else {
+						_os << _item.Name << ' ';
+					}
+					if ( _item.Kind == MK_COUNTER ) {
+						_os << ((MetricCounter *)_item.Metric)->Value( );
+					} else if ( _item.Kind == MK_GAUGE ) {
+						_os << ((MetricGauge *)_item.Metric)->Value( );
+					} else {
+						((MetricHistogram *)_item.Metric)->Snapshot( *_hs );
+						const char * _sep = (_format == MF_JSON) ? "," : " ";
+						const char * _eq = (_format == MF_JSON) ? "\":" : "=";
+						const char * _q = (_format == MF_JSON) ? "\"" : "";
+						if ( _format == MF_JSON ) _os << '{';
+						_os << _q << "count" << _eq << _hs->Count( ) << _sep
+							<< _q << "mean" << _eq << (Uint64)_hs->Mean( );
+						for ( Uint32 p = 0; p < 4; ++p )
+							_os << _sep << _q << _labels[p] << _eq << _hs->Percentile( _percents[p] );
+						_os << _sep << _q << "max" << _eq << _hs->Max( );
+						if ( _format == MF_JSON ) _os << '}';
+					}
+					if ( _format == MF_TEXT ) _os << '\n';
+				}
+				if ( _format == MF_JSON ) _os << '}';
+				PDELETE( _hs );
+				return _os.str( );
+			}
+		};
+	}
+}
+
+#endif // plib.utility.metrics.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
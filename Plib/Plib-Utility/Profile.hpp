@@ -0,0 +1,270 @@
+/*
+* Copyright (c) 2010, Push Chen
+* All rights reserved.
+*
+* File Name			: Profile.hpp
+* Propose  			: Scoped profiling zones, exported as chrome trace.
+*
+* Current Version	: 1.0
+* Change Log		: First Definition.
+* Author			: Push Chen
+* Change Date		: 2026-10-19
+*/
+
+#pragma once
+
+#ifndef _PLIB_UTILITY_PROFILE_HPP_
+#define _PLIB_UTILITY_PROFILE_HPP_
+
+#if _DEF_IOS
+#include "Atomic.hpp"
+#include "Locker.hpp"
+#include "Stopwatch.hpp"
+#else
+#include <Plib-Basic/Atomic.hpp>
+#include <Plib-Threading/Locker.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#endif
+
+#include <vector>
+
+namespace Plib
+{
+	namespace Utility
+	{
+		// One finished zone, the time is in cycles of MonotonicClock.
+		struct ProfileEvent
+		{
+			const char *							Name;
+			Uint64									Begin;
+			Uint64									End;
+		};
+
+		/*
+		 * Ring buffer of one thread.
+		 * Only the owner thread writes, the exporter reads the events
+		 * before the published head. The oldest events are overwritten
+		 * when the buffer is full.
+		 */
+		class ProfileBuffer
+		{
+		public:
+			enum { PROFILE_BUFFER_EVENTS = 16384 };
+
+			ProfileEvent							Events[PROFILE_BUFFER_EVENTS];
+			volatile Uint64							Head;
+			Uint32									ThreadIndex;
+
+			ProfileBuffer( Uint32 _index ) : Head( 0 ), ThreadIndex( _index ) { CONSTRUCTURE; }
+			~ProfileBuffer( ) { DESTRUCTURE; }
+
+			INLINE void Push( const char * _name, Uint64 _begin, Uint64 _end )
+			{
+				Uint64 _head = Head;
+				ProfileEvent & _event = Events[_head % PROFILE_BUFFER_EVENTS];
+				_event.Name = _name;
+				_event.Begin = _begin;
+				_event.End = _end;
+				Plib::Basic::AtomicStore( &Head, _head + 1, Plib::Basic::AO_RELEASE );
+			}
+		};
+
+		/*
+		 * Profiler.
+		 * Disabled by default, a disabled zone costs one load and one
+		 * branch. Define PLIB_PROFILE_DISABLE to compile all zones out.
+		 * Export after Disable, or the export may see some events being
+		 * overwritten by the running threads.
+		 */
+		class Profiler
+		{
+		protected:
+			std::vector< ProfileBuffer * >			m_Buffers;
+			Plib::Threading::Mutex					m_Lock;
+			volatile Int32							m_Enabled;
+			Uint64									m_Origin;
+
+			static INLINE ProfileBuffer * & __LocalBuffer( )
+			{
+				static PLIB_THREAD_LOCAL ProfileBuffer * _buffer = NULL;
+				return _buffer;
+			}
+
+			// First zone of the thread, the buffer is kept until exit
+			// so the events of finished threads can still be exported.
+			INLINE ProfileBuffer * __NewBuffer( )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				ProfileBuffer * _buffer;
+				PNEWPARAM( ProfileBuffer, _buffer, (Uint32)m_Buffers.size( ) + 1 );
+				m_Buffers.push_back( _buffer );
+				return _buffer;
+			}
+
+			// Copy the published events of all threads.
+			INLINE void __Collect( std::vector< ProfileEvent > & _events,
+				std::vector< Uint32 > & _threads )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				for ( Uint32 b = 0; b < m_Buffers.size( ); ++b ) {
+					ProfileBuffer * _buffer = m_Buffers[b];
+					Uint64 _head = Plib::Basic::AtomicLoad( &_buffer->Head, Plib::Basic::AO_ACQUIRE );
+					Uint64 _first = ( _head > ProfileBuffer::PROFILE_BUFFER_EVENTS ) ?
+						_head - ProfileBuffer::PROFILE_BUFFER_EVENTS : 0;
+					for ( Uint64 i = _first; i < _head; ++i ) {
+						_events.push_back( _buffer->Events[i % ProfileBuffer::PROFILE_BUFFER_EVENTS] );
+						_threads.push_back( _buffer->ThreadIndex );
+					}
+				}
+			}
+
+			INLINE Uint64 __ToNanoSeconds( Uint64 _cycles ) const
+			{
+				Uint64 _offset = ( _cycles > m_Origin ) ? _cycles - m_Origin : 0;
+				return (Uint64)((double)_offset / Plib::Threading::MonotonicClock::CyclesPerNanoSecond( ));
+			}
+
+		private:
+			Profiler( const Profiler & );
+			Profiler & operator = ( const Profiler & );
+
+		public:
+			Profiler( ) : m_Enabled( 0 ), m_Origin( 0 ) { CONSTRUCTURE; }
+			~Profiler( )
+			{
+				DESTRUCTURE;
+				for ( Uint32 i = 0; i < m_Buffers.size( ); ++i ) {
+					ProfileBuffer * _buffer = m_Buffers[i];
+					PDELETE( _buffer );
+				}
+			}
+
+			static INLINE Profiler & Instance( )
+			{
+				static Profiler _profiler;
+				return _profiler;
+			}
+
+			INLINE bool Enabled( ) const
+			{
+				return Plib::Basic::AtomicLoad( &m_Enabled, Plib::Basic::AO_RELAXED ) != 0;
+			}
+
+			INLINE void Enable( )
+			{
+				// Calibrate the clock before the first zone.
+				Plib::Threading::MonotonicClock::CyclesPerNanoSecond( );
+				if ( m_Origin == 0 ) m_Origin = Plib::Threading::MonotonicClock::Cycles( );
+				Plib::Basic::AtomicStore( &m_Enabled, (Int32)1, Plib::Basic::AO_RELAXED );
+			}
+			INLINE void Disable( )
+			{
+				Plib::Basic::AtomicStore( &m_Enabled, (Int32)0, Plib::Basic::AO_RELAXED );
+			}
+
+			INLINE void Record( const char * _name, Uint64 _begin, Uint64 _end )
+			{
+				ProfileBuffer * & _buffer = __LocalBuffer( );
+				if ( _buffer == NULL ) _buffer = __NewBuffer( );
+				_buffer->Push( _name, _begin, _end );
+			}
+
+			// Chrome trace event json, open it in chrome://tracing or perfetto.
+			bool ExportChromeTrace( const char * _path )
+			{
+				FILE * _file = fopen( _path, "w" );
+				if ( _file == NULL ) return false;
+				std::vector< ProfileEvent > _events;
+				std::vector< Uint32 > _threads;
+				__Collect( _events, _threads );
+				fputs( "{\"traceEvents\":[", _file );
+				for ( Uint32 i = 0; i < _events.size( ); ++i ) {
+					Uint64 _begin = __ToNanoSeconds( _events[i].Begin );
+					Uint64 _end = __ToNanoSeconds( _events[i].End );
+					fprintf( _file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+						"\"ts\":%llu.%03u,\"dur\":%llu.%03u}", (i == 0 ? "" : ",\n"),
+						_events[i].Name, _threads[i],
+						(unsigned long long)(_begin / 1000), (Uint32)(_begin % 1000),
+						(unsigned long long)((_end - _begin) / 1000), (Uint32)((_end - _begin) % 1000) );
+				}
+				fputs( "]}\n", _file );
+				return fclose( _file ) == 0;
+			}
+
+			// Compact binary file:
+			// "PLIBPROF", Uint32 version, Uint64 event count, then each event
+			// as Uint32 thread, Uint64 begin ns, Uint64 duration ns,
+			// Uint16 name length and the name.
+			bool ExportBinary( const char * _path )
+			{
+				FILE * _file = fopen( _path, "wb" );
+				if ( _file == NULL ) return false;
+				std::vector< ProfileEvent > _events;
+				std::vector< Uint32 > _threads;
+				__Collect( _events, _threads );
+				Uint32 _version = 1;
+				Uint64 _count = _events.size( );
+				fwrite( "PLIBPROF", 1, 8, _file );
+				fwrite( &_version, sizeof(_version), 1, _file );
+				fwrite( &_count, sizeof(_count), 1, _file );
+				for ( Uint32 i = 0; i < _events.size( ); ++i ) {
+					Uint64 _begin = __ToNanoSeconds( _events[i].Begin );
+					Uint64 _duration = __ToNanoSeconds( _events[i].End ) - _begin;
+					Uint16 _length = (Uint16)strlen( _events[i].Name );
+					fwrite( &_threads[i], sizeof(Uint32), 1, _file );
+					fwrite( &_begin, sizeof(_begin), 1, _file );
+					fwrite( &_duration, sizeof(_duration), 1, _file );
+					fwrite( &_length, sizeof(_length), 1, _file );
+					fwrite( _events[i].Name, 1, _length, _file );
+				}
+				return fclose( _file ) == 0;
+			}
+
+			// Drop all recorded events, call it after Disable.
+			INLINE void Clear( )
+			{
+				Plib::Threading::Locker _lock( m_Lock );
+				for ( Uint32 i = 0; i < m_Buffers.size( ); ++i )
+					Plib::Basic::AtomicStore( &m_Buffers[i]->Head, (Uint64)0 );
+			}
+		};
+
+		// Record the scope as one event, the name must be a literal.
+		class ProfileZone
+		{
+			const char *							m_Name;
+			Uint64									m_Begin;
+		public:
+			ProfileZone( const char * _name )
+				: m_Name( Profiler::Instance( ).Enabled( ) ? _name : NULL ), m_Begin( 0 )
+			{
+				if ( m_Name != NULL ) m_Begin = Plib::Threading::MonotonicClock::Cycles( );
+			}
+			~ProfileZone( )
+			{
+				if ( m_Name == NULL ) return;
+				Profiler::Instance( ).Record( m_Name, m_Begin,
+					Plib::Threading::MonotonicClock::Cycles( ) );
+			}
+		};
+	}
+}
+
+#define PLIB_PROFILE_CONCAT_( _a, _b )		_a##_b
+#define PLIB_PROFILE_CONCAT( _a, _b )		PLIB_PROFILE_CONCAT_( _a, _b )
+
+#ifndef PLIB_PROFILE_DISABLE
+#define PLIB_PROFILE_ZONE( _Name )			\
+	Plib::Utility::ProfileZone PLIB_PROFILE_CONCAT( __plib_zone_, __LINE__ )( _Name )
+#else
+#define PLIB_PROFILE_ZONE( _Name )
+#endif
+
+#endif // plib.utility.profile.hpp
+
+/*
+ Push Chen.
+ littlepush@gmail.com
+ http://pushchen.com
+ http://twitter.com/littlepush
+ */
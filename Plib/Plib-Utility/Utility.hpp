@@ -20,10 +20,14 @@
 #include "Debug.hpp"
 #include "Encode.hpp"
 #include "Random.hpp"
+#include "Metrics.hpp"
+#include "Profile.hpp"
 #else
 #include <Plib-Utility/Debug.hpp>
 #include <Plib-Utility/Encode.hpp>
 #include <Plib-Utility/Random.hpp>
+#include <Plib-Utility/Metrics.hpp>
+#include <Plib-Utility/Profile.hpp>
 #endif
 
 #endif // plib.utility.utility.hpp
@@ -0,0 +1,101 @@
+#include <Plib-Network/Admission.hpp>
+#include <Plib-Generic/LockFreeQueue.hpp>
+#include <Plib-Utility/Metrics.hpp>
+#include <Plib-Threading/Thread.hpp>
+#include <iostream>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Utility;
+using namespace Plib::Threading;
+
+// One worker serves a request in 200us, the requests come 1.5 times
+// faster for two seconds, then at half the capacity for one second.
+// Without the admission the queue delay grows all the time, the depth
+// bound caps it at the bound, CoDel keeps most of it under twice the
+// target.
+
+#define BENCH_SERVICE		200		// us
+#define BENCH_OVERLOAD		2000	// ms
+#define BENCH_RECOVER		1000	// ms
+
+typedef Admitted< Uint32 >												TItem;
+typedef Plib::Generic::BlockingQueue< Plib::Generic::MpmcQueue< TItem > >	TQueue;
+
+TQueue					gQueue;
+AdmissionControl		gAdmission;
+MetricHistogram			gDelay;
+MetricHistogram			gRecoverDelay;
+volatile Int32			gServed;
+volatile Int32			gShed;
+volatile Int32			gRecovering;
+volatile Int32			gDone;
+
+void Spin( Uint64 _us )
+{
+	Uint64 _end = Plib::Basic::MonotonicMicroSeconds( ) + _us;
+	while ( Plib::Basic::MonotonicMicroSeconds( ) < _end );
+}
+
+void Worker( )
+{
+	TItem _item;
+	while ( !Plib::Basic::AtomicLoad( &gDone ) || gQueue.PopN( &_item, 0 ) != 0 ) {
+		if ( !gQueue.Pop( _item, 10 ) ) continue;
+		Uint64 _delay = Plib::Basic::MonotonicMicroSeconds( ) - _item.Since;
+		if ( !gAdmission.Leave( _item.Since ) ) {
+			// The rejection costs nearly nothing.
+			Plib::Basic::AtomicFetchAdd( &gShed, (Int32)1 );
+			continue;
+		}
+		gDelay.Record( _delay );
+		if ( Plib::Basic::AtomicLoad( &gRecovering ) ) gRecoverDelay.Record( _delay );
+		Spin( BENCH_SERVICE );
+		Plib::Basic::AtomicFetchAdd( &gServed, (Int32)1 );
+	}
+}
+
+void Produce( Uint64 _interval, Uint32 _mileSec )
+{
+	Uint64 _start = Plib::Basic::MonotonicMicroSeconds( );
+	Uint64 _next = _start;
+	while ( _next < _start + (Uint64)_mileSec * 1000 ) {
+		while ( Plib::Basic::MonotonicMicroSeconds( ) < _next ) ThreadSys::Sleep( 0 );
+		if ( gAdmission.Enter( ) ) gQueue.Push( TItem( 0 ) );
+		else Plib::Basic::AtomicFetchAdd( &gShed, (Int32)1 );
+		_next += _interval;
+	}
+}
+
+void RunBench( const char * _name, Uint32 _depth, Uint32 _target )
+{
+	gAdmission.Set( _depth, _target, 100000 );
+	gDelay.Reset( );
+	gRecoverDelay.Reset( );
+	gServed = gShed = gRecovering = gDone = 0;
+
+	Thread< void( ) > _worker;
+	_worker.Jobs += Worker;
+	_worker.Start( );
+	Produce( BENCH_SERVICE * 2 / 3, BENCH_OVERLOAD );
+	gRecovering = 1;
+	Produce( BENCH_SERVICE * 2, BENCH_RECOVER );
+	gDone = 1;
+	_worker.Stop( false );
+	_worker.WaitUntilStop( );
+
+	HistogramSnapshot _all, _recover;
+	gDelay.Snapshot( _all );
+	gRecoverDelay.Snapshot( _recover );
+	std::cout << _name << ": served " << gServed << ", shed " << gShed
+		<< ", queue delay p50 " << _all.Percentile( 50 ) << "us p99 " << _all.Percentile( 99 )
+		<< "us, after overload p99 " << _recover.Percentile( 99 ) << "us" << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	RunBench( "no admission  ", 0, 0 );
+	RunBench( "depth 256     ", 256, 0 );
+	RunBench( "codel 5ms     ", 0, 5000 );
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <Plib-Network/Network.hpp>
+
+using namespace Plib;
+using namespace Plib::Generic;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// Calls to a local listener on loopback, a new connection for each call
+// against the connection borrowed from the pool.
+
+#define BENCH_PORT			6544
+#define BENCH_CALLS			2000
+
+typedef ListenerFrame< Selector< SyncSock > >	TL;
+
+struct ListenGT
+{
+	static TL		gtl;
+};
+
+TL ListenGT::gtl;
+
+// Keep the accepted connections open.
+void TestWorking( )
+{
+	while( ThreadSys::Running( ) )
+	{
+		TL::RefSocketT rSock = ListenGT::gtl.GetReadableSocket( 100 );
+		if ( rSock.RefNull( ) ) continue;
+		ListenGT::gtl.ReleaseSocket( rSock, rSock->IsConnect( ) );
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	ListenGT::gtl.Listen( BENCH_PORT );
+	Thread< void( void ) > tW;
+	tW.Jobs += TestWorking;
+	tW.Start();
+
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_CALLS; ++i ) {
+		SyncSock _so;
+		_so.Connect( "localhost", BENCH_PORT, 1000 );
+	}
+	_sw.Tick( );
+	std::cout << "connect each call: " << _sw.GetMileSecUsed( ) * 1000 / BENCH_CALLS << "us" << std::endl;
+
+	ClientPool< SyncSock > _pool( 2, 8 );
+	_pool.Warmup( "localhost", BENCH_PORT, 2 );
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_CALLS; ++i ) {
+		ClientPool< SyncSock >::RpConnect _cnnt = _pool.Borrow( "localhost", BENCH_PORT );
+		_pool.Return( "localhost", BENCH_PORT, _cnnt );
+	}
+	_sw.Tick( );
+	std::cout << "pooled call:       " << _sw.GetMileSecUsed( ) * 1000 / BENCH_CALLS << "us, created "
+		<< _pool.CreatedCount( ) << ", reused " << _pool.ReusedCount( ) << std::endl;
+
+	// The idle ones over MaxIdleTime are closed, MinIdle is refilled.
+	_pool.SetMaxIdleTime( 1 );
+	usleep( 5000 );
+	Uint32 _closed = _pool.HealthCheck( );
+	std::cout << "health check closed " << _closed << ", idle "
+		<< _pool.IdleCount( "localhost", BENCH_PORT ) << std::endl;
+
+	tW.Stop( );
+	return 0;
+}
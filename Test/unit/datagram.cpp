@@ -0,0 +1,119 @@
+#include <Plib-Network/DatagramService.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <iostream>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// Loopback echo, packets per second of the service.
+// Each client sends a burst and waits for the replies, a lost packet
+// only costs the receive time out of its burst.
+// It includes Plib-Text, which does not build in this tree yet. The
+// rates quoted with the service were measured against a stub of the
+// text module and are not verified on the real library.
+
+#define BENCH_CLIENTS		8
+#define BENCH_BURST			32
+#define BENCH_PAYLOAD		64
+#define BENCH_TIME			2000	// ms
+
+struct TEchoParser
+{
+	SOCKEVENTSTATUE ParseDatagram( const FrameView & _datagram )
+	{
+		return ( _datagram.Length > 0 ) ? SOEVENT_DONE : SOEVENT_ILLEAGE;
+	}
+	void Clear( ) { }
+};
+
+typedef DatagramService< TEchoParser >		TService;
+
+void Echo( TService::TRequest & _req )
+{
+	_req.Reply( _req.Data.Data, _req.Data.Length );
+}
+
+Uint32				gPort;
+volatile Int32		gReplies;
+
+void Client( Uint32 _index )
+{
+	int _so = ::socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	struct timeval _timeout = { 0, 20000 };
+	setsockopt( _so, SOL_SOCKET, SO_RCVTIMEO, &_timeout, sizeof(_timeout) );
+	struct sockaddr_in _addr;
+	memset( &_addr, 0, sizeof(_addr) );
+	_addr.sin_family = AF_INET;
+	_addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	_addr.sin_port = htons( gPort );
+	connect( _so, (struct sockaddr *)&_addr, sizeof(_addr) );
+
+	char _payload[BENCH_PAYLOAD];
+	memset( _payload, 'a' + _index, sizeof(_payload) );
+	struct mmsghdr _msgs[BENCH_BURST];
+	struct iovec _iovs[BENCH_BURST];
+	char _replies[BENCH_BURST][BENCH_PAYLOAD];
+	while ( ThreadSys::Running( ) ) {
+		for ( Uint32 i = 0; i < BENCH_BURST; ++i ) {
+			memset( &_msgs[i], 0, sizeof(_msgs[i]) );
+			_iovs[i].iov_base = _payload;
+			_iovs[i].iov_len = sizeof(_payload);
+			_msgs[i].msg_hdr.msg_iov = &_iovs[i];
+			_msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		sendmmsg( _so, _msgs, BENCH_BURST, 0 );
+		for ( Uint32 _got = 0; _got < BENCH_BURST; ) {
+			for ( Uint32 i = 0; i < BENCH_BURST; ++i ) {
+				_iovs[i].iov_base = _replies[i];
+				_iovs[i].iov_len = BENCH_PAYLOAD;
+			}
+			int _ret = recvmmsg( _so, _msgs, BENCH_BURST - _got, MSG_WAITFORONE, NULL );
+			if ( _ret <= 0 ) break;
+			_got += _ret;
+			Plib::Basic::AtomicFetchAdd( &gReplies, (Int32)_ret );
+		}
+	}
+	close( _so );
+}
+
+void RunBench( const char * _name, Uint32 _batchSize, Uint32 _shards, bool _segment = false )
+{
+	TService _service;
+	_service.WorkProcess = Echo;
+	_service.SetBatchSize( _batchSize );
+	_service.SetShards( _shards );
+	_service.SetGro( _segment );
+	_service.SetGso( _segment );
+	if ( !_service.StartServer( 0, 2 ) ) {
+		std::cout << _name << ": failed to start" << std::endl;
+		return;
+	}
+	gPort = _service.Port( );
+	gReplies = 0;
+
+	Thread< void( Uint32 ) > _clients[BENCH_CLIENTS];
+	for ( Uint32 i = 0; i < BENCH_CLIENTS; ++i ) {
+		_clients[i].Jobs += Client;
+		_clients[i].Start( i );
+	}
+	StopWatch _sw;
+	ThreadSys::Sleep( BENCH_TIME );
+	_sw.Tick( );
+	Int32 _replies = Plib::Basic::AtomicLoad( &gReplies );
+	for ( Uint32 i = 0; i < BENCH_CLIENTS; ++i ) _clients[i].Stop( );
+	_service.StopServer( );
+
+	double _pps = (double)_replies * 1000.0 / (double)_sw.GetMileSecUsed( );
+	std::cout << _name << ": " << (Uint64)_pps << " packets/s, "
+		<< _service.Metrics.Counter( "datagram.batches" ).Value( ) << " batches" << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	RunBench( "one by one      ", 1, 1 );
+	RunBench( "recvmmsg 64     ", 64, 1 );
+	RunBench( "recvmmsg 64 x2  ", 64, 2 );
+	RunBench( "gro + gso 64    ", 64, 1, true );
+	return 0;
+}
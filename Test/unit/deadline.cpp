@@ -0,0 +1,85 @@
+#include <Plib-Network/Deadline.hpp>
+#include <Plib-Threading/Thread.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <iostream>
+#include <sys/socket.h>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// A work process calls a slow peer, which answers after 500ms. The
+// request has a budget of 100ms and the call has its own 1s timeout.
+// Without the deadline the call waits for the peer, with it the call
+// gives up when the budget is used. Also the cost of the checks on the
+// hot path.
+
+#define BENCH_PEER_DELAY	500		// ms
+#define BENCH_TIMEOUT		1000	// ms
+#define BENCH_BUDGET		100		// ms
+#define BENCH_CHECKS		10000000
+
+// An outgoing call as the request does it, the timeout is cut to the
+// deadline current in the thread.
+bool CallPeer( int _so, Uint32 _timeOut )
+{
+	Deadline _deadline = Deadline::Current( );
+	if ( _deadline.IsSet( ) ) _timeOut = _deadline.Clamp( _timeOut );
+	if ( _timeOut == 0 ) return false;
+	struct timeval _tv = { (time_t)( _timeOut / 1000 ), (suseconds_t)( ( _timeOut % 1000 ) * 1000 ) };
+	setsockopt( _so, SOL_SOCKET, SO_RCVTIMEO, &_tv, sizeof(_tv) );
+	char _byte;
+	return ::write( _so, "q", 1 ) == 1 && ::read( _so, &_byte, 1 ) == 1;
+}
+
+int gPeer[2];
+
+void Peer( )
+{
+	char _byte;
+	while ( ::read( gPeer[1], &_byte, 1 ) == 1 ) {
+		usleep( BENCH_PEER_DELAY * 1000 );
+		if ( ::send( gPeer[1], "a", 1, MSG_NOSIGNAL ) != 1 ) break;
+	}
+}
+
+void RunCall( const char * _name, Uint32 _budget )
+{
+	socketpair( AF_UNIX, SOCK_STREAM, 0, gPeer );
+	Thread< void( ) > _peer;
+	_peer.Jobs += Peer;
+	_peer.Start( );
+
+	// The service accepted the request now.
+	Deadline _deadline = Deadline::After( _budget );
+	StopWatch _sw;
+	bool _answered;
+	{
+		DeadlineScope _scope( _deadline );
+		_answered = CallPeer( gPeer[0], BENCH_TIMEOUT );
+	}
+	_sw.Tick( );
+	std::cout << _name << ": " << ( _answered ? "answered" : "gave up" ) << " after "
+		<< _sw.GetMileSecUsed( ) << "ms, budget left " << _deadline.Remaining( ) << "ms" << std::endl;
+
+	::shutdown( gPeer[0], SHUT_RDWR );
+	_peer.Stop( false );
+	_peer.WaitUntilStop( );
+	close( gPeer[0] );
+	close( gPeer[1] );
+}
+
+int main( int argc, char * argv[] )
+{
+	RunCall( "no deadline   ", 0 );
+	RunCall( "budget 100ms  ", BENCH_BUDGET );
+
+	DeadlineScope _scope( Deadline::After( 60000 ) );
+	StopWatch _sw;
+	Uint64 _sum = 0;
+	for ( Uint32 i = 0; i < BENCH_CHECKS; ++i ) _sum += Deadline::Current( ).Clamp( 1000 );
+	_sw.Tick( );
+	std::cout << "current + clamp: " << (double)_sw.GetMicroSecUsed( ) * 1000.0 / BENCH_CHECKS
+		<< "ns (" << _sum / BENCH_CHECKS << ")" << std::endl;
+	return 0;
+}
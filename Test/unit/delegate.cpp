@@ -0,0 +1,87 @@
+#include <Plib-Generic/Generic.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+
+using namespace Plib::Generic;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Bind and invoke cost of the delegate.
+// The loop does what _Request::Create does for each request:
+// clear the buffer update event, bind the parser, and the socket
+// calls it when data arrives.
+
+#define BENCH_COUNT		1000000
+
+struct TSock;
+typedef Delegate< int ( TSock *, void * ) >		TEvent;
+
+struct TSock
+{
+	TEvent			onBufferUpdate;
+};
+
+struct TParser
+{
+	Uint64			mCount;
+	TParser( ) : mCount( 0 ) { }
+	int ParseIncoming( TSock *, void * ) { return (int)(++mCount); }
+};
+
+// Function object larger than the slot buffer.
+struct TBigFunc
+{
+	Uint64			mPad[8];
+	Uint64 *		mSum;
+	int operator () ( TSock *, void * ) const { *mSum += mPad[0]; return 0; }
+};
+
+Uint64 gCalls = 0;
+int CountCall( TSock *, void * ) { return (int)(++gCalls); }
+
+int main( int argc, char * argv[] )
+{
+	TSock _sock;
+	TParser _parser;
+	Uint64 _sum = 0;
+	TBigFunc _big;
+	_big.mPad[0] = 5;
+	_big.mSum = &_sum;
+
+	// Multicast, in the order of binding, return the last one.
+	TEvent _event;
+	_event += &CountCall;
+	_event += std::make_pair( &_parser, &TParser::ParseIncoming );
+	_event += _big;
+	_event += &CountCall;
+	TEvent _copy = _event;
+	_event.Clear( );
+	int _ret = _copy( &_sock, NULL );
+	bool _multicast = ( _ret == 2 && _parser.mCount == 1 && _sum == 5 &&
+		_copy.Count( ) == 4 && !_event );
+	std::cout << "multicast: " << (_multicast ? "ok" : "wrong") << std::endl;
+
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		_sock.onBufferUpdate.Clear( );
+		_sock.onBufferUpdate += std::make_pair( &_parser, &TParser::ParseIncoming );
+		_sock.onBufferUpdate( &_sock, NULL );
+	}
+	_sw.Tick( );
+	bool _rebind = ( _parser.mCount == BENCH_COUNT + 1 );
+	std::cout << "rebind + invoke: " << _sw.GetMileSecUsed( ) << "ms, "
+		<< (_rebind ? "ok" : "wrong") << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) _sock.onBufferUpdate( &_sock, NULL );
+	_sw.Tick( );
+	std::cout << "invoke: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		TEvent _c( _sock.onBufferUpdate );
+		_c( &_sock, NULL );
+	}
+	_sw.Tick( );
+	std::cout << "copy + invoke: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	return _multicast && _rebind ? 0 : 1;
+}
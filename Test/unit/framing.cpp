@@ -0,0 +1,117 @@
+#include <Plib-Network/Framing.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <iostream>
+#include <string>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// Frames arrive in small reads. The codec keeps its scan position,
+// the old way scans the whole buffer again on every read.
+
+#define BENCH_FRAMES		2000
+#define BENCH_CHUNK			64
+
+struct TBuffer
+{
+	std::string		mData;
+	void Append( const char * _data, Uint32 _length ) { mData.append( _data, _length ); }
+};
+
+// Full rescan of the buffer on each read, like a parser without a codec.
+FRAMESTATUE RescanLine( const char * _data, Uint32 _size, FrameView & _frame )
+{
+	for ( Uint32 i = 0; i + 1 < _size; ++i ) {
+		if ( _data[i] == '\r' && _data[i + 1] == '\n' ) {
+			_frame.Data = _data;
+			_frame.Length = i;
+			return FRAME_DONE;
+		}
+	}
+	return FRAME_UNFINISHED;
+}
+
+template < typename _TyCodec >
+Uint64 FeedCodec( _TyCodec & _codec, const std::string & _stream )
+{
+	std::string _buffer;
+	FrameView _frame;
+	Uint64 _frames = 0;
+	for ( Uint32 _pos = 0; _pos < _stream.size( ); _pos += BENCH_CHUNK ) {
+		_buffer.append( _stream, _pos, BENCH_CHUNK );
+		while ( _codec.Scan( _buffer.data( ), (Uint32)_buffer.size( ), _frame ) == FRAME_DONE ) {
+			++_frames;
+			_buffer.erase( 0, _codec.Consumed( ) );
+			_codec.Clear( );
+		}
+	}
+	return _frames;
+}
+
+Uint64 FeedRescan( const std::string & _stream )
+{
+	std::string _buffer;
+	FrameView _frame;
+	Uint64 _frames = 0;
+	for ( Uint32 _pos = 0; _pos < _stream.size( ); _pos += BENCH_CHUNK ) {
+		_buffer.append( _stream, _pos, BENCH_CHUNK );
+		while ( RescanLine( _buffer.data( ), (Uint32)_buffer.size( ), _frame ) == FRAME_DONE ) {
+			++_frames;
+			_buffer.erase( 0, _frame.Length + 2 );
+		}
+	}
+	return _frames;
+}
+
+int main( int argc, char * argv[] )
+{
+	// 16KB lines, read 64 bytes each time.
+	std::string _body( 16 * 1024, 'x' );
+	DelimiterCodec _line;
+	TBuffer _lines;
+	for ( Uint32 i = 0; i < BENCH_FRAMES; ++i )
+		_line.Pack( _lines, _body.data( ), (Uint32)_body.size( ) );
+
+	StopWatch _sw;
+	Uint64 _frames = FeedCodec( _line, _lines.mData );
+	_sw.Tick( );
+	std::cout << "delimiter codec: " << _frames << " frames in " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	_sw.SetStart( );
+	_frames = FeedRescan( _lines.mData );
+	_sw.Tick( );
+	std::cout << "full rescan:     " << _frames << " frames in " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	// Length prefixed frames of all header kinds.
+	LengthPrefixCodec< 4 > _fixed;
+	VarintPrefixCodec _varint;
+	FixedSizeCodec _record( 100 );
+	TBuffer _fixedStream, _varintStream, _recordStream;
+	for ( Uint32 i = 0; i < BENCH_FRAMES * 10; ++i ) {
+		Uint32 _length = ( i * 7919 ) % 1000;
+		_fixed.Pack( _fixedStream, _body.data( ), _length );
+		_varint.Pack( _varintStream, _body.data( ), _length );
+		_record.Pack( _recordStream, _body.data( ), _length );
+	}
+	_sw.SetStart( );
+	_frames = FeedCodec( _fixed, _fixedStream.mData );
+	_sw.Tick( );
+	std::cout << "length codec:    " << _frames << " frames in " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	_sw.SetStart( );
+	_frames = FeedCodec( _varint, _varintStream.mData );
+	_sw.Tick( );
+	std::cout << "varint codec:    " << _frames << " frames in " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	_sw.SetStart( );
+	_frames = FeedCodec( _record, _recordStream.mData );
+	_sw.Tick( );
+	std::cout << "fixed codec:     " << _frames << " frames in " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	// Oversized frame is refused before it is buffered.
+	VarintPrefixCodec _limited( 1024 );
+	TBuffer _big;
+	_limited.Pack( _big, _body.data( ), 4096 );
+	FrameView _frame;
+	std::cout << "oversized frame: " << ( _limited.Scan( _big.mData.data( ), 3, _frame ) == FRAME_ILLEAGE ?
+		"refused" : "accepted" ) << std::endl;
+	return 0;
+}
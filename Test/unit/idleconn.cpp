@@ -0,0 +1,88 @@
+#include <Plib-Network/Syncsock.hpp>
+#include <iostream>
+#include <vector>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+using namespace Plib;
+using namespace Plib::Network;
+
+// The memory held by an idle keep-alive connection: the socket with its
+// reference handle, and the read buffer after one request was served.
+// The connections are socket pairs, the socket of one side is kept as
+// the listener keeps an accepted one, with the events of the listener.
+// Projected to one million connections.
+// It includes Plib-Text, which does not build in this tree yet. The
+// figures quoted with the change were measured against a stub of the
+// text module whose string is a std::string, so the buffer part is
+// not verified on the real library.
+
+#define BENCH_CONNECTIONS	20000
+#define BENCH_MESSAGE		2048
+#define BENCH_PROJECT		1000000
+
+size_t HeapInUse( )
+{
+	return mallinfo2( ).uordblks;
+}
+
+int main( int argc, char * argv[] )
+{
+	// Two descriptors for each connection.
+	struct rlimit _limit;
+	getrlimit( RLIMIT_NOFILE, &_limit );
+	_limit.rlim_cur = _limit.rlim_max;
+	setrlimit( RLIMIT_NOFILE, &_limit );
+	Uint32 _count = BENCH_CONNECTIONS;
+	if ( _limit.rlim_cur < 2 * _count + 64 ) _count = (Uint32)( _limit.rlim_cur - 64 ) / 2;
+
+	// The table of the listener.
+	SyncSock::SockEvents _events;
+	std::vector< RPSyncSock > _socks;
+	std::vector< Plib::Text::RString * > _buffers;
+	std::vector< int > _peers;
+	_socks.reserve( _count );
+	_buffers.reserve( _count );
+	_peers.reserve( _count );
+	char _message[BENCH_MESSAGE];
+	memset( _message, 'x', BENCH_MESSAGE );
+
+	size_t _before = HeapInUse( );
+	for ( Uint32 i = 0; i < _count; ++i ) {
+		int _pair[2];
+		if ( socketpair( AF_UNIX, SOCK_STREAM, 0, _pair ) != 0 ) {
+			_count = i;
+			break;
+		}
+		RPSyncSock _sock;
+		_sock->ShareEvents( &_events );
+		_sock->Bind( _pair[0], true );
+		Plib::Text::RString * _buffer = new Plib::Text::RString( );
+		_sock->AttachReadBuffer( _buffer );
+
+		// One request served, then the connection waits for the next.
+		::send( _pair[1], _message, BENCH_MESSAGE, MSG_NOSIGNAL );
+		_sock->Read( 1000 );
+		_buffer->Clear( );
+		_buffer->Shrink( );
+
+		_socks.push_back( _sock );
+		_buffers.push_back( _buffer );
+		_peers.push_back( _pair[1] );
+	}
+	size_t _after = HeapInUse( );
+
+	double _perConnection = (double)( _after - _before ) / _count;
+	std::cout << "connections: " << _count << ", sizeof(SyncSock): " << sizeof(SyncSock) << std::endl;
+	std::cout << "heap per idle connection: " << _perConnection << " bytes" << std::endl;
+	std::cout << "at " << BENCH_PROJECT << " connections: "
+		<< _perConnection * BENCH_PROJECT / ( 1024 * 1024 ) << " MB" << std::endl;
+
+	_socks.clear( );
+	for ( Uint32 i = 0; i < _count; ++i ) {
+		delete _buffers[i];
+		close( _peers[i] );
+	}
+	return 0;
+}
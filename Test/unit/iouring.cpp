@@ -0,0 +1,99 @@
+#include <Plib-Network/Network.hpp>
+
+using namespace Plib;
+using namespace Plib::Generic;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+using namespace Plib::Utility;
+
+// Loopback echo on the listener frame, the select poller against the
+// io_uring poller. Clients send one small message and wait the echo,
+// the round trip latency and the poller syscalls per request.
+
+#define BENCH_CLIENTS		8
+#define BENCH_REQUESTS		5000
+
+template < typename _TyPoller >
+struct TEcho
+{
+	typedef ListenerFrame< _TyPoller >	TL;
+	TL					mListener;
+	Thread< void( ) >	mWorker;
+	TEcho( ) { mWorker.Jobs += std::make_pair( this, &TEcho< _TyPoller >::Work ); }
+	void Work( )
+	{
+		char _buffer[256];
+		while ( ThreadSys::Running( ) ) {
+			typename TL::RefSocketT rSock = mListener.GetReadableSocket( 100 );
+			if ( rSock.RefNull( ) ) continue;
+			int _len = ::recv( rSock->hSo, _buffer, sizeof(_buffer), 0 );
+			if ( _len <= 0 ) { mListener.ReleaseSocket( rSock, false ); continue; }
+			::send( rSock->hSo, _buffer, _len, PLIB_NETWORK_NOSIGNAL );
+			mListener.ReleaseSocket( rSock, true );
+		}
+	}
+};
+
+MetricHistogram		gLatency;
+Uint32				gPort = 0;
+Uint32				gFailed = 0;
+
+void Client( )
+{
+	SyncSock _so;
+	if ( !_so.Connect( "127.0.0.1", gPort, 1000 ) ) return;
+	char _buffer[64] = "ping";
+	for ( Uint32 i = 0; i < BENCH_REQUESTS; ++i ) {
+		Uint64 _begin = MonotonicClock::NanoSeconds( );
+		::send( _so.hSo, _buffer, 32, PLIB_NETWORK_NOSIGNAL );
+		Uint32 _got = 0;
+		while ( _got < 32 ) {
+			int _len = ::recv( _so.hSo, _buffer, 32 - _got, 0 );
+			if ( _len <= 0 ) return;
+			_got += _len;
+		}
+		gLatency.Record( ( MonotonicClock::NanoSeconds( ) - _begin ) / 1000 );
+	}
+}
+
+template < typename _TyPoller >
+TEcho< _TyPoller > & Run( const char * _name, Uint32 _port )
+{
+	static TEcho< _TyPoller > _echo;
+	gPort = _port;
+	gLatency.Reset( );
+	if ( _echo.mListener.Listen( _port ) != LF_SUCCESS ) {
+		std::cout << _name << ": listen failed" << std::endl;
+		++gFailed;
+		return _echo;
+	}
+	_echo.mWorker.Start( );
+	Thread< void( ) > _clients[BENCH_CLIENTS];
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_CLIENTS; ++i ) {
+		_clients[i].Jobs += &Client;
+		_clients[i].Start( );
+	}
+	for ( Uint32 i = 0; i < BENCH_CLIENTS; ++i ) _clients[i].WaitUntilStop( );
+	_sw.Tick( );
+	HistogramSnapshot _snap;
+	gLatency.Snapshot( _snap );
+	std::cout << _name << ": " << _snap.Count( ) << " requests in " << _sw.GetMileSecUsed( )
+		<< "ms, p50 " << _snap.Percentile( 50 ) << "us, p99 " << _snap.Percentile( 99 ) << "us" << std::endl;
+	// Every request must get its echo.
+	if ( _snap.Count( ) != (Uint64)BENCH_CLIENTS * BENCH_REQUESTS ) ++gFailed;
+	_echo.mWorker.Stop( );
+	return _echo;
+}
+
+int main( int argc, char * argv[] )
+{
+	Run< Selector< SyncSock > >( "select", 6545 );
+#if PLIB_HAS_IO_URING
+	TEcho< IoUringPoller< SyncSock > > & _uring = Run< IoUringPoller< SyncSock > >( "io_uring", 6546 );
+	// The worker adds one recv and one send to both.
+	std::cout << "io_uring enter per request: " << (double)_uring.mListener.Poller( ).EnterCount( ) /
+		( BENCH_CLIENTS * BENCH_REQUESTS ) << std::endl;
+#endif
+	return gFailed == 0 ? 0 : 1;
+}
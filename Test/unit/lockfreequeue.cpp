@@ -0,0 +1,122 @@
+#include <Plib-Generic/Generic.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+
+using namespace Plib::Generic;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Throughput of the lock free queues.
+// Each consumer sums what it gets, the total must be equal to
+// the sum of all pushed values.
+
+#define BENCH_COUNT		1000000
+#define BENCH_THREADS	4
+#define BENCH_BATCH		32
+
+struct TNode : public MpscNode
+{
+	Uint64			mValue;
+};
+
+BlockingQueue< SpscQueue< Uint64 > >		gSpsc( 1024 );
+BlockingQueue< MpmcQueue< Uint64 > >		gMpmc( 1024 );
+BlockingQueue< MpscQueue< TNode > >			gMpsc;
+TNode										gNodes[BENCH_COUNT];
+volatile Uint64								gSum = 0;
+
+void * SpscProducer( void * )
+{
+	Uint64 _batch[BENCH_BATCH];
+	for ( Uint64 i = 0; i < BENCH_COUNT; i += BENCH_BATCH ) {
+		Uint32 _count = 0;
+		for ( ; _count < BENCH_BATCH; ++_count ) _batch[_count] = i + _count;
+		Uint32 _sent = 0;
+		while ( _sent < _count ) {
+			Uint32 _pushed = gSpsc.PushN( _batch + _sent, _count - _sent );
+			// Full, wait for one slot.
+			if ( _pushed == 0 && gSpsc.Push( _batch[_sent] ) ) _pushed = 1;
+			_sent += _pushed;
+		}
+	}
+	return NULL;
+}
+
+void * MpmcProducer( void * _p )
+{
+	Uint64 _from = (Uint64)(size_t)_p * (BENCH_COUNT / BENCH_THREADS);
+	for ( Uint64 i = 0; i < BENCH_COUNT / BENCH_THREADS; ++i ) gMpmc.Push( _from + i );
+	return NULL;
+}
+
+void * MpmcConsumer( void * )
+{
+	Uint64 _sum = 0, _value;
+	for ( Uint32 i = 0; i < BENCH_COUNT / BENCH_THREADS; ++i ) {
+		gMpmc.Pop( _value );
+		_sum += _value;
+	}
+	Plib::Basic::AtomicFetchAdd( &gSum, _sum );
+	return NULL;
+}
+
+void * MpscProducer( void * _p )
+{
+	Uint32 _from = (Uint32)(size_t)_p * (BENCH_COUNT / BENCH_THREADS);
+	for ( Uint32 i = 0; i < BENCH_COUNT / BENCH_THREADS; ++i ) {
+		gNodes[_from + i].mValue = _from + i;
+		gMpsc.Push( gNodes + _from + i );
+	}
+	return NULL;
+}
+
+Uint32 gFailed = 0;
+
+void PrintResult( const char * _name, StopWatch & _sw, Uint64 _sum )
+{
+	_sw.Tick( );
+	Uint64 _expect = (Uint64)BENCH_COUNT * (BENCH_COUNT - 1) / 2;
+	std::cout << _name << _sw.GetMileSecUsed( ) << "ms, "
+		<< (_sum == _expect ? "ok" : "wrong sum") << std::endl;
+	if ( _sum != _expect ) ++gFailed;
+}
+
+int main( int argc, char * argv[] )
+{
+	pthread_t _threads[BENCH_THREADS * 2];
+
+	// SPSC with batch.
+	StopWatch _sw;
+	pthread_create( _threads, NULL, SpscProducer, NULL );
+	Uint64 _sum = 0, _batch[BENCH_BATCH];
+	for ( Uint32 _got = 0; _got < BENCH_COUNT; ) {
+		Uint32 _count = gSpsc.PopN( _batch, BENCH_BATCH );
+		if ( _count == 0 && gSpsc.Pop( _batch[0] ) ) _count = 1;
+		for ( Uint32 i = 0; i < _count; ++i ) _sum += _batch[i];
+		_got += _count;
+	}
+	pthread_join( _threads[0], NULL );
+	PrintResult( "SPSC 1x1: ", _sw, _sum );
+
+	// MPMC.
+	_sw.SetStart( );
+	for ( size_t i = 0; i < BENCH_THREADS; ++i ) {
+		pthread_create( _threads + i, NULL, MpmcProducer, (void *)i );
+		pthread_create( _threads + BENCH_THREADS + i, NULL, MpmcConsumer, NULL );
+	}
+	for ( Uint32 i = 0; i < BENCH_THREADS * 2; ++i ) pthread_join( _threads[i], NULL );
+	PrintResult( "MPMC 4x4: ", _sw, gSum );
+
+	// MPSC.
+	_sw.SetStart( );
+	for ( size_t i = 0; i < BENCH_THREADS; ++i )
+		pthread_create( _threads + i, NULL, MpscProducer, (void *)i );
+	_sum = 0;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		TNode * _node;
+		gMpsc.Pop( _node );
+		_sum += _node->mValue;
+	}
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_join( _threads[i], NULL );
+	PrintResult( "MPSC 4x1: ", _sw, _sum );
+	return gFailed == 0 ? 0 : 1;
+}
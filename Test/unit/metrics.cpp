@@ -0,0 +1,80 @@
+#include <Plib-Utility/Metrics.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+
+using namespace Plib::Utility;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Record cost of the lock free metrics against a stats struct under
+// a mutex, what the users did in AfterOneRequest. The percentiles of
+// a known distribution are checked against the bucket error.
+
+#define BENCH_THREADS	4
+#define BENCH_COUNT		1000000
+
+MetricsRegistry		gRegistry;
+MetricCounter &		gRequests = gRegistry.Counter( "requests" );
+MetricHistogram &	gLatency = gRegistry.Histogram( "latency_us" );
+MetricGauge &		gDepth = gRegistry.Gauge( "queue" );
+
+struct TLockedStats
+{
+	Mutex			mLock;
+	Uint64			mCount;
+	Uint64			mSum;
+	Uint64			mMax;
+} gLocked = { Mutex( ), 0, 0, 0 };
+
+void * MetricsWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		gRequests.Add( );
+		gLatency.Record( i % 10000 );
+	}
+	return NULL;
+}
+
+void * LockedWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		Locker _l( gLocked.mLock );
+		++gLocked.mCount;
+		gLocked.mSum += i % 10000;
+		if ( i % 10000 > gLocked.mMax ) gLocked.mMax = i % 10000;
+	}
+	return NULL;
+}
+
+void Run( const char * _name, void *(*_worker)( void * ) )
+{
+	pthread_t _threads[BENCH_THREADS];
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_create( _threads + i, NULL, _worker, NULL );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_join( _threads[i], NULL );
+	_sw.Tick( );
+	std::cout << _name << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	Run( "mutex stats: ", LockedWorker );
+	Run( "metrics: ", MetricsWorker );
+
+	// Uniform 0 - 9999, p50 near 5000 and p99 near 9900, 6.25% error.
+	HistogramSnapshot _snap;
+	gLatency.Snapshot( _snap );
+	Uint64 _p50 = _snap.Percentile( 50 ), _p99 = _snap.Percentile( 99 );
+	bool _ok = gRequests.Value( ) == (Int64)BENCH_THREADS * BENCH_COUNT &&
+		_snap.Count( ) == (Uint64)BENCH_THREADS * BENCH_COUNT && _snap.Max( ) == 9999 &&
+		_p50 >= 5000 && _p50 <= 5000 * 1.0625 && _p99 >= 9900 && _p99 <= 9999;
+	std::cout << "percentiles: p50 " << _p50 << ", p99 " << _p99 << ", "
+		<< (_ok ? "ok" : "wrong") << std::endl;
+
+	gDepth.Set( 3 );
+	StopWatch _sw;
+	std::string _json = gRegistry.Snapshot( MF_JSON );
+	_sw.Tick( );
+	std::cout << gRegistry.Snapshot( MF_TEXT );
+	std::cout << _json << std::endl << "snapshot: " << _sw.GetMicroSecUsed( ) << "us" << std::endl;
+	return _ok ? 0 : 1;
+}
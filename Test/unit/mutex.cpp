@@ -0,0 +1,151 @@
+#include <Plib-Threading/Semaphore.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Mutex and Semaphore against the plain pthread objects.
+// Uncontended: one thread lock/unlock or release/get in a loop.
+// Contended: 4 threads add one shared counter under the lock,
+// and two threads ping-pong with two semaphores.
+
+#define BENCH_COUNT		1000000
+#define BENCH_THREADS	4
+#define BENCH_PINGPONG	100000
+
+// The old semaphore, a mutex with a condition.
+struct TCondSem
+{
+	pthread_mutex_t		mMutex;
+	pthread_cond_t		mCond;
+	Int32				mCount;
+	TCondSem( ) : mCount( 0 ) {
+		pthread_mutex_init( &mMutex, NULL );
+		pthread_cond_init( &mCond, NULL );
+	}
+	void Release( ) {
+		pthread_mutex_lock( &mMutex );
+		++mCount;
+		pthread_cond_signal( &mCond );
+		pthread_mutex_unlock( &mMutex );
+	}
+	bool Get( ) {
+		pthread_mutex_lock( &mMutex );
+		while ( mCount == 0 ) pthread_cond_wait( &mCond, &mMutex );
+		--mCount;
+		pthread_mutex_unlock( &mMutex );
+		return true;
+	}
+};
+
+Mutex				gMutex;
+pthread_mutex_t		gPMutex = PTHREAD_MUTEX_INITIALIZER;
+Uint64				gCounter = 0;
+
+Semaphore			gPing( 0, 1 ), gPong( 0, 1 );
+TCondSem			gCPing, gCPong;
+
+void * MutexWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT / BENCH_THREADS; ++i ) {
+		gMutex.Lock( ); ++gCounter; gMutex.UnLock( );
+	}
+	return NULL;
+}
+
+void * PMutexWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT / BENCH_THREADS; ++i ) {
+		pthread_mutex_lock( &gPMutex ); ++gCounter; pthread_mutex_unlock( &gPMutex );
+	}
+	return NULL;
+}
+
+void * PongWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_PINGPONG; ++i ) { gPing.Get( ); gPong.Release( ); }
+	return NULL;
+}
+
+void * CondPongWorker( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_PINGPONG; ++i ) { gCPing.Get( ); gCPong.Release( ); }
+	return NULL;
+}
+
+Uint32 gFailed = 0;
+
+void RunContended( const char * _name, void *(*_worker)( void * ) )
+{
+	pthread_t _threads[BENCH_THREADS];
+	gCounter = 0;
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_create( _threads + i, NULL, _worker, NULL );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_join( _threads[i], NULL );
+	_sw.Tick( );
+	std::cout << _name << _sw.GetMileSecUsed( ) << "ms, "
+		<< (gCounter == BENCH_COUNT ? "ok" : "wrong count") << std::endl;
+	if ( gCounter != BENCH_COUNT ) ++gFailed;
+}
+
+void * IdleWorker( void * ) { return NULL; }
+
+int main( int argc, char * argv[] )
+{
+	// glibc skips the atomic operations while the process has only
+	// one thread, start one so the uncontended numbers are fair.
+	pthread_t _idle;
+	pthread_create( &_idle, NULL, IdleWorker, NULL );
+	pthread_join( _idle, NULL );
+
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) { gMutex.Lock( ); gMutex.UnLock( ); }
+	_sw.Tick( );
+	std::cout << "Mutex uncontended: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		pthread_mutex_lock( &gPMutex ); pthread_mutex_unlock( &gPMutex );
+	}
+	_sw.Tick( );
+	std::cout << "pthread uncontended: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	Semaphore _sem( 0, 1 );
+	TCondSem _condSem;
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) { _sem.Release( ); _sem.Get( ); }
+	_sw.Tick( );
+	std::cout << "Semaphore uncontended: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) { _condSem.Release( ); _condSem.Get( ); }
+	_sw.Tick( );
+	std::cout << "cond sem uncontended: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	// Time out must not take the count.
+	_sw.SetStart( );
+	bool _timeout = !_sem.Get( 20 );
+	_sw.Tick( );
+	std::cout << "Semaphore timeout: " << _sw.GetMileSecUsed( ) << "ms, "
+		<< (_timeout && _sem.Count( ) == 0 ? "ok" : "wrong") << std::endl;
+	if ( !_timeout || _sem.Count( ) != 0 ) ++gFailed;
+
+	RunContended( "Mutex 4 threads: ", MutexWorker );
+	RunContended( "pthread 4 threads: ", PMutexWorker );
+
+	pthread_t _pong;
+	_sw.SetStart( );
+	pthread_create( &_pong, NULL, PongWorker, NULL );
+	for ( Uint32 i = 0; i < BENCH_PINGPONG; ++i ) { gPing.Release( ); gPong.Get( ); }
+	pthread_join( _pong, NULL );
+	_sw.Tick( );
+	std::cout << "Semaphore ping-pong: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	pthread_create( &_pong, NULL, CondPongWorker, NULL );
+	for ( Uint32 i = 0; i < BENCH_PINGPONG; ++i ) { gCPing.Release( ); gCPong.Get( ); }
+	pthread_join( _pong, NULL );
+	_sw.Tick( );
+	std::cout << "cond sem ping-pong: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	return gFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include <Plib-Generic/Generic.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <vector>
+#include <algorithm>
+
+using namespace Plib::Generic;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Indexed access on a 1M element Order and Array.
+// The objects are inserted in random order, so the storages
+// are not full and the position must be located by the block index.
+// The Order is checked against a sorted std::vector, the keys come with
+// duplicates and about a third of the keys searched are missing.
+
+#define BENCH_COUNT		1000000
+
+int gFailed = 0;
+
+void Check( bool _ok, const char * _what, Uint32 _at )
+{
+	if ( _ok ) return;
+	if ( ++gFailed <= 10 ) std::cout << "FAILED: " << _what << " at " << _at << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	Order< Uint32, Less< Uint32 > > roInt;
+	Array< Uint32 > raInt;
+	std::vector< Uint32 > _keys( BENCH_COUNT );
+	srand( 1 );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) _keys[i] = (Uint32)rand() % BENCH_COUNT;
+
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		roInt.SortInsert( _keys[i] );
+	}
+	_sw.Tick( );
+	std::cout << "Order SortInsert: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	// The reference, the order of the equal keys does not matter.
+	std::vector< Uint32 > _sorted( _keys );
+	std::sort( _sorted.begin( ), _sorted.end( ) );
+	Check( roInt.Size( ) == _sorted.size( ), "Order Size", roInt.Size( ) );
+	for ( Uint32 i = 0; i < roInt.Size( ) && i < _sorted.size( ); ++i )
+		Check( roInt[i] == _sorted[i], "Order SortInsert", i );
+
+	Uint32 _found = 0;
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		if ( roInt.Find( (i * 7919) % BENCH_COUNT ) != (Uint32)-1 ) ++_found;
+	}
+	_sw.Tick( );
+	std::cout << "Order Find:       " << _sw.GetMileSecUsed( ) << "ms, found: "
+		<< _found << std::endl;
+
+	// Find gives the first of the equal keys, -1 when missing.
+	Uint32 _expectFound = 0;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		Uint32 _key = (i * 7919) % BENCH_COUNT;
+		std::vector< Uint32 >::iterator _it = 
+			std::lower_bound( _sorted.begin( ), _sorted.end( ), _key );
+		Uint32 _expect = ( _it == _sorted.end( ) || *_it != _key ) ? 
+			(Uint32)-1 : (Uint32)( _it - _sorted.begin( ) );
+		if ( _expect != (Uint32)-1 ) ++_expectFound;
+		Check( roInt.Find( _key ) == _expect, "Order Find", _key );
+	}
+	Check( roInt.Find( BENCH_COUNT ) == (Uint32)-1, "Order Find past the end", BENCH_COUNT );
+	Check( _found == _expectFound, "Order Find count", _found );
+
+	Uint64 _sum = 0;
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		_sum += roInt[(i * 7919) % BENCH_COUNT];
+	}
+	_sw.Tick( );
+	std::cout << "Order operator[]: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	// Array with random insert position.
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		raInt.Insert( i, (Uint32)rand() % (raInt.Size() + 1) );
+	}
+	_sw.Tick( );
+	std::cout << "Array Insert:     " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		_sum += raInt[(i * 7919) % BENCH_COUNT];
+	}
+	_sw.Tick( );
+	std::cout << "Array operator[]: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT / 2; ++i )
+	{
+		raInt.Remove( (Uint32)rand() % raInt.Size() );
+	}
+	_sw.Tick( );
+	std::cout << "Array Remove:     " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	std::cout << "sum: " << _sum << std::endl;
+
+	roInt.Clear( );
+	raInt.Clear( );
+	std::cout << ( gFailed == 0 ? "check: ok" : "check: FAILED" ) << std::endl;
+	return gFailed == 0 ? 0 : 1;
+}
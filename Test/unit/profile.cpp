@@ -0,0 +1,58 @@
+#include <Plib-Utility/Profile.hpp>
+
+using namespace Plib::Utility;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Cost of a profiling zone when disabled at runtime and when
+// recording, then 4 threads record and the trace is exported.
+
+#define BENCH_COUNT		10000000
+#define BENCH_THREADS	4
+
+volatile Uint64 gWork = 0;
+
+void Work( )
+{
+	PLIB_PROFILE_ZONE( "Work" );
+	++gWork;
+}
+
+void * Worker( void * )
+{
+	for ( Uint32 i = 0; i < 1000; ++i ) {
+		PLIB_PROFILE_ZONE( "Worker::Loop" );
+		for ( Uint32 j = 0; j < 10; ++j ) Work( );
+	}
+	return NULL;
+}
+
+int main( int argc, char * argv[] )
+{
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) Work( );
+	_sw.Tick( );
+	std::cout << "disabled zone: " << _sw.GetNanoSecUsed( ) / (BENCH_COUNT / 1000) << "ps each" << std::endl;
+
+	Profiler::Instance( ).Enable( );
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) Work( );
+	_sw.Tick( );
+	std::cout << "enabled zone: " << _sw.GetNanoSecUsed( ) / BENCH_COUNT << "ns each" << std::endl;
+	Profiler::Instance( ).Disable( );
+	Profiler::Instance( ).Clear( );
+
+	Profiler::Instance( ).Enable( );
+	pthread_t _threads[BENCH_THREADS];
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_create( _threads + i, NULL, Worker, NULL );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_join( _threads[i], NULL );
+	Profiler::Instance( ).Disable( );
+
+	_sw.SetStart( );
+	bool _json = Profiler::Instance( ).ExportChromeTrace( "/tmp/plib_profile.json" );
+	bool _bin = Profiler::Instance( ).ExportBinary( "/tmp/plib_profile.bin" );
+	_sw.Tick( );
+	std::cout << "export " << BENCH_THREADS * 11000 << " events: " << _sw.GetMileSecUsed( ) << "ms, "
+		<< (_json && _bin ? "ok" : "failed") << std::endl;
+	return _json && _bin ? 0 : 1;
+}
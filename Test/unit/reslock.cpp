@@ -0,0 +1,86 @@
+#include <Plib-Threading/Threading.hpp>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// 32 threads lock random keys out of 1M distinct keys and add the
+// counter of the key. The sum of all counters must be the count of
+// all operations. The ResLock memory does not grow with the keys.
+// One thread holding two keys of the same stripe must not block itself.
+
+#define BENCH_KEYS		1000000
+#define BENCH_THREADS	32
+#define BENCH_COUNT		200000		// operations per thread.
+
+Uint32									gCounters[BENCH_KEYS];
+ResLock< Uint32 >						gResLock;
+ResLock< Uint32, TicketLocker >			gFairLock;
+
+template < typename _TyLock >
+void * Worker( void * _p )
+{
+	_TyLock * _lock = (_TyLock *)_p;
+	Uint32 _seed = (Uint32)(size_t)pthread_self( ) | 1;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		_seed ^= _seed << 13; _seed ^= _seed >> 17; _seed ^= _seed << 5;
+		Uint32 _key = _seed % BENCH_KEYS;
+		_lock->Lock( _key );
+		++gCounters[_key];
+		_lock->UnLock( _key );
+	}
+	return NULL;
+}
+
+// Same interface, one mutex for all keys.
+struct TGlobalLock
+{
+	Mutex			mLock;
+	void Lock( Uint32 ) { mLock.Lock( ); }
+	void UnLock( Uint32 ) { mLock.UnLock( ); }
+};
+TGlobalLock								gGlobal;
+
+template < typename _TyLock >
+bool Run( const char * _name, _TyLock & _lock )
+{
+	pthread_t _threads[BENCH_THREADS];
+	::memset( gCounters, 0, sizeof(gCounters) );
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i )
+		pthread_create( _threads + i, NULL, Worker< _TyLock >, &_lock );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) pthread_join( _threads[i], NULL );
+	_sw.Tick( );
+	Uint64 _sum = 0;
+	for ( Uint32 i = 0; i < BENCH_KEYS; ++i ) _sum += gCounters[i];
+	bool _ok = ( _sum == (Uint64)BENCH_THREADS * BENCH_COUNT );
+	std::cout << _name << _sw.GetMileSecUsed( ) << "ms, " << sizeof(_lock) << " bytes, "
+		<< (_ok ? "ok" : "wrong sum") << std::endl;
+	return _ok;
+}
+
+// Lock a key and another key of the same stripe in one thread.
+template < typename _TyLock >
+bool SameStripe( _TyLock & _lock )
+{
+	Uint32 _other = 1;
+	while ( _lock.StripeOf( _other ) != _lock.StripeOf( 0 ) ) ++_other;
+	_lock.Lock( 0 );
+	_lock.Lock( _other );
+	bool _reentered = _lock.TryLock( 0 );
+	_lock.UnLock( 0 );
+	_lock.UnLock( _other );
+	_lock.UnLock( 0 );
+	// The last unlock releases the stripe.
+	return _reentered && _lock.TryLock( _other ) && ( _lock.UnLock( _other ), true );
+}
+
+int main( int argc, char * argv[] )
+{
+	bool _same = SameStripe( gResLock ) && SameStripe( gFairLock );
+	std::cout << "same stripe: " << ( _same ? "ok" : "deadlock" ) << std::endl;
+	if ( !_same ) return 1;
+	bool _ok = Run( "global mutex: ", gGlobal );
+	_ok = Run( "ResLock: ", gResLock ) && _ok;
+	_ok = Run( "ResLock fair: ", gFairLock ) && _ok;
+	return _ok ? 0 : 1;
+}
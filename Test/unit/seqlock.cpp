@@ -0,0 +1,99 @@
+#include <Plib-Threading/Threading.hpp>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Many readers against RWLock, SeqLock and BRLock.
+// Each reader reads a small config object BENCH_COUNT times, one
+// writer updates it every 100us. The object is checked on every
+// read, the two fields must always match.
+
+#define BENCH_COUNT		1000000
+#define BENCH_MAX_READERS	8
+
+struct TConfig
+{
+	Uint64			mVersion;
+	Uint64			mCheck;
+};
+
+RWLock				gRWLock;
+BRLock				gBRLock;
+TConfig				gConfig = { 0, 0 };
+SeqLock< TConfig >	gSeqConfig;
+volatile Int32		gWriting = 1;
+volatile Int32		gBroken = 0;
+
+void Check( const TConfig & _c )
+{
+	if ( _c.mCheck != ~_c.mVersion && _c.mVersion != 0 )
+		Plib::Basic::AtomicStore( &gBroken, (Int32)1 );
+}
+
+void * RWReader( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		ReadLocker _l( gRWLock );
+		Check( gConfig );
+	}
+	return NULL;
+}
+
+void * SeqReader( void * )
+{
+	TConfig _c;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		gSeqConfig.Read( _c );
+		Check( _c );
+	}
+	return NULL;
+}
+
+void * BRReader( void * )
+{
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		BRReadLocker _l( gBRLock );
+		Check( gConfig );
+	}
+	return NULL;
+}
+
+void * Writer( void * _p )
+{
+	Uint32 _kind = (Uint32)(size_t)_p;
+	for ( Uint64 _v = 1; Plib::Basic::AtomicLoad( &gWriting ); ++_v ) {
+		TConfig _c = { _v, ~_v };
+		if ( _kind == 0 ) { WriteLocker _l( gRWLock ); gConfig = _c; }
+		else if ( _kind == 1 ) { gSeqConfig.Write( _c ); }
+		else { BRWriteLocker _l( gBRLock ); gConfig = _c; }
+		usleep( 100 );
+	}
+	return NULL;
+}
+
+void Run( const char * _name, Uint32 _kind, void *(*_reader)( void * ), Uint32 _readers )
+{
+	pthread_t _threads[BENCH_MAX_READERS], _writer;
+	gWriting = 1;
+	pthread_create( &_writer, NULL, Writer, (void *)(size_t)_kind );
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < _readers; ++i ) pthread_create( _threads + i, NULL, _reader, NULL );
+	for ( Uint32 i = 0; i < _readers; ++i ) pthread_join( _threads[i], NULL );
+	_sw.Tick( );
+	Plib::Basic::AtomicStore( &gWriting, (Int32)0 );
+	pthread_join( _writer, NULL );
+	Uint64 _ms = _sw.GetMileSecUsed( );
+	std::cout << _name << _readers << " readers: " << _ms << "ms, "
+		<< (Uint64)_readers * BENCH_COUNT / (_ms ? _ms : 1) / 1000 << "M reads/s, "
+		<< (gBroken ? "broken" : "ok") << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	for ( Uint32 _readers = 1; _readers <= BENCH_MAX_READERS; _readers *= 2 ) {
+		Run( "RWLock  ", 0, RWReader, _readers );
+		Run( "SeqLock ", 1, SeqReader, _readers );
+		Run( "BRLock  ", 2, BRReader, _readers );
+	}
+	return gBroken ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+#include <Plib-Threading/Stopwatch.hpp>
+#include <sys/time.h>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Cost of one SetStart + Tick for each clock source of the stop watch,
+// and the measured time of a 20ms sleep. The cached now is stale when
+// the sleep starts and must fall back to the clock.
+
+#define BENCH_COUNT		1000000
+
+Uint64 Run( const char * _name, StopWatchMode _mode )
+{
+	StopWatch _sw( true, _mode ), _total;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		_sw.SetStart( );
+		_sw.Tick( );
+	}
+	_total.Tick( );
+	// No poller, let the cached now go stale.
+	usleep( 2 * PLIB_CACHED_NOW_PERIOD / 1000 );
+	_sw.SetStart( );
+	usleep( 20000 );
+	MonotonicClock::UpdateCachedNow( );
+	_sw.Tick( );
+	std::cout << _name << _total.GetNanoSecUsed( ) / BENCH_COUNT << "ns each, 20ms sleep: "
+		<< _sw.GetMicroSecUsed( ) << "us" << std::endl;
+	return _sw.GetMicroSecUsed( );
+}
+
+int main( int argc, char * argv[] )
+{
+	struct timeval _tv;
+	StopWatch _total;
+	for ( Uint32 i = 0; i < BENCH_COUNT * 2; ++i ) ::gettimeofday( &_tv, NULL );
+	_total.Tick( );
+	std::cout << "gettimeofday x2: " << _total.GetNanoSecUsed( ) / BENCH_COUNT << "ns each" << std::endl;
+
+	MonotonicClock::UpdateCachedNow( );
+	Run( "monotonic: ", SW_MONOTONIC );
+	Run( "coarse: ", SW_COARSE );
+	Run( "tsc: ", SW_TSC );
+	Uint64 _cached = Run( "cached: ", SW_CACHED );
+	std::cout << "tsc cycles per ns: " << MonotonicClock::CyclesPerNanoSecond( ) << std::endl;
+	bool _ok = ( _cached >= 20000 && _cached < 30000 );
+	std::cout << "cached 20ms sleep: " << (_ok ? "ok" : "wrong") << std::endl;
+	return _ok ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+#include <Plib-Threading/Threading.hpp>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Cost of the ThreadSys::Running loop check, with 4 threads spinning
+// on it at once, and the wake up of WaitForSignal by Stop.
+
+#define BENCH_THREADS	4
+#define BENCH_TIME		200		// ms
+
+Uint64 gChecks[BENCH_THREADS];
+
+void Spin( Uint32 _index )
+{
+	Uint64 _checks = 0;
+	while ( ThreadSys::Running( ) ) ++_checks;
+	gChecks[_index] = _checks;
+}
+
+void Waiting( )
+{
+	while ( ThreadSys::Running( ) ) ThreadSys::WaitForSignal( 10000 );
+}
+
+int main( int argc, char * argv[] )
+{
+	Thread< void( Uint32 ) > _threads[BENCH_THREADS];
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) {
+		_threads[i].Jobs += &Spin;
+		_threads[i].Start( i );
+	}
+	usleep( BENCH_TIME * 1000 );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) _threads[i].Stop( );
+	Uint64 _all = 0;
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) _all += gChecks[i];
+	std::cout << "Running( ): " << _all / BENCH_THREADS << " checks per thread in "
+		<< BENCH_TIME << "ms, " << (double)BENCH_TIME * 1000000 * BENCH_THREADS / _all
+		<< "ns each" << std::endl;
+	std::cout << "out of a thread: " << ( ThreadSys::Running( ) ? "running" : "not running" ) << std::endl;
+
+	Thread< void( ) > _waiting;
+	_waiting.Jobs += &Waiting;
+	_waiting.Start( );
+	usleep( 10000 );
+	StopWatch _sw;
+	_waiting.Stop( );
+	_sw.Tick( );
+	std::cout << "stop a waiting thread: " << _sw.GetMicroSecUsed( ) << "us" << std::endl;
+	return 0;
+}
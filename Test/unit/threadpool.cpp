@@ -0,0 +1,91 @@
+#include <Plib-Threading/Threading.hpp>
+#include <algorithm>
+
+using namespace Plib::Generic;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Latency from submit to start of a task, in micro seconds.
+// "role threads" is the old Service model: a queue with a mutex and
+// a semaphore, each worker thread blocks on the semaphore.
+// The tasks arrive one by one with a small gap, like requests.
+
+#define BENCH_COUNT		20000
+#define BENCH_THREADS	4
+#define BENCH_GAP		20		// micro seconds between two tasks.
+
+struct TJob
+{
+	Uint64			mSubmit;
+	Uint64			mLatency;
+	void Run( ) { mLatency = Plib::Basic::MonotonicMicroSeconds( ) - mSubmit; }
+};
+
+TJob				gJobs[BENCH_COUNT];
+
+// Old model.
+Mutex				gQueueLock;
+Semaphore			gQueueSem( 0, 0xFFFF );
+Queue< TJob * >		gQueue;
+volatile Int32		gRoleRunning = 1;
+
+void RoleThread( )
+{
+	while ( Plib::Basic::AtomicLoad( &gRoleRunning ) ) {
+		if ( !gQueueSem.Get( 10 ) ) continue;
+		gQueueLock.Lock( );
+		TJob * _job = gQueue.Head( );
+		gQueue.Pop( );
+		gQueueLock.UnLock( );
+		_job->Run( );
+	}
+}
+
+void WaitGap( )
+{
+	Uint64 _until = Plib::Basic::MonotonicMicroSeconds( ) + BENCH_GAP;
+	while ( Plib::Basic::MonotonicMicroSeconds( ) < _until ) Plib::Basic::CpuRelax( );
+}
+
+void PrintLatency( const char * _name )
+{
+	Vector< Uint64 > _lat;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) _lat.PushBack( gJobs[i].mLatency );
+	std::sort( _lat.Begin(), _lat.End() );
+	std::cout << _name << " p50: " << _lat[BENCH_COUNT / 2] << "us, p99: "
+		<< _lat[BENCH_COUNT * 99 / 100] << "us, p999: "
+		<< _lat[BENCH_COUNT * 999 / 1000] << "us, max: "
+		<< _lat[BENCH_COUNT - 1] << "us" << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	Thread< void( ) > _roles[BENCH_THREADS];
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) {
+		_roles[i].Jobs += &RoleThread;
+		_roles[i].Start( );
+	}
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		gJobs[i].mSubmit = Plib::Basic::MonotonicMicroSeconds( );
+		gQueueLock.Lock( );
+		gQueue.Push( gJobs + i );
+		gQueueLock.UnLock( );
+		gQueueSem.Release( );
+		WaitGap( );
+	}
+	Plib::Basic::AtomicStore( &gRoleRunning, (Int32)0 );
+	for ( Uint32 i = 0; i < BENCH_THREADS; ++i ) _roles[i].Stop( );
+	PrintLatency( "role threads" );
+
+	ThreadPool _pool;
+	_pool.Start( BENCH_THREADS );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		gJobs[i].mSubmit = Plib::Basic::MonotonicMicroSeconds( );
+		_pool.Submit( ThreadPool::TaskT( gJobs + i, &TJob::Run ) );
+		WaitGap( );
+	}
+	while ( _pool.PendingCount( ) > 0 ) ThreadSys::Sleep( 1 );
+	_pool.Stop( );
+	PrintLatency( "thread pool " );
+	return 0;
+}
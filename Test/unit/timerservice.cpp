@@ -0,0 +1,77 @@
+#include <Plib-Threading/Threading.hpp>
+
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Thousands of timers on the one thread of the timer service.
+// Schedule and cancel cost of the wheel, and how late the callbacks
+// fire against the expected time.
+
+#define BENCH_TIMERS		10000
+#define BENCH_COUNT			1000000
+
+struct TProbe
+{
+	TimerTask		mTask;
+	Uint64			mExpect;		// microseconds
+	Uint64			mFired;
+	TProbe( ) : mExpect( 0 ), mFired( 0 )
+	{
+		mTask.Handler += std::make_pair( this, &TProbe::OnTimer );
+	}
+	void OnTimer( ) { mFired = Plib::Basic::MonotonicMicroSeconds( ); }
+};
+
+TProbe				gProbes[BENCH_TIMERS];
+
+Uint64 gTicks = 0;
+void OnTick( ) { ++gTicks; }
+
+int main( int argc, char * argv[] )
+{
+	TimerService _service;
+
+	// Schedule then cancel, never fire.
+	TimerTask _task;
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i ) {
+		_service.Schedule( _task, 1 + (i % 100000) );
+		_service.Cancel( _task );
+	}
+	_sw.Tick( );
+	std::cout << "schedule + cancel: " << _sw.GetMileSecUsed( ) * 1000000 / BENCH_COUNT
+		<< "ns each" << std::endl;
+
+	// Spread over 2 seconds, all levels of the wheel are used.
+	_service.Start( );
+	Uint64 _now = Plib::Basic::MonotonicMicroSeconds( );
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_TIMERS; ++i ) {
+		Uint64 _delay = (i * 7919) % 2000;
+		gProbes[i].mExpect = _now + _delay * 1000;
+		_service.Schedule( gProbes[i].mTask, _delay );
+	}
+	_sw.Tick( );
+	std::cout << "schedule " << BENCH_TIMERS << " timers: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	while ( _service.PendingCount( ) > 0 ) usleep( 10000 );
+
+	Uint64 _maxLate = 0, _sumLate = 0, _early = 0;
+	for ( Uint32 i = 0; i < BENCH_TIMERS; ++i ) {
+		if ( gProbes[i].mFired + 1000 < gProbes[i].mExpect ) { ++_early; continue; }
+		Uint64 _late = (gProbes[i].mFired > gProbes[i].mExpect) ?
+			gProbes[i].mFired - gProbes[i].mExpect : 0;
+		_sumLate += _late;
+		if ( _late > _maxLate ) _maxLate = _late;
+	}
+	std::cout << "fired: avg late " << _sumLate / BENCH_TIMERS << "us, max late "
+		<< _maxLate << "us, " << (_early == 0 ? "ok" : "early") << std::endl;
+
+	// Periodic timer of the old interface.
+	Timer _timer( 10, true, _service );
+	_timer += &OnTick;
+	usleep( 205000 );
+	_timer.SetEnable( false );
+	std::cout << "timer ticks in 205ms: " << gTicks << std::endl;
+	_service.Stop( );
+	return _early == 0 ? 0 : 1;
+}
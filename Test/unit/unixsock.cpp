@@ -0,0 +1,147 @@
+#include <Plib-Network/Endpoint.hpp>
+#include <Plib-Threading/Thread.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <iostream>
+#include <netinet/tcp.h>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// Small RPC to a local peer, loopback TCP against a unix socket.
+// One client sends a request and waits for the echo, then a fresh
+// connection for each request.
+
+#define BENCH_RPC			50000
+#define BENCH_CONNECT		5000
+#define BENCH_PAYLOAD		128
+
+int		gListenFD = -1;
+
+int Listen( const Endpoint & _endpoint )
+{
+	struct sockaddr_storage _addr;
+	socklen_t _len = _endpoint.Address( _addr );
+	int _so = ::socket( _endpoint.Family( ), SOCK_STREAM, 0 );
+	int _val = 1;
+	setsockopt( _so, SOL_SOCKET, SO_REUSEADDR, &_val, sizeof(_val) );
+	_endpoint.Unlink( );
+	if ( ::bind( _so, (struct sockaddr *)&_addr, _len ) != 0 || ::listen( _so, 1024 ) != 0 ) {
+		close( _so );
+		return -1;
+	}
+	return _so;
+}
+
+int Connect( const Endpoint & _endpoint )
+{
+	struct sockaddr_storage _addr;
+	socklen_t _len = _endpoint.Address( _addr );
+	if ( !_endpoint.IsUnix( ) ) {
+		struct sockaddr_in * _in = (struct sockaddr_in *)&_addr;
+		_in->sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	}
+	int _so = ::socket( _endpoint.Family( ), SOCK_STREAM, 0 );
+	if ( ::connect( _so, (struct sockaddr *)&_addr, _len ) != 0 ) {
+		close( _so );
+		return -1;
+	}
+	int _val = 1;
+	if ( !_endpoint.IsUnix( ) ) setsockopt( _so, IPPROTO_TCP, TCP_NODELAY, &_val, sizeof(_val) );
+	return _so;
+}
+
+bool ReadAll( int _so, char * _buffer, int _size )
+{
+	for ( int _got = 0; _got < _size; ) {
+		int _ret = ::read( _so, _buffer + _got, _size - _got );
+		if ( _ret <= 0 ) return false;
+		_got += _ret;
+	}
+	return true;
+}
+
+// Echo every connection until it is closed.
+void Server( )
+{
+	char _buffer[BENCH_PAYLOAD];
+	while ( ThreadSys::Running( ) ) {
+		int _so = ::accept( gListenFD, NULL, NULL );
+		if ( _so < 0 ) break;
+		int _val = 1;
+		setsockopt( _so, IPPROTO_TCP, TCP_NODELAY, &_val, sizeof(_val) );
+		while ( ReadAll( _so, _buffer, BENCH_PAYLOAD ) ) {
+			if ( ::write( _so, _buffer, BENCH_PAYLOAD ) != BENCH_PAYLOAD ) break;
+		}
+		close( _so );
+	}
+}
+
+void RunBench( const char * _name, const Endpoint & _endpoint )
+{
+	gListenFD = Listen( _endpoint );
+	if ( gListenFD < 0 ) {
+		std::cout << _name << ": failed to listen" << std::endl;
+		return;
+	}
+	Thread< void( ) > _server;
+	_server.Jobs += Server;
+	_server.Start( );
+
+	char _buffer[BENCH_PAYLOAD];
+	memset( _buffer, 'x', sizeof(_buffer) );
+	int _so = Connect( _endpoint );
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_RPC; ++i ) {
+		if ( ::write( _so, _buffer, BENCH_PAYLOAD ) != BENCH_PAYLOAD ||
+			!ReadAll( _so, _buffer, BENCH_PAYLOAD ) ) break;
+	}
+	_sw.Tick( );
+	close( _so );
+	double _rpc = (double)_sw.GetMicroSecUsed( ) / BENCH_RPC;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_CONNECT; ++i ) {
+		_so = Connect( _endpoint );
+		if ( _so < 0 ) break;
+		if ( ::write( _so, _buffer, BENCH_PAYLOAD ) != BENCH_PAYLOAD ||
+			!ReadAll( _so, _buffer, BENCH_PAYLOAD ) ) { close( _so ); break; }
+		close( _so );
+	}
+	_sw.Tick( );
+	double _connect = (double)_sw.GetMicroSecUsed( ) / BENCH_CONNECT;
+
+	_server.Stop( false );
+	::shutdown( gListenFD, SHUT_RDWR );
+	close( gListenFD );
+	_server.WaitUntilStop( );
+	_endpoint.Unlink( );
+	std::cout << _name << ": " << _rpc << "us per rpc, "
+		<< _connect << "us per connect + rpc" << std::endl;
+}
+
+// A long path is not valid, and only the file no one listens on
+// is taken as stale.
+bool CheckEndpoint( )
+{
+	std::string _long( Endpoint::PATH_MAX_LENGTH + 1, 'x' );
+	if ( Endpoint::Unix( _long.c_str( ) ).Valid( ) ) return false;
+	Endpoint _endpoint = Endpoint::Unix( "/tmp/plib-stale.sock" );
+	_endpoint.Unlink( );
+	int _so = Listen( _endpoint );
+	if ( _so < 0 ) return false;
+	bool _kept = !_endpoint.UnlinkStale( );
+	close( _so );
+	return _kept && _endpoint.UnlinkStale( ) && !_endpoint.UnlinkStale( );
+}
+
+int main( int argc, char * argv[] )
+{
+	bool _endpoint = CheckEndpoint( );
+	std::cout << "endpoint check: " << ( _endpoint ? "ok" : "FAILED" ) << std::endl;
+	if ( !_endpoint ) return 1;
+	RunBench( "loopback tcp  ", Endpoint::Tcp( 16543 ) );
+	RunBench( "unix path     ", Endpoint::Unix( "/tmp/plib-bench.sock" ) );
+	RunBench( "unix abstract ", Endpoint::Unix( "@plib-bench" ) );
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include <Plib-Generic/Generic.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+
+using namespace Plib::Generic;
+using namespace Plib::Threading;
+using namespace Plib;
+
+// Compare Vector with Array on push/index/iterate.
+// Each line prints the mileseconds used.
+
+#define BENCH_COUNT		1000000
+
+template < typename _TyContainer >
+void BenchContainer( const char * _name, _TyContainer & _container )
+{
+	StopWatch _sw;
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		_container.PushBack( i );
+	}
+	_sw.Tick( );
+	std::cout << _name << " push:    " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	Uint64 _sum = 0;
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < BENCH_COUNT; ++i )
+	{
+		// Random access.
+		_sum += _container[(i * 7919) % BENCH_COUNT];
+	}
+	_sw.Tick( );
+	std::cout << _name << " index:   " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+
+	_sw.SetStart( );
+	for ( Uint32 i = 0; i < _container.Size(); ++i )
+	{
+		_sum += _container[i];
+	}
+	_sw.Tick( );
+	std::cout << _name << " iterate: " << _sw.GetMileSecUsed( ) << "ms" << std::endl;
+	std::cout << _name << " sum:     " << _sum << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	Array< Uint32 > raInt;
+	BenchContainer( "Array ", raInt );
+
+	RVector< Uint32 > rvInt;
+	BenchContainer( "Vector", rvInt );
+
+	// Scan by iterator.
+	StopWatch _sw;
+	Uint64 _sum = 0;
+	for ( RVector< Uint32 >::Iterator _it = rvInt.Begin(); _it != rvInt.End(); ++_it )
+	{
+		_sum += *_it;
+	}
+	_sw.Tick( );
+	std::cout << "Vector iterator: " << _sw.GetMileSecUsed( ) << "ms, sum: " << _sum << std::endl;
+
+	rvInt.Clear( );
+	rvInt.ShrinkToFit( );
+	raInt.Clear( );
+	return 0;
+}
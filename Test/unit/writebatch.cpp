@@ -0,0 +1,196 @@
+#include <Plib-Network/WriteBatch.hpp>
+#include <Plib-Threading/Thread.hpp>
+#include <Plib-Threading/Stopwatch.hpp>
+#include <iostream>
+#include <netinet/tcp.h>
+
+using namespace Plib;
+using namespace Plib::Network;
+using namespace Plib::Threading;
+
+// Pipelined small requests over loopback TCP with no delay, the server
+// answers each burst one send per response, or by the write batch.
+// The tcp_info of glibc stops before the segment counters, the kernel
+// only appends to it, so the counters follow its fields.
+// Count the write calls and the segments sent by the server.
+// Then the held responses must be pushed before a slow one.
+
+#define BENCH_ROUNDS		20000
+#define BENCH_PIPELINE		16
+#define BENCH_REQUEST		64
+#define BENCH_RESPONSE		200
+#define BENCH_PORT			16544
+
+struct TTcpInfo
+{
+	struct tcp_info		Base;
+	Uint64				PacingRate;
+	Uint64				MaxPacingRate;
+	Uint64				BytesAcked;
+	Uint64				BytesReceived;
+	Uint32				SegsOut;
+	Uint32				SegsIn;
+};
+
+// The write side of the socket, as the service sees it.
+struct TRawSock
+{
+	int			hSo;
+	Uint32		Calls;
+
+	bool Write( const char * _data, unsigned _length )
+	{
+		++Calls;
+		return ::send( hSo, _data, _length, MSG_NOSIGNAL ) == (ssize_t)_length;
+	}
+	bool WriteV( const SODATAPAIR * _pairs, unsigned _count, bool _more )
+	{
+		struct iovec _iov[2];
+		size_t _total = 0;
+		for ( unsigned i = 0; i < _count; ++i ) {
+			_iov[i].iov_base = (void *)_pairs[i].data;
+			_iov[i].iov_len = _pairs[i].length;
+			_total += _pairs[i].length;
+		}
+		struct msghdr _msg;
+		memset( &_msg, 0, sizeof(_msg) );
+		_msg.msg_iov = _iov;
+		_msg.msg_iovlen = _count;
+		++Calls;
+		return ::sendmsg( hSo, &_msg, MSG_NOSIGNAL | ( _more ? MSG_MORE : 0 ) ) == (ssize_t)_total;
+	}
+	bool SetCork( bool _cork )
+	{
+		int _flag = _cork ? 1 : 0;
+		return setsockopt( hSo, IPPROTO_TCP, TCP_CORK, &_flag, sizeof(_flag) ) != -1;
+	}
+};
+
+int			gListenFD = -1;
+bool		gBatch = false;
+Uint32		gFlushBytes = 0;
+Uint32		gCalls = 0;
+Uint32		gSegments = 0;
+Uint32		gFailed = 0;
+
+bool ReadAll( int _so, char * _buffer, int _size )
+{
+	for ( int _got = 0; _got < _size; ) {
+		int _ret = ::read( _so, _buffer + _got, _size - _got );
+		if ( _ret <= 0 ) return false;
+		_got += _ret;
+	}
+	return true;
+}
+
+void Server( )
+{
+	int _so = ::accept( gListenFD, NULL, NULL );
+	if ( _so < 0 ) return;
+	int _val = 1;
+	setsockopt( _so, IPPROTO_TCP, TCP_NODELAY, &_val, sizeof(_val) );
+	TRawSock _sock = { _so, 0 };
+	char _request[BENCH_REQUEST * BENCH_PIPELINE];
+	char _response[BENCH_RESPONSE];
+	memset( _response, 'r', sizeof(_response) );
+	while ( ReadAll( _so, _request, sizeof(_request) ) ) {
+		if ( !gBatch ) {
+			for ( Uint32 i = 0; i < BENCH_PIPELINE; ++i ) _sock.Write( _response, BENCH_RESPONSE );
+			continue;
+		}
+		WriteBatch< TRawSock > _output( &_sock, gFlushBytes );
+		for ( Uint32 i = 0; i < BENCH_PIPELINE; ++i ) {
+			_output.Add( _response, BENCH_RESPONSE, i + 1 < BENCH_PIPELINE );
+		}
+	}
+	TTcpInfo _info;
+	socklen_t _len = sizeof(_info);
+	if ( getsockopt( _so, IPPROTO_TCP, TCP_INFO, &_info, &_len ) == 0 && _len >= sizeof(_info) )
+		gSegments = _info.SegsOut;
+	gCalls = _sock.Calls;
+	close( _so );
+}
+
+void RunBench( const char * _name, bool _batch, Uint32 _flushBytes = 64 * 1024 )
+{
+	gBatch = _batch;
+	gFlushBytes = _flushBytes;
+	gListenFD = ::socket( AF_INET, SOCK_STREAM, 0 );
+	int _val = 1;
+	setsockopt( gListenFD, SOL_SOCKET, SO_REUSEADDR, &_val, sizeof(_val) );
+	struct sockaddr_in _addr;
+	memset( &_addr, 0, sizeof(_addr) );
+	_addr.sin_family = AF_INET;
+	_addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	_addr.sin_port = htons( BENCH_PORT );
+	if ( ::bind( gListenFD, (struct sockaddr *)&_addr, sizeof(_addr) ) != 0 ||
+		::listen( gListenFD, 16 ) != 0 ) {
+		std::cout << _name << ": failed to listen" << std::endl;
+		++gFailed;
+		close( gListenFD );
+		return;
+	}
+	Thread< void( ) > _server;
+	_server.Jobs += Server;
+	_server.Start( );
+
+	int _so = ::socket( AF_INET, SOCK_STREAM, 0 );
+	::connect( _so, (struct sockaddr *)&_addr, sizeof(_addr) );
+	setsockopt( _so, IPPROTO_TCP, TCP_NODELAY, &_val, sizeof(_val) );
+	char _request[BENCH_REQUEST * BENCH_PIPELINE];
+	char _response[BENCH_RESPONSE * BENCH_PIPELINE];
+	memset( _request, 'q', sizeof(_request) );
+	StopWatch _sw;
+	Uint32 _rounds = 0;
+	for ( ; _rounds < BENCH_ROUNDS; ++_rounds ) {
+		if ( ::write( _so, _request, sizeof(_request) ) != (ssize_t)sizeof(_request) ||
+			!ReadAll( _so, _response, sizeof(_response) ) ) break;
+	}
+	_sw.Tick( );
+	close( _so );
+	_server.Stop( false );
+	_server.WaitUntilStop( );
+	close( gListenFD );
+	std::cout << _name << ": " << (double)_sw.GetMicroSecUsed( ) / BENCH_ROUNDS << "us per burst, "
+		<< (double)gCalls / BENCH_ROUNDS << " writes, "
+		<< (double)gSegments / BENCH_ROUNDS << " segments"
+		<< ( _rounds == BENCH_ROUNDS ? "" : ", wrong: lost responses" ) << std::endl;
+	// All the responses of every burst must come back.
+	if ( _rounds != BENCH_ROUNDS ) ++gFailed;
+}
+
+// Delay 10ms, the next response is expected to take 10us, then 20ms.
+void RunHold( )
+{
+	int _pair[2];
+	if ( ::socketpair( AF_UNIX, SOCK_STREAM, 0, _pair ) != 0 ) {
+		std::cout << "hold: failed to connect" << std::endl;
+		++gFailed;
+		return;
+	}
+	TRawSock _sock = { _pair[0], 0 };
+	bool _ok;
+	{
+		WriteBatch< TRawSock > _output( &_sock, 64 * 1024, 10000 );
+		_output.Add( "a", 1, true );
+		_ok = _output.Hold( 10 ) && _sock.Calls == 0;
+		_ok = _output.Hold( 20000 ) && _sock.Calls == 1 && _ok;
+		char _got = 0;
+		_ok = ::recv( _pair[1], &_got, 1, MSG_DONTWAIT ) == 1 && _got == 'a' && _ok;
+		_output.Add( "b", 1, false );
+	}
+	close( _pair[0] );
+	close( _pair[1] );
+	std::cout << "hold before a slow one: " << ( _ok ? "ok" : "wrong" ) << std::endl;
+	if ( !_ok ) ++gFailed;
+}
+
+int main( int argc, char * argv[] )
+{
+	RunBench( "send each   ", false );
+	RunBench( "write batch ", true );
+	// Flushed with MSG_MORE before the last one, still full segments.
+	RunBench( "flush at 1k ", true, 1024 );
+	RunHold( );
+	return gFailed == 0 ? 0 : 1;
+}